@@ -1,6 +1,7 @@
 #include "ImageAsset.h"
 
 #include "asset/AssetCache.h"
+#include "asset/MipmapGenerator.h"
 #include "asset/external/DDSImage.h"
 #include "core/Assert.h"
 #include "core/Logging.h"
@@ -12,10 +13,61 @@
 #include <cereal/types/vector.hpp>
 #include <fmt/format.h>
 #include <fstream>
+#include <optional>
 #include <stb_image.h>
 
 namespace {
 AssetCache<ImageAsset> s_imageAssetCache {};
+
+struct MappedDDSImage {
+    std::unique_ptr<MappedFile> file {};
+    std::span<u8 const> pixelData {};
+
+    Extent3D extent {};
+    ImageFormat format { ImageFormat::Unknown };
+    bool sRGB { false };
+    std::vector<ImageMip> mips {};
+};
+
+std::optional<MappedDDSImage> mapDDSImage(std::filesystem::path const& filePath)
+{
+    MappedDDSImage mappedImage {};
+
+    mappedImage.file = MappedFile::map(filePath);
+    if (mappedImage.file == nullptr) {
+        ARKOSE_LOG(Error, "Failed to load image asset at path '{}'", filePath);
+        return {};
+    }
+
+    std::span<u8 const> fileData = mappedImage.file->data();
+    if (!DDS::isValidHeader(fileData.data(), fileData.size())) {
+        ARKOSE_LOG(Warning, "File '{}' is not a valid DDS file, trying to load as image asset", filePath);
+    }
+
+    u32 numMips;
+    u8 const* pixelData = DDS::loadFromMemory(fileData.data(), fileData.size(), mappedImage.extent, mappedImage.format, mappedImage.sRGB, numMips);
+
+    if (pixelData == nullptr) {
+        ARKOSE_LOG(Error, "Failed to load image asset '{}' (DDS reported error, likely invalid file)", filePath);
+        return {};
+    }
+
+    mappedImage.mips = DDS::computeMipOffsetAndSize(mappedImage.extent, mappedImage.format, numMips);
+
+    ARKOSE_ASSERT(mappedImage.mips[0].offset == 0); // we assume all the mips are laid out sequentially
+    size_t pixelDataSize = mappedImage.mips.back().offset + mappedImage.mips.back().size;
+
+    size_t pixelDataOffset = pixelData - fileData.data();
+    if (pixelDataOffset + pixelDataSize > fileData.size()) {
+        ARKOSE_LOG(Error, "Failed to load image asset '{}' (file is truncated)", filePath);
+        return {};
+    }
+
+    mappedImage.pixelData = fileData.subspan(pixelDataOffset, pixelDataSize);
+
+    return mappedImage;
+}
+
 }
 
 bool imageFormatIsBlockCompressed(ImageFormat format)
@@ -255,44 +307,30 @@ ImageAsset* ImageAsset::loadOrCreate(std::filesystem::path const& filePath)
 
 bool ImageAsset::readFromFile(std::filesystem::path const& filePath)
 {
+    SCOPED_PROFILE_ZONE();
+
     if (!isValidAssetPath(filePath)) {
         ARKOSE_LOG(Warning, "Trying to load image asset with invalid file extension: '{}'", filePath);
         return false;
     }
 
-    std::optional<std::vector<std::byte>> maybeFileData = FileIO::readBinaryDataFromFile<std::byte>(filePath);
-    if (!maybeFileData) {
-        ARKOSE_LOG(Error, "Failed to load image asset at path '{}'", filePath);
+    std::optional<MappedDDSImage> mappedImage = mapDDSImage(filePath);
+    if (!mappedImage.has_value()) {
         return false;
     }
 
-    std::vector<std::byte> const& fileData = maybeFileData.value();
-    if (!DDS::isValidHeader(reinterpret_cast<u8 const*>(fileData.data()), fileData.size())) { 
-        ARKOSE_LOG(Warning, "File '{}' is not a valid DDS file, trying to load as image asset", filePath);
-    }
+    m_extent = mappedImage->extent;
 
-    Extent3D extent;
-    ImageFormat format;
-    bool srgb;
-    u32 numMips;
-    void* data = (void*)DDS::loadFromMemory(reinterpret_cast<u8 const*>(fileData.data()), fileData.size(), extent, format, srgb, numMips);
+    m_format = mappedImage->format;
+    m_type = mappedImage->sRGB ? ImageType::sRGBColor : ImageType::Unknown;
 
-    if (data == nullptr) {
-        ARKOSE_LOG(Error, "Failed to load image asset '{}' (DDS reported error, likely invalid file)", filePath);
-        return false;
-    }
-
-    m_extent = extent;
-
-    m_format = format;
-    m_type = srgb ? ImageType::sRGBColor : ImageType::Unknown;
-
-    m_mips = DDS::computeMipOffsetAndSize(extent, format, numMips);
+    m_mips = std::move(mappedImage->mips);
 
-    uint8_t* dataPtr = reinterpret_cast<uint8_t*>(data);
-    ARKOSE_ASSERT(m_mips[0].offset == 0); // we assume all the mips are laid out sequentially
-    size_t dataSize = m_mips.back().offset + m_mips.back().size;
-    m_pixelData = std::vector<uint8_t>(dataPtr, dataPtr + dataSize);
+    // Don't copy the pixel data, just keep the file mapped and read the pixels straight from it
+    m_pixelData.clear();
+    m_mappedFile = std::move(mappedImage->file);
+    m_mappedPixelData = mappedImage->pixelData;
+    m_pixelDataIsMapped = true;
 
     setAssetFilePath(filePath);
 
@@ -312,7 +350,8 @@ bool ImageAsset::writeToFile(std::filesystem::path const& filePath, AssetStorage
 
     bool sRGB = m_type == ImageType::sRGBColor;
 
-    return DDS::writeToFile(filePath, m_pixelData.data(), m_pixelData.size(), m_extent, m_format, sRGB, narrow_cast<u32>(m_mips.size()));
+    std::span<u8 const> pixelData = this->pixelData();
+    return DDS::writeToFile(filePath, pixelData.data(), pixelData.size(), m_extent, m_format, sRGB, narrow_cast<u32>(m_mips.size()));
 }
 
 std::span<u8 const> ImageAsset::pixelDataForMip(size_t mipIdx) const
@@ -321,12 +360,40 @@ std::span<u8 const> ImageAsset::pixelDataForMip(size_t mipIdx) const
         return {};
     }
 
+    std::span<u8 const> pixelData = this->pixelData();
+    if (pixelData.empty()) {
+        return {};
+    }
+
     ImageMip const& mip = m_mips[mipIdx];
     ARKOSE_ASSERT(mip.size > 0);
-    ARKOSE_ASSERT(mip.offset < m_pixelData.size());
-    ARKOSE_ASSERT(mip.offset + mip.size <= m_pixelData.size());
+    ARKOSE_ASSERT(mip.offset < pixelData.size());
+    ARKOSE_ASSERT(mip.offset + mip.size <= pixelData.size());
+
+    return pixelData.subspan(mip.offset, mip.size);
+}
 
-    return std::span<u8 const> { m_pixelData.data() + mip.offset, mip.size };
+std::span<u8 const> ImageAsset::pixelData() const
+{
+    if (m_pixelDataIsMapped) {
+        return m_mappedPixelData;
+    } else {
+        return m_pixelData;
+    }
+}
+
+void ImageAsset::makePixelDataOwned()
+{
+    if (!m_pixelDataIsMapped) {
+        return;
+    }
+
+    std::span<u8 const> mappedPixelData = pixelData();
+    m_pixelData.assign(mappedPixelData.begin(), mappedPixelData.end());
+
+    m_pixelDataIsMapped = false;
+    m_mappedPixelData = {};
+    m_mappedFile.reset();
 }
 
 size_t ImageAsset::totalImageSizeIncludingMips() const
@@ -336,85 +403,25 @@ size_t ImageAsset::totalImageSizeIncludingMips() const
     return lastMip.offset + lastMip.size;
 }
 
-bool ImageAsset::generateMipmaps()
+bool ImageAsset::generateMipmaps(MipmapFilter filter)
 {
     SCOPED_PROFILE_ZONE();
 
-    // TODO: Implement proper error handling!
-    ARKOSE_ASSERT(m_mips.size() == 1);
-    ARKOSE_ASSERT(depth() == 1);
-
-    if (!ark::isPowerOfTwo(width()) || !ark::isPowerOfTwo(height())) {
-        ARKOSE_LOG(Warning, "Non-power-of-two mipmap generation is not yet implemented.");
+    if (m_mips.size() != 1) {
+        ARKOSE_LOG(Error, "Can't generate mipmaps for image asset '{}' as it already has {} mips", name, m_mips.size());
         return false;
     }
 
-    // TODO: Support more formats!
-    ARKOSE_ASSERT(m_format == ImageFormat::RGBA8);
-
-    u32 mipHeight = height();
-    u32 mipWidth = width();
-    u32 levels = static_cast<u32>(std::floor(std::log2(std::max(mipHeight, mipWidth))) + 1);
-
-    for (u32 level = 1; level < levels; ++level) {
-
-        std::string zoneName = fmt::format("Mip level {}", level);
-        SCOPED_PROFILE_ZONE_DYNAMIC(zoneName, 0xaa5577);
-
-        u32 previousMipLevel = level - 1;
-        ImageMip previousMip = m_mips[previousMipLevel];
-        std::vector<rgba8> previousMipPixels = pixelDataAsRGBA8(level - 1);
-
-        u32 thisMipHeight = std::max(mipHeight / 2, 1u);
-        u32 thisMipWidth = std::max(mipWidth / 2, 1u);
-        u32 sizeRatio = (mipWidth / thisMipWidth) * (mipHeight / thisMipHeight);
-
-        ImageMip& thisMip = m_mips.emplace_back();
-        thisMip.offset = previousMip.offset + previousMip.size;
-        thisMip.size = previousMip.size / sizeRatio;
-
-        m_pixelData.reserve(thisMip.offset + thisMip.size);
-
-        for (u32 y = 0; y < thisMipHeight; ++y) {
-            for (u32 x = 0; x < thisMipWidth; ++x) {
-
-                u32 x0 = 2 * x + 0;
-                u32 y0 = 2 * y + 0;
-                u32 x1 = std::min(2 * x + 1, mipWidth - 1);
-                u32 y1 = std::min(2 * y + 1, mipHeight - 1);
-
-                rgba8 pix0 = previousMipPixels[x0 + y0 * mipWidth];
-                rgba8 pix1 = previousMipPixels[x0 + y1 * mipWidth];
-                rgba8 pix2 = previousMipPixels[x1 + y0 * mipWidth];
-                rgba8 pix3 = previousMipPixels[x1 + y1 * mipWidth];
-
-                // TODO: Would be nice to have some kind of vector constructor that can take a non-narrowing type an argument
-                float rAvg = (static_cast<float>(pix0.x) + static_cast<float>(pix1.x) + static_cast<float>(pix2.x) + static_cast<float>(pix3.x)) / 4.0f;
-                float gAvg = (static_cast<float>(pix0.y) + static_cast<float>(pix1.y) + static_cast<float>(pix2.y) + static_cast<float>(pix3.y)) / 4.0f;
-                float bAvg = (static_cast<float>(pix0.z) + static_cast<float>(pix1.z) + static_cast<float>(pix2.z) + static_cast<float>(pix3.z)) / 4.0f;
-                float aAvg = (static_cast<float>(pix0.w) + static_cast<float>(pix1.w) + static_cast<float>(pix2.w) + static_cast<float>(pix3.w)) / 4.0f;
-
-                u8 r = static_cast<u8>(std::round(rAvg));
-                u8 g = static_cast<u8>(std::round(gAvg));
-                u8 b = static_cast<u8>(std::round(bAvg));
-                u8 a = static_cast<u8>(std::round(aAvg));
-
-                // (This works nicely when we're in rgba8 and it's a u8 vector, but for all other cases it won't be this simple)
-                m_pixelData.emplace_back(r);
-                m_pixelData.emplace_back(g);
-                m_pixelData.emplace_back(b);
-                m_pixelData.emplace_back(a);
-
-            }
-        }
-
-        // Next mip..
-        mipHeight = thisMipHeight;
-        mipWidth = thisMipWidth;
-
+    if (hasCompressedFormat()) {
+        ARKOSE_LOG(Error, "Can't generate mipmaps for image asset '{}' as it has a block-compressed format", name);
+        return false;
     }
 
-    return true;
+    // The mips are generated in place, so we need our own copy of the pixel data
+    makePixelDataOwned();
+
+    MipmapGenerator mipmapGenerator { m_format, m_type, filter };
+    return mipmapGenerator.generateMipChain(m_extent, m_pixelData, m_mips);
 }
 
 Extent3D ImageAsset::extentAtMip(size_t mipIdx) const
@@ -462,26 +469,3 @@ ImageAsset::rgba8 ImageAsset::getPixelAsRGBA8(u32 x, u32 y, u32 z, u32 mipIdx) c
 
     return pixel;
 }
-
-std::vector<ImageAsset::rgba8> ImageAsset::pixelDataAsRGBA8(size_t mipIdx) const
-{
-    ARKOSE_ASSERT(depth() == 1);
-
-    // TODO: Support more formats! The function name only refers to the output format and should be able to convert
-    ARKOSE_ASSERT(format() == ImageFormat::RGBA8);
-
-    ImageMip const& mip = m_mips[mipIdx];
-    size_t numPixels = mip.size / (4 * sizeof(u8));
-
-    std::vector<rgba8> rgbaPixelData {};
-    rgbaPixelData.reserve(numPixels);
-
-    for (size_t offset = mip.offset; offset < mip.offset + mip.size; offset += 4) {
-        rgbaPixelData.emplace_back(m_pixelData[offset + 0],
-                                   m_pixelData[offset + 1],
-                                   m_pixelData[offset + 2],
-                                   m_pixelData[offset + 3]);
-    }
-
-    return rgbaPixelData;
-}
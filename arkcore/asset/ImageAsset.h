@@ -3,6 +3,7 @@
 #include "asset/Asset.h"
 #include "core/Types.h"
 #include "utility/Extent.h"
+#include "utility/MappedFile.h"
 #include <ark/vector.h>
 #include <span>
 #include <string>
@@ -36,6 +37,15 @@ enum class ImageFormat {
     BC7 = 301,
 };
 
+enum class MipmapFilter {
+    // Averages the pixels covered by the footprint of the smaller mip pixel
+    Box,
+    // Kaiser-windowed sinc, sharper than box at a small risk of ringing
+    Kaiser,
+    // Lanczos (3 lobes), the sharpest option but also the most prone to ringing
+    Lanczos,
+};
+
 bool imageFormatIsBlockCompressed(ImageFormat);
 u32 imageFormatBlockSize(ImageFormat);
 
@@ -92,8 +102,8 @@ public:
 
     size_t totalImageSizeIncludingMips() const;
 
-    // Generate mipmaps (slow)
-    bool generateMipmaps();
+    // Generate a full mip chain from the first mip level (for any uncompressed format and size)
+    bool generateMipmaps(MipmapFilter = MipmapFilter::Box);
 
     bool hasSourceAsset() const { return not m_sourceAssetFilePath.empty(); }
     std::filesystem::path sourceAssetFilePath() const { return std::filesystem::path(m_sourceAssetFilePath); }
@@ -107,12 +117,19 @@ private:
     ImageFormat m_format { ImageFormat::RGBA8 };
     ImageType m_type { ImageType::Unknown };
 
-    // Pixel data binary blob
+    // Pixel data binary blob (empty if the pixel data is read from the mapped file)
     std::vector<u8> m_pixelData {};
 
-    std::vector<ImageMip> m_mips {};
+    // Memory-mapped asset file, for images loaded from disk. The mapping lives as long as the asset, so any pixel data spans
+    // stay valid for as long as the asset does. Pages that are no longer used can simply be dropped by the OS when needed.
+    std::unique_ptr<MappedFile> m_mappedFile {};
+    std::span<u8 const> m_mappedPixelData {};
+    bool m_pixelDataIsMapped { false };
 
-    std::vector<rgba8> pixelDataAsRGBA8(size_t mipIdx) const;
+    std::span<u8 const> pixelData() const;
+    void makePixelDataOwned();
+
+    std::vector<ImageMip> m_mips {};
 
     std::string m_sourceAssetFilePath {};
 };
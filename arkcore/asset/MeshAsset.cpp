@@ -1,11 +1,14 @@
 #include "MeshAsset.h"
 
 #include "asset/AssetCache.h"
+#include "asset/MeshAssetFlatLayout.h"
 #include "asset/TextureCompressor.h"
 #include "core/Assert.h"
 #include "core/Logging.h"
+#include "core/parallel/ParallelFor.h"
 #include "physics/PhysicsMesh.h"
 #include "utility/FileIO.h"
+#include "utility/MappedFile.h"
 #include "utility/Profiling.h"
 #include <ark/defer.h>
 #include <cereal/archives/binary.hpp>
@@ -19,6 +22,50 @@
 
 namespace {
 AssetCache<MeshAsset> s_meshAssetCache {};
+
+// Octahedral encoding of a unit vector onto the [-1, +1] square, matching octahedralEncode in shaders/common/octahedral.glsl
+vec2 octahedralEncode(vec3 v)
+{
+    float l1norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1norm == 0.0f) {
+        return vec2(0.0f);
+    }
+
+    vec2 result = vec2(v.x, v.y) / l1norm;
+    if (v.z < 0.0f) {
+        auto signNotZero = [](float f) { return f >= 0.0f ? 1.0f : -1.0f; };
+        result = vec2((1.0f - std::abs(result.y)) * signNotZero(result.x),
+                      (1.0f - std::abs(result.x)) * signNotZero(result.y));
+    }
+
+    return result;
+}
+
+u32 packSnorm2x16(vec2 v)
+{
+    u16 x = static_cast<u16>(static_cast<i16>(meshopt_quantizeSnorm(std::clamp(v.x, -1.0f, 1.0f), 16)));
+    u16 y = static_cast<u16>(static_cast<i16>(meshopt_quantizeSnorm(std::clamp(v.y, -1.0f, 1.0f), 16)));
+    return static_cast<u32>(x) | (static_cast<u32>(y) << 16);
+}
+
+u32 packHalf2x16(vec2 v)
+{
+    return static_cast<u32>(meshopt_quantizeHalf(v.x)) | (static_cast<u32>(meshopt_quantizeHalf(v.y)) << 16);
+}
+
+u32 encodeCompactNormal(vec3 normal)
+{
+    return packSnorm2x16(octahedralEncode(normal));
+}
+
+// The bitangent sign is folded into y, see encodeCompactTangent in shaders/common/nonPositionVertex.glsl
+u32 encodeCompactTangent(vec4 tangent)
+{
+    vec2 octahedral = octahedralEncode(tangent.xyz());
+    float y = std::max(octahedral.y * 0.5f + 0.5f, 1.0f / 32767.0f);
+    return packSnorm2x16(vec2(octahedral.x, tangent.w < 0.0f ? -y : y));
+}
+
 }
 
 MeshSegmentAsset::MeshSegmentAsset() = default;
@@ -212,6 +259,47 @@ void MeshSegmentAsset::optimize()
     
 }
 
+MeshSegmentAsset MeshSegmentAsset::createSimplifiedSegment(size_t targetIndexCount, float targetError, float& outError) const
+{
+    SCOPED_PROFILE_ZONE();
+
+    ARKOSE_ASSERT(isIndexedMesh());
+
+    float const* vertexPositions = value_ptr(positions[0]);
+    constexpr size_t vertexPositionStride = sizeof(vec3);
+
+    // Lock the borders so that neighbouring segments (e.g. with different materials) still line up without any cracks
+    constexpr unsigned int simplifyOptions = meshopt_SimplifyLockBorder;
+
+    std::vector<u32> simplifiedIndices(indices.size());
+    float relativeError = 0.0f;
+    size_t simplifiedIndexCount = meshopt_simplify(simplifiedIndices.data(), indices.data(), indices.size(),
+                                                   vertexPositions, vertexCount(), vertexPositionStride,
+                                                   targetIndexCount, targetError, simplifyOptions, &relativeError);
+    simplifiedIndices.resize(simplifiedIndexCount);
+
+    outError = relativeError * meshopt_simplifyScale(vertexPositions, vertexCount(), vertexPositionStride);
+
+    MeshSegmentAsset simplifiedSegment = *this;
+    simplifiedSegment.indices = std::move(simplifiedIndices);
+    simplifiedSegment.opacityMicroMapData.reset();
+
+    // The whole segment may collapse, in which case there is nothing to optimize or generate meshlets for
+    if (simplifiedSegment.indices.empty()) {
+        simplifiedSegment.meshletData.reset();
+        return simplifiedSegment;
+    }
+
+    // Optimize the new indices, which also drops all vertices no longer referenced
+    simplifiedSegment.optimize();
+
+    if (meshletData.has_value()) {
+        simplifiedSegment.generateMeshlets();
+    }
+
+    return simplifiedSegment;
+}
+
 void MeshSegmentAsset::remapVertexData(std::vector<u32> const& remapTable, size_t newVertexCount)
 {
     meshopt_remapVertexBuffer(positions.data(), positions.data(), positions.size(), sizeof(decltype(positions[0])), remapTable.data());
@@ -795,6 +883,15 @@ std::vector<u8> MeshSegmentAsset::assembleVertexData(VertexLayout const& layout,
         case VertexComponent::Tangent4F: {
             offsetInFirstVertex += copyComponentData(tangents, vec4(1.0f, 0.0f, 0.0f, 1.0f));
         } break;
+        case VertexComponent::TexCoord2H: {
+            offsetInFirstVertex += copyComponentDataWithTransformation(texcoord0s, packHalf2x16(vec2(0.0f)), packHalf2x16);
+        } break;
+        case VertexComponent::NormalOct2S16: {
+            offsetInFirstVertex += copyComponentDataWithTransformation(normals, encodeCompactNormal(vec3(0.0f, 0.0f, 1.0f)), encodeCompactNormal);
+        } break;
+        case VertexComponent::TangentOct2S16: {
+            offsetInFirstVertex += copyComponentDataWithTransformation(tangents, encodeCompactTangent(vec4(1.0f, 0.0f, 0.0f, 1.0f)), encodeCompactTangent);
+        } break;
         case VertexComponent::JointWeight4F: {
             offsetInFirstVertex += copyComponentData(jointWeights, vec4(0.0f));
         } break;
@@ -848,6 +945,26 @@ MeshAsset* MeshAsset::manage(std::unique_ptr<MeshAsset>&& meshAsset)
 
 bool MeshAsset::readFromFile(std::filesystem::path const& filePath)
 {
+    SCOPED_PROFILE_ZONE();
+
+    if (std::unique_ptr<MappedFile> mappedFile = MappedFile::map(filePath)) {
+        if (MeshAssetFlatLayout::isFlatLayout(mappedFile->data())) {
+            if (!MeshAssetFlatLayout::read(mappedFile->data(), *this, filePath)) {
+                return false;
+            }
+
+            setAssetFilePath(filePath);
+
+            if (name.empty()) {
+                name = filePath.stem().string();
+            }
+
+            return true;
+        }
+    }
+
+    // Not in the flat binary layout, so it's either an older cereal binary archive or a json file
+
     std::ifstream fileStream(filePath, std::ios::binary);
     if (!fileStream.is_open()) {
         ARKOSE_LOG(Error, "Failed to load mesh asset at path '{}'", filePath);
@@ -894,27 +1011,116 @@ bool MeshAsset::writeToFile(std::filesystem::path const& filePath, AssetStorage
         return false;
     }
 
-    std::ofstream fileStream { filePath, std::ios::binary | std::ios::trunc };
+    if (assetStorage == AssetStorage::Binary) {
+        // Binary mesh assets may be mapped (see readFromFile), so replace the file instead of truncating it underneath the mapping
+        std::vector<u8> fileData = MeshAssetFlatLayout::write(*this);
+        return FileIO::replaceFileWithBinaryData(filePath, reinterpret_cast<std::byte const*>(fileData.data()), fileData.size());
+    }
+
+    std::ofstream fileStream { filePath, std::ios::trunc };
     if (not fileStream.is_open()) {
         return false;
     }
 
-    switch (assetStorage) {
-    case AssetStorage::Binary: {
-        cereal::BinaryOutputArchive archive(fileStream);
-        archive(AssetHeader(AssetMagicValue));
-        archive(*this);
-    } break;
-    case AssetStorage::Json: {
+    {
         cereal::JSONOutputArchive archive(fileStream);
         archive(cereal::make_nvp("mesh", *this));
-    } break;
     }
 
     fileStream.close();
     return true;
 }
 
+void MeshAsset::processForImport()
+{
+    SCOPED_PROFILE_ZONE();
+
+    std::vector<MeshSegmentAsset*> segments {};
+    for (MeshLODAsset& lod : LODs) {
+        for (MeshSegmentAsset& segment : lod.meshSegments) {
+            segments.push_back(&segment);
+        }
+    }
+
+    ParallelFor(segments.size(), [&](size_t segmentIdx) {
+        segments[segmentIdx]->processForImport();
+    });
+}
+
+void MeshAsset::generateLODs(u32 lodCount, float targetIndexRatio, float maxError)
+{
+    SCOPED_PROFILE_ZONE();
+
+    ARKOSE_ASSERT(targetIndexRatio > 0.0f && targetIndexRatio < 1.0f);
+
+    if (LODs.empty() || lodCount <= 1) {
+        return;
+    }
+
+    // A LOD which doesn't get rid of at least this fraction of the indices of the previous LOD isn't worth its memory
+    constexpr float MinIndexCountReduction = 0.1f;
+
+    // All LODs are simplified from LOD0 (rather than from the previous LOD) so the errors don't accumulate
+    LODs.resize(1);
+    size_t segmentCount = LODs[0].meshSegments.size();
+
+    // Error of the current version of each segment, which is kept for the LODs where the segment itself is kept
+    std::vector<float> segmentErrors(segmentCount, 0.0f);
+
+    auto countIndices = [](MeshLODAsset const& lod) -> size_t {
+        size_t indexCount = 0;
+        for (MeshSegmentAsset const& segment : lod.meshSegments) {
+            indexCount += segment.indices.size();
+        }
+        return indexCount;
+    };
+
+    for (u32 lodIdx = 1; lodIdx < lodCount; ++lodIdx) {
+        MeshLODAsset const& lod0 = LODs[0];
+        MeshLODAsset const& previousLod = LODs[lodIdx - 1];
+
+        MeshLODAsset lod {};
+        lod.meshSegments.resize(segmentCount);
+
+        float lodIndexRatio = std::pow(targetIndexRatio, static_cast<float>(lodIdx));
+
+        ParallelFor(segmentCount, [&](size_t segmentIdx) {
+            MeshSegmentAsset const& sourceSegment = lod0.meshSegments[segmentIdx];
+            MeshSegmentAsset const& previousSegment = previousLod.meshSegments[segmentIdx];
+
+            size_t targetIndexCount = (static_cast<size_t>(static_cast<float>(sourceSegment.indices.size()) * lodIndexRatio) / 3) * 3;
+
+            float simplificationError = 0.0f;
+            MeshSegmentAsset simplifiedSegment = sourceSegment.createSimplifiedSegment(targetIndexCount, maxError, simplificationError);
+
+            // Keep the segment of the previous LOD if it collapses entirely or doesn't improve on it, so all LODs have matching segments
+            if (simplifiedSegment.indices.empty() || simplifiedSegment.indices.size() >= previousSegment.indices.size()) {
+                lod.meshSegments[segmentIdx] = previousSegment;
+            } else {
+                lod.meshSegments[segmentIdx] = std::move(simplifiedSegment);
+                segmentErrors[segmentIdx] = simplificationError;
+            }
+        });
+
+        size_t previousIndexCount = countIndices(previousLod);
+        size_t indexCount = countIndices(lod);
+        if (static_cast<float>(indexCount) > static_cast<float>(previousIndexCount) * (1.0f - MinIndexCountReduction)) {
+            ARKOSE_LOG(Verbose, "Mesh '{}': stopping LOD generation at LOD{}, can't simplify any further within the error bounds", name, lodIdx);
+            break;
+        }
+
+        lod.simplificationError = *std::max_element(segmentErrors.begin(), segmentErrors.end());
+
+        ARKOSE_LOG(Verbose, "Mesh '{}': generated LOD{} with {} triangles ({:.1f}% of LOD0), error {:.5f}", name, lodIdx,
+                   indexCount / 3, 100.0f * static_cast<float>(indexCount) / static_cast<float>(countIndices(lod0)), lod.simplificationError);
+
+        LODs.push_back(std::move(lod));
+    }
+
+    // Allow rendering with all the LODs we ended up with (e.g. the glTF loader only knows about LOD0 and limits it to that)
+    maxLOD = narrow_cast<u32>(LODs.size() - 1);
+}
+
 std::vector<PhysicsMesh> MeshAsset::createPhysicsMeshes(size_t lodIdx) const
 {
     ARKOSE_ASSERT(lodIdx < LODs.size());
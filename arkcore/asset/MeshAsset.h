@@ -58,6 +58,10 @@ public:
 
     void optimize();
 
+    // Create a simplified copy of this (processed) segment with approximately `targetIndexCount` indices, without exceeding
+    // `targetError` (relative to the extents of the segment). The resulting error, in mesh space units, is written to `outError`.
+    MeshSegmentAsset createSimplifiedSegment(size_t targetIndexCount, float targetError, float& outError) const;
+
     void generateMeshlets();
     void generateFlatNormals();
     void generateTangents();
@@ -137,6 +141,9 @@ public:
 
     // List of mesh segments to be rendered (at least one needed)
     std::vector<MeshSegmentAsset> meshSegments {};
+
+    // Max. geometric error (in mesh space units) compared to LOD0, for LODs generated by simplification
+    float simplificationError { 0.0f };
 };
 
 class MeshAsset final : public Asset<MeshAsset> {
@@ -159,6 +166,13 @@ public:
     template<class Archive>
     void serialize(Archive&, u32 version);
 
+    // Process all mesh segments of all LODs for import (see MeshSegmentAsset::processForImport), in parallel
+    void processForImport();
+
+    // Replace LOD1+ with a chain of LODs simplified from the (processed) LOD0, where each LOD targets `targetIndexRatio` of the
+    // indices of the previous LOD within `maxError` (relative to the segment extents). The chain ends early if it stops reducing.
+    void generateLODs(u32 lodCount, float targetIndexRatio, float maxError);
+
     std::vector<PhysicsMesh> createPhysicsMeshes(size_t lodIdx) const;
     PhysicsMesh createUnifiedPhysicsMesh(size_t lodIdx) const;
 
@@ -191,6 +205,8 @@ enum class MeshAssetVersion : u32 {
     AddOpacityMicroMaps,
     AddMorphTargets,
     AddMorphTargetNames,
+    FlatBinaryLayout,
+    AddLODSimplificationError,
     ////////////////////////////////////////////////////////////////////////////
     // Add new versions above this delimiter
     VersionCount,
@@ -272,6 +288,9 @@ template<class Archive>
 void MeshLODAsset::serialize(Archive& archive, u32 version)
 {
     archive(CEREAL_NVP(meshSegments));
+    if (version >= toUnderlying(MeshAssetVersion::AddLODSimplificationError)) {
+        archive(CEREAL_NVP(simplificationError));
+    }
 }
 
 template<class Archive>
@@ -0,0 +1,437 @@
+#include "MeshAssetFlatLayout.h"
+
+#include "asset/MeshAsset.h"
+#include "core/Logging.h"
+#include "core/parallel/ParallelFor.h"
+#include "utility/EnumHelpers.h"
+#include "utility/Profiling.h"
+#include <ark/core.h>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// The blobs are copied straight to and from memory, so we assume the file and the machine agree on the byte order
+static_assert(std::endian::native == std::endian::little);
+
+namespace {
+
+// All blobs start at a multiple of this, so the data is suitably aligned for any of its element types (and for SIMD)
+constexpr u64 BlobAlignment = 16;
+
+// Byte range of a blob within the file
+struct BlobRange {
+    u64 offset { 0 };
+    u64 size { 0 };
+};
+
+struct FileHeader {
+    std::array<char, 4> magicValue {};
+    u32 version { 0 };
+
+    u32 lodCount { 0 };
+    u32 segmentCount { 0 };
+    u32 morphTargetCount { 0 };
+
+    u32 minLOD { 0 };
+    u32 maxLOD { 0 };
+    u32 reserved { 0 };
+
+    float boundingBoxMin[3] {};
+    float boundingBoxMax[3] {};
+    float boundingSphere[4] {};
+
+    BlobRange name {};
+    BlobRange lodTable {};
+    BlobRange segmentTable {};
+    BlobRange morphTargetTable {};
+};
+
+struct LODRecord {
+    u32 firstSegment { 0 };
+    u32 segmentCount { 0 };
+    float simplificationError { 0.0f };
+    u32 reserved { 0 };
+};
+
+// LOD record as stored before MeshAssetVersion::AddLODSimplificationError
+struct LegacyLODRecord {
+    u32 firstSegment { 0 };
+    u32 segmentCount { 0 };
+};
+
+struct SegmentRecord {
+    static constexpr u32 HasMeshletData = 1u << 0;
+    static constexpr u32 HasOpacityMicroMapData = 1u << 1;
+
+    BlobRange positions {};
+    BlobRange texcoord0s {};
+    BlobRange normals {};
+    BlobRange tangents {};
+    BlobRange jointIndices {};
+    BlobRange jointWeights {};
+    BlobRange indices {};
+
+    BlobRange meshlets {};
+    BlobRange meshletVertexIndirection {};
+    BlobRange meshletIndices {};
+
+    BlobRange opacityMicroMapData {};
+
+    BlobRange material {};
+
+    u32 firstMorphTarget { 0 };
+    u32 morphTargetCount { 0 };
+
+    u32 flags { 0 };
+    u32 reserved { 0 };
+};
+
+struct MorphTargetRecord {
+    BlobRange name {};
+    BlobRange positions {};
+    BlobRange normals {};
+    BlobRange tangents {};
+};
+
+// NOTE: Changing any of these records changes the file format, which requires a new MeshAssetVersion!
+static_assert(sizeof(FileHeader) == 136);
+static_assert(sizeof(LODRecord) == 16);
+static_assert(sizeof(LegacyLODRecord) == 8);
+static_assert(sizeof(SegmentRecord) == 208);
+static_assert(sizeof(MorphTargetRecord) == 64);
+static_assert(sizeof(MeshletAsset) == 32);
+
+class LayoutWriter {
+public:
+    LayoutWriter()
+        : m_data(sizeof(FileHeader))
+    {
+    }
+
+    template<typename T>
+    BlobRange appendBlob(std::span<T const> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        u64 offset = ark::alignUp(static_cast<u64>(m_data.size()), BlobAlignment);
+        u64 size = values.size_bytes();
+
+        m_data.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(m_data.data() + offset, values.data(), size);
+        }
+
+        return BlobRange { .offset = offset, .size = size };
+    }
+
+    template<typename T>
+    BlobRange appendBlob(std::vector<T> const& values)
+    {
+        return appendBlob(std::span<T const>(values));
+    }
+
+    BlobRange appendString(std::string_view string)
+    {
+        return appendBlob(std::span<char const>(string.data(), string.size()));
+    }
+
+    std::vector<u8> finalize(FileHeader const& header)
+    {
+        std::memcpy(m_data.data(), &header, sizeof(FileHeader));
+        return std::move(m_data);
+    }
+
+private:
+    std::vector<u8> m_data;
+};
+
+class LayoutReader {
+public:
+    explicit LayoutReader(std::span<u8 const> data)
+        : m_data(data)
+    {
+    }
+
+    template<typename T>
+    bool readBlob(BlobRange range, std::vector<T>& outValues) const
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        if (!isValidRange(range) || range.size % sizeof(T) != 0) {
+            return false;
+        }
+
+        outValues.resize(range.size / sizeof(T));
+        if (range.size > 0) {
+            std::memcpy(outValues.data(), m_data.data() + range.offset, range.size);
+        }
+
+        return true;
+    }
+
+    bool readString(BlobRange range, std::string& outString) const
+    {
+        if (!isValidRange(range)) {
+            return false;
+        }
+
+        outString.assign(reinterpret_cast<char const*>(m_data.data() + range.offset), range.size);
+        return true;
+    }
+
+private:
+    bool isValidRange(BlobRange range) const
+    {
+        return range.offset <= m_data.size() && range.size <= m_data.size() - range.offset;
+    }
+
+    std::span<u8 const> m_data;
+};
+
+bool readSegment(LayoutReader const& reader, SegmentRecord const& segmentRecord, std::vector<MorphTargetRecord> const& morphTargetRecords, MeshSegmentAsset& segment)
+{
+    bool success = reader.readBlob(segmentRecord.positions, segment.positions)
+        && reader.readBlob(segmentRecord.texcoord0s, segment.texcoord0s)
+        && reader.readBlob(segmentRecord.normals, segment.normals)
+        && reader.readBlob(segmentRecord.tangents, segment.tangents)
+        && reader.readBlob(segmentRecord.jointIndices, segment.jointIndices)
+        && reader.readBlob(segmentRecord.jointWeights, segment.jointWeights)
+        && reader.readBlob(segmentRecord.indices, segment.indices)
+        && reader.readString(segmentRecord.material, segment.material);
+
+    // The segment may have been read into before (e.g. when reloading an already loaded asset), so don't let the optional
+    // data from previous contents survive if this segment doesn't have any
+    segment.meshletData.reset();
+    segment.opacityMicroMapData.reset();
+
+    if (success && (segmentRecord.flags & SegmentRecord::HasMeshletData)) {
+        MeshletDataAsset& meshletData = segment.meshletData.emplace();
+        success = reader.readBlob(segmentRecord.meshlets, meshletData.meshlets)
+            && reader.readBlob(segmentRecord.meshletVertexIndirection, meshletData.meshletVertexIndirection)
+            && reader.readBlob(segmentRecord.meshletIndices, meshletData.meshletIndices);
+    }
+
+    if (success && (segmentRecord.flags & SegmentRecord::HasOpacityMicroMapData)) {
+        OpacityMicroMapDataAsset& ommData = segment.opacityMicroMapData.emplace();
+        success = reader.readBlob(segmentRecord.opacityMicroMapData, ommData.ommSdkSerializedData);
+    }
+
+    if (static_cast<u64>(segmentRecord.firstMorphTarget) + segmentRecord.morphTargetCount > morphTargetRecords.size()) {
+        return false;
+    }
+
+    segment.morphTargets.resize(segmentRecord.morphTargetCount);
+    for (u32 idx = 0; success && idx < segmentRecord.morphTargetCount; ++idx) {
+        MorphTargetRecord const& morphTargetRecord = morphTargetRecords[segmentRecord.firstMorphTarget + idx];
+        MorphTargetAsset& morphTarget = segment.morphTargets[idx];
+
+        success = reader.readString(morphTargetRecord.name, morphTarget.name)
+            && reader.readBlob(morphTargetRecord.positions, morphTarget.positions)
+            && reader.readBlob(morphTargetRecord.normals, morphTarget.normals)
+            && reader.readBlob(morphTargetRecord.tangents, morphTarget.tangents);
+    }
+
+    return success;
+}
+
+}
+
+bool MeshAssetFlatLayout::isFlatLayout(std::span<u8 const> fileData)
+{
+    if (fileData.size() < sizeof(FileHeader)) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, fileData.data(), sizeof(FileHeader));
+
+    // Older binary files store the cereal class version right after the magic value, where we now have the version,
+    // so any version before the flat layout was introduced means it's a cereal binary archive.
+    return header.magicValue == MeshAsset::AssetMagicValue
+        && header.version >= toUnderlying(MeshAssetVersion::FlatBinaryLayout);
+}
+
+bool MeshAssetFlatLayout::read(std::span<u8 const> fileData, MeshAsset& meshAsset, std::filesystem::path const& filePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    if (!isFlatLayout(fileData)) {
+        ARKOSE_LOG(Error, "Mesh asset '{}' is not in the flat binary layout", filePath);
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, fileData.data(), sizeof(FileHeader));
+
+    if (header.version > toUnderlying(MeshAssetVersion::LatestVersion)) {
+        ARKOSE_LOG(Error, "Mesh asset '{}' has version {} which is newer than the latest known version {}, can't read it",
+                   filePath, header.version, toUnderlying(MeshAssetVersion::LatestVersion));
+        return false;
+    }
+
+    LayoutReader reader { fileData };
+
+    std::vector<LODRecord> lodRecords {};
+    std::vector<SegmentRecord> segmentRecords {};
+    std::vector<MorphTargetRecord> morphTargetRecords {};
+
+    bool validLodTable = false;
+    if (header.version >= toUnderlying(MeshAssetVersion::AddLODSimplificationError)) {
+        validLodTable = reader.readBlob(header.lodTable, lodRecords);
+    } else {
+        std::vector<LegacyLODRecord> legacyLodRecords {};
+        validLodTable = reader.readBlob(header.lodTable, legacyLodRecords);
+        for (LegacyLODRecord const& legacyLodRecord : legacyLodRecords) {
+            lodRecords.push_back(LODRecord { .firstSegment = legacyLodRecord.firstSegment,
+                                             .segmentCount = legacyLodRecord.segmentCount });
+        }
+    }
+
+    bool validTables = validLodTable && lodRecords.size() == header.lodCount
+        && reader.readBlob(header.segmentTable, segmentRecords) && segmentRecords.size() == header.segmentCount
+        && reader.readBlob(header.morphTargetTable, morphTargetRecords) && morphTargetRecords.size() == header.morphTargetCount
+        && reader.readString(header.name, meshAsset.name);
+
+    if (!validTables) {
+        ARKOSE_LOG(Error, "Mesh asset '{}' is corrupt (invalid header or tables)", filePath);
+        return false;
+    }
+
+    meshAsset.minLOD = header.minLOD;
+    meshAsset.maxLOD = header.maxLOD;
+
+    meshAsset.boundingBox = ark::aabb3(vec3(header.boundingBoxMin[0], header.boundingBoxMin[1], header.boundingBoxMin[2]),
+                                       vec3(header.boundingBoxMax[0], header.boundingBoxMax[1], header.boundingBoxMax[2]));
+    meshAsset.boundingSphere = geometry::Sphere(vec3(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2]),
+                                                header.boundingSphere[3]);
+
+    // Create all segments up front, so that their data can then be read in parallel
+    std::vector<MeshSegmentAsset*> segments {};
+    segments.reserve(segmentRecords.size());
+
+    meshAsset.LODs.resize(lodRecords.size());
+    for (size_t lodIdx = 0; lodIdx < lodRecords.size(); ++lodIdx) {
+        LODRecord const& lodRecord = lodRecords[lodIdx];
+
+        // The segments of the LODs are stored in order, one LOD after the other
+        if (lodRecord.firstSegment != segments.size() || lodRecord.segmentCount > segmentRecords.size() - segments.size()) {
+            ARKOSE_LOG(Error, "Mesh asset '{}' is corrupt (invalid segment range for LOD{})", filePath, lodIdx);
+            return false;
+        }
+
+        MeshLODAsset& lod = meshAsset.LODs[lodIdx];
+        lod.simplificationError = lodRecord.simplificationError;
+        lod.meshSegments.resize(lodRecord.segmentCount);
+        for (MeshSegmentAsset& segment : lod.meshSegments) {
+            segments.push_back(&segment);
+        }
+    }
+
+    if (segments.size() != segmentRecords.size()) {
+        ARKOSE_LOG(Error, "Mesh asset '{}' is corrupt (segments not referenced by any LOD)", filePath);
+        return false;
+    }
+
+    std::vector<u8> segmentReadSuccess(segments.size(), 0);
+    ParallelFor(segments.size(), [&](size_t segmentIdx) {
+        segmentReadSuccess[segmentIdx] = readSegment(reader, segmentRecords[segmentIdx], morphTargetRecords, *segments[segmentIdx]);
+    });
+
+    for (size_t segmentIdx = 0; segmentIdx < segments.size(); ++segmentIdx) {
+        if (!segmentReadSuccess[segmentIdx]) {
+            ARKOSE_LOG(Error, "Mesh asset '{}' is corrupt (invalid data for segment {})", filePath, segmentIdx);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<u8> MeshAssetFlatLayout::write(MeshAsset const& meshAsset)
+{
+    SCOPED_PROFILE_ZONE();
+
+    LayoutWriter writer {};
+
+    std::vector<LODRecord> lodRecords {};
+    std::vector<SegmentRecord> segmentRecords {};
+    std::vector<MorphTargetRecord> morphTargetRecords {};
+
+    for (MeshLODAsset const& lod : meshAsset.LODs) {
+
+        lodRecords.push_back(LODRecord { .firstSegment = narrow_cast<u32>(segmentRecords.size()),
+                                         .segmentCount = narrow_cast<u32>(lod.meshSegments.size()),
+                                         .simplificationError = lod.simplificationError });
+
+        for (MeshSegmentAsset const& segment : lod.meshSegments) {
+            SegmentRecord segmentRecord {};
+
+            segmentRecord.positions = writer.appendBlob(segment.positions);
+            segmentRecord.texcoord0s = writer.appendBlob(segment.texcoord0s);
+            segmentRecord.normals = writer.appendBlob(segment.normals);
+            segmentRecord.tangents = writer.appendBlob(segment.tangents);
+            segmentRecord.jointIndices = writer.appendBlob(segment.jointIndices);
+            segmentRecord.jointWeights = writer.appendBlob(segment.jointWeights);
+            segmentRecord.indices = writer.appendBlob(segment.indices);
+
+            if (segment.meshletData.has_value()) {
+                segmentRecord.flags |= SegmentRecord::HasMeshletData;
+                segmentRecord.meshlets = writer.appendBlob(segment.meshletData->meshlets);
+                segmentRecord.meshletVertexIndirection = writer.appendBlob(segment.meshletData->meshletVertexIndirection);
+                segmentRecord.meshletIndices = writer.appendBlob(segment.meshletData->meshletIndices);
+            }
+
+            if (segment.opacityMicroMapData.has_value()) {
+                segmentRecord.flags |= SegmentRecord::HasOpacityMicroMapData;
+                segmentRecord.opacityMicroMapData = writer.appendBlob(segment.opacityMicroMapData->ommSdkSerializedData);
+            }
+
+            segmentRecord.material = writer.appendString(segment.material);
+
+            segmentRecord.firstMorphTarget = narrow_cast<u32>(morphTargetRecords.size());
+            segmentRecord.morphTargetCount = narrow_cast<u32>(segment.morphTargets.size());
+
+            for (MorphTargetAsset const& morphTarget : segment.morphTargets) {
+                morphTargetRecords.push_back(MorphTargetRecord { .name = writer.appendString(morphTarget.name),
+                                                                 .positions = writer.appendBlob(morphTarget.positions),
+                                                                 .normals = writer.appendBlob(morphTarget.normals),
+                                                                 .tangents = writer.appendBlob(morphTarget.tangents) });
+            }
+
+            segmentRecords.push_back(segmentRecord);
+        }
+    }
+
+    FileHeader header {};
+    header.magicValue = MeshAsset::AssetMagicValue;
+    header.version = toUnderlying(MeshAssetVersion::LatestVersion);
+
+    header.lodCount = narrow_cast<u32>(lodRecords.size());
+    header.segmentCount = narrow_cast<u32>(segmentRecords.size());
+    header.morphTargetCount = narrow_cast<u32>(morphTargetRecords.size());
+
+    header.minLOD = meshAsset.minLOD;
+    header.maxLOD = meshAsset.maxLOD;
+
+    header.boundingBoxMin[0] = meshAsset.boundingBox.min.x;
+    header.boundingBoxMin[1] = meshAsset.boundingBox.min.y;
+    header.boundingBoxMin[2] = meshAsset.boundingBox.min.z;
+    header.boundingBoxMax[0] = meshAsset.boundingBox.max.x;
+    header.boundingBoxMax[1] = meshAsset.boundingBox.max.y;
+    header.boundingBoxMax[2] = meshAsset.boundingBox.max.z;
+
+    header.boundingSphere[0] = meshAsset.boundingSphere.center().x;
+    header.boundingSphere[1] = meshAsset.boundingSphere.center().y;
+    header.boundingSphere[2] = meshAsset.boundingSphere.center().z;
+    header.boundingSphere[3] = meshAsset.boundingSphere.radius();
+
+    header.name = writer.appendString(meshAsset.name);
+    header.lodTable = writer.appendBlob(lodRecords);
+    header.segmentTable = writer.appendBlob(segmentRecords);
+    header.morphTargetTable = writer.appendBlob(morphTargetRecords);
+
+    return writer.finalize(header);
+}
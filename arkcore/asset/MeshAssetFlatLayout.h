@@ -0,0 +1,20 @@
+#pragma once
+
+#include "core/Types.h"
+#include <filesystem>
+#include <span>
+#include <vector>
+
+class MeshAsset;
+
+// Binary .arkmsh layout (since MeshAssetVersion::FlatBinaryLayout). The file starts with a fixed-size header followed by
+// tables of fixed-size LOD, segment & morph target records, which refer to the actual data by byte offset and size. All
+// vertex, index & meshlet data is stored as aligned, contiguous blobs, so loading a mesh is a matter of mapping the file
+// and copying out the blobs in bulk, without having to parse the data element by element.
+namespace MeshAssetFlatLayout {
+    // Returns true if the data (i.e., the contents of an .arkmsh file) is stored in the flat binary layout
+    bool isFlatLayout(std::span<u8 const> fileData);
+
+    bool read(std::span<u8 const> fileData, MeshAsset&, std::filesystem::path const& filePath);
+    std::vector<u8> write(MeshAsset const&);
+}
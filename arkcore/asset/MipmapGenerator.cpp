@@ -0,0 +1,516 @@
+#include "MipmapGenerator.h"
+
+#include "core/Assert.h"
+#include "core/Logging.h"
+#include "core/parallel/ParallelFor.h"
+#include "utility/Profiling.h"
+#include <ark/color.h>
+#include <array>
+#include <fmt/format.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPMAP_GENERATOR_USE_SSE 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(MIPMAP_GENERATOR_USE_SSE) && defined(__AVX__)
+#define MIPMAP_GENERATOR_USE_AVX 1
+#endif
+
+namespace {
+
+// Number of destination pixels we aim to process per task when filtering a mip level in parallel
+constexpr size_t PixelsPerBand = 16 * 1024;
+
+// Size of the table used for encoding linear values to sRGB. With this many entries the encoded value is at most off
+// by a single step from the exact result, even in the dark range where the sRGB curve is the steepest.
+constexpr size_t SRGBEncodeTableSize = 8192;
+
+struct DecodeTables {
+    std::array<float, 256> linear {};
+    std::array<float, 256> sRGB {};
+    std::array<u8, SRGBEncodeTableSize> sRGBEncode {};
+};
+
+DecodeTables const& decodeTables()
+{
+    static DecodeTables const tables = []() {
+        DecodeTables tables {};
+
+        for (size_t value = 0; value < 256; ++value) {
+            float normalizedValue = static_cast<float>(value) / 255.0f;
+            tables.linear[value] = normalizedValue;
+            tables.sRGB[value] = ark::colorspace::sRGB::gammaDecode(normalizedValue);
+        }
+
+        for (size_t idx = 0; idx < SRGBEncodeTableSize; ++idx) {
+            float linearValue = static_cast<float>(idx) / static_cast<float>(SRGBEncodeTableSize - 1);
+            float encodedValue = ark::colorspace::sRGB::gammaEncode(linearValue);
+            tables.sRGBEncode[idx] = static_cast<u8>(std::clamp(encodedValue * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+
+        return tables;
+    }();
+
+    return tables;
+}
+
+u8 encodeLinearUnorm8(float value)
+{
+    return static_cast<u8>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+u8 encodeSRGBUnorm8(float value, DecodeTables const& tables)
+{
+    size_t tableIdx = static_cast<size_t>(std::clamp(value, 0.0f, 1.0f) * static_cast<float>(SRGBEncodeTableSize - 1) + 0.5f);
+    return tables.sRGBEncode[tableIdx];
+}
+
+void decodeRow(float* dst, u8 const* src, u32 width, u32 componentCount, u32 sRGBComponentCount, DecodeTables const& tables)
+{
+    for (u32 x = 0; x < width; ++x) {
+        for (u32 componentIdx = 0; componentIdx < componentCount; ++componentIdx) {
+            u8 value = src[componentIdx];
+            dst[componentIdx] = componentIdx < sRGBComponentCount ? tables.sRGB[value] : tables.linear[value];
+        }
+        dst += componentCount;
+        src += componentCount;
+    }
+}
+
+void encodeRow(u8* dst, float const* src, u32 width, u32 componentCount, u32 sRGBComponentCount, DecodeTables const& tables)
+{
+    for (u32 x = 0; x < width; ++x) {
+        for (u32 componentIdx = 0; componentIdx < componentCount; ++componentIdx) {
+            float value = src[componentIdx];
+            dst[componentIdx] = componentIdx < sRGBComponentCount ? encodeSRGBUnorm8(value, tables) : encodeLinearUnorm8(value);
+        }
+        dst += componentCount;
+        src += componentCount;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Filters
+
+// Radius of the filter kernel, in destination pixels
+float filterRadius(MipmapFilter filter)
+{
+    switch (filter) {
+    case MipmapFilter::Box:
+        return 0.5f;
+    case MipmapFilter::Kaiser:
+    case MipmapFilter::Lanczos:
+        return 3.0f;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+float sinc(float x)
+{
+    if (std::abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+    return std::sin(x) / x;
+}
+
+// Zeroth order modified Bessel function of the first kind (series expansion)
+float bessel0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    float halfX = x / 2.0f;
+    for (int k = 1; k < 32; ++k) {
+        float factor = halfX / static_cast<float>(k);
+        term *= factor * factor;
+        sum += term;
+        if (term < sum * 1e-7f) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Evaluate the (non-normalized) filter at `x` destination pixels from the center of the kernel
+float evaluateFilter(MipmapFilter filter, float x)
+{
+    switch (filter) {
+    case MipmapFilter::Kaiser: {
+        constexpr float Width = 3.0f;
+        constexpr float Alpha = 4.0f;
+        float t = x / Width;
+        if (t * t >= 1.0f) {
+            return 0.0f;
+        }
+        return sinc(ark::PI * x) * bessel0(Alpha * std::sqrt(1.0f - t * t)) / bessel0(Alpha);
+    }
+    case MipmapFilter::Lanczos: {
+        constexpr float Lobes = 3.0f;
+        if (std::abs(x) >= Lobes) {
+            return 0.0f;
+        }
+        return sinc(ark::PI * x) * sinc(ark::PI * x / Lobes);
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+// For every destination pixel along one axis, the range of source pixels and their weights. Source pixels outside of
+// the image are clamped to the edge, so all taps of a destination pixel are in a contiguous range of source pixels.
+struct FilterTaps {
+    u32 maxTapCount { 0 };
+    std::vector<u32> firstSourceIdx {};
+    std::vector<u32> tapCount {};
+    std::vector<float> weights {};
+
+    float const* weightsForPixel(u32 destinationIdx) const { return weights.data() + destinationIdx * maxTapCount; }
+};
+
+FilterTaps computeFilterTaps(u32 sourceSize, u32 destinationSize, MipmapFilter filter)
+{
+    FilterTaps taps {};
+
+    taps.firstSourceIdx.resize(destinationSize);
+    taps.tapCount.resize(destinationSize);
+
+    if (sourceSize == destinationSize) {
+        // This axis is already at its smallest size (1) while the other one keeps shrinking
+        taps.maxTapCount = 1;
+        taps.weights.resize(destinationSize, 1.0f);
+        for (u32 idx = 0; idx < destinationSize; ++idx) {
+            taps.firstSourceIdx[idx] = idx;
+            taps.tapCount[idx] = 1;
+        }
+        return taps;
+    }
+
+    ARKOSE_ASSERT(sourceSize > destinationSize);
+
+    float scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+    float sourceRadius = filterRadius(filter) * scale;
+
+    taps.maxTapCount = static_cast<u32>(std::ceil(2.0f * sourceRadius)) + 2;
+    taps.weights.resize(destinationSize * taps.maxTapCount, 0.0f);
+
+    i32 lastSourceIdx = static_cast<i32>(sourceSize) - 1;
+
+    for (u32 destinationIdx = 0; destinationIdx < destinationSize; ++destinationIdx) {
+
+        float center = (static_cast<float>(destinationIdx) + 0.5f) * scale;
+        i32 firstIdx = static_cast<i32>(std::floor(center - sourceRadius));
+        i32 lastIdx = static_cast<i32>(std::ceil(center + sourceRadius)) - 1;
+
+        i32 firstClampedIdx = std::clamp(firstIdx, 0, lastSourceIdx);
+        i32 lastClampedIdx = std::clamp(lastIdx, 0, lastSourceIdx);
+        ARKOSE_ASSERT(lastClampedIdx - firstClampedIdx + 1 <= static_cast<i32>(taps.maxTapCount));
+
+        float* weights = taps.weights.data() + destinationIdx * taps.maxTapCount;
+        float weightSum = 0.0f;
+
+        for (i32 sourceIdx = firstIdx; sourceIdx <= lastIdx; ++sourceIdx) {
+
+            float weight;
+            if (filter == MipmapFilter::Box) {
+                // Weight by how much of the source pixel is covered by the destination pixel's footprint
+                float footprintMin = center - sourceRadius;
+                float footprintMax = center + sourceRadius;
+                float coverageMin = std::max(static_cast<float>(sourceIdx), footprintMin);
+                float coverageMax = std::min(static_cast<float>(sourceIdx + 1), footprintMax);
+                weight = std::max(0.0f, coverageMax - coverageMin);
+            } else {
+                float x = (static_cast<float>(sourceIdx) + 0.5f - center) / scale;
+                weight = evaluateFilter(filter, x);
+            }
+
+            i32 clampedIdx = std::clamp(sourceIdx, 0, lastSourceIdx);
+            weights[clampedIdx - firstClampedIdx] += weight;
+            weightSum += weight;
+        }
+
+        if (weightSum != 0.0f) {
+            for (i32 tapIdx = 0; tapIdx <= lastClampedIdx - firstClampedIdx; ++tapIdx) {
+                weights[tapIdx] /= weightSum;
+            }
+        }
+
+        taps.firstSourceIdx[destinationIdx] = static_cast<u32>(firstClampedIdx);
+        taps.tapCount[destinationIdx] = static_cast<u32>(lastClampedIdx - firstClampedIdx + 1);
+    }
+
+    return taps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Row kernels
+
+// dst[i] += weight * src[i] for all i in [0, count)
+void accumulateScaledRow(float* dst, float const* src, float weight, size_t count)
+{
+    size_t idx = 0;
+
+#if defined(MIPMAP_GENERATOR_USE_AVX)
+    __m256 weight8 = _mm256_set1_ps(weight);
+    for (; idx + 8 <= count; idx += 8) {
+        __m256 value = _mm256_mul_ps(_mm256_loadu_ps(src + idx), weight8);
+        _mm256_storeu_ps(dst + idx, _mm256_add_ps(_mm256_loadu_ps(dst + idx), value));
+    }
+#endif
+
+#if defined(MIPMAP_GENERATOR_USE_SSE)
+    __m128 weight4 = _mm_set1_ps(weight);
+    for (; idx + 4 <= count; idx += 4) {
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(src + idx), weight4);
+        _mm_storeu_ps(dst + idx, _mm_add_ps(_mm_loadu_ps(dst + idx), value));
+    }
+#endif
+
+    for (; idx < count; ++idx) {
+        dst[idx] += weight * src[idx];
+    }
+}
+
+template<u32 ComponentCount>
+void filterRowHorizontally(float* dst, float const* src, FilterTaps const& taps, u32 destinationWidth)
+{
+    for (u32 x = 0; x < destinationWidth; ++x) {
+
+        float const* weights = taps.weightsForPixel(x);
+        float const* sourcePixels = src + taps.firstSourceIdx[x] * ComponentCount;
+        u32 tapCount = taps.tapCount[x];
+
+#if defined(MIPMAP_GENERATOR_USE_SSE)
+        if constexpr (ComponentCount == 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (u32 tapIdx = 0; tapIdx < tapCount; ++tapIdx) {
+                __m128 pixel = _mm_loadu_ps(sourcePixels + tapIdx * 4);
+                sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(weights[tapIdx])));
+            }
+            _mm_storeu_ps(dst + x * 4, sum);
+            continue;
+        }
+#endif
+
+        std::array<float, ComponentCount> sum {};
+        for (u32 tapIdx = 0; tapIdx < tapCount; ++tapIdx) {
+            for (u32 componentIdx = 0; componentIdx < ComponentCount; ++componentIdx) {
+                sum[componentIdx] += weights[tapIdx] * sourcePixels[tapIdx * ComponentCount + componentIdx];
+            }
+        }
+        for (u32 componentIdx = 0; componentIdx < ComponentCount; ++componentIdx) {
+            dst[x * ComponentCount + componentIdx] = sum[componentIdx];
+        }
+    }
+}
+
+void filterRowHorizontally(float* dst, float const* src, FilterTaps const& taps, u32 destinationWidth, u32 componentCount)
+{
+    switch (componentCount) {
+    case 1:
+        filterRowHorizontally<1>(dst, src, taps, destinationWidth);
+        break;
+    case 2:
+        filterRowHorizontally<2>(dst, src, taps, destinationWidth);
+        break;
+    case 3:
+        filterRowHorizontally<3>(dst, src, taps, destinationWidth);
+        break;
+    case 4:
+        filterRowHorizontally<4>(dst, src, taps, destinationWidth);
+        break;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+// Normal maps are stored as unorm values in [0, 1], so they have to be remapped to [-1, +1] before normalizing
+void renormalizeRow(float* row, u32 width, u32 componentCount)
+{
+    ARKOSE_ASSERT(componentCount >= 3);
+    for (u32 x = 0; x < width; ++x) {
+        float* pixel = row + x * componentCount;
+        ark::vec3 normal = ark::vec3(pixel[0], pixel[1], pixel[2]) * 2.0f - ark::vec3(1.0f);
+        float length = ark::length(normal);
+        if (length > 1e-6f) {
+            normal = normal / length;
+        } else {
+            normal = ark::vec3(0.0f, 0.0f, 1.0f);
+        }
+        pixel[0] = normal.x * 0.5f + 0.5f;
+        pixel[1] = normal.y * 0.5f + 0.5f;
+        pixel[2] = normal.z * 0.5f + 0.5f;
+    }
+}
+
+}
+
+MipmapGenerator::MipmapGenerator(ImageFormat format, ImageType type, MipmapFilter filter)
+    : m_format(format)
+    , m_filter(filter)
+{
+    switch (format) {
+    case ImageFormat::R8:
+    case ImageFormat::RG8:
+    case ImageFormat::RGB8:
+    case ImageFormat::RGBA8:
+        m_componentCount = static_cast<u32>(format) - static_cast<u32>(ImageFormat::R8) + 1;
+        m_floatComponents = false;
+        break;
+    case ImageFormat::R32F:
+    case ImageFormat::RG32F:
+    case ImageFormat::RGB32F:
+    case ImageFormat::RGBA32F:
+        m_componentCount = static_cast<u32>(format) - static_cast<u32>(ImageFormat::R32F) + 1;
+        m_floatComponents = true;
+        break;
+    default:
+        // Unsupported (i.e., block compressed) formats are reported in generateMipChain
+        break;
+    }
+
+    // Filter sRGB encoded images in linear space. Only 8-bit formats are stored with the sRGB transfer function, and
+    // two-component images are grayscale-alpha, just like the four-component images have alpha in the last component.
+    if (type == ImageType::sRGBColor && !m_floatComponents) {
+        bool hasAlpha = m_componentCount == 2 || m_componentCount == 4;
+        m_sRGBComponentCount = hasAlpha ? m_componentCount - 1 : m_componentCount;
+    }
+
+    m_renormalize = type == ImageType::NormalMap && !m_floatComponents && m_componentCount >= 3;
+}
+
+u32 MipmapGenerator::mipLevelCountForExtent(Extent3D extent)
+{
+    u32 maxDimension = std::max({ extent.width(), extent.height(), extent.depth() });
+
+    u32 levelCount = 1;
+    while ((maxDimension >> levelCount) > 0) {
+        levelCount += 1;
+    }
+
+    return levelCount;
+}
+
+bool MipmapGenerator::generateMipChain(Extent3D extent, std::vector<u8>& pixelData, std::vector<ImageMip>& mips) const
+{
+    SCOPED_PROFILE_ZONE();
+
+    if (m_componentCount == 0) {
+        ARKOSE_LOG(Error, "MipmapGenerator: can't generate mipmaps for image format {}", m_format);
+        return false;
+    }
+
+    if (extent.depth() != 1) {
+        ARKOSE_LOG(Error, "MipmapGenerator: mipmap generation for 3D images is not yet implemented");
+        return false;
+    }
+
+    size_t bytesPerComponent = m_floatComponents ? sizeof(float) : sizeof(u8);
+    size_t bytesPerPixel = m_componentCount * bytesPerComponent;
+
+    size_t firstMipSize = extent.width() * extent.height() * bytesPerPixel;
+    if (pixelData.size() < firstMipSize) {
+        ARKOSE_LOG(Error, "MipmapGenerator: pixel data is too small for the image extent");
+        return false;
+    }
+
+    // Lay out all mips up front so we can allocate the final buffer once and write every level directly into it
+    u32 levelCount = mipLevelCountForExtent(extent);
+    std::vector<Extent2D> levelExtents {};
+    mips.clear();
+
+    size_t totalSize = 0;
+    for (u32 level = 0; level < levelCount; ++level) {
+        u32 levelWidth = std::max(extent.width() >> level, 1u);
+        u32 levelHeight = std::max(extent.height() >> level, 1u);
+        levelExtents.emplace_back(levelWidth, levelHeight);
+
+        size_t levelSize = levelWidth * levelHeight * bytesPerPixel;
+        mips.push_back(ImageMip { .offset = totalSize,
+                                  .size = levelSize });
+        totalSize += levelSize;
+    }
+
+    pixelData.resize(totalSize);
+
+    DecodeTables const& tables = decodeTables();
+    u32 componentCount = m_componentCount;
+
+    for (u32 level = 1; level < levelCount; ++level) {
+
+        std::string zoneName = fmt::format("Mip level {}", level);
+        SCOPED_PROFILE_ZONE_DYNAMIC(zoneName, 0xaa5577);
+
+        Extent2D sourceExtent = levelExtents[level - 1];
+        Extent2D destinationExtent = levelExtents[level];
+
+        FilterTaps horizontalTaps = computeFilterTaps(sourceExtent.width(), destinationExtent.width(), m_filter);
+        FilterTaps verticalTaps = computeFilterTaps(sourceExtent.height(), destinationExtent.height(), m_filter);
+
+        u8 const* sourceData = pixelData.data() + mips[level - 1].offset;
+        u8* destinationData = pixelData.data() + mips[level].offset;
+
+        size_t sourceRowComponents = sourceExtent.width() * componentCount;
+        size_t destinationRowComponents = destinationExtent.width() * componentCount;
+
+        // Each band of destination rows is filtered by a single task, so the scratch rows only have to be allocated once per band
+        size_t rowsPerBand = std::max(PixelsPerBand / destinationExtent.width(), size_t(1));
+        size_t bandCount = ark::divideAndRoundUp(size_t(destinationExtent.height()), rowsPerBand);
+
+        ParallelFor(bandCount, [&](size_t bandIdx) {
+
+            std::vector<float> decodedRow {};
+            if (!m_floatComponents) {
+                decodedRow.resize(sourceRowComponents);
+            }
+
+            std::vector<float> verticallyFilteredRow(sourceRowComponents);
+            std::vector<float> filteredRow(destinationRowComponents);
+
+            u32 firstRow = static_cast<u32>(bandIdx * rowsPerBand);
+            u32 lastRow = std::min(static_cast<u32>(firstRow + rowsPerBand), destinationExtent.height());
+
+            for (u32 y = firstRow; y < lastRow; ++y) {
+
+                // Filter vertically first, so that each source row only has to be read once per destination row
+                std::fill(verticallyFilteredRow.begin(), verticallyFilteredRow.end(), 0.0f);
+
+                float const* weights = verticalTaps.weightsForPixel(y);
+                for (u32 tapIdx = 0; tapIdx < verticalTaps.tapCount[y]; ++tapIdx) {
+                    u32 sourceY = verticalTaps.firstSourceIdx[y] + tapIdx;
+
+                    float const* sourceRow;
+                    if (m_floatComponents) {
+                        sourceRow = reinterpret_cast<float const*>(sourceData) + sourceY * sourceRowComponents;
+                    } else {
+                        u8 const* encodedRow = sourceData + sourceY * sourceRowComponents;
+                        decodeRow(decodedRow.data(), encodedRow, sourceExtent.width(), componentCount, m_sRGBComponentCount, tables);
+                        sourceRow = decodedRow.data();
+                    }
+
+                    accumulateScaledRow(verticallyFilteredRow.data(), sourceRow, weights[tapIdx], sourceRowComponents);
+                }
+
+                filterRowHorizontally(filteredRow.data(), verticallyFilteredRow.data(), horizontalTaps, destinationExtent.width(), componentCount);
+
+                if (m_renormalize) {
+                    renormalizeRow(filteredRow.data(), destinationExtent.width(), componentCount);
+                }
+
+                if (m_floatComponents) {
+                    float* destinationRow = reinterpret_cast<float*>(destinationData) + y * destinationRowComponents;
+                    std::copy(filteredRow.begin(), filteredRow.end(), destinationRow);
+                } else {
+                    u8* destinationRow = destinationData + y * destinationRowComponents;
+                    encodeRow(destinationRow, filteredRow.data(), destinationExtent.width(), componentCount, m_sRGBComponentCount, tables);
+                }
+            }
+        });
+    }
+
+    return true;
+}
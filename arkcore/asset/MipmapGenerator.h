@@ -0,0 +1,31 @@
+#pragma once
+
+#include "asset/ImageAsset.h"
+#include <vector>
+
+// Generates full mip chains for images in any of the uncompressed image formats, including non-power-of-two sizes.
+// Every level is resampled from the level above it with a separable filter, and all levels are written into a single
+// preallocated pixel data buffer. The rows of each level are filtered in parallel using the task graph (if available).
+class MipmapGenerator {
+public:
+    MipmapGenerator(ImageFormat, ImageType, MipmapFilter);
+    ~MipmapGenerator() = default;
+
+    // Number of mip levels in a full mip chain (down to 1x1) for an image of the given extent
+    static u32 mipLevelCountForExtent(Extent3D);
+
+    // Generate a full mip chain for the first mip level, which is expected to be at the start of `pixelData`. The pixel
+    // data buffer is resized to fit all the mips and `mips` will describe the full chain, including the first level.
+    bool generateMipChain(Extent3D, std::vector<u8>& pixelData, std::vector<ImageMip>& mips) const;
+
+private:
+    ImageFormat m_format;
+    MipmapFilter m_filter;
+
+    u32 m_componentCount { 0 };
+    bool m_floatComponents { false };
+
+    // Number of components that are affected by the sRGB transfer function (i.e., all but alpha)
+    u32 m_sRGBComponentCount { 0 };
+    bool m_renormalize { false };
+};
@@ -3,58 +3,112 @@
 #include "asset/ImageAsset.h"
 #include "core/Assert.h"
 #include "core/Logging.h"
+#include "core/parallel/ParallelFor.h"
 #include "utility/Profiling.h"
-#include <fmt/format.h>
-#include <rdo_bc_encoder.h>
+#include <array>
 #include <bc7decomp.h>
-#include <thread>
+#include <bc7enc.h>
+#include <cstring>
+#include <mutex>
+#include <rgbcx.h>
 
-static std::unique_ptr<ImageAsset> compressWithParams(ImageAsset const& inputImage, ImageFormat compressedFormat, rdo_bc::rdo_bc_params params)
-{
-    std::vector<u8> compressedPixelData {};
-    std::vector<ImageMip> compressedMips {};
+namespace {
 
-    for (size_t mipIdx = 0; mipIdx < inputImage.numMips(); ++mipIdx) {
+constexpr u32 BlockDimension = 4;
 
-        std::string zoneName = fmt::format("Mip level {}", mipIdx);
-        SCOPED_PROFILE_ZONE_DYNAMIC(zoneName, 0xaa5577);
+// Number of blocks we aim to compress per task. A tile is made up of whole block rows of a single mip, and the tiles of
+// all mips are compressed at the same time, so even a single large image will make use of all worker threads.
+constexpr u32 BlocksPerTile = 256;
 
-        auto pixelData = inputImage.pixelDataForMip(mipIdx);
+void initializeEncoders()
+{
+    // The encoders set up global lookup tables, so make sure that only happens once, even if compressing on many threads
+    static std::once_flag s_encodersInitialized;
+    std::call_once(s_encodersInitialized, []() {
+        bc7enc_compress_block_init();
+        rgbcx::init();
+    });
+}
 
-        // Create an image that can be used by the encoder
-        Extent3D mipExtent = inputImage.extentAtMip(mipIdx);
-        utils::image_u8 sourceImage { mipExtent.width(), mipExtent.height() };
-        std::memcpy(sourceImage.get_pixels().data(), pixelData.data(), pixelData.size());
+struct CompressionTile {
+    u32 mipIdx;
+    u32 firstBlockRow;
+    u32 blockRowCount;
+};
 
-        rdo_bc::rdo_bc_encoder encoder {};
+using BlockPixels = std::array<u8, BlockDimension * BlockDimension * 4>;
 
-        if (!encoder.init(sourceImage, params)) {
-            ARKOSE_LOG(Error, "Failed to init encoder");
-            return nullptr;
+// Gather the RGBA8 pixels of a block, clamping to the edge for blocks that extend past the edge of the mip
+void gatherBlockPixels(BlockPixels& blockPixels, std::span<u8 const> mipPixels, Extent3D mipExtent, u32 blockX, u32 blockY)
+{
+    for (u32 y = 0; y < BlockDimension; ++y) {
+        u32 pixelY = std::min(blockY * BlockDimension + y, mipExtent.height() - 1);
+        for (u32 x = 0; x < BlockDimension; ++x) {
+            u32 pixelX = std::min(blockX * BlockDimension + x, mipExtent.width() - 1);
+            u8 const* pixel = mipPixels.data() + (pixelY * mipExtent.width() + pixelX) * 4;
+            std::memcpy(blockPixels.data() + (y * BlockDimension + x) * 4, pixel, 4);
         }
+    }
+}
 
-        if (!encoder.encode()) {
-            ARKOSE_LOG(Error, "Failed to encode/compress image");
-            return nullptr;
-        }
+template<typename EncodeBlockFunction>
+std::unique_ptr<ImageAsset> compressBlocks(ImageAsset const& inputImage, ImageFormat compressedFormat, EncodeBlockFunction&& encodeBlock)
+{
+    initializeEncoders();
 
-        u32 compressedMipSize = encoder.get_total_blocks_size_in_bytes();
-        u8 const* compressedMipData = static_cast<u8 const*>(encoder.get_blocks());
+    u32 blockSize = imageFormatBlockSize(compressedFormat);
 
-        size_t currentOffset = compressedMips.size() > 0 ? (compressedMips.back().offset + compressedMips.back().size) : 0;
-        compressedPixelData.resize(currentOffset + compressedMipSize);
+    // Lay out all compressed mips up front, so every tile can be compressed straight into the final buffer
+    std::vector<ImageMip> compressedMips {};
+    std::vector<CompressionTile> tiles {};
+    size_t totalSize = 0;
 
-        std::memcpy(compressedPixelData.data() + currentOffset, compressedMipData, compressedMipSize);
+    for (size_t mipIdx = 0; mipIdx < inputImage.numMips(); ++mipIdx) {
+
+        Extent3D mipExtent = inputImage.extentAtMip(mipIdx);
+        u32 blocksWide = ark::divideAndRoundUp(mipExtent.width(), BlockDimension);
+        u32 blocksHigh = ark::divideAndRoundUp(mipExtent.height(), BlockDimension);
 
-        compressedMips.push_back(ImageMip { .offset = currentOffset,
+        size_t compressedMipSize = static_cast<size_t>(blocksWide) * blocksHigh * blockSize;
+        compressedMips.push_back(ImageMip { .offset = totalSize,
                                             .size = compressedMipSize });
+        totalSize += compressedMipSize;
+
+        u32 blockRowsPerTile = std::max(BlocksPerTile / blocksWide, 1u);
+        for (u32 firstBlockRow = 0; firstBlockRow < blocksHigh; firstBlockRow += blockRowsPerTile) {
+            tiles.push_back(CompressionTile { .mipIdx = static_cast<u32>(mipIdx),
+                                              .firstBlockRow = firstBlockRow,
+                                              .blockRowCount = std::min(blockRowsPerTile, blocksHigh - firstBlockRow) });
+        }
     }
 
+    std::vector<u8> compressedPixelData(totalSize);
+
+    ParallelFor(tiles.size(), [&](size_t tileIdx) {
+        CompressionTile const& tile = tiles[tileIdx];
+
+        std::span<u8 const> mipPixels = inputImage.pixelDataForMip(tile.mipIdx);
+        Extent3D mipExtent = inputImage.extentAtMip(tile.mipIdx);
+        u32 blocksWide = ark::divideAndRoundUp(mipExtent.width(), BlockDimension);
+
+        u8* compressedMipData = compressedPixelData.data() + compressedMips[tile.mipIdx].offset;
+
+        BlockPixels blockPixels;
+        for (u32 blockY = tile.firstBlockRow; blockY < tile.firstBlockRow + tile.blockRowCount; ++blockY) {
+            for (u32 blockX = 0; blockX < blocksWide; ++blockX) {
+                gatherBlockPixels(blockPixels, mipPixels, mipExtent, blockX, blockY);
+                size_t blockIdx = blockY * blocksWide + blockX;
+                encodeBlock(compressedMipData + blockIdx * blockSize, blockPixels.data());
+            }
+        }
+    });
+
     return ImageAsset::createCopyWithReplacedFormat(inputImage, compressedFormat, std::move(compressedPixelData), std::move(compressedMips));
+}
 
 }
 
-std::unique_ptr<ImageAsset> TextureCompressor::compressBC7(ImageAsset const& inputImage)
+std::unique_ptr<ImageAsset> TextureCompressor::compressBC7(ImageAsset const& inputImage, TextureCompressionQuality quality)
 {
     SCOPED_PROFILE_ZONE();
 
@@ -62,21 +116,34 @@ std::unique_ptr<ImageAsset> TextureCompressor::compressBC7(ImageAsset const& inp
     ARKOSE_ASSERT(inputImage.width() % 4 == 0 && inputImage.height() % 4 == 0);
     ARKOSE_ASSERT(inputImage.format() == ImageFormat::RGBA8); // TODO: Also add support for RGB, which will require some manual padding
 
-    rdo_bc::rdo_bc_params params {};
-    params.m_status_output = false; // no debug printing
-    params.m_use_bc7e = false; // no ispc support yet (on our end)
-
-    params.m_dxgi_format = DXGI_FORMAT_BC7_UNORM;
-
-    // RDO (optional; will decrease compressed size on disc, but with some slight sacrifice to quality)
-    //params.m_rdo_max_threads = std::max(1u, std::thread::hardware_concurrency());
-    //params.m_bc7enc_reduce_entropy = true;
-    //params.m_rdo_lambda = 100.0f;
+    bc7enc_compress_block_params params {};
+    bc7enc_compress_block_params_init(&params);
+    bc7enc_compress_block_params_init_linear_weights(&params);
+
+    switch (quality) {
+    case TextureCompressionQuality::Fast:
+        params.m_max_partitions = 16;
+        params.m_uber_level = 0;
+        params.m_try_least_squares = false;
+        break;
+    case TextureCompressionQuality::Normal:
+        params.m_max_partitions = BC7ENC_MAX_PARTITIONS;
+        params.m_uber_level = BC7ENC_MAX_UBER_LEVEL;
+        break;
+    case TextureCompressionQuality::Slow:
+        params.m_max_partitions = BC7ENC_MAX_PARTITIONS;
+        params.m_uber_level = BC7ENC_MAX_UBER_LEVEL;
+        // Consider all mode 1 & 7 partitions instead of only the ones the estimator deems likely
+        params.m_mode17_partition_estimation_filterbank = false;
+        break;
+    }
 
-    return compressWithParams(inputImage, ImageFormat::BC7, params);
+    return compressBlocks(inputImage, ImageFormat::BC7, [&params](u8* compressedBlock, u8 const* blockPixels) {
+        bc7enc_compress_block(compressedBlock, blockPixels, &params);
+    });
 }
 
-std::unique_ptr<ImageAsset> TextureCompressor::compressBC5(ImageAsset const& inputImage)
+std::unique_ptr<ImageAsset> TextureCompressor::compressBC5(ImageAsset const& inputImage, TextureCompressionQuality quality)
 {
     SCOPED_PROFILE_ZONE();
 
@@ -86,12 +153,15 @@ std::unique_ptr<ImageAsset> TextureCompressor::compressBC5(ImageAsset const& inp
     // TODO: Also add support for RB and RGB, but the encoder expects a 4-component image input even for BC5
     ARKOSE_ASSERT(inputImage.format() == ImageFormat::RGBA8);
 
-    rdo_bc::rdo_bc_params params {};
-    params.m_dxgi_format = DXGI_FORMAT_BC5_UNORM;
-    params.m_status_output = false; // no debug printing
-    params.m_use_hq_bc345 = true;
+    bool highQuality = quality != TextureCompressionQuality::Fast;
 
-    return compressWithParams(inputImage, ImageFormat::BC5, params);
+    return compressBlocks(inputImage, ImageFormat::BC5, [highQuality](u8* compressedBlock, u8 const* blockPixels) {
+        if (highQuality) {
+            rgbcx::encode_bc5_hq(compressedBlock, blockPixels);
+        } else {
+            rgbcx::encode_bc5(compressedBlock, blockPixels);
+        }
+    });
 }
 
 std::unique_ptr<ImageAsset> TextureCompressor::decompressToRGBA32F(ImageAsset const& compressedImage)
@@ -4,6 +4,13 @@ class ImageAsset;
 
 #include <memory>
 
+// Trades compression speed for compressed image quality
+enum class TextureCompressionQuality {
+    Fast,
+    Normal,
+    Slow,
+};
+
 class TextureCompressor {
 public:
 
@@ -11,10 +18,10 @@ public:
     ~TextureCompressor() = default;
 
     // For most 8-bit RGB(A) textures
-    std::unique_ptr<ImageAsset> compressBC7(ImageAsset const&);
+    std::unique_ptr<ImageAsset> compressBC7(ImageAsset const&, TextureCompressionQuality = TextureCompressionQuality::Normal);
 
     // For normal maps, where the B-component is discarded
-    std::unique_ptr<ImageAsset> compressBC5(ImageAsset const&);
+    std::unique_ptr<ImageAsset> compressBC5(ImageAsset const&, TextureCompressionQuality = TextureCompressionQuality::Normal);
 
     // Decompress a compressed texture to a standardized RGBA32F format,
     // where missing components are filled in with 0.0.
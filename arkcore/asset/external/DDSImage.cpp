@@ -197,29 +197,9 @@ std::vector<ImageMip> DDS::computeMipOffsetAndSize(Extent3D extentMip0, ImageFor
         u32 mipSize;
         if (imageFormatIsBlockCompressed(format)) {
 
-            #if 1
-            // Assume the DDS file has properly padded these mips to 4x4 blocks
-            u32 paddingX = currentExtent.width() % 4;
-            u32 paddingY = currentExtent.height() % 4;
-            if (paddingX > 0 || paddingY > 0) {
-                currentExtent = { currentExtent.width() + paddingX,
-                                  currentExtent.height() + paddingY,
-                                  1 };
-            }
-            #else
-            if (currentExtent.width() < 4 || currentExtent.height() < 4) {
-                // Assume the DDS file has properly padded these mips to 4x4
-                currentExtent = { std::max(4u, currentExtent.width()),
-                                  std::max(4u, currentExtent.height()),
-                                  1 };
-            } else {
-                ARKOSE_ASSERT(currentExtent.width() % 4 == 0);
-                ARKOSE_ASSERT(currentExtent.height() % 4 == 0);
-            }
-            #endif
-
-            u32 blocksX = currentExtent.width() / 4;
-            u32 blocksY = currentExtent.height() / 4;
+            // Mips which aren't a multiple of the block size are padded to whole blocks
+            u32 blocksX = ark::divideAndRoundUp(currentExtent.width(), 4u);
+            u32 blocksY = ark::divideAndRoundUp(currentExtent.height(), 4u);
             u32 blockSize = imageFormatBlockSize(format);
 
             mipSize = blocksX * blocksY * blockSize;
@@ -370,8 +350,10 @@ bool DDS::writeToFile(std::filesystem::path const& filePath, u8 const* imageData
     std::byte* imageDataStart = fileData + 4 + sizeof(DDSHeader) + (hasDX10Header ? sizeof(DDSHeaderDX10) : 0);
     memcpy(imageDataStart, imageData, imageDataSize);
 
-    // TODO: Add error handling for writing files!
-    FileIO::writeBinaryDataToFile(filePath, fileData, fileSize);
+    // NOTE: Replace rather than overwrite the file, as the old file could still be memory-mapped by a loaded image asset
+    bool didWrite = FileIO::replaceFileWithBinaryData(filePath, fileData, fileSize);
 
-    return true;
+    free(fileData);
+
+    return didWrite;
 }
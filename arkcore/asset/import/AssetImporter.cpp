@@ -6,10 +6,37 @@
 #include "asset/misc/ImageBakeSpec.h"
 #include "core/Assert.h"
 #include "core/Logging.h"
-#include "core/parallel/ParallelFor.h"
+#include "core/parallel/TaskGraph.h"
 #include "utility/FileIO.h"
+#include <cereal/archives/binary.hpp>
 #include <fmt/format.h>
 
+// Bump this whenever a change to the mesh import processing changes its output, to invalidate the bake cache
+constexpr u32 MeshImportVersion = 1;
+
+static BakeCacheKey calculateMeshBakeCacheKey(MeshAsset const& mesh, AssetImporterOptions const& options)
+{
+    SCOPED_PROFILE_ZONE();
+
+    ContentHasher hasher {};
+    hasher.append("MeshImport");
+    hasher.appendValue(MeshImportVersion);
+    hasher.appendValue(toUnderlying(MeshAssetVersion::LatestVersion));
+    hasher.appendValue(options.saveMeshesInTextualFormat);
+    hasher.appendValue(options.meshLODCount);
+    hasher.appendValue(options.meshLODTriangleRatio);
+    hasher.appendValue(options.meshLODMaxError);
+
+    // Hash the unprocessed mesh by serializing it, which covers all of its source data and resolved material references
+    {
+        HashingOutputStream hashingStream { hasher };
+        cereal::BinaryOutputArchive archive(hashingStream);
+        archive(mesh);
+    }
+
+    return hasher.finalize();
+}
+
 std::unique_ptr<AssetImportTask> AssetImportTask::create(std::filesystem::path const& assetFilePath,
                                                          std::filesystem::path const& targetDirectory,
                                                          std::filesystem::path const& tempDirectory,
@@ -114,42 +141,13 @@ void AssetImportTask::importGltf()
 
     m_processedItemCount += 1;
 
-    if (m_result.images.size() > 0) {
-        updateStatus("Generating MIP maps & compressing textures");
-    }
-
-    // Compress all images (the slow part of this process) in parallel
-    ParallelFor(result.images.size(), [&](size_t idx) {
-        auto& image = result.images[idx];
-
-        // Only compress here if we're not able to (or don't want to) defer it with an image spec
-        if (image && !image->hasSourceAsset() || !options.generateImageSpecs) {
-
-            if (options.generateMipmaps && image->numMips() == 1) {
-                // NOTE: Can fail!
-                image->generateMipmaps();
-            }
-
-            if (options.blockCompressImages && !image->hasCompressedFormat()) {
-                TextureCompressor textureCompressor {};
-                if (image->type() == ImageType::NormalMap) {
-                    image = textureCompressor.compressBC5(*image);
-                } else {
-                    image = textureCompressor.compressBC7(*image);
-                }
-            }
-        }
-
-        m_processedItemCount += 1;
-    });
-
-    if (result.images.size() > 0) {
-        updateStatus("Writing images");
-    }
+    // Assign target file paths to all assets up front, so that the import steps below only depend on each other where
+    // they actually need the results of another step, not just to be able to reference its asset file path.
 
+    std::vector<std::filesystem::path> imageTargetPaths(result.images.size());
     int unnamedImageIdx = 0;
-    for (auto& image : result.images) {
-
+    for (size_t imageIdx = 0; imageIdx < result.images.size(); ++imageIdx) {
+        auto& image = result.images[imageIdx];
         if (image) {
 
             std::string fileName;
@@ -162,144 +160,229 @@ void AssetImportTask::importGltf()
                 fileName = fmt::format("image{:04}", unnamedImageIdx++);
             }
 
-            std::filesystem::path targetFilePath = (m_targetDirectory / fileName).replace_extension(ImageAsset::AssetFileExtension);
+            imageTargetPaths[imageIdx] = (m_targetDirectory / fileName).replace_extension(ImageAsset::AssetFileExtension);
+        }
+    }
+
+    std::unordered_map<std::string, int> materialNameMap {};
+    for (auto& material : result.materials) {
+
+        std::string fileName = material->name;
+        if (fileName.empty()) {
+            fileName = "material";
+        }
+
+        int count = materialNameMap[fileName]++;
+        if (count > 0 || fileName == "material") {
+            fileName = fmt::format("{}{:04}", fileName, count);
+        }
+
+        material->setAssetFilePath((m_targetDirectory / fileName).replace_extension(MaterialAsset::AssetFileExtension));
+    }
+
+    std::unordered_map<std::string, int> meshNameMap {};
+    for (auto& mesh : result.meshes) {
+
+        std::string fileName = mesh->name;
+        if (fileName.empty()) {
+            fileName = "mesh";
+        }
+
+        int count = meshNameMap[fileName]++;
+        if (count > 0 || fileName == "mesh") {
+            fileName = fmt::format("{}{:04}", fileName, count);
+        }
+
+        mesh->setAssetFilePath((m_targetDirectory / fileName).replace_extension(MeshAsset::AssetFileExtension));
+    }
+
+    // All import steps are set up as a graph of tasks, so that e.g. meshes are processed and written while images are still
+    // being compressed, instead of running one phase after another. If the task graph isn't initialized (see
+    // TaskGraph::isInitialized) the steps are simply executed inline in the order they are added, which respects all dependencies.
+
+    Task* rootTask = TaskGraph::isInitialized() ? &Task::createEmpty() : nullptr;
+    std::vector<Task*> stepTasks {};
+
+    auto addImportStep = [&](std::vector<Task*> const& dependencies, TaskFunction&& stepFunction) -> Task* {
+        if (rootTask == nullptr) {
+            stepFunction();
+            return nullptr;
+        }
+
+        // NOTE: Not auto-released, as later steps might still need to add a dependency on this task after it has completed
+        Task& stepTask = Task::createWithParent(*rootTask, std::move(stepFunction));
+        for (Task* dependency : dependencies) {
+            stepTask.addDependency(*dependency);
+        }
+
+        TaskGraph::get().scheduleTask(stepTask);
+        stepTasks.push_back(&stepTask);
+
+        return &stepTask;
+    };
+
+    updateStatus("Importing images, materials & meshes");
+
+    // NOTE: Null images keep a null spec, just to ensure the arrays match
+    result.imageSpecs.resize(result.images.size());
+
+    for (size_t imageIdx = 0; imageIdx < result.images.size(); ++imageIdx) {
+
+        // Images which failed to load have nothing to compress or write
+        if (!result.images[imageIdx]) {
+            m_processedItemCount += 2;
+            continue;
+        }
+
+        // Compress images (the slow part of this process)
+        Task* compressTask = addImportStep({}, [&, imageIdx]() {
+            auto& image = result.images[imageIdx];
+
+            // Only compress here if we're not able to (or don't want to) defer it with an image spec
+            if (!image->hasSourceAsset() || !options.generateImageSpecs) {
+
+                if (options.generateMipmaps && image->numMips() == 1) {
+                    // NOTE: Can fail!
+                    image->generateMipmaps(options.mipmapFilter);
+                }
+
+                if (options.blockCompressImages && !image->hasCompressedFormat()) {
+                    TextureCompressor textureCompressor {};
+                    if (image->type() == ImageType::NormalMap) {
+                        image = textureCompressor.compressBC5(*image, options.compressionQuality);
+                    } else {
+                        image = textureCompressor.compressBC7(*image, options.compressionQuality);
+                    }
+                }
+            }
+
+            m_processedItemCount += 1;
+        });
+
+        // Write images (or image specs)
+        addImportStep({ compressTask }, [&, imageIdx]() {
+            auto& image = result.images[imageIdx];
+
+            std::filesystem::path const& targetFilePath = imageTargetPaths[imageIdx];
             image->setAssetFilePath(targetFilePath);
 
             if (options.generateImageSpecs && image->hasSourceAsset()) {
 
-                auto& imgSpec = result.imageSpecs.emplace_back(std::make_unique<ImageBakeSpec>());
+                auto& imgSpec = result.imageSpecs[imageIdx];
+                imgSpec = std::make_unique<ImageBakeSpec>();
                 imgSpec->inputImage = image->sourceAssetFilePath().generic_string();
                 imgSpec->targetImage = targetFilePath.generic_string();
                 imgSpec->type = image->type();
                 imgSpec->generateMipmaps = options.generateMipmaps;
+                imgSpec->mipmapFilter = options.mipmapFilter;
                 imgSpec->compress = options.blockCompressImages;
+                imgSpec->compressionQuality = options.compressionQuality;
 
                 std::string imgSpecExtension = ImageAsset::AssetFileExtension + std::string(".imgspec");
-                std::filesystem::path imgSpecFilePath = (m_tempDirectory / fileName).replace_extension(imgSpecExtension);
+                std::filesystem::path imgSpecFilePath = (m_tempDirectory / targetFilePath.filename()).replace_extension(imgSpecExtension);
                 imgSpec->writeToFile(imgSpecFilePath);
                 imgSpec->selfPath = imgSpecFilePath;
 
             } else {
+                // NOTE: Leave a null-spec just to ensure arrays match
                 image->writeToFile(targetFilePath, AssetStorage::Binary);
-                result.imageSpecs.emplace_back(); // emplace null-spec just to ensure arrays match
             }
-        }
 
-        m_processedItemCount += 1;
+            m_processedItemCount += 1;
+        });
     }
 
-    if (m_result.materials.size() > 0) {
-        updateStatus("Writing materials");
-    }
-
-    std::unordered_map<std::string, int> materialNameMap {};
     for (auto& material : result.materials) {
 
-        // Resolve references (paths) to image assets
-        // (The glTF loader will use its local glTF indices while loading, since we don't yet know the file paths)
-
-        auto resolveImageFilePath = [&](std::optional<MaterialInput>& materialInput) {
-            if (materialInput.has_value()) {
-                int gltfIdx = materialInput->userData;
-                ARKOSE_ASSERT(gltfIdx >= 0 && gltfIdx < narrow_cast<int>(result.images.size()));
-                auto& image = result.images[gltfIdx];
-                if (image) {
-                    materialInput->image = image->assetFilePath().generic_string();
-                }
-            }
-        };
-
-        resolveImageFilePath(material->baseColor);
-        resolveImageFilePath(material->emissiveColor);
-        resolveImageFilePath(material->normalMap);
-        resolveImageFilePath(material->materialProperties);
-        resolveImageFilePath(material->occlusionMap);
+        // Write materials
+        addImportStep({}, [&]() {
 
-        std::string fileName = material->name;
-        if (fileName.empty()) {
-            fileName = "material";
-        }
+            // Resolve references (paths) to image assets
+            // (The glTF loader will use its local glTF indices while loading, since we don't yet know the file paths)
 
-        int count = materialNameMap[fileName]++;
-        if (count > 0 || fileName == "material") {
-            fileName = fmt::format("{}{:04}", fileName, count);
-        }
+            auto resolveImageFilePath = [&](std::optional<MaterialInput>& materialInput) {
+                if (materialInput.has_value()) {
+                    int gltfIdx = materialInput->userData;
+                    ARKOSE_ASSERT(gltfIdx >= 0 && gltfIdx < narrow_cast<int>(result.images.size()));
+                    if (!imageTargetPaths[gltfIdx].empty()) {
+                        materialInput->image = imageTargetPaths[gltfIdx].generic_string();
+                    }
+                }
+            };
 
-        std::filesystem::path targetFilePath = (m_targetDirectory / fileName).replace_extension(MaterialAsset::AssetFileExtension);
+            resolveImageFilePath(material->baseColor);
+            resolveImageFilePath(material->emissiveColor);
+            resolveImageFilePath(material->normalMap);
+            resolveImageFilePath(material->materialProperties);
+            resolveImageFilePath(material->occlusionMap);
 
-        material->writeToFile(targetFilePath, AssetStorage::Json);
-        material->setAssetFilePath(targetFilePath);
+            material->writeToFile(material->assetFilePath(), AssetStorage::Json);
 
-        m_processedItemCount += 1;
+            m_processedItemCount += 1;
+        });
     }
 
-    if (m_result.meshes.size() > 0) {
-        updateStatus("Resolving mesh materials");
-    }
+    // Meshes served from the bake cache are already processed & written, so only the rest have to be written after processing
+    std::vector<BakeCacheKey> meshBakeCacheKeys(result.meshes.size());
+    std::vector<u8> meshServedFromBakeCache(result.meshes.size(), false);
 
-    for (auto& mesh : result.meshes) {
+    std::vector<Task*> writeMeshTasks {};
+    for (size_t meshIdx = 0; meshIdx < result.meshes.size(); ++meshIdx) {
+        auto& mesh = result.meshes[meshIdx];
 
-        // Resolve references (paths) to material assets
-        // (The glTF loader will use its local glTF indices while loading, since we don't yet know the file paths)
+        // Resolve mesh materials & process meshes
+        Task* processTask = addImportStep({}, [&, meshIdx]() {
 
-        for (MeshLODAsset& lod : mesh->LODs) {
-            for (MeshSegmentAsset& meshSegment : lod.meshSegments) {
-                if (meshSegment.userData != -1) {
-                    int gltfIdx = meshSegment.userData;
-                    ARKOSE_ASSERT(gltfIdx >= 0 && gltfIdx < narrow_cast<int>(result.materials.size()));
-                    auto& material = result.materials[gltfIdx];
-                    meshSegment.material = material->assetFilePath().generic_string();
+            // Resolve references (paths) to material assets
+            // (The glTF loader will use its local glTF indices while loading, since we don't yet know the file paths)
+
+            for (MeshLODAsset& lod : mesh->LODs) {
+                for (MeshSegmentAsset& meshSegment : lod.meshSegments) {
+                    if (meshSegment.userData != -1) {
+                        int gltfIdx = meshSegment.userData;
+                        ARKOSE_ASSERT(gltfIdx >= 0 && gltfIdx < narrow_cast<int>(result.materials.size()));
+                        auto& material = result.materials[gltfIdx];
+                        meshSegment.material = material->assetFilePath().generic_string();
+                    }
                 }
             }
-        }
 
-        m_processedItemCount += 1;
-    }
-
-    if (m_result.meshes.size() > 0) {
-        updateStatus("Processing meshes");
-    }
+            m_processedItemCount += 1;
 
-    ParallelFor(result.meshes.size(), [&](size_t idx) {
-        auto& mesh = result.meshes[idx];
-        for (MeshLODAsset& lod : mesh->LODs) {
-            for (MeshSegmentAsset& meshSegment : lod.meshSegments) {
-                meshSegment.processForImport();
+            if (options.bakeCache != nullptr) {
+                meshBakeCacheKeys[meshIdx] = calculateMeshBakeCacheKey(*mesh, options);
+                if (options.bakeCache->retrieve(meshBakeCacheKeys[meshIdx], mesh->assetFilePath())) {
+                    // Load the processed mesh so the import result matches what was written
+                    meshServedFromBakeCache[meshIdx] = mesh->readFromFile(mesh->assetFilePath());
+                }
             }
-        }
 
-        m_processedItemCount += 1;
-    });
+            if (!meshServedFromBakeCache[meshIdx]) {
+                mesh->processForImport();
+                if (options.meshLODCount > 1) {
+                    mesh->generateLODs(options.meshLODCount, options.meshLODTriangleRatio, options.meshLODMaxError);
+                }
+            }
 
-    if (m_result.meshes.size() > 0) {
-        updateStatus("Writing meshes");
-    }
+            m_processedItemCount += 1;
+        });
 
-    std::unordered_map<std::string, int> meshNameMap {};
-    for (auto& mesh : result.meshes) {
+        // Write meshes
+        Task* writeTask = addImportStep({ processTask }, [&, meshIdx]() {
+            if (!meshServedFromBakeCache[meshIdx]) {
+                // TODO: Json is currently super slow with all the data we have, even for smaller meshes, but if we separate out the core data it will be fine.
+                AssetStorage assetStorage = options.saveMeshesInTextualFormat ? AssetStorage::Json : AssetStorage::Binary;
+                if (mesh->writeToFile(mesh->assetFilePath(), assetStorage) && options.bakeCache != nullptr) {
+                    options.bakeCache->store(meshBakeCacheKeys[meshIdx], mesh->assetFilePath());
+                }
+            }
 
-        std::string fileName = mesh->name;
-        if (fileName.empty()) {
-            fileName = "mesh";
-        }
+            m_processedItemCount += 1;
+        });
 
-        int count = meshNameMap[fileName]++;
-        if (count > 0 || fileName == "mesh") {
-            fileName = fmt::format("{}{:04}", fileName, count);
+        if (writeTask) {
+            writeMeshTasks.push_back(writeTask);
         }
-
-        std::filesystem::path targetFilePath = (m_targetDirectory / fileName).replace_extension(MeshAsset::AssetFileExtension);
-
-        // TODO: Json is currently super slow with all the data we have, even for smaller meshes, but if we separate out the core data it will be fine.
-        AssetStorage assetStorage = options.saveMeshesInTextualFormat ? AssetStorage::Json : AssetStorage::Binary;
-        mesh->writeToFile(targetFilePath, assetStorage);
-        mesh->setAssetFilePath(targetFilePath);
-
-        m_processedItemCount += 1;
-    }
-
-    if (m_result.skeletons.size() > 0) {
-        updateStatus("Writing skeletons");
     }
 
     std::unordered_map<std::string, int> skeletonNameMap {};
@@ -316,15 +399,13 @@ void AssetImportTask::importGltf()
         }
 
         std::filesystem::path targetFilePath = (m_targetDirectory / fileName).replace_extension(SkeletonAsset::AssetFileExtension);
-
-        skeleton->writeToFile(targetFilePath, AssetStorage::Json);
         skeleton->setAssetFilePath(targetFilePath);
 
-        m_processedItemCount += 1;
-    }
-
-    if (m_result.animations.size() > 0) {
-        updateStatus("Writing animations");
+        // Write skeletons
+        addImportStep({}, [&]() {
+            skeleton->writeToFile(skeleton->assetFilePath(), AssetStorage::Json);
+            m_processedItemCount += 1;
+        });
     }
 
     std::unordered_map<std::string, int> animationNameMap {};
@@ -341,15 +422,17 @@ void AssetImportTask::importGltf()
         }
 
         std::filesystem::path targetFilePath = (m_targetDirectory / fileName).replace_extension(AnimationAsset::AssetFileExtension);
-
-        animation->writeToFile(targetFilePath, AssetStorage::Json);
         animation->setAssetFilePath(targetFilePath);
 
-        m_processedItemCount += 1;
+        // Write animations
+        addImportStep({}, [&]() {
+            animation->writeToFile(animation->assetFilePath(), AssetStorage::Json);
+            m_processedItemCount += 1;
+        });
     }
 
-    // Make an SetAsset for the imported asset
-    {
+    // Make an SetAsset for the imported asset, once all its meshes are written
+    addImportStep(writeMeshTasks, [&]() {
         result.set = std::make_unique<SetAsset>();
 
         std::string fileName = m_assetFilePath.filename().replace_extension("").string();
@@ -369,6 +452,16 @@ void AssetImportTask::importGltf()
         result.set->setAssetFilePath(targetFilePath);
 
         m_processedItemCount += 1;
+    });
+
+    if (rootTask != nullptr) {
+        rootTask->executeSynchronous();
+        TaskGraph::get().waitForCompletion(*rootTask);
+
+        for (Task* stepTask : stepTasks) {
+            stepTask->release();
+        }
+        rootTask->release();
     }
 
     ARKOSE_ASSERT(progress() == 1.0f);
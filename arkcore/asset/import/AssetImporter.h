@@ -7,6 +7,7 @@
 #include "asset/MeshAsset.h"
 #include "asset/SetAsset.h"
 #include "asset/SkeletonAsset.h"
+#include "asset/misc/BakeCache.h"
 #include "asset/misc/ImageBakeSpec.h"
 #include "core/parallel/PollableTask.h"
 #include <atomic>
@@ -46,12 +47,24 @@ struct ImportResult {
 struct AssetImporterOptions {
     // Generate mipmaps when importing image assets?
     bool generateMipmaps { false };
+    // Filter to use when generating mipmaps
+    MipmapFilter mipmapFilter { MipmapFilter::Box };
     // Compress images in BC5 format for normal maps and BC7 for all other textures.
     bool blockCompressImages { false };
+    // Quality of the block compression, trading compression time for quality
+    TextureCompressionQuality compressionQuality { TextureCompressionQuality::Normal };
     // Generate iamge specs instead of image assets (so they can be procesed separately)
     bool generateImageSpecs { false };
     // Save imported meshes in textual format
     bool saveMeshesInTextualFormat { false };
+    // Number of LODs for imported meshes (including LOD0), where LOD1+ are generated by mesh simplification
+    u32 meshLODCount { 1 };
+    // Fraction of the triangles of the previous LOD that each generated LOD aims for
+    float meshLODTriangleRatio { 0.5f };
+    // Max. simplification error (relative to the mesh segment extents) allowed for generated LODs
+    float meshLODMaxError { 0.02f };
+    // Serve processed meshes from (and store them in) this bake cache, if not null
+    BakeCache* bakeCache { nullptr };
 };
 
 
@@ -0,0 +1,225 @@
+#include "BakeCache.h"
+
+#include "core/Logging.h"
+#include "utility/FileIO.h"
+#include "utility/Profiling.h"
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr u64 Prime1 = 0x9E3779B185EBCA87ull;
+constexpr u64 Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr u64 Prime3 = 0x165667B19E3779F9ull;
+constexpr u64 Prime4 = 0x85EBCA77C2B2AE63ull;
+
+constexpr u64 rotateLeft(u64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+constexpr u64 avalanche(u64 hash)
+{
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+}
+
+std::string BakeCacheKey::toString() const
+{
+    return fmt::format("{:016x}{:016x}", high, low);
+}
+
+ContentHasher::ContentHasher()
+    : m_lanes { Prime1 + Prime2, Prime3 ^ Prime4 }
+{
+}
+
+void ContentHasher::mixWord(u64 word)
+{
+    m_lanes[0] = rotateLeft(m_lanes[0] ^ (word * Prime2), 31) * Prime1;
+    m_lanes[1] = rotateLeft(m_lanes[1] + (word * Prime4), 27) * Prime3;
+}
+
+void ContentHasher::append(void const* data, size_t size)
+{
+    u8 const* bytes = static_cast<u8 const*>(data);
+    m_totalSize += size;
+
+    // Finish any partial word from the previous append first
+    while (m_pendingByteCount > 0 && size > 0) {
+        m_pendingWord |= static_cast<u64>(*bytes++) << (8 * m_pendingByteCount);
+        size -= 1;
+        if (++m_pendingByteCount == sizeof(u64)) {
+            mixWord(m_pendingWord);
+            m_pendingWord = 0;
+            m_pendingByteCount = 0;
+        }
+    }
+
+    while (size >= sizeof(u64)) {
+        u64 word;
+        std::memcpy(&word, bytes, sizeof(u64));
+        mixWord(word);
+        bytes += sizeof(u64);
+        size -= sizeof(u64);
+    }
+
+    for (; size > 0; --size) {
+        m_pendingWord |= static_cast<u64>(*bytes++) << (8 * m_pendingByteCount);
+        m_pendingByteCount += 1;
+    }
+}
+
+void ContentHasher::append(std::string_view string)
+{
+    // Include the size so that e.g. "ab" + "c" and "a" + "bc" hash differently
+    appendValue(string.size());
+    append(string.data(), string.size());
+}
+
+bool ContentHasher::appendFileContents(std::filesystem::path const& filePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    std::ifstream file { filePath, std::ios::binary };
+    if (!file.is_open()) {
+        return false;
+    }
+
+    constexpr size_t ChunkSize = 1024 * 1024;
+    std::vector<char> chunk(ChunkSize);
+
+    while (file) {
+        file.read(chunk.data(), ChunkSize);
+        append(chunk.data(), static_cast<size_t>(file.gcount()));
+    }
+
+    return !file.bad();
+}
+
+BakeCacheKey ContentHasher::finalize() const
+{
+    u64 lane0 = m_lanes[0];
+    u64 lane1 = m_lanes[1];
+
+    u64 tail = m_pendingWord ^ (m_totalSize * Prime3);
+    lane0 = rotateLeft(lane0 ^ (tail * Prime2), 31) * Prime1;
+    lane1 = rotateLeft(lane1 + (tail * Prime4), 27) * Prime3;
+
+    // Cross the lanes so that every output bit depends on both of them
+    return BakeCacheKey { .high = avalanche(lane0 + rotateLeft(lane1, 17)),
+                          .low = avalanche(lane1 ^ rotateLeft(lane0, 41)) };
+}
+
+HashingOutputStream::HashingOutputStream(ContentHasher& hasher)
+    : std::ostream(nullptr)
+    , m_streamBuffer(hasher)
+{
+    rdbuf(&m_streamBuffer);
+}
+
+HashingOutputStream::HashingStreamBuffer::int_type HashingOutputStream::HashingStreamBuffer::overflow(int_type character)
+{
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+        char value = traits_type::to_char_type(character);
+        m_hasher.append(&value, 1);
+    }
+    return traits_type::not_eof(character);
+}
+
+std::streamsize HashingOutputStream::HashingStreamBuffer::xsputn(char const* data, std::streamsize count)
+{
+    m_hasher.append(data, static_cast<size_t>(count));
+    return count;
+}
+
+BakeCache::BakeCache(std::filesystem::path cacheDirectory)
+    : m_cacheDirectory(std::move(cacheDirectory))
+{
+}
+
+std::filesystem::path BakeCache::entryPath(BakeCacheKey const& key, std::filesystem::path const& fileExtension) const
+{
+    // Spread the entries over subdirectories to avoid ending up with huge directories
+    std::string keyString = key.toString();
+    std::filesystem::path entryFileName = std::filesystem::path(keyString).replace_extension(fileExtension);
+    return m_cacheDirectory / keyString.substr(0, 2) / entryFileName;
+}
+
+bool BakeCache::retrieve(BakeCacheKey const& key, std::filesystem::path const& targetFilePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    std::filesystem::path cachedFilePath = entryPath(key, targetFilePath.extension());
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(cachedFilePath, error)) {
+        m_missCount += 1;
+        return false;
+    }
+
+    // NOTE: Copy rather than link, as baked files may later be rewritten in place, which would then modify the cache entry.
+    // The target file is replaced rather than overwritten, as the old file could still be memory-mapped by a loaded asset.
+    if (!FileIO::replaceFileWithCopy(targetFilePath, cachedFilePath)) {
+        ARKOSE_LOG(Warning, "BakeCache: failed to copy cached file '{}' to '{}'", cachedFilePath, targetFilePath);
+        m_missCount += 1;
+        return false;
+    }
+
+    m_hitCount += 1;
+    return true;
+}
+
+void BakeCache::store(BakeCacheKey const& key, std::filesystem::path const& bakedFilePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    std::filesystem::path cachedFilePath = entryPath(key, bakedFilePath.extension());
+
+    // Multiple bakes (possibly in separate processes) could store the same entry at the same time, so write to a unique
+    // temporary file first and then move it in place, so that no one can ever see a partially written cache entry.
+    std::random_device randomDevice {};
+    u64 uniqueValue = (static_cast<u64>(randomDevice()) << 32) | static_cast<u64>(randomDevice());
+    std::filesystem::path temporaryFilePath = cachedFilePath;
+    temporaryFilePath += fmt::format(".{:016x}.tmp", uniqueValue);
+
+    std::error_code error;
+    std::filesystem::create_directories(cachedFilePath.parent_path(), error);
+
+    if (!error) {
+        std::filesystem::copy_file(bakedFilePath, temporaryFilePath, std::filesystem::copy_options::overwrite_existing, error);
+    }
+
+    if (!error) {
+        std::filesystem::rename(temporaryFilePath, cachedFilePath, error);
+    }
+
+    if (error) {
+        ARKOSE_LOG(Warning, "BakeCache: failed to store '{}' in the cache: {}", bakedFilePath, error.message());
+        std::filesystem::remove(temporaryFilePath, error);
+        m_storeFailureCount += 1;
+    }
+}
+
+void BakeCache::logStatistics(std::string_view toolName) const
+{
+    u32 hitCount = m_hitCount.load();
+    u32 missCount = m_missCount.load();
+    u32 lookupCount = hitCount + missCount;
+
+    float hitRate = lookupCount > 0 ? static_cast<float>(hitCount) / static_cast<float>(lookupCount) : 0.0f;
+    ARKOSE_LOG(Info, "{}: bake cache '{}': {} hits, {} misses ({:.1f}% hit rate)", toolName, m_cacheDirectory, hitCount, missCount, 100.0f * hitRate);
+
+    if (u32 storeFailureCount = m_storeFailureCount.load(); storeFailureCount > 0) {
+        ARKOSE_LOG(Warning, "{}: failed to store {} entries in the bake cache", toolName, storeFailureCount);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core/Types.h"
+#include <atomic>
+#include <filesystem>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+struct BakeCacheKey {
+    u64 high { 0 };
+    u64 low { 0 };
+
+    std::string toString() const;
+};
+
+// Streaming 128-bit hash of all the inputs of a bake. It's not a cryptographic hash, but with 128 bits an accidental
+// collision between two cache entries is not a practical concern.
+class ContentHasher {
+public:
+    ContentHasher();
+
+    void append(void const* data, size_t size);
+    void append(std::string_view);
+
+    template<typename T>
+    void appendValue(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    // Append the full contents of a file. Returns false if the file could not be read.
+    bool appendFileContents(std::filesystem::path const&);
+
+    BakeCacheKey finalize() const;
+
+private:
+    void mixWord(u64 word);
+
+    u64 m_lanes[2];
+    u64 m_pendingWord { 0 };
+    u32 m_pendingByteCount { 0 };
+    u64 m_totalSize { 0 };
+};
+
+// Output stream which hashes everything written to it, e.g. for hashing an asset by serializing it to this stream
+class HashingOutputStream final : public std::ostream {
+public:
+    explicit HashingOutputStream(ContentHasher&);
+
+private:
+    class HashingStreamBuffer final : public std::streambuf {
+    public:
+        explicit HashingStreamBuffer(ContentHasher& hasher)
+            : m_hasher(hasher)
+        {
+        }
+
+    protected:
+        int_type overflow(int_type) override;
+        std::streamsize xsputn(char const*, std::streamsize) override;
+
+    private:
+        ContentHasher& m_hasher;
+    };
+
+    HashingStreamBuffer m_streamBuffer;
+};
+
+// A local on-disk cache of baked asset files. Entries are content addressed, i.e., keyed on a hash of everything that
+// affects the baked output (source data, bake options & tool version), so an unchanged input can be served by copying
+// the previously baked file instead of baking it again. The cache directory can be deleted at any time.
+class BakeCache {
+public:
+    explicit BakeCache(std::filesystem::path cacheDirectory);
+
+    // If there is a cached file for the key, copy it to `targetFilePath` and return true (a cache hit)
+    bool retrieve(BakeCacheKey const&, std::filesystem::path const& targetFilePath);
+
+    // Store a copy of the file baked to `bakedFilePath` for the key, so the next bake with the same key is a cache hit
+    void store(BakeCacheKey const&, std::filesystem::path const& bakedFilePath);
+
+    u32 hitCount() const { return m_hitCount.load(); }
+    u32 missCount() const { return m_missCount.load(); }
+
+    void logStatistics(std::string_view toolName) const;
+
+private:
+    std::filesystem::path entryPath(BakeCacheKey const&, std::filesystem::path const& fileExtension) const;
+
+    std::filesystem::path m_cacheDirectory;
+
+    std::atomic_uint32_t m_hitCount { 0 };
+    std::atomic_uint32_t m_missCount { 0 };
+    std::atomic_uint32_t m_storeFailureCount { 0 };
+};
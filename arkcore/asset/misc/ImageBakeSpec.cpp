@@ -1,7 +1,17 @@
 #include "ImageBakeSpec.h"
 
+#include "asset/misc/BakeCache.h"
 #include "utility/FileIO.h"
 
+void ImageBakeSpec::hashBakeOptions(ContentHasher& hasher) const
+{
+    hasher.appendValue(type);
+    hasher.appendValue(generateMipmaps);
+    hasher.appendValue(mipmapFilter);
+    hasher.appendValue(compress);
+    hasher.appendValue(compressionQuality);
+}
+
 bool ImageBakeSpec::writeToFile(std::filesystem::path const& filePath) const
 {
     std::ofstream fileStream { filePath };
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "asset/ImageAsset.h"
+#include "asset/TextureCompressor.h"
 #include <filesystem>
 
+class ContentHasher;
+
 // Specifies metadata for how to bake an image
 struct ImageBakeSpec {
     std::string inputImage;
@@ -11,23 +14,36 @@ struct ImageBakeSpec {
     ImageType type { ImageType::Unknown };
 
     bool generateMipmaps { true };
+    MipmapFilter mipmapFilter { MipmapFilter::Box };
     bool compress { true };
+    TextureCompressionQuality compressionQuality { TextureCompressionQuality::Normal };
 
     template<class Archive>
     void serialize(Archive&);
 
+    // Hash all options that affect the baked image (i.e., everything but the file paths)
+    void hashBakeOptions(ContentHasher&) const;
+
     bool writeToFile(std::filesystem::path const& filePath) const;
     bool readFromFile(std::filesystem::path const& filePath);
 
     // eh hack, but works for now..
     std::filesystem::path selfPath;
+
+private:
+    // For fields added after the initial version: when reading, if the next field in the archive is not `name` it's missing
+    template<class Archive>
+    static bool hasNextField(Archive&, char const* name);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
+#include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <cereal/types/string.hpp>
+#include <cstring>
+#include <type_traits>
 
 template<class Archive>
 void ImageBakeSpec::serialize(Archive& archive)
@@ -37,4 +53,23 @@ void ImageBakeSpec::serialize(Archive& archive)
     archive(CEREAL_NVP(type));
     archive(CEREAL_NVP(generateMipmaps));
     archive(CEREAL_NVP(compress));
+
+    // Added after the initial version, so specs written before then don't have them and will use the defaults
+    if (hasNextField(archive, "compressionQuality")) {
+        archive(CEREAL_NVP(compressionQuality));
+    }
+    if (hasNextField(archive, "mipmapFilter")) {
+        archive(CEREAL_NVP(mipmapFilter));
+    }
+}
+
+template<class Archive>
+bool ImageBakeSpec::hasNextField(Archive& archive, char const* name)
+{
+    if constexpr (std::is_same_v<Archive, cereal::JSONInputArchive>) {
+        char const* nextName = archive.getNodeName();
+        return nextName != nullptr && std::strcmp(nextName, name) == 0;
+    } else {
+        return true;
+    }
 }
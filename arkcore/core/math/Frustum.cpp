@@ -3,6 +3,15 @@
 #include "utility/Profiling.h"
 #include "core/Assert.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_USE_SSE 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
 namespace geometry {
 
 Frustum Frustum::createFromProjectionMatrix(mat4 M)
@@ -23,6 +32,14 @@ Frustum::Frustum(Plane planes[6])
         ARKOSE_ASSERT(!planes[i].isDegenerate());
         m_planes[i] = planes[i];
     }
+
+    for (size_t lane = 0; lane < 8; ++lane) {
+        Plane const& plane = m_planes[lane < 6 ? lane : 0];
+        m_planeNormalX[lane] = plane.normal().x;
+        m_planeNormalY[lane] = plane.normal().y;
+        m_planeNormalZ[lane] = plane.normal().z;
+        m_planeDistance[lane] = plane.distance();
+    }
 }
 
 bool Frustum::isPointInside(vec3 point) const
@@ -40,6 +57,23 @@ bool Frustum::includesSphere(const Sphere& sphere) const
 {
     //SCOPED_PROFILE_ZONE();
 
+#if defined(FRUSTUM_USE_SSE)
+    __m128 centerX = _mm_set1_ps(sphere.center().x);
+    __m128 centerY = _mm_set1_ps(sphere.center().y);
+    __m128 centerZ = _mm_set1_ps(sphere.center().z);
+    __m128 radius = _mm_set1_ps(sphere.radius());
+
+    int outsideMask = 0;
+    for (size_t lane = 0; lane < 8; lane += 4) {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(m_planeNormalX + lane), centerX),
+                                                _mm_mul_ps(_mm_load_ps(m_planeNormalY + lane), centerY)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_load_ps(m_planeNormalZ + lane), centerZ),
+                                                _mm_load_ps(m_planeDistance + lane)));
+        outsideMask |= _mm_movemask_ps(_mm_cmpgt_ps(distance, radius));
+    }
+
+    return outsideMask == 0;
+#else
     for (const Plane& plane : m_planes) {
         float distance = dot(plane.normal(), sphere.center()) + plane.distance();
         if (distance > sphere.radius())
@@ -47,28 +81,53 @@ bool Frustum::includesSphere(const Sphere& sphere) const
     }
 
     return true;
+#endif
 }
 
 bool Frustum::includesAABB(ark::aabb3 const& aabb) const
 {
     //SCOPED_PROFILE_ZONE();
 
-    vec3 corners[8] = { /*vec3(aabb.min.x, aabb.min.y, aabb.min.z)*/ aabb.min,
-                        vec3(aabb.min.x, aabb.min.y, aabb.max.z),
-                        vec3(aabb.min.x, aabb.max.y, aabb.min.z),
-                        vec3(aabb.min.x, aabb.max.y, aabb.max.z),
-                        vec3(aabb.max.x, aabb.min.y, aabb.min.z),
-                        vec3(aabb.max.x, aabb.min.y, aabb.max.z),
-                        vec3(aabb.max.x, aabb.max.y, aabb.min.z),
-                        /*vec3(aabb.max.x, aabb.max.y, aabb.max.z)*/ aabb.max };
-
-    for (vec3 const& corner : corners) {
-        if (isPointInside(corner)) {
-            return true;
-        }
+    // The box is outside of a plane if its center is further away from it than the box's extent projected onto the plane normal
+    vec3 center = (aabb.min + aabb.max) * 0.5f;
+    vec3 extent = (aabb.max - aabb.min) * 0.5f;
+
+#if defined(FRUSTUM_USE_SSE)
+    __m128 centerX = _mm_set1_ps(center.x);
+    __m128 centerY = _mm_set1_ps(center.y);
+    __m128 centerZ = _mm_set1_ps(center.z);
+    __m128 extentX = _mm_set1_ps(extent.x);
+    __m128 extentY = _mm_set1_ps(extent.y);
+    __m128 extentZ = _mm_set1_ps(extent.z);
+    __m128 signMask = _mm_set1_ps(-0.0f);
+
+    int outsideMask = 0;
+    for (size_t lane = 0; lane < 8; lane += 4) {
+        __m128 normalX = _mm_load_ps(m_planeNormalX + lane);
+        __m128 normalY = _mm_load_ps(m_planeNormalY + lane);
+        __m128 normalZ = _mm_load_ps(m_planeNormalZ + lane);
+
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)),
+                                     _mm_add_ps(_mm_mul_ps(normalZ, centerZ), _mm_load_ps(m_planeDistance + lane)));
+        __m128 projectedExtent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, normalX), extentX),
+                                                       _mm_mul_ps(_mm_andnot_ps(signMask, normalY), extentY)),
+                                            _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), extentZ));
+
+        outsideMask |= _mm_movemask_ps(_mm_cmpgt_ps(distance, projectedExtent));
+    }
+
+    return outsideMask == 0;
+#else
+    for (const Plane& plane : m_planes) {
+        vec3 normal = plane.normal();
+        float distance = dot(normal, center) + plane.distance();
+        float projectedExtent = std::abs(normal.x) * extent.x + std::abs(normal.y) * extent.y + std::abs(normal.z) * extent.z;
+        if (distance > projectedExtent)
+            return false;
     }
 
-    return false;
+    return true;
+#endif
 }
 
 Plane const& Frustum::plane(size_t idx) const
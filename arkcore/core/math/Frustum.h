@@ -25,6 +25,13 @@ private:
 
     // NOTE: normal of planes are pointing outwards!
     Plane m_planes[6];
+
+    // The same planes in structure-of-arrays form for testing against all planes at once with SIMD. The last two
+    // lanes repeat the first plane so that all 8 lanes always contain a valid plane.
+    alignas(16) float m_planeNormalX[8] {};
+    alignas(16) float m_planeNormalY[8] {};
+    alignas(16) float m_planeNormalZ[8] {};
+    alignas(16) float m_planeDistance[8] {};
 };
 
 }
@@ -3,8 +3,91 @@
 #include "core/Logging.h"
 #include "TaskGraph.h"
 
+#include <ark/core.h>
 #include <vector>
 
+namespace ParallelForDetail {
+
+// Number of ranges to split the work into per thread that can execute it. More ranges than threads lets faster
+// threads pick up more work so we balance the load even when the cost per item varies.
+constexpr size_t RangesPerThread = 4;
+
+inline size_t automaticGrainSize(size_t count)
+{
+    size_t threadCount = TaskGraph::get().workerThreadCountExcludingSelf() + 1;
+    size_t targetRangeCount = threadCount * RangesPerThread;
+    return ark::divideAndRoundUp(count, targetRangeCount);
+}
+
+template<typename RangeFunction>
+struct RangeSplitContext {
+    Task& rootTask;
+    RangeFunction& rangeBody;
+};
+
+template<typename RangeFunction>
+void splitAndExecuteRanges(RangeSplitContext<RangeFunction>& context, size_t firstRangeIdx, size_t lastRangeIdx)
+{
+    // Keep splitting the ranges in half, handing off the upper half to other threads, until only a single range is left
+    // for this thread to execute. This way the calling thread doesn't have to create and enqueue every single task.
+    while (lastRangeIdx - firstRangeIdx > 1) {
+        size_t midRangeIdx = firstRangeIdx + (lastRangeIdx - firstRangeIdx) / 2;
+
+        Task& task = Task::createWithParent(context.rootTask, [&context, midRangeIdx, lastRangeIdx]() {
+            splitAndExecuteRanges(context, midRangeIdx, lastRangeIdx);
+        });
+
+        task.autoReleaseOnCompletion();
+        TaskGraph::get().scheduleTask(task);
+
+        lastRangeIdx = midRangeIdx;
+    }
+
+    context.rangeBody(firstRangeIdx);
+}
+
+template<typename RangeFunction>
+void executeRanges(size_t rangeCount, RangeFunction&& rangeBody)
+{
+    TaskGraph& taskGraph = TaskGraph::get();
+    Task& rootTask = Task::createEmpty();
+
+    RangeSplitContext<RangeFunction> context { rootTask, rangeBody };
+    splitAndExecuteRanges(context, 0, rangeCount);
+
+    // Finish the (empty) root task itself, so that it's only waiting for the child tasks to complete
+    rootTask.executeSynchronous();
+
+    taskGraph.waitForCompletion(rootTask);
+    rootTask.release();
+}
+
+template<typename Function>
+void parallelForWithGrainSize(size_t count, size_t grainSize, Function& body)
+{
+    size_t rangeCount = ark::divideAndRoundUp(count, grainSize);
+
+    if (rangeCount == 1) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            body(idx);
+        }
+        return;
+    }
+
+    executeRanges(rangeCount, [&](size_t rangeIdx) {
+        size_t firstIdx = rangeIdx * grainSize;
+        size_t lastIdx = std::min(firstIdx + grainSize, count);
+
+        for (size_t idx = firstIdx; idx < lastIdx; ++idx) {
+            body(idx);
+        }
+    });
+}
+
+}
+
+// Calls `body(idx)` for every index in [0, count) using the task graph. The index range is split up recursively over the
+// available threads, and the grain size (number of indices processed per task) is picked based on the worker count.
 template<typename Function>
 void ParallelFor(size_t count, Function&& body, bool singleThreaded = false)
 {
@@ -17,10 +100,6 @@ void ParallelFor(size_t count, Function&& body, bool singleThreaded = false)
         return;
     }
 
-    if (count > 1000) {
-        ARKOSE_LOG(Warning, "ParallelFor with large count ({}), consider using ParallelForBatched to reduce task enqueue overhead.", count);
-    }
-
     if (singleThreaded || !TaskGraph::isInitialized()) {
         for (size_t i = 0; i < count; ++i) {
             body(i);
@@ -28,25 +107,11 @@ void ParallelFor(size_t count, Function&& body, bool singleThreaded = false)
         return;
     }
 
-    TaskGraph& taskGraph = TaskGraph::get();
-    Task& rootTask = Task::createEmpty();
-
-    // TODO: Perhaps use a divide-and-conquer strategy so the calling thread doesn't have to do all task setup
-    for (size_t idx = 0; idx < count; ++idx) {
-
-        Task& task = Task::createWithParent(rootTask, [&body, idx]() {
-            body(idx);
-        });
-
-        task.autoReleaseOnCompletion();
-        taskGraph.scheduleTask(task);
-    }
-
-    taskGraph.scheduleTask(rootTask);
-    taskGraph.waitForCompletion(rootTask);
-    rootTask.release();
+    size_t grainSize = ParallelForDetail::automaticGrainSize(count);
+    ParallelForDetail::parallelForWithGrainSize(count, grainSize, body);
 }
 
+// Same as ParallelFor, but with an explicit grain size, i.e., `batchSize` indices will be processed per task.
 template<typename Function>
 void ParallelForBatched(size_t count, size_t batchSize, Function&& body, bool singleThreaded = false)
 {
@@ -56,10 +121,6 @@ void ParallelForBatched(size_t count, size_t batchSize, Function&& body, bool si
         return;
     }
 
-    if (batchSize == 1) {
-        return ParallelFor(count, std::move(body), singleThreaded);
-    }
-
     if (count <= batchSize || singleThreaded || !TaskGraph::isInitialized()) {
         for (size_t idx = 0; idx < count; ++idx) {
             body(idx);
@@ -67,15 +128,51 @@ void ParallelForBatched(size_t count, size_t batchSize, Function&& body, bool si
         return;
     }
 
-    size_t batchCount = ark::divideAndRoundUp(count, batchSize);
-    ParallelFor(batchCount, [&](size_t batchIdx) {
-
-        size_t firstIdx = batchIdx * batchSize;
-        size_t lastIdx = std::min(firstIdx + batchSize, count);
+    ParallelForDetail::parallelForWithGrainSize(count, batchSize, body);
+}
 
+// Calls `body(idx)` for every index in [0, count) using the task graph and combines the returned values using `reduce`,
+// starting from `identity`. Every range is reduced separately and the partial results are then combined in index order,
+// so the result is deterministic as long as `reduce` is associative (it doesn't have to be commutative).
+template<typename T, typename Function, typename ReduceFunction>
+T ParallelReduce(size_t count, T identity, Function&& body, ReduceFunction&& reduce, bool singleThreaded = false)
+{
+    auto reduceRange = [&](size_t firstIdx, size_t lastIdx) -> T {
+        T result = identity;
         for (size_t idx = firstIdx; idx < lastIdx; ++idx) {
-            body(idx);
+            result = reduce(std::move(result), body(idx));
         }
+        return result;
+    };
+
+    if (count <= 1 || singleThreaded || !TaskGraph::isInitialized()) {
+        return reduceRange(0, count);
+    }
+
+    size_t grainSize = ParallelForDetail::automaticGrainSize(count);
+    size_t rangeCount = ark::divideAndRoundUp(count, grainSize);
+
+    if (rangeCount == 1) {
+        return reduceRange(0, count);
+    }
+
+    // NOTE: Keep each partial result on its own cache line to avoid false sharing between the threads
+    struct alignas(64) PartialResult {
+        T value;
+    };
 
+    std::vector<PartialResult> partialResults(rangeCount, PartialResult { identity });
+
+    ParallelForDetail::executeRanges(rangeCount, [&](size_t rangeIdx) {
+        size_t firstIdx = rangeIdx * grainSize;
+        size_t lastIdx = std::min(firstIdx + grainSize, count);
+        partialResults[rangeIdx].value = reduceRange(firstIdx, lastIdx);
     });
+
+    T result = std::move(identity);
+    for (PartialResult& partialResult : partialResults) {
+        result = reduce(std::move(result), std::move(partialResult.value));
+    }
+
+    return result;
 }
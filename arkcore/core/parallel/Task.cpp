@@ -2,6 +2,10 @@
 
 #include "core/Assert.h"
 #include "core/Logging.h"
+#include "core/parallel/TaskGraph.h"
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #if defined(NDEBUG)
  #define WITH_LIFETIME_TRACKING 0
@@ -13,24 +17,160 @@ namespace {
 #if WITH_LIFETIME_TRACKING
 static std::atomic_int64_t g_numAliveTasks { 0 };
 #endif
+
+// Pool of fixed-size memory slots for tasks, so that creating a task never has to touch the global allocator once
+// the pool has warmed up. Every thread has its own free lists so allocating and releasing doesn't need any locking.
+// Tasks are often created on one thread and released on another (e.g. ParallelFor creates all tasks on the calling
+// thread while they are auto-released on the workers) so released slots are handed back in batches through a shared
+// list, meaning we only have to take a lock once every `SlotsPerBatch` tasks. Tasks can be released at any time, even
+// after the task graph has shut down, so the memory of the pool is kept for the lifetime of the program and reused.
+class TaskPool {
+public:
+    void* allocate();
+    void free(void*);
+
+private:
+    struct alignas(Task) Slot {
+        union {
+            Slot* next;
+            std::byte data[sizeof(Task)];
+        };
+    };
+
+    struct SlotList {
+        Slot* head { nullptr };
+        u32 count { 0 };
+
+        void push(Slot* slot)
+        {
+            slot->next = head;
+            head = slot;
+            count += 1;
+        }
+
+        Slot* pop()
+        {
+            Slot* slot = head;
+            head = slot->next;
+            count -= 1;
+            return slot;
+        }
+    };
+
+    struct ThreadLocalSlots {
+        // Hand the free slots back to the pool when the thread exits, so they can be used by other threads
+        ~ThreadLocalSlots();
+
+        SlotList allocateList {};
+        SlotList releaseList {};
+    };
+
+    static constexpr u32 SlotsPerBatch = 64;
+    static constexpr u32 SlotsPerChunk = 16 * SlotsPerBatch;
+
+    ThreadLocalSlots& threadLocalSlots();
+    SlotList acquireBatch();
+    void releaseBatch(SlotList);
+
+    std::mutex m_mutex {};
+    std::vector<std::unique_ptr<Slot[]>> m_chunks {};
+    std::vector<SlotList> m_freeBatches {};
+};
+
+static TaskPool g_taskPool {};
+
+TaskPool::ThreadLocalSlots::~ThreadLocalSlots()
+{
+    g_taskPool.releaseBatch(allocateList);
+    g_taskPool.releaseBatch(releaseList);
+}
+
+TaskPool::ThreadLocalSlots& TaskPool::threadLocalSlots()
+{
+    thread_local ThreadLocalSlots slots {};
+    return slots;
+}
+
+TaskPool::SlotList TaskPool::acquireBatch()
+{
+    std::scoped_lock<std::mutex> lock { m_mutex };
+
+    if (m_freeBatches.empty()) {
+        auto& chunk = m_chunks.emplace_back(std::make_unique<Slot[]>(SlotsPerChunk));
+        for (u32 batchStart = 0; batchStart < SlotsPerChunk; batchStart += SlotsPerBatch) {
+            SlotList& batch = m_freeBatches.emplace_back();
+            for (u32 idx = batchStart; idx < batchStart + SlotsPerBatch; ++idx) {
+                batch.push(&chunk[idx]);
+            }
+        }
+    }
+
+    SlotList batch = m_freeBatches.back();
+    m_freeBatches.pop_back();
+    return batch;
+}
+
+void TaskPool::releaseBatch(SlotList batch)
+{
+    // NOTE: The batch doesn't have to be full, allocate() will simply acquire another one sooner
+    if (batch.count > 0) {
+        std::scoped_lock<std::mutex> lock { m_mutex };
+        m_freeBatches.push_back(batch);
+    }
+}
+
+void* TaskPool::allocate()
+{
+    ThreadLocalSlots& slots = threadLocalSlots();
+
+    if (slots.allocateList.count == 0) {
+        if (slots.releaseList.count > 0) {
+            std::swap(slots.allocateList, slots.releaseList);
+        } else {
+            slots.allocateList = acquireBatch();
+        }
+    }
+
+    return slots.allocateList.pop()->data;
+}
+
+void TaskPool::free(void* memory)
+{
+    ThreadLocalSlots& slots = threadLocalSlots();
+    slots.releaseList.push(reinterpret_cast<Slot*>(memory));
+
+    if (slots.releaseList.count == SlotsPerBatch) {
+        releaseBatch(slots.releaseList);
+        slots.releaseList = {};
+    }
+}
+
 }
 
 Task& Task::create(TaskFunction&& taskFunction)
 {
     // NOTE: See auto-release logic!
-    return *new Task(std::move(taskFunction), nullptr);
+    return createPooled(std::move(taskFunction), nullptr);
 }
 
 Task& Task::createEmpty()
 {
     // NOTE: See auto-release logic!
-    return *new Task(TaskFunction(), nullptr);
+    return createPooled(TaskFunction(), nullptr);
 }
 
 Task& Task::createWithParent(Task& parentTask, TaskFunction&& taskFunction)
 {
     // NOTE: See auto-release logic!
-    return *new Task(std::move(taskFunction), &parentTask);
+    return createPooled(std::move(taskFunction), &parentTask);
+}
+
+Task& Task::createPooled(TaskFunction&& taskFunction, Task* parentTask)
+{
+    void* memory = g_taskPool.allocate();
+    Task* task = new (memory) Task(std::move(taskFunction), parentTask);
+    task->m_pooled = true;
+    return *task;
 }
 
 Task::Task(TaskFunction&& taskFunction, Task* parentTask)
@@ -57,19 +197,74 @@ Task::~Task()
 
 void Task::executeSynchronous()
 {
+    // NOTE: Only the implicit "not yet scheduled" dependency may remain, as we can't synchronously wait for dependencies here
+    ARKOSE_ASSERTM(m_unresolvedDependencies.load() <= 1, "Can't synchronously execute a task with unresolved dependencies");
     execute();
 }
 
 bool Task::isCompleted() const
 {
-    return m_unfinishedTasks.load(std::memory_order_seq_cst) == 0;
+    return m_completed.load(std::memory_order_seq_cst);
 }
 
 void Task::release()
 {
     // NOTE: Yeah I don't love this, but the idea is to expose and pass around Tasks as references, so I don't want to expose
     // the memory management of it. I'd prefer it to seem more of an implementation detail to the whole task graph system.
-    delete this;
+    if (m_pooled) {
+        this->~Task();
+        g_taskPool.free(this);
+    } else {
+        delete this;
+    }
+}
+
+void Task::addDependency(Task& predecessor)
+{
+    ARKOSE_ASSERT(&predecessor != this);
+
+    std::scoped_lock<std::mutex> lock { predecessor.m_continuationsMutex };
+
+    // If the predecessor has already completed there is nothing to wait for
+    if (predecessor.m_continuationsResolved) {
+        return;
+    }
+
+    m_unresolvedDependencies.fetch_add(1);
+    predecessor.m_continuations.push_back(this);
+}
+
+void Task::then(TaskFunction&& taskFunction, QueueType queueType)
+{
+    Task& continuation = Task::create(std::move(taskFunction));
+    continuation.addDependency(*this);
+    continuation.autoReleaseOnCompletion();
+
+    TaskGraph::get().scheduleTask(continuation, queueType);
+}
+
+bool Task::resolveDependency()
+{
+    i32 previousCount = m_unresolvedDependencies.fetch_sub(1);
+    ARKOSE_ASSERT(previousCount > 0);
+    return previousCount == 1;
+}
+
+void Task::resolveContinuations()
+{
+    std::vector<Task*> continuations {};
+
+    {
+        std::scoped_lock<std::mutex> lock { m_continuationsMutex };
+        m_continuationsResolved = true;
+        std::swap(continuations, m_continuations);
+    }
+
+    for (Task* continuation : continuations) {
+        if (continuation->resolveDependency()) {
+            TaskGraph::get().enqueueTask(*continuation, continuation->m_queueType);
+        }
+    }
 }
 
 void Task::autoReleaseOnCompletion()
@@ -89,13 +284,27 @@ void Task::execute()
 void Task::finish()
 {
     bool completed = m_unfinishedTasks.fetch_sub(1) == 1;
-    if (completed && m_parentTask) {
-        m_parentTask->finish();
+    if (!completed) {
+        // The last child task to finish will finish this task
+        return;
     }
 
-    if (m_autoReleaseOnCompletion) {
+    resolveContinuations();
+
+    // NOTE: Whoever is waiting for this task may release it as soon as it's marked as completed, so we can't touch
+    // any of its members after that point.
+    Task* parentTask = m_parentTask;
+    bool autoRelease = m_autoReleaseOnCompletion;
+
+    m_completed.store(true, std::memory_order_seq_cst);
+
+    if (autoRelease) {
         release();
     }
+
+    if (parentTask) {
+        parentTask->finish();
+    }
 }
 
 void Task::initializeTasks()
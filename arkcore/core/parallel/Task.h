@@ -2,10 +2,17 @@
 
 #include <ark/copying.h>
 #include "core/Types.h"
+#include "core/parallel/TaskFunction.h"
 #include <atomic>
-#include <functional>
+#include <mutex>
+#include <vector>
 
-using TaskFunction = std::function<void()>;
+enum class QueueType {
+    // For frame-critical work, will be picked up before any other tasks
+    HighPriority,
+    Default,
+    Background,
+};
 
 class Task {
 public:
@@ -20,6 +27,15 @@ public:
 
     bool isCompleted() const;
 
+    // Make this task wait for `predecessor` to complete (including its child tasks) before it's executed. When scheduled,
+    // the task will be held back by the task graph and only enqueued once all its dependencies have completed. Must be
+    // called before this task is scheduled, but it's fine if the predecessor has already completed at this point.
+    void addDependency(Task& predecessor);
+
+    // Create a continuation task which will be executed once this task has completed. The continuation is scheduled
+    // on the given queue and auto-released when it completes, so no reference to it is returned as it could dangle.
+    void then(TaskFunction&&, QueueType = QueueType::Default);
+
     void release();
     virtual void autoReleaseOnCompletion();
 
@@ -32,12 +48,30 @@ private:
     void execute();
     void finish();
 
+    // Returns true if this call resolved the last dependency, meaning it's up to the caller to enqueue the task
+    bool resolveDependency();
+    void resolveContinuations();
+
     static void initializeTasks();
     static void shutdownTasks();
 
+    // Tasks created through the static create functions are allocated from a task pool, see Task.cpp
+    static Task& createPooled(TaskFunction&&, Task* parentTask);
+    bool m_pooled { false };
+
     TaskFunction m_function {};
 
     Task* m_parentTask { nullptr };
     std::atomic_int32_t m_unfinishedTasks { 1 };
+    std::atomic_bool m_completed { false };
     std::atomic_bool m_autoReleaseOnCompletion { false };
+
+    // Number of tasks this task is waiting for, plus one for not yet having been scheduled
+    std::atomic_int32_t m_unresolvedDependencies { 1 };
+    QueueType m_queueType { QueueType::Default };
+
+    // Tasks waiting for this task to complete
+    std::mutex m_continuationsMutex {};
+    std::vector<Task*> m_continuations {};
+    bool m_continuationsResolved { false };
 };
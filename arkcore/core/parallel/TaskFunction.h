@@ -0,0 +1,143 @@
+#pragma once
+
+#include "core/Types.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Type-erased `void()` callable, similar to std::function, but with inline storage large enough for the
+// typical task lambda so that creating a task doesn't have to touch the global allocator. Callables which
+// don't fit the inline storage are still supported but will be heap-allocated.
+class TaskFunction final {
+public:
+    static constexpr size_t InlineStorageSize = 48;
+
+    TaskFunction() = default;
+
+    template<typename Function>
+        requires(!std::is_same_v<std::decay_t<Function>, TaskFunction>)
+    TaskFunction(Function&& function);
+
+    TaskFunction(TaskFunction&&) noexcept;
+    TaskFunction& operator=(TaskFunction&&) noexcept;
+
+    TaskFunction(TaskFunction const&) = delete;
+    TaskFunction& operator=(TaskFunction const&) = delete;
+
+    ~TaskFunction() { reset(); }
+
+    explicit operator bool() const { return m_invoke != nullptr; }
+    void operator()() { m_invoke(m_storage); }
+
+    void reset();
+
+    template<typename Function>
+    static constexpr bool storesInline()
+    {
+        return sizeof(Function) <= InlineStorageSize
+            && alignof(Function) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<Function>;
+    }
+
+private:
+    enum class Operation {
+        MoveTo,
+        Destroy,
+    };
+
+    using InvokeFunction = void (*)(void* storage);
+    using ManageFunction = void (*)(Operation, void* storage, void* otherStorage);
+
+    alignas(std::max_align_t) std::byte m_storage[InlineStorageSize];
+    InvokeFunction m_invoke { nullptr };
+    ManageFunction m_manage { nullptr };
+};
+
+template<typename Function>
+    requires(!std::is_same_v<std::decay_t<Function>, TaskFunction>)
+TaskFunction::TaskFunction(Function&& function)
+{
+    using FunctionType = std::decay_t<Function>;
+
+    if constexpr (std::is_pointer_v<FunctionType> || std::is_constructible_v<bool, FunctionType const&>) {
+        // E.g. function pointers or std::function, which can be "empty"
+        if (!static_cast<bool>(function)) {
+            return;
+        }
+    }
+
+    if constexpr (storesInline<FunctionType>()) {
+
+        new (m_storage) FunctionType(std::forward<Function>(function));
+
+        m_invoke = [](void* storage) {
+            (*std::launder(reinterpret_cast<FunctionType*>(storage)))();
+        };
+
+        m_manage = [](Operation operation, void* storage, void* otherStorage) {
+            FunctionType* self = std::launder(reinterpret_cast<FunctionType*>(storage));
+            switch (operation) {
+            case Operation::MoveTo:
+                new (otherStorage) FunctionType(std::move(*self));
+                self->~FunctionType();
+                break;
+            case Operation::Destroy:
+                self->~FunctionType();
+                break;
+            }
+        };
+
+    } else {
+
+        new (m_storage) FunctionType*(new FunctionType(std::forward<Function>(function)));
+
+        m_invoke = [](void* storage) {
+            (**std::launder(reinterpret_cast<FunctionType**>(storage)))();
+        };
+
+        m_manage = [](Operation operation, void* storage, void* otherStorage) {
+            FunctionType* self = *std::launder(reinterpret_cast<FunctionType**>(storage));
+            switch (operation) {
+            case Operation::MoveTo:
+                new (otherStorage) FunctionType*(self);
+                break;
+            case Operation::Destroy:
+                delete self;
+                break;
+            }
+        };
+
+    }
+}
+
+inline TaskFunction::TaskFunction(TaskFunction&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+inline TaskFunction& TaskFunction::operator=(TaskFunction&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+
+        if (other.m_manage) {
+            other.m_manage(Operation::MoveTo, other.m_storage, m_storage);
+        }
+
+        m_invoke = std::exchange(other.m_invoke, nullptr);
+        m_manage = std::exchange(other.m_manage, nullptr);
+    }
+
+    return *this;
+}
+
+inline void TaskFunction::reset()
+{
+    if (m_manage) {
+        m_manage(Operation::Destroy, m_storage, nullptr);
+    }
+
+    m_invoke = nullptr;
+    m_manage = nullptr;
+}
@@ -6,6 +6,11 @@
 #include <atomic>
 #include <fmt/format.h>
 
+#if PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #define SCOPED_PROFILE_ZONE_TASKGRAPH() SCOPED_PROFILE_ZONE_COLOR(0xaa33aa)
 
 static std::unique_ptr<TaskGraph> g_taskGraphInstance { nullptr };
@@ -14,20 +19,55 @@ std::mutex TaskGraph::s_taskQueueListMutex {};
 std::atomic_bool TaskGraph::s_validated { false };
 
 TaskGraph::PerThreadTaskQueues TaskGraph::s_taskQueueList {};
-TaskGraph::ThreadTaskQueueLookupMap TaskGraph::s_taskQueueLookup {};
 
-void TaskGraph::initialize()
+thread_local TaskGraph::TaskQueues* TaskGraph::s_taskQueuesForThisThread { nullptr };
+thread_local size_t TaskGraph::s_taskQueueIndexForThisThread { 0 };
+thread_local bool TaskGraph::s_thisThreadIsWorker { false };
+thread_local u32 TaskGraph::s_stealRandomState { 0 };
+
+static bool setAffinityForActiveThread(u32 coreIdx)
+{
+#if PLATFORM_WINDOWS
+    // Systems with more than 64 logical cores split them into processor groups, so find the group which contains this core
+    WORD groupCount = GetActiveProcessorGroupCount();
+    for (WORD group = 0; group < groupCount; ++group) {
+        DWORD groupCoreCount = GetActiveProcessorCount(group);
+        if (coreIdx < groupCoreCount) {
+            GROUP_AFFINITY groupAffinity {};
+            groupAffinity.Group = group;
+            groupAffinity.Mask = KAFFINITY(1) << coreIdx;
+            return SetThreadGroupAffinity(GetCurrentThread(), &groupAffinity, nullptr) != 0;
+        }
+        coreIdx -= groupCoreCount;
+    }
+    return false;
+#elif PLATFORM_LINUX
+    if (coreIdx >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(coreIdx, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    // Not supported on this platform (e.g. macOS only supports affinity hints, not explicit pinning)
+    return false;
+#endif
+}
+
+void TaskGraph::initialize(TaskGraphSettings settings)
 {
     SCOPED_PROFILE_ZONE_TASKGRAPH();
 
     Task::initializeTasks();
 
-    if (std::thread::hardware_concurrency() == 1) {
+    if (!settings.numDefaultWorkerThreads.has_value() && std::thread::hardware_concurrency() == 1) {
         ARKOSE_LOG(Fatal, "TaskGraph: this CPU only supports a single hardware thread, which is not compatible with this TaskGraph, exiting.");
     }
 
     ARKOSE_ASSERT(g_taskGraphInstance == nullptr);
-    g_taskGraphInstance = std::unique_ptr<TaskGraph>(new TaskGraph());
+    g_taskGraphInstance = std::unique_ptr<TaskGraph>(new TaskGraph(settings));
 }
 
 void TaskGraph::shutdown()
@@ -49,14 +89,22 @@ TaskGraph& TaskGraph::get()
     return *g_taskGraphInstance;
 }
 
-TaskGraph::TaskGraph()
+TaskGraph::TaskGraph(TaskGraphSettings settings)
+    : m_workerIdleMode(settings.workerIdleMode)
 {
-    unsigned int hardwareConcurrency = std::thread::hardware_concurrency();
+    u32 hardwareConcurrency = std::max(std::thread::hardware_concurrency(), 1u);
 
-    u32 numDefaultWorkerThreads = std::min(hardwareConcurrency - 1, 10u);
+    u32 numDefaultWorkerThreads = settings.numDefaultWorkerThreads.value_or(hardwareConcurrency - 1);
+    u32 numBackgroundWorkerThreads = settings.numBackgroundWorkerThreads;
 
-    // These don't necessarily need to be on hardware threads
-    u32 numBackgroundWorkerThreads = 2;
+    ARKOSE_ASSERT(numDefaultWorkerThreads > 0);
+
+    if (settings.pinWorkerThreadsToCores && numDefaultWorkerThreads >= hardwareConcurrency) {
+        ARKOSE_LOG(Warning, "TaskGraph: more default workers ({}) than available cores excluding the main thread, some will share cores.", numDefaultWorkerThreads);
+    }
+
+    ARKOSE_LOG(Info, "TaskGraph: creating {} default and {} background worker threads{}", numDefaultWorkerThreads, numBackgroundWorkerThreads,
+               settings.pinWorkerThreadsToCores ? " (pinned to cores)" : "");
 
     // NOTE: The +1 is for the main thread queues, i.e. this current one which doesn't get an explicit worker
     const size_t numExpectedTaskQueues = (numDefaultWorkerThreads + numBackgroundWorkerThreads) + 1;
@@ -65,15 +113,22 @@ TaskGraph::TaskGraph()
 
     u64 workerId = 1;
 
-    for (size_t i = 0; i < numDefaultWorkerThreads; ++i) {
+    for (u32 i = 0; i < numDefaultWorkerThreads; ++i) {
         std::string workerName = fmt::format("TaskGraphWorker{}", i + 1);
-        m_workers.push_back(std::make_unique<Worker>(*this, WorkStrategy::Default, workerId, workerName));
+
+        // Leave the first core for the main thread
+        std::optional<u32> pinnedCore {};
+        if (settings.pinWorkerThreadsToCores && hardwareConcurrency > 1) {
+            pinnedCore = 1 + (i % (hardwareConcurrency - 1));
+        }
+
+        m_workers.push_back(std::make_unique<Worker>(*this, WorkStrategy::Default, workerId, workerName, pinnedCore));
         workerId += 1;
     }
 
-    for (size_t i = 0; i < numBackgroundWorkerThreads; ++i) {
+    for (u32 i = 0; i < numBackgroundWorkerThreads; ++i) {
         std::string workerName = fmt::format("TaskGraphBackgroundWorker{}", i + 1);
-        m_workers.push_back(std::make_unique<Worker>(*this, WorkStrategy::BackgroundOnly, workerId, workerName));
+        m_workers.push_back(std::make_unique<Worker>(*this, WorkStrategy::BackgroundOnly, workerId, workerName, std::nullopt));
         workerId += 1;
     }
 
@@ -106,7 +161,11 @@ TaskGraph::~TaskGraph()
     {
         std::scoped_lock<std::mutex> lock { s_taskQueueListMutex };
         s_taskQueueList.clear();
+        s_validated = false;
     }
+
+    // NOTE: The worker threads are all gone now, but the thread that created the task graph might create a new one later
+    s_taskQueuesForThisThread = nullptr;
 }
 
 size_t TaskGraph::workerThreadCount() const
@@ -124,21 +183,63 @@ size_t TaskGraph::workerThreadCountExcludingSelf() const
 
 bool TaskGraph::thisThreadIsWorker() const
 {
-    auto callingThreadId = std::this_thread::get_id();
-    for (const auto& worker : m_workers) {
-        if (callingThreadId == worker->threadId()) {
-            return true;
-        }
-    }
-    return false;
+    return s_thisThreadIsWorker;
 }
 
 void TaskGraph::scheduleTask(Task& task, QueueType queueType)
+{
+    task.m_queueType = queueType;
+
+    // Resolve the implicit "not yet scheduled" dependency. If there are other unresolved dependencies the task will be
+    // enqueued by whatever thread completes the last one of them, see Task::resolveContinuations().
+    if (task.resolveDependency()) {
+        enqueueTask(task, queueType);
+    }
+}
+
+void TaskGraph::enqueueTask(Task& task, QueueType queueType)
 {
     // Always enqueue on own queue, let other workers steal from this
     TaskQueues& taskQueues = taskQueuesForThisThread();
     TaskQueue& taskQueue = taskQueues.queue(queueType);
     taskQueue.enqueue(&task);
+
+    // NOTE: This must be sequentially consistent with the worker setting its parked flag and then checking the queues
+    // one last time before going to sleep, as otherwise we could miss waking a worker that is about to park.
+    if (m_numParkedWorkers.load(std::memory_order_seq_cst) > 0) {
+        wakeWorkerForQueue(queueType);
+    }
+}
+
+void TaskGraph::wakeWorkerForQueue(QueueType queueType)
+{
+    // Prefer waking up the workers which only can execute tasks from this queue type, so that we keep as many
+    // default workers available for default work as possible. For default tasks this is simply the default workers.
+    if (queueType == QueueType::Background) {
+        for (auto& worker : m_workers) {
+            if (worker->strategy() == WorkStrategy::BackgroundOnly && worker->tryUnpark()) {
+                return;
+            }
+        }
+    }
+
+    for (auto& worker : m_workers) {
+        if (worker->canExecuteTasksFrom(queueType) && worker->tryUnpark()) {
+            return;
+        }
+    }
+}
+
+TaskGraph::IdleStatistics TaskGraph::idleStatistics() const
+{
+    IdleStatistics statistics {};
+    for (auto const& worker : m_workers) {
+        IdleStatistics workerStatistics = worker->idleStatistics();
+        statistics.spins += workerStatistics.spins;
+        statistics.parks += workerStatistics.parks;
+        statistics.wakeups += workerStatistics.wakeups;
+    }
+    return statistics;
 }
 
 void TaskGraph::waitForCompletion(Task& task)
@@ -146,7 +247,12 @@ void TaskGraph::waitForCompletion(Task& task)
     SCOPED_PROFILE_ZONE_TASKGRAPH();
 
     while (!task.isCompleted()) {
-        if (Task* otherTask = getNextTask(QueueType::Default)) {
+        Task* otherTask = getNextTask(QueueType::HighPriority);
+        if (!otherTask) {
+            otherTask = getNextTask(QueueType::Default);
+        }
+
+        if (otherTask) {
             SCOPED_PROFILE_ZONE_NAME_AND_COLOR("Execute task", 0xaa33aa);
             otherTask->execute();
         } else {
@@ -175,7 +281,8 @@ void TaskGraph::waitUntilGraphIsIdle() const
 }
 
 TaskGraph::TaskQueues::TaskQueues()
-    : defaultQueue(1024)
+    : highPriorityQueue(256)
+    , defaultQueue(1024)
     , backgroundQueue(100)
 {
 }
@@ -187,6 +294,8 @@ TaskGraph::TaskQueues::~TaskQueues()
 TaskGraph::TaskQueue& TaskGraph::TaskQueues::queue(QueueType queueType)
 {
     switch (queueType) {
+    case QueueType::HighPriority:
+        return highPriorityQueue;
     case QueueType::Default:
         return defaultQueue;
     case QueueType::Background:
@@ -200,11 +309,15 @@ TaskGraph::TaskQueues& TaskGraph::createTaskQueuesForThisThread()
 {
     std::scoped_lock<std::mutex> lock { s_taskQueueListMutex };
 
+    ARKOSE_ASSERT(s_taskQueuesForThisThread == nullptr);
+
+    s_taskQueueIndexForThisThread = s_taskQueueList.size();
     auto& taskQueues = s_taskQueueList.emplace_back(std::make_unique<TaskQueues>());
+    s_taskQueuesForThisThread = taskQueues.get();
 
-    std::thread::id threadId = std::this_thread::get_id();
-    ARKOSE_ASSERT(!s_taskQueueLookup.contains(threadId));
-    s_taskQueueLookup[threadId] = taskQueues.get();
+    // Seed the victim selection differently for each thread so not all thieves start with the same queue
+    // NOTE: xorshift requires a non-zero state
+    s_stealRandomState = (static_cast<u32>(s_taskQueueIndexForThisThread + 1) * 0x9e3779b9u) | 1u;
 
     return *taskQueues;
 }
@@ -212,17 +325,8 @@ TaskGraph::TaskQueues& TaskGraph::createTaskQueuesForThisThread()
 TaskGraph::TaskQueues& TaskGraph::taskQueuesForThisThread()
 {
     // NOTE: All threads must register at startup, before ever calling this function!
-    // After that the task queue map is immutable so we make no attempt at guarding access to it
-
-    // TODO: Could use thread-local storage for this
-    std::thread::id threadId = std::this_thread::get_id();
-    auto entry = s_taskQueueLookup.find(threadId);
-
-    ARKOSE_ASSERT(entry != s_taskQueueLookup.end());
-    ARKOSE_ASSERT(entry->second != nullptr);
-
-    TaskQueues* taskQueues = entry->second;
-    return *taskQueues;
+    ARKOSE_ASSERT(s_taskQueuesForThisThread != nullptr);
+    return *s_taskQueuesForThisThread;
 }
 
 void TaskGraph::validateTaskQueueMap(size_t expectedCount)
@@ -243,10 +347,23 @@ Task* TaskGraph::getNextTask(QueueType queueType)
         return nextTask;
     }
 
-    // Try stealing one from another thread's queue
-    // NOTE: For now the queue is short enough that we can just try all.. (including our own queue again)
-    for (auto& stealTaskQueue : s_taskQueueList) {
-        if (stealTaskQueue->queue(queueType).try_dequeue(nextTask)) {
+    // Try stealing one from another thread's queue, starting from a random victim so that not all thieves contend on the same queue
+    // NOTE: For now the list is short enough that we can just try all of them
+    size_t queueCount = s_taskQueueList.size();
+
+    u32& randomState = s_stealRandomState;
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    size_t firstVictimIdx = randomState % queueCount;
+    for (size_t offset = 0; offset < queueCount; ++offset) {
+        size_t victimIdx = (firstVictimIdx + offset) % queueCount;
+        if (victimIdx == s_taskQueueIndexForThisThread) {
+            continue;
+        }
+
+        if (s_taskQueueList[victimIdx]->queue(queueType).try_dequeue(nextTask)) {
             return nextTask;
         }
     }
@@ -258,7 +375,10 @@ Task* TaskGraph::getNextTaskForWorkStrategy(WorkStrategy strategy)
 {
     switch (strategy) {
     case WorkStrategy::Default: {
-        Task* task = getNextTask(QueueType::Default);
+        Task* task = getNextTask(QueueType::HighPriority);
+        if (!task) {
+            task = getNextTask(QueueType::Default);
+        }
         if (!task) {
             task = getNextTask(QueueType::Background);
         }
@@ -271,11 +391,12 @@ Task* TaskGraph::getNextTaskForWorkStrategy(WorkStrategy strategy)
     }
 }
 
-TaskGraph::Worker::Worker(TaskGraph& owningTaskGraph, WorkStrategy strategy, u64 workerId, std::string name)
+TaskGraph::Worker::Worker(TaskGraph& owningTaskGraph, WorkStrategy strategy, u64 workerId, std::string name, std::optional<u32> pinnedCore)
     : m_taskGraph(&owningTaskGraph)
     , m_strategy(strategy)
     , m_name(std::move(name))
     , m_workerId(workerId)
+    , m_pinnedCore(pinnedCore)
 {
     m_thread = std::thread([this]() {
 
@@ -283,8 +404,13 @@ TaskGraph::Worker::Worker(TaskGraph& owningTaskGraph, WorkStrategy strategy, u64
             SCOPED_PROFILE_ZONE_NAME_AND_COLOR("Worker setup", 0xaa33aa);
             Profiling::setNameForActiveThread(m_name.c_str());
 
+            if (m_pinnedCore.has_value() && !setAffinityForActiveThread(*m_pinnedCore)) {
+                ARKOSE_LOG(Warning, "TaskGraph: failed to pin worker '{}' to core {}", m_name, *m_pinnedCore);
+            }
+
             m_threadId = std::this_thread::get_id();
             m_taskQueues = &TaskGraph::createTaskQueuesForThisThread();
+            s_thisThreadIsWorker = true;
 
             while (!s_validated) {
                 std::this_thread::sleep_for(std::chrono::nanoseconds::min());
@@ -293,42 +419,28 @@ TaskGraph::Worker::Worker(TaskGraph& owningTaskGraph, WorkStrategy strategy, u64
 
         while (m_alive) {
 
-            if (Task* taskToExecute = m_taskGraph->getNextTaskForWorkStrategy(m_strategy)) {
-
-                SCOPED_PROFILE_ZONE_NAME_AND_COLOR("Execute task", 0xaa33aa);
-
-                m_idle = false;
-                taskToExecute->execute();
-
-            } else {
+            Task* taskToExecute = m_taskGraph->getNextTaskForWorkStrategy(m_strategy);
 
+            if (!taskToExecute) {
                 m_idle = true;
-                std::this_thread::yield();
 
-                // TODO: Implement proper idle mode when no task has been found for a while
-
-                /*
-                m_idle = true;
+                if (m_taskGraph->m_workerIdleMode == WorkerIdleMode::YieldOnly) {
+                    std::this_thread::yield();
+                    continue;
+                }
 
-                std::unique_lock<std::mutex> idleLock { m_idleMutex };
-                m_idleCondition.wait(idleLock, [&]() {
-
-                    if (not m_alive) {
-                        return true;
-                    }
-
-                    if (m_taskQueue->try_dequeue(taskToExecute)) {
-                        return true;
-                    }
+                taskToExecute = spinForTask();
+            }
 
-                    return false;
+            if (!taskToExecute) {
+                taskToExecute = parkUntilWoken();
+            }
 
-                    // return !(m_alive && m_taskQueue->size_approx() == 0);
-                });
+            if (taskToExecute) {
+                SCOPED_PROFILE_ZONE_NAME_AND_COLOR("Execute task", 0xaa33aa);
 
                 m_idle = false;
-                */
-
+                taskToExecute->execute();
             }
         }
     });
@@ -352,7 +464,10 @@ const std::thread::id& TaskGraph::Worker::threadId() const
 
 void TaskGraph::Worker::triggerShutdown()
 {
-    m_alive = false;
+    {
+        std::scoped_lock<std::mutex> lock { m_idleMutex };
+        m_alive = false;
+    }
     m_idleCondition.notify_all();
 }
 
@@ -366,5 +481,90 @@ void TaskGraph::Worker::waitUntilShutdown()
 
 u64 TaskGraph::Worker::numWaitingTasks(QueueType queueType) const
 {
-    return taskQueuesForThisThread().queue(queueType).size_approx();
+    return m_taskQueues->queue(queueType).size_approx();
+}
+
+bool TaskGraph::Worker::canExecuteTasksFrom(QueueType queueType) const
+{
+    switch (m_strategy) {
+    case WorkStrategy::Default:
+        return true;
+    case WorkStrategy::BackgroundOnly:
+        return queueType == QueueType::Background;
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+bool TaskGraph::Worker::tryUnpark()
+{
+    bool expected = true;
+    if (!m_parked.compare_exchange_strong(expected, false)) {
+        return false;
+    }
+
+    {
+        // NOTE: Lock so that we can't notify in between the worker checking its wait predicate and it going to sleep
+        std::scoped_lock<std::mutex> lock { m_idleMutex };
+    }
+    m_idleCondition.notify_one();
+
+    m_wakeupCounter.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+TaskGraph::IdleStatistics TaskGraph::Worker::idleStatistics() const
+{
+    IdleStatistics statistics {};
+    statistics.spins = m_spinCounter.load(std::memory_order_relaxed);
+    statistics.parks = m_parkCounter.load(std::memory_order_relaxed);
+    statistics.wakeups = m_wakeupCounter.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+Task* TaskGraph::Worker::spinForTask()
+{
+    for (u32 spinIdx = 0; spinIdx < m_spinCount && m_alive; ++spinIdx) {
+
+        // Back off gradually, first just polling the queues again, then yielding our time slice
+        if (spinIdx >= MinSpinCount) {
+            std::this_thread::yield();
+        }
+
+        if (Task* task = m_taskGraph->getNextTaskForWorkStrategy(m_strategy)) {
+            m_spinCounter.fetch_add(spinIdx + 1, std::memory_order_relaxed);
+            m_spinCount = std::min(2 * m_spinCount, MaxSpinCount);
+            return task;
+        }
+    }
+
+    m_spinCounter.fetch_add(m_spinCount, std::memory_order_relaxed);
+    m_spinCount = std::max(m_spinCount / 2, MinSpinCount);
+    return nullptr;
+}
+
+Task* TaskGraph::Worker::parkUntilWoken()
+{
+    SCOPED_PROFILE_ZONE_NAME_AND_COLOR("Parked", 0xaa33aa);
+
+    m_parked.store(true, std::memory_order_seq_cst);
+    m_taskGraph->m_numParkedWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+    // Check one last time after announcing that we're parked, as a task could have been scheduled after we last
+    // checked the queues but before we marked ourselves as parked, in which case nobody will try to wake us up.
+    Task* task = m_taskGraph->getNextTaskForWorkStrategy(m_strategy);
+
+    if (!task) {
+        m_parkCounter.fetch_add(1, std::memory_order_relaxed);
+
+        std::unique_lock<std::mutex> idleLock { m_idleMutex };
+        m_idleCondition.wait_for(idleLock, MaxParkDuration, [this]() {
+            return !m_parked.load() || !m_alive.load();
+        });
+    }
+
+    m_taskGraph->m_numParkedWorkers.fetch_sub(1, std::memory_order_seq_cst);
+    m_parked.store(false, std::memory_order_seq_cst);
+
+    return task;
 }
@@ -4,38 +4,59 @@
 #include "core/Types.h"
 #include "core/parallel/Task.h"
 #include <concurrentqueue.h>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <optional>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 // TaskGraph / job system implementation based on the one outline here:
 // https://blog.molecular-matters.com/tag/job-system/
 
-enum class QueueType {
-    Default,
-    Background,
-};
-
 enum class WorkStrategy {
     Default,
     BackgroundOnly,
 };
 
+enum class WorkerIdleMode {
+    // Poll the queues for an adaptive number of spins, then park until woken up when a task is scheduled
+    SpinThenPark,
+    // Yield and poll the queues again, i.e., never sleep. This is how workers used to idle, which is only kept around so the
+    // two can be compared (see TaskGraphBenchmarkTool), as it keeps all idle workers busy.
+    YieldOnly,
+};
+
+struct TaskGraphSettings {
+    // Number of workers for default (and high priority) tasks. If not set, one worker per hardware thread except the calling one.
+    std::optional<u32> numDefaultWorkerThreads {};
+    // Workers which only execute background tasks. These don't necessarily need to be on hardware threads.
+    u32 numBackgroundWorkerThreads { 2 };
+    // Pin each default worker thread to its own core, skipping the first core which is left for the calling (main) thread
+    bool pinWorkerThreadsToCores { false };
+    // How workers wait for new tasks when there are none to execute
+    WorkerIdleMode workerIdleMode { WorkerIdleMode::SpinThenPark };
+};
+
 class TaskGraph final {
 public:
 
+    struct IdleStatistics {
+        u64 spins { 0 };
+        u64 parks { 0 };
+        u64 wakeups { 0 };
+    };
+
     ~TaskGraph();
 
-    static void initialize();
+    static void initialize(TaskGraphSettings = {});
     static void shutdown();
 
     static bool isInitialized();
 
     static TaskGraph& get();
 
+    // Schedule the task for execution. If the task has unresolved dependencies it will be enqueued once they have completed.
     void scheduleTask(Task&, QueueType = QueueType::Default);
     void waitForCompletion(Task&);
 
@@ -50,12 +71,20 @@ public:
     Task* getNextTask(QueueType);
     Task* getNextTaskForWorkStrategy(WorkStrategy);
 
+    // Accumulated over all workers since the task graph was initialized
+    IdleStatistics idleStatistics() const;
+
 private:
 
-    TaskGraph();
+    explicit TaskGraph(TaskGraphSettings);
     TaskGraph(TaskGraph&) = delete;
     TaskGraph& operator=(TaskGraph&) = delete;
 
+    friend class Task;
+
+    // Enqueue a task that is ready to be executed, i.e., it doesn't have any unresolved dependencies
+    void enqueueTask(Task&, QueueType);
+
     using TaskQueue = moodycamel::ConcurrentQueue<Task*>;
 
     struct TaskQueues {
@@ -65,41 +94,74 @@ private:
         TaskQueue& queue(QueueType);
 
     private:
+        TaskQueue highPriorityQueue;
         TaskQueue defaultQueue;
         TaskQueue backgroundQueue;
     };
 
     using PerThreadTaskQueues = std::vector<std::unique_ptr<TaskQueues>>;
-    using ThreadTaskQueueLookupMap = std::unordered_map<std::thread::id, TaskQueues*>;
 
     static PerThreadTaskQueues s_taskQueueList;
-    static ThreadTaskQueueLookupMap s_taskQueueLookup;
     static std::mutex s_taskQueueListMutex;
     static std::atomic_bool s_validated;
 
+    // Set up when each thread creates its task queues, so we don't have to look them up on every schedule/dequeue
+    static thread_local TaskQueues* s_taskQueuesForThisThread;
+    static thread_local size_t s_taskQueueIndexForThisThread;
+    static thread_local bool s_thisThreadIsWorker;
+    static thread_local u32 s_stealRandomState;
+
     static TaskQueues& createTaskQueuesForThisThread();
     static TaskQueues& taskQueuesForThisThread();
     static void validateTaskQueueMap(size_t expectedCount);
 
+    // Wake up one parked worker which is able to execute tasks from the given queue type (if any)
+    void wakeWorkerForQueue(QueueType);
+    std::atomic<u32> m_numParkedWorkers { 0 };
+
+    WorkerIdleMode m_workerIdleMode { WorkerIdleMode::SpinThenPark };
+
     //
 
     class Worker {
     public:
 
-        Worker(TaskGraph&, WorkStrategy, u64 workerId, std::string name);
+        Worker(TaskGraph&, WorkStrategy, u64 workerId, std::string name, std::optional<u32> pinnedCore);
         ~Worker();
 
         const std::string& name() const { return m_name; }
         const std::thread::id& threadId() const;
 
+        WorkStrategy strategy() const { return m_strategy; }
+
         void triggerShutdown();
         void waitUntilShutdown();
 
         u64 numWaitingTasks(QueueType) const;
         bool isIdle() const { return m_idle.load(); }
 
+        bool canExecuteTasksFrom(QueueType) const;
+
+        // Try to wake this worker if it's currently parked, returns true if it was woken up by this call
+        bool tryUnpark();
+
+        IdleStatistics idleStatistics() const;
+
     private:
 
+        Task* spinForTask();
+        Task* parkUntilWoken();
+
+        // Adaptive spin budget, i.e., how many times we poll the queues before parking. The budget grows if
+        // spinning successfully finds work and shrinks if we end up parking anyway.
+        static constexpr u32 MinSpinCount = 16;
+        static constexpr u32 MaxSpinCount = 4096;
+        u32 m_spinCount { 256 };
+
+        // Upper bound for how long we stay parked without being woken up, as a safeguard in case we miss
+        // a task since the queues can report being empty while some other thread is still enqueuing.
+        static constexpr std::chrono::milliseconds MaxParkDuration { 5 };
+
         TaskGraph* m_taskGraph { nullptr };
 
         WorkStrategy m_strategy;
@@ -108,13 +170,20 @@ private:
         u64 m_workerId;
         std::thread::id m_threadId {};
 
+        std::optional<u32> m_pinnedCore {};
+
         std::optional<std::thread> m_thread {};
         std::atomic<bool> m_alive { true };
 
         std::atomic<bool> m_idle { false };
+        std::atomic<bool> m_parked { false };
         std::mutex m_idleMutex {};
         std::condition_variable m_idleCondition {};
 
+        std::atomic<u64> m_spinCounter { 0 };
+        std::atomic<u64> m_parkCounter { 0 };
+        std::atomic<u64> m_wakeupCounter { 0 };
+
         TaskGraph::TaskQueues* m_taskQueues {};
     };
 
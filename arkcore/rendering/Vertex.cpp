@@ -25,6 +25,9 @@ VertexLayout VertexLayout::replaceAllWithPaddingBut(VertexComponent savedCompone
     for (VertexComponent& component : paddedLayout.m_components) { 
         if (component != savedComponent) {
             switch (vertexComponentSize(component)) {
+            case 4:
+                component = VertexComponent::Padding1F;
+                break;
             case 8:
                 component = VertexComponent::Padding2F;
                 break;
@@ -18,6 +18,12 @@ enum class VertexComponent : int {
     Velocity3F,
     Color4U8,
 
+    // Compact components, all 32 bits each
+    TexCoord2H, // 2x float16
+    NormalOct2S16, // octahedral encoded unit vector, 2x snorm16
+    TangentOct2S16, // octahedral encoded unit vector with the bitangent sign folded into y, 2x snorm16
+
+    Padding1F,
     Padding2F,
     Padding3F,
     Padding4F,
@@ -45,8 +51,13 @@ static constexpr size_t vertexComponentSize(VertexComponent component)
         static_assert(sizeof(uvec4) == 4 * sizeof(u32));
         return sizeof(uvec4);
     case VertexComponent::Color4U8:
+    case VertexComponent::TexCoord2H:
+    case VertexComponent::NormalOct2S16:
+    case VertexComponent::TangentOct2S16:
         return sizeof(u32);
 
+    case VertexComponent::Padding1F:
+        return sizeof(float);
     case VertexComponent::Padding2F:
         static_assert(sizeof(vec2) == 2 * sizeof(float));
         return sizeof(vec2);
@@ -87,7 +98,15 @@ static constexpr const char* vertexComponentToString(VertexComponent component)
         return "Velocity3F";
     case VertexComponent::Color4U8:
         return "Color4U8";
-
+    case VertexComponent::TexCoord2H:
+        return "TexCoord2H";
+    case VertexComponent::NormalOct2S16:
+        return "NormalOct2S16";
+    case VertexComponent::TangentOct2S16:
+        return "TangentOct2S16";
+
+    case VertexComponent::Padding1F:
+        return "Padding1F";
     case VertexComponent::Padding2F:
         return "Padding2F";
     case VertexComponent::Padding3F:
@@ -103,6 +122,7 @@ static constexpr const char* vertexComponentToString(VertexComponent component)
 static constexpr bool vertexComponentIsPadding(VertexComponent component)
 {
     switch (component) {
+    case VertexComponent::Padding1F:
     case VertexComponent::Padding2F:
     case VertexComponent::Padding3F:
     case VertexComponent::Padding4F:
@@ -27,6 +27,9 @@ struct VertexAllocation {
         OffsetAllocator::Allocation skinningVertAlloc {};
         OffsetAllocator::Allocation velocityVertAlloc {};
         std::vector<OffsetAllocator::Allocation> morphTargetVertAllocs {};
+        OffsetAllocator::Allocation meshletAlloc {};
+        OffsetAllocator::Allocation meshletVertexIndirectionAlloc {};
+        OffsetAllocator::Allocation meshletIndexAlloc {};
     };
 
     // For managing owned allocations to free when this is destroyed
@@ -1,6 +1,7 @@
 #include "Transform.h"
 
 #include "core/Logging.h"
+#include <atomic>
 #include <imgui.h>
 #include <cereal/cereal.hpp>
 #include <cereal/archives/json.hpp>
@@ -27,6 +28,7 @@ void Transform::drawGui()
     if (changed) {
         m_matrix = {};
         m_normalMatrix = {};
+        m_changeStamp = nextChangeStamp();
     }
 
     if (ImGui::Button("Log transform as json")) {
@@ -43,6 +45,13 @@ void Transform::setParent(Transform const* parent)
     m_parent = parent;
     m_matrix = {};
     m_normalMatrix = {};
+    m_changeStamp = nextChangeStamp();
+}
+
+u64 Transform::nextChangeStamp()
+{
+    static std::atomic<u64> s_changeStampCounter { 0 };
+    return s_changeStampCounter.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
 Transform Transform::flattened() const
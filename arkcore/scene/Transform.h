@@ -1,11 +1,13 @@
 #pragma once
 
 #include "core/Badge.h"
+#include "core/Types.h"
 #include "utility/Profiling.h"
 #include <ark/matrix.h>
 #include <ark/vector.h>
 #include <ark/quaternion.h>
 #include <ark/transform.h>
+#include <algorithm>
 #include <optional>
 
 class GpuScene;
@@ -68,6 +70,7 @@ public:
     {
         m_translation = translation;
         m_matrix = {};
+        m_changeStamp = nextChangeStamp();
         return *this;
     }
 
@@ -76,6 +79,7 @@ public:
         m_orientation = normalize(orientation);
         m_matrix = {};
         m_normalMatrix = {};
+        m_changeStamp = nextChangeStamp();
         return *this;
     }
 
@@ -84,6 +88,7 @@ public:
         m_scale = scale;
         m_matrix = {};
         m_normalMatrix = {};
+        m_changeStamp = nextChangeStamp();
         return *this;
     }
 
@@ -92,6 +97,7 @@ public:
         m_scale = vec3(scale);
         m_matrix = {};
         m_normalMatrix = {};
+        m_changeStamp = nextChangeStamp();
         return *this;
     }
 
@@ -102,6 +108,7 @@ public:
         // Reset matrix
         m_matrix = {};
         m_normalMatrix = {};
+        m_changeStamp = nextChangeStamp();
     }
 
     mat4 localMatrix() const
@@ -155,8 +162,23 @@ public:
         return m_previousFrameWorldMatrix.value_or(worldMatrix());
     }
 
+    // Stamp which changes whenever the world matrix of this transform may have changed, i.e., when this transform or any
+    // of its parents are modified. Useful for cheaply detecting which objects have moved since some earlier point in time.
+    u64 worldMatrixChangeStamp() const
+    {
+        if (!m_parent) {
+            return m_changeStamp;
+        }
+
+        return std::max(m_changeStamp, m_parent->worldMatrixChangeStamp());
+    }
+
 private:
 
+    // Stamps are unique & increasing across all transforms, so the greatest stamp along a parent chain always changes
+    // when any transform in the chain is modified (or when the chain itself changes).
+    static u64 nextChangeStamp();
+
     mat4 calculateLocalMatrix() const
     {
         mat4 translation = ark::translate(m_translation);
@@ -177,6 +199,8 @@ private:
 
     std::optional<mat4> m_previousFrameWorldMatrix{ std::nullopt };
 
+    u64 m_changeStamp { nextChangeStamp() };
+
     // Euler angles in degrees, cached as the source of truth for the inspector.
     // Only resynced from m_orientation when it no longer represents the same rotation as the cached angles.
     vec3 m_eulerDegreesGui {};
@@ -202,6 +226,8 @@ void Transform::load(Archive& archive)
     archive(cereal::make_nvp("scale", m_scale));
 
     m_orientation = normalize(m_orientation);
+
+    m_changeStamp = nextChangeStamp();
 }
 
 template<class Archive>
@@ -2,6 +2,70 @@
 
 #include "core/Assert.h"
 #include "core/Logging.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+std::filesystem::path temporaryPathForReplacing(std::filesystem::path const& filePath)
+{
+    // Unique per thread and call, as the same file could be written by multiple threads at once
+    static std::atomic<u64> s_temporaryFileCounter { 0 };
+    size_t threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string suffix = fmt::format(".{:x}-{}.tmp", threadHash, s_temporaryFileCounter.fetch_add(1));
+
+    std::filesystem::path temporaryPath = filePath;
+    temporaryPath += suffix;
+    return temporaryPath;
+}
+
+bool swapInTemporaryFile(std::filesystem::path const& temporaryPath, std::filesystem::path const& filePath)
+{
+    std::error_code error;
+
+#if PLATFORM_WINDOWS
+    // On Windows a file can't be replaced while it's mapped (the rename fails with ERROR_USER_MAPPED_FILE or access denied),
+    // but it can itself be renamed as long as all its handles allow FILE_SHARE_DELETE (see MappedFile), so move it aside first.
+    std::filesystem::path asidePath {};
+    if (std::filesystem::exists(filePath, error)) {
+        asidePath = temporaryPath;
+        asidePath.replace_extension(".old");
+        std::filesystem::rename(filePath, asidePath, error);
+        if (error) {
+            ARKOSE_LOG(Error, "Could not move file '{}' aside to replace it: {}", filePath, error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+#endif
+
+    // NOTE: On POSIX systems renaming only replaces the directory entry, while the old file lives on for as long as it's open or mapped
+    std::filesystem::rename(temporaryPath, filePath, error);
+    if (error) {
+        ARKOSE_LOG(Error, "Could not replace file '{}': {}", filePath, error.message());
+        std::filesystem::remove(temporaryPath, error);
+#if PLATFORM_WINDOWS
+        if (!asidePath.empty()) {
+            std::filesystem::rename(asidePath, filePath, error);
+        }
+#endif
+        return false;
+    }
+
+#if PLATFORM_WINDOWS
+    if (!asidePath.empty()) {
+        std::filesystem::remove(asidePath, error);
+        if (error) {
+            // Most likely it's still mapped, in which case it can't be deleted until it's unmapped
+            ARKOSE_LOG(Warning, "Could not remove replaced file '{}', leaving it behind: {}", asidePath, error.message());
+        }
+    }
+#endif
+
+    return true;
+}
+
+}
 
 bool FileIO::fileReadable(std::filesystem::path const& filePath)
 {
@@ -58,6 +122,55 @@ void FileIO::writeBinaryDataToFile(std::filesystem::path const& filePath, std::b
     file.close();
 }
 
+bool FileIO::replaceFileWithBinaryData(std::filesystem::path const& filePath, std::byte const* data, size_t size)
+{
+    SCOPED_PROFILE_ZONE();
+
+    ensureDirectoryForFile(filePath);
+
+    std::filesystem::path temporaryPath = temporaryPathForReplacing(filePath);
+
+    {
+        std::ofstream file;
+        file.open(temporaryPath, std::ios::out | std::ios::trunc | std::ios::binary);
+
+        if (!file.is_open()) {
+            ARKOSE_LOG(Error, "Could not create file '{}' for writing binary data", temporaryPath);
+            return false;
+        }
+
+        file.write(reinterpret_cast<char const*>(data), size);
+        if (!file.good()) {
+            ARKOSE_LOG(Error, "Could not write binary data to file '{}'", temporaryPath);
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    return swapInTemporaryFile(temporaryPath, filePath);
+}
+
+bool FileIO::replaceFileWithCopy(std::filesystem::path const& filePath, std::filesystem::path const& sourceFilePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    ensureDirectoryForFile(filePath);
+
+    std::filesystem::path temporaryPath = temporaryPathForReplacing(filePath);
+
+    std::error_code error;
+    std::filesystem::copy_file(sourceFilePath, temporaryPath, std::filesystem::copy_options::overwrite_existing, error);
+    if (error) {
+        ARKOSE_LOG(Error, "Could not copy file '{}' to '{}': {}", sourceFilePath, temporaryPath, error.message());
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    return swapInTemporaryFile(temporaryPath, filePath);
+}
+
 std::optional<std::string> FileIO::readFile(std::filesystem::path const& filePath)
 {
     SCOPED_PROFILE_ZONE();
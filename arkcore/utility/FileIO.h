@@ -19,6 +19,13 @@ void ensureDirectoryForFile(std::filesystem::path const& filePath);
 void writeTextDataToFile(std::filesystem::path const& filePath, std::string_view text);
 void writeBinaryDataToFile(std::filesystem::path const& filePath, std::byte const* data, size_t size);
 
+// Write to a temporary file next to the target and then swap it in for the target file, so that anyone who has the old file
+// open or memory-mapped (see MappedFile) keeps seeing its old contents, instead of having the file truncated underneath them.
+// On Windows the old file is moved aside and removed after the swap, which only works if it's opened with FILE_SHARE_DELETE,
+// and if it's still mapped it's left behind next to the target. Returns false (and logs) if the file could not be replaced.
+bool replaceFileWithBinaryData(std::filesystem::path const& filePath, std::byte const* data, size_t size);
+bool replaceFileWithCopy(std::filesystem::path const& filePath, std::filesystem::path const& sourceFilePath);
+
 std::optional<std::string> readFile(std::filesystem::path const& filePath);
 bool readFileLineByLine(std::filesystem::path const& filePath, std::function<LoopAction(const std::string& line)>);
 
@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+
+#include "utility/Profiling.h"
+
+#if PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<MappedFile> MappedFile::map(std::filesystem::path const& filePath)
+{
+    SCOPED_PROFILE_ZONE();
+
+    // NOTE: Can't use std::make_unique as the constructor is private
+    std::unique_ptr<MappedFile> mappedFile { new MappedFile() };
+
+#if PLATFORM_WINDOWS
+
+    // Let others write, rename and delete the file while it's mapped, so that it can still be re-baked
+    constexpr DWORD shareMode = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, shareMode, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    mappedFile->m_fileHandle = fileHandle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        return nullptr;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        return nullptr;
+    }
+    mappedFile->m_mappingHandle = mappingHandle;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    mappedFile->m_data = static_cast<u8 const*>(data);
+    mappedFile->m_size = static_cast<size_t>(fileSize.QuadPart);
+
+#else
+
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) {
+        return nullptr;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        close(fileDescriptor);
+        return nullptr;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStatus.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    // The mapping keeps its own reference to the file, so we don't need the file descriptor anymore
+    close(fileDescriptor);
+
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    // We generally read all of the mapped data front to back (e.g. when uploading all mips of an image)
+    madvise(data, fileSize, MADV_SEQUENTIAL);
+
+    mappedFile->m_data = static_cast<u8 const*>(data);
+    mappedFile->m_size = fileSize;
+
+#endif
+
+    return mappedFile;
+}
+
+MappedFile::~MappedFile()
+{
+#if PLATFORM_WINDOWS
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr) {
+        CloseHandle(m_fileHandle);
+    }
+#else
+    if (m_data != nullptr) {
+        munmap(const_cast<u8*>(m_data), m_size);
+    }
+#endif
+}
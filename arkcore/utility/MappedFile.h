@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/Types.h"
+#include <ark/copying.h>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+// A read-only memory mapping of a whole file. Nothing is read up front; the OS pages in the file contents as they are
+// accessed, and since the pages are backed by the file itself they can be dropped under memory pressure at no cost.
+// Files which may be mapped must never be truncated in place, as accessing the truncated pages crashes (SIGBUS), so
+// rewrite them with FileIO::replaceFileWithBinaryData(..) which leaves the mapped file intact until it's unmapped.
+class MappedFile final {
+public:
+    // Map the file at the given path, or return nullptr if it can't be opened or mapped (e.g. if it's empty)
+    static std::unique_ptr<MappedFile> map(std::filesystem::path const&);
+
+    ~MappedFile();
+
+    ARK_NON_COPYABLE(MappedFile)
+
+    std::span<u8 const> data() const { return { m_data, m_size }; }
+    size_t size() const { return m_size; }
+
+private:
+    MappedFile() = default;
+
+    u8 const* m_data { nullptr };
+    size_t m_size { 0 };
+
+#if PLATFORM_WINDOWS
+    void* m_fileHandle { nullptr };
+    void* m_mappingHandle { nullptr };
+#endif
+};
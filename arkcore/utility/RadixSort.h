@@ -0,0 +1,70 @@
+#pragma once
+
+#include "core/Types.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+struct RadixSortItem {
+    u64 key { 0 };
+    u32 index { 0 };
+};
+
+// Stable LSD radix sort on the 64-bit keys, processing one byte per pass, so it's O(n) in the number of items. Passes for bytes
+// which are the same for all keys are skipped entirely. The scratch vector is only grown, never shrunk, so by reusing it (and
+// the items vector) across calls there are no allocations once they have reached their peak size.
+inline void radixSort(std::vector<RadixSortItem>& items, std::vector<RadixSortItem>& scratch)
+{
+    constexpr size_t NumPasses = sizeof(u64);
+    constexpr size_t NumBuckets = 256;
+
+    size_t itemCount = items.size();
+    if (itemCount < 2) {
+        return;
+    }
+
+    // Count all bytes up front in a single pass over the items
+    std::array<std::array<u32, NumBuckets>, NumPasses> histograms {};
+    for (RadixSortItem const& item : items) {
+        for (size_t pass = 0; pass < NumPasses; ++pass) {
+            histograms[pass][(item.key >> (8 * pass)) & 0xFF] += 1;
+        }
+    }
+
+    if (scratch.size() < itemCount) {
+        scratch.resize(itemCount);
+    }
+
+    RadixSortItem* source = items.data();
+    RadixSortItem* destination = scratch.data();
+
+    for (size_t pass = 0; pass < NumPasses; ++pass) {
+        std::array<u32, NumBuckets> const& histogram = histograms[pass];
+
+        // If all keys fall into the same bucket this pass wouldn't change the order
+        u8 firstKeyByte = static_cast<u8>((source[0].key >> (8 * pass)) & 0xFF);
+        if (histogram[firstKeyByte] == itemCount) {
+            continue;
+        }
+
+        std::array<u32, NumBuckets> bucketOffsets;
+        u32 offset = 0;
+        for (size_t bucket = 0; bucket < NumBuckets; ++bucket) {
+            bucketOffsets[bucket] = offset;
+            offset += histogram[bucket];
+        }
+
+        for (size_t idx = 0; idx < itemCount; ++idx) {
+            RadixSortItem const& item = source[idx];
+            destination[bucketOffsets[(item.key >> (8 * pass)) & 0xFF]++] = item;
+        }
+
+        std::swap(source, destination);
+    }
+
+    // After an odd number of passes the sorted result is in the scratch buffer
+    if (source != items.data()) {
+        std::copy(source, source + itemCount, items.data());
+    }
+}
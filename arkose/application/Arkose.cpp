@@ -98,7 +98,11 @@ int Arkose::runArkoseApplication(int argc, char** argv)
     // Initialize core systems
     MemoryManager::initialize();
     CommandLine::initialize(argc, argv);
-    TaskGraph::initialize();
+
+    TaskGraphSettings taskGraphSettings {};
+    taskGraphSettings.numDefaultWorkerThreads = CommandLine::namedArgumentValue<u32>("-workerThreads");
+    taskGraphSettings.pinWorkerThreadsToCores = CommandLine::hasArgument("-pinWorkerThreads");
+    TaskGraph::initialize(taskGraphSettings);
     System::initialize();
 
     System& system = System::get();
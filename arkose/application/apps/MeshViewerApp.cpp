@@ -322,6 +322,10 @@ void MeshViewerApp::drawMeshHierarchyPanel()
                         //ARKOSE_LOG(Info, "Clicked on segment '{}'", m_segmentNameCache[m_selectedSegmentIdx]);
                     }
 
+                    if (lodIdx > 0) {
+                        ImGui::Text("Simplification error: %.5f", lod.simplificationError);
+                    }
+
                     ImGui::EndTabItem();
                 }
             }
@@ -20,6 +20,7 @@
 #include "rendering/Registry.h"
 #include <imgui.h>
 #include <ImGuizmo.h>
+#include <algorithm>
 #include <ark/aabb.h>
 #include <ark/color.h>
 #include <ark/conversion.h>
@@ -116,6 +117,11 @@ void GpuScene::initialize(Badge<Scene>, bool rayTracingCapable, bool meshShading
 
 void GpuScene::preRender()
 {
+    // Growing the vertex manager's buffers will replace them, so it can only be done in between frames, and
+    // all binding sets referencing the buffers must be recreated, which means reconstructing the pipeline.
+    if (m_vertexManager != nullptr && m_vertexManager->growBuffersIfNeeded()) {
+        backend().renderPipelineDidChange(pipeline());
+    }
 }
 
 void GpuScene::postRender()
@@ -292,6 +298,11 @@ size_t GpuScene::forEachLocalRTShadow(std::function<void(size_t, Light const&, T
 void GpuScene::drawGui()
 {
     ImGui::SliderFloat("Global mip bias", &m_globalMipBias, -10.0f, +10.0f);
+
+    if (ImGui::TreeNode("Culling & LOD selection")) {
+        m_forwardCullingSettings.drawGui();
+        ImGui::TreePop();
+    }
 }
 
 RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg)
@@ -373,6 +384,7 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
     //ARKOSE_LOG(Info, "Allocating space for {} instances, requiring {:.1f} MB of VRAM", m_drawables.capacity(), ark::conversion::to::MB(objectDataBufferSize));
     Buffer& objectDataBuffer = reg.createBuffer(objectDataBufferSize, Buffer::Usage::StorageBuffer);
     objectDataBuffer.setStride(sizeof(ShaderDrawable));
+    m_drawablesNeedFullUpload = true;
     reg.publish("SceneObjectData", objectDataBuffer);
     BindingSet& objectBindingSet = reg.createBindingSet({ ShaderBinding::storageBuffer(objectDataBuffer, ShaderStage::Vertex) });
     reg.publish("SceneObjectSet", objectBindingSet);
@@ -413,6 +425,10 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
 
         rtTriangleMeshBufferPtr = &rtTriangleMeshBuffer;
 
+        // The triangle mesh buffer is new, so the full instance table must be uploaded again
+        m_rayTracingInstances.clear();
+        m_sceneTlasNeedsFullBuild = true;
+
         BindingSet& rtMeshDataBindingSet = reg.createBindingSet({ ShaderBinding::storageBufferReadonly(rtTriangleMeshBuffer, ShaderStage::AnyRayTrace),
                                                                   ShaderBinding::storageBufferReadonly(vertexManager().indexBuffer(), ShaderStage::AnyRayTrace),
                                                                   ShaderBinding::storageBufferReadonly(vertexManager().positionVertexBuffer(), ShaderStage::AnyRayTrace),
@@ -561,13 +577,18 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
         // Update material data
         if (m_pendingMaterialUpdates.size() > 0)
         {
-            // TODO: Probably batch all neighbouring indices into a single upload? (Or can we let the UploadBuffer do that optimization for us?)
+            // Upload in index order, so the upload buffer can merge neighbouring materials into a single copy
+            std::sort(m_pendingMaterialUpdates.begin(), m_pendingMaterialUpdates.end(), [](MaterialHandle lhs, MaterialHandle rhs) {
+                return lhs.index() < rhs.index();
+            });
+
             for (MaterialHandle handle : m_pendingMaterialUpdates) {
-                ShaderMaterial shaderMaterial = m_managedMaterials.isValidHandle(handle)
-                    ? m_managedMaterials.get(handle)
-                    : ShaderMaterial(); // if deleted
                 size_t bufferOffset = handle.index() * sizeof(ShaderMaterial);
-                uploadBuffer.upload(shaderMaterial, *m_materialDataBuffer, bufferOffset);
+                if (m_managedMaterials.isValidHandle(handle)) {
+                    uploadBuffer.emplaceUpload<ShaderMaterial>(*m_materialDataBuffer, bufferOffset, m_managedMaterials.get(handle));
+                } else {
+                    uploadBuffer.emplaceUpload<ShaderMaterial>(*m_materialDataBuffer, bufferOffset); // if deleted
+                }
             }
             m_pendingMaterialUpdates.clear();
         }
@@ -576,6 +597,7 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
         {
             m_vertexManager->processMeshStreaming(cmdList, uploadBuffer, m_changedStaticMeshes);
             m_vertexManager->processHairStreaming(cmdList, uploadBuffer);
+            m_vertexManager->processDefragmentation(cmdList, uploadBuffer, m_changedStaticMeshes);
         }
 
         // Update camera data
@@ -714,11 +736,8 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
         {
             moodycamel::ConcurrentQueue<StaticMeshInstance*> instancesNeedingReinit {};
 
-            std::atomic<size_t> drawableCount { 0 };
-
             size_t itemCount = staticMeshInstances().size();
-            size_t batchSize = itemCount >= 512 ? 512 : 64; // if instance count is small don't go crazy with batch size
-            ParallelForBatched(itemCount, batchSize, [this, &drawableCount, &instancesNeedingReinit](size_t idx) {
+            size_t drawableCount = ParallelReduce(itemCount, size_t(0), [this, &instancesNeedingReinit](size_t idx) -> size_t {
                 auto& instance = staticMeshInstances()[idx];
 
                 bool meshHasUpdated = m_changedStaticMeshes.contains(instance->mesh());
@@ -733,15 +752,12 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
                     // This would mean another indirection on the GPU when looking up transforms, but significantly less updating and iterating on the CPU
                     // to e.g. update transforms.
                     for (DrawableObjectHandle drawableHandle : instance->drawableHandles()) {
-                        ShaderDrawable& drawable = m_drawables.get(drawableHandle);
-                        drawable.worldFromLocal = instance->transform().worldMatrix();
-                        drawable.worldFromTangent = mat4(instance->transform().worldNormalMatrix());
-                        drawable.previousFrameWorldFromLocal = instance->transform().previousFrameWorldMatrix();
+                        updateDrawableTransform(drawableHandle, instance->transform());
                     }
                 }
 
-                drawableCount += instance->drawableHandles().size();
-            });
+                return instance->drawableHandles().size();
+            }, std::plus<size_t>());
 
             m_changedStaticMeshes.clear();
 
@@ -757,15 +773,27 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
                 for (size_t segmentIdx = 0; segmentIdx < drawableHandles.size(); ++segmentIdx) {
                     DrawableObjectHandle drawableHandle = drawableHandles[segmentIdx];
 
-                    ShaderDrawable& drawable = m_drawables.get(drawableHandle);
-                    drawable.worldFromLocal = skeletalMeshInstance->transform().worldMatrix();
-                    drawable.worldFromTangent = mat4(skeletalMeshInstance->transform().worldNormalMatrix());
-                    drawable.previousFrameWorldFromLocal = skeletalMeshInstance->transform().previousFrameWorldMatrix();
+                    updateDrawableTransform(drawableHandle, skeletalMeshInstance->transform());
 
                     if (skeletalMeshInstance->hasSkinningVertexMappingForSegmentIndex(segmentIdx)) {
                         SkinningVertexMapping const& mapping = skeletalMeshInstance->skinningVertexMappingForSegmentIndex(segmentIdx);
+                        ShaderDrawable& drawable = m_drawables.get(drawableHandle);
+
                         if (mapping.skinnedTarget.hasVelocityData()) {
-                            drawable.relativeVelocityVertex = mapping.skinnedTarget.firstVelocityVertex - mapping.skinnedTarget.firstVertex;
+                            i32 relativeVelocityVertex = mapping.skinnedTarget.firstVelocityVertex - static_cast<i32>(mapping.skinnedTarget.firstVertex);
+                            if (drawable.relativeVelocityVertex != relativeVelocityVertex) {
+                                drawable.relativeVelocityVertex = relativeVelocityVertex;
+                                m_drawableUploadStates[drawableHandle.index()].dirty = true;
+                            }
+                        }
+
+                        if (drawable.firstIndex != mapping.skinnedTarget.firstIndex
+                            || drawable.indexCount != mapping.skinnedTarget.indexCount
+                            || drawable.vertexOffset != static_cast<i32>(mapping.skinnedTarget.firstVertex)) {
+                            drawable.firstIndex = mapping.skinnedTarget.firstIndex;
+                            drawable.indexCount = mapping.skinnedTarget.indexCount;
+                            drawable.vertexOffset = mapping.skinnedTarget.firstVertex;
+                            m_drawableUploadStates[drawableHandle.index()].dirty = true;
                         }
                     }
                 }
@@ -775,16 +803,13 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
 
             for (auto& hairInstance : m_hairInstances) {
                 if (DrawableObjectHandle drawableHandle = hairInstance->drawableHandle()) {
-                    ShaderDrawable& drawable = m_drawables.get(drawableHandle);
-                    drawable.worldFromLocal = hairInstance->transform().worldMatrix();
-                    drawable.worldFromTangent = mat4(hairInstance->transform().worldNormalMatrix());
-                    drawable.previousFrameWorldFromLocal = hairInstance->transform().previousFrameWorldMatrix();
+                    updateDrawableTransform(drawableHandle, hairInstance->transform());
                     drawableCount += 1;
                 }
             }
 
             m_drawableCountForFrame = drawableCount;
-            uploadBuffer.upload(m_drawables.resourceSpan(), objectDataBuffer);
+            uploadDirtyDrawables(uploadBuffer, objectDataBuffer);
         }
 
         // Update exposure data
@@ -870,146 +895,308 @@ RenderPipelineNode::ExecuteCallback GpuScene::construct(GpuScene&, Registry& reg
         cmdList.executeBufferCopyOperations(uploadBuffer);
 
         if (m_maintainRayTracingScene) {
+            ARKOSE_ASSERT(rtTriangleMeshBufferPtr != nullptr);
+            updateRayTracingScene(cmdList, uploadBuffer, *rtTriangleMeshBufferPtr);
+        }
+    };
+}
+
+void GpuScene::updateRayTracingScene(CommandList& cmdList, UploadBuffer& uploadBuffer, Buffer& rtTriangleMeshBuffer)
+{
+    SCOPED_PROFILE_ZONE();
 
-            SCOPED_PROFILE_ZONE_NAMED("Update TLAS");
+    // If an instance has moved further than this (relative to its size) since the last full build, refitting the TLAS
+    // would result in too much overlap between its nodes, so we rebuild it instead.
+    constexpr float MaxRefitDisplacementRelativeToSize = 1.0f;
 
-            auto tlasBuildType = AccelerationStructureBuildType::Update;
+    // If more than this fraction of all instances have moved since the last full build, rebuild the TLAS
+    constexpr float MaxRefitMovedInstanceFraction = 0.25f;
 
-            // TODO: Fill in both of these and upload to the GPU buffers. For now they will be 1:1
-            std::vector<RTTriangleMesh> rayTracingMeshData {};
-            std::vector<RTGeometryInstance> rayTracingGeometryInstances {};
+    // Dirty instances closer than this to each other are uploaded in a single range, to avoid many tiny copies
+    constexpr u32 MaxDirtyRangeGap = 8;
 
-            for (auto& instance : staticMeshInstances()) {
-                if (StaticMesh* staticMesh = staticMeshForHandle(instance->mesh())) {
-                    for (StaticMeshLOD& staticMeshLOD : staticMesh->LODs()) {
-                        for (StaticMeshSegment& meshSegment : staticMeshLOD.meshSegments) {
+    bool needsFullBuild = m_sceneTlasNeedsFullBuild;
+    bool needsUpdate = false;
 
-                            if (meshSegment.blas == nullptr) { 
-                                // Not yet loaded
-                                continue;
-                            }
+    m_dirtyRayTracingInstances.clear();
 
-                            u32 rtMeshIndex = narrow_cast<u32>(rayTracingMeshData.size());
-
-                            DrawCallDescription drawCallDesc = DrawCallDescription::fromVertexAllocation(meshSegment.vertexAllocation);
-                            rayTracingMeshData.push_back(RTTriangleMesh { .firstVertex = drawCallDesc.vertexOffset,
-                                                                          .firstIndex = static_cast<int>(drawCallDesc.firstIndex),
-                                                                          .materialIndex = meshSegment.material.indexOfType<int>() });
-
-                            tlasBuildType = AccelerationStructureBuildType::FullBuild; // TODO: Only do a full rebuild sometimes!
-
-                            uint8_t hitMask = 0x00;
-                            uint32_t sbtOffset = 0;
-                            if (const ShaderMaterial* material = materialForHandle(meshSegment.material)) {
-                                switch (material->blendMode) {
-                                case BLEND_MODE_OPAQUE:
-                                    hitMask = RT_HIT_MASK_OPAQUE;
-                                    sbtOffset = 0;
-                                    break;
-                                case BLEND_MODE_MASKED:
-                                    hitMask = RT_HIT_MASK_MASKED;
-                                    sbtOffset = 1;
-                                    break;
-                                case BLEND_MODE_TRANSLUCENT:
-                                    hitMask = RT_HIT_MASK_BLEND;
-                                    sbtOffset = 2;
-                                    break;
-                                default:
-                                    ASSERT_NOT_REACHED();
-                                }
-                            }
-                            ARKOSE_ASSERT(hitMask != 0);
-
-                            // TODO: Probably create a geometry per mesh but only a single instance per model, and use the SBT for material lookup!
-                            rayTracingGeometryInstances.push_back(RTGeometryInstance { .blas = meshSegment.blas.get(),
-                                                                                       .transform = &instance->transform(),
-                                                                                       .shaderBindingTableOffset = sbtOffset,
-                                                                                       .customInstanceId = rtMeshIndex,
-                                                                                       .hitMask = hitMask });
-                        }
-                    }
-                }
+    u32 instanceCount = 0;
+    auto visitInstance = [&](BottomLevelAS const& blas, Transform const& transform, StaticMeshSegment const& meshSegment, float localBoundingRadius) {
+        u32 instanceIdx = instanceCount++;
+        if (instanceIdx == m_rayTracingInstances.size()) {
+            m_rayTracingInstances.emplace_back();
+        }
+
+        RayTracingInstance& instance = m_rayTracingInstances[instanceIdx];
+        u64 transformChangeStamp = transform.worldMatrixChangeStamp();
+
+        DrawCallDescription drawCallDesc = DrawCallDescription::fromVertexAllocation(meshSegment.vertexAllocation);
+        RTTriangleMesh meshData { .firstVertex = drawCallDesc.vertexOffset,
+                                  .firstIndex = static_cast<int>(drawCallDesc.firstIndex),
+                                  .materialIndex = meshSegment.material.indexOfType<int>() };
+
+        u8 hitMask = 0x00;
+        u32 sbtOffset = 0;
+        if (const ShaderMaterial* material = materialForHandle(meshSegment.material)) {
+            switch (material->blendMode) {
+            case BLEND_MODE_OPAQUE:
+                hitMask = RT_HIT_MASK_OPAQUE;
+                sbtOffset = 0;
+                break;
+            case BLEND_MODE_MASKED:
+                hitMask = RT_HIT_MASK_MASKED;
+                sbtOffset = 1;
+                break;
+            case BLEND_MODE_TRANSLUCENT:
+                hitMask = RT_HIT_MASK_BLEND;
+                sbtOffset = 2;
+                break;
+            default:
+                ASSERT_NOT_REACHED();
+            }
+        }
+        ARKOSE_ASSERT(hitMask != 0);
+
+        bool sameGeometry = instance.blas == &blas
+            && instance.blasAddressStamp == blas.addressStamp()
+            && instance.transform == &transform;
+
+        bool sameInstanceData = instance.meshData.firstVertex == meshData.firstVertex
+            && instance.meshData.firstIndex == meshData.firstIndex
+            && instance.meshData.materialIndex == meshData.materialIndex
+            && instance.shaderBindingTableOffset == sbtOffset
+            && instance.hitMask == hitMask;
+
+        if (!sameGeometry) {
+            // A new instance in this slot (or a new BLAS), which requires a full build
+            instance = RayTracingInstance { .blas = &blas,
+                                            .blasAddressStamp = blas.addressStamp(),
+                                            .transform = &transform,
+                                            .transformChangeStamp = transformChangeStamp,
+                                            .meshData = meshData,
+                                            .shaderBindingTableOffset = sbtOffset,
+                                            .hitMask = hitMask,
+                                            .localBoundingRadius = localBoundingRadius };
+            m_dirtyRayTracingInstances.push_back(instanceIdx);
+            needsFullBuild = true;
+        } else if (!sameInstanceData) {
+            instance.meshData = meshData;
+            instance.shaderBindingTableOffset = sbtOffset;
+            instance.hitMask = hitMask;
+            instance.transformChangeStamp = transformChangeStamp;
+            m_dirtyRayTracingInstances.push_back(instanceIdx);
+            needsUpdate = true;
+        } else if (instance.transformChangeStamp != transformChangeStamp) {
+            instance.transformChangeStamp = transformChangeStamp;
+            m_dirtyRayTracingInstances.push_back(instanceIdx);
+            needsUpdate = true;
+
+            if (!instance.movedSinceLastFullBuild) {
+                instance.movedSinceLastFullBuild = true;
+                m_rayTracingInstancesMovedSinceLastFullBuild += 1;
             }
 
-            for (auto& instance : skeletalMeshInstances()) {
-                if (SkeletalMesh* skeletalMesh = skeletalMeshForHandle(instance->mesh())) {
-                    StaticMesh const& staticMesh = skeletalMesh->underlyingMesh();
-                    for (StaticMeshLOD const& staticMeshLOD : staticMesh.LODs()) {
-                        for (u32 segmentIdx = 0; segmentIdx < staticMeshLOD.meshSegments.size(); ++segmentIdx) {
-                            StaticMeshSegment const& meshSegment = staticMeshLOD.meshSegments[segmentIdx];
+            float displacement = distance(transform.positionInWorld(), instance.positionAtLastFullBuild);
+            if (displacement > MaxRefitDisplacementRelativeToSize * instance.worldBoundingRadiusAtLastFullBuild) {
+                needsFullBuild = true;
+            }
+        }
+    };
+
+    // NOTE: Only LOD0 is ray traced. Adding an instance for every LOD would place all of them on top of each other in the scene.
 
-                            if (!instance->hasBlasForSegmentIndex(segmentIdx)) {
-                                // Not yet loaded
-                                continue;
-                            }
+    for (auto& instance : staticMeshInstances()) {
+        if (StaticMesh* staticMesh = staticMeshForHandle(instance->mesh())) {
+            if (staticMesh->numLODs() == 0) {
+                continue;
+            }
 
-                            u32 rtMeshIndex = narrow_cast<u32>(rayTracingMeshData.size());
-
-                            DrawCallDescription drawCallDesc = DrawCallDescription::fromVertexAllocation(meshSegment.vertexAllocation);
-                            rayTracingMeshData.push_back(RTTriangleMesh { .firstVertex = drawCallDesc.vertexOffset,
-                                                                            .firstIndex = static_cast<int>(drawCallDesc.firstIndex),
-                                                                            .materialIndex = meshSegment.material.indexOfType<int>() });
-
-                            BottomLevelAS const& blas = *instance->blasForSegmentIndex(segmentIdx);
-
-                            tlasBuildType = AccelerationStructureBuildType::FullBuild; // TODO: Only do a full rebuild sometimes!
-
-                            uint8_t hitMask = 0x00;
-                            uint32_t sbtOffset = 0;
-                            if (const ShaderMaterial* material = materialForHandle(meshSegment.material)) {
-                                switch (material->blendMode) {
-                                case BLEND_MODE_OPAQUE:
-                                    hitMask = RT_HIT_MASK_OPAQUE;
-                                    sbtOffset = 0;
-                                    break;
-                                case BLEND_MODE_MASKED:
-                                    hitMask = RT_HIT_MASK_MASKED;
-                                    sbtOffset = 1;
-                                    break;
-                                case BLEND_MODE_TRANSLUCENT:
-                                    hitMask = RT_HIT_MASK_BLEND;
-                                    sbtOffset = 2;
-                                    break;
-                                default:
-                                    ASSERT_NOT_REACHED();
-                                }
-                            }
-                            ARKOSE_ASSERT(hitMask != 0);
-
-                            // TODO: Probably create a geometry per mesh but only a single instance per model, and use the SBT for material lookup!
-                            rayTracingGeometryInstances.push_back(RTGeometryInstance { .blas = &blas,
-                                                                                       .transform = &instance->transform(),
-                                                                                       .shaderBindingTableOffset = sbtOffset,
-                                                                                       .customInstanceId = rtMeshIndex,
-                                                                                       .hitMask = hitMask });
-                        }
-                    }
+            for (StaticMeshSegment& meshSegment : staticMesh->lodAtIndex(0).meshSegments) {
+                if (meshSegment.blas == nullptr) {
+                    // Not yet loaded
+                    continue;
                 }
 
-                // TODO: Ensure there is a BLAS, update it, and make an instance of it for the TLAS
-                // NOTE: We don't need to dig into the skeletal mesh underneath since the instance has its own
-                //       buffers which the skinning manager should keep up to date every frame!
+                visitInstance(*meshSegment.blas, instance->transform(), meshSegment, staticMesh->boundingSphere().radius());
             }
+        }
+    }
 
-            ARKOSE_ASSERT(rtTriangleMeshBufferPtr != nullptr);
-            uploadBuffer.upload(rayTracingMeshData, *rtTriangleMeshBufferPtr);
+    for (auto& instance : skeletalMeshInstances()) {
+        if (SkeletalMesh* skeletalMesh = skeletalMeshForHandle(instance->mesh())) {
+            StaticMesh const& staticMesh = skeletalMesh->underlyingMesh();
+            if (staticMesh.numLODs() == 0) {
+                continue;
+            }
+
+            StaticMeshLOD const& staticMeshLOD = staticMesh.lodAtIndex(0);
+            for (u32 segmentIdx = 0; segmentIdx < staticMeshLOD.meshSegments.size(); ++segmentIdx) {
+                if (!instance->hasBlasForSegmentIndex(segmentIdx)) {
+                    // Not yet loaded
+                    continue;
+                }
+
+                visitInstance(*instance->blasForSegmentIndex(segmentIdx), instance->transform(), staticMeshLOD.meshSegments[segmentIdx], staticMesh.boundingSphere().radius());
+
+                // The skinned BLASes are updated every frame, so the TLAS must at least be refit to match
+                needsUpdate = true;
+            }
+        }
+    }
+
+    if (instanceCount < m_rayTracingInstances.size()) {
+        m_rayTracingInstances.resize(instanceCount);
+        needsFullBuild = true;
+    }
+
+    if (m_rayTracingInstancesMovedSinceLastFullBuild > MaxRefitMovedInstanceFraction * static_cast<float>(instanceCount)) {
+        needsFullBuild = true;
+    }
+
+    TopLevelAS& sceneTlas = *m_sceneTopLevelAccelerationStructure;
+    sceneTlas.setInstanceCount(instanceCount);
 
-            TopLevelAS& sceneTlas = *m_sceneTopLevelAccelerationStructure;
-            sceneTlas.updateInstanceDataWithUploadBuffer(rayTracingGeometryInstances, uploadBuffer);
-            cmdList.executeBufferCopyOperations(uploadBuffer);
+    // Upload the dirty instances, merging nearby ones into a single range (the dirty indices are already sorted)
+    if (m_dirtyRayTracingInstances.size() > 0) {
+        SCOPED_PROFILE_ZONE_NAMED("Upload dirty TLAS instances");
 
-            // Only do an update most frame, but every x frames require a full rebuild
-            if (m_framesUntilNextFullTlasBuild == 0) {
-                tlasBuildType = AccelerationStructureBuildType::FullBuild;
+        std::vector<RTGeometryInstance> rangeGeometryInstances {};
+        std::vector<RTTriangleMesh> rangeMeshData {};
+
+        size_t dirtyIdx = 0;
+        while (dirtyIdx < m_dirtyRayTracingInstances.size()) {
+            u32 firstInstanceIdx = m_dirtyRayTracingInstances[dirtyIdx];
+            u32 lastInstanceIdx = firstInstanceIdx;
+
+            while (dirtyIdx + 1 < m_dirtyRayTracingInstances.size() && m_dirtyRayTracingInstances[dirtyIdx + 1] - lastInstanceIdx <= MaxDirtyRangeGap) {
+                lastInstanceIdx = m_dirtyRayTracingInstances[++dirtyIdx];
             }
-            if (tlasBuildType == AccelerationStructureBuildType::FullBuild) {
-                m_framesUntilNextFullTlasBuild = 60;
+            dirtyIdx += 1;
+
+            rangeGeometryInstances.clear();
+            rangeMeshData.clear();
+
+            for (u32 instanceIdx = firstInstanceIdx; instanceIdx <= lastInstanceIdx; ++instanceIdx) {
+                RayTracingInstance const& instance = m_rayTracingInstances[instanceIdx];
+                rangeGeometryInstances.push_back(RTGeometryInstance { .blas = instance.blas,
+                                                                      .transform = instance.transform,
+                                                                      .shaderBindingTableOffset = instance.shaderBindingTableOffset,
+                                                                      .customInstanceId = instanceIdx,
+                                                                      .hitMask = instance.hitMask });
+                rangeMeshData.push_back(instance.meshData);
             }
 
-            cmdList.buildTopLevelAcceratationStructure(sceneTlas, tlasBuildType);
-            m_framesUntilNextFullTlasBuild -= 1;
+            sceneTlas.updateInstanceDataRangeWithUploadBuffer(firstInstanceIdx, rangeGeometryInstances, uploadBuffer);
+            uploadBuffer.upload(rangeMeshData.data(), rangeMeshData.size() * sizeof(RTTriangleMesh), rtTriangleMeshBuffer, firstInstanceIdx * sizeof(RTTriangleMesh));
         }
-    };
+
+        cmdList.executeBufferCopyOperations(uploadBuffer);
+    }
+
+    if (needsFullBuild) {
+        cmdList.buildTopLevelAcceratationStructure(sceneTlas, AccelerationStructureBuildType::FullBuild);
+
+        // Track movement relative to this build from now on
+        for (RayTracingInstance& instance : m_rayTracingInstances) {
+            vec3 worldScale = instance.transform->scaleInWorld();
+            float maxScale = std::max({ std::abs(worldScale.x), std::abs(worldScale.y), std::abs(worldScale.z) });
+
+            instance.worldBoundingRadiusAtLastFullBuild = instance.localBoundingRadius * maxScale;
+            instance.positionAtLastFullBuild = instance.transform->positionInWorld();
+            instance.movedSinceLastFullBuild = false;
+        }
+
+        m_rayTracingInstancesMovedSinceLastFullBuild = 0;
+        m_sceneTlasNeedsFullBuild = false;
+
+    } else if (needsUpdate) {
+        cmdList.buildTopLevelAcceratationStructure(sceneTlas, AccelerationStructureBuildType::Update);
+    }
+
+    // NOTE: If nothing changed at all the TLAS from the previous frame is still valid as-is, so there's nothing to build
+}
+
+void GpuScene::markDrawableDirty(DrawableObjectHandle handle, Transform const& transform)
+{
+    if (handle.index() >= m_drawableUploadStates.size()) {
+        m_drawableUploadStates.resize(handle.index() + 1);
+    }
+
+    // The drawable was just written in full from the current transform, but its previous frame matrix may still be catching up
+    DrawableUploadState& uploadState = m_drawableUploadStates[handle.index()];
+    uploadState.transformChangeStamp = transform.worldMatrixChangeStamp();
+    uploadState.previousFrameMatrixPending = true;
+    uploadState.dirty = true;
+}
+
+void GpuScene::updateDrawableTransform(DrawableObjectHandle handle, Transform const& transform)
+{
+    // NOTE: Called in parallel for different drawables, so this must only ever touch the state for this one drawable
+    DrawableUploadState& uploadState = m_drawableUploadStates[handle.index()];
+
+    u64 changeStamp = transform.worldMatrixChangeStamp();
+    bool transformChanged = changeStamp != uploadState.transformChangeStamp;
+
+    if (!transformChanged && !uploadState.previousFrameMatrixPending) {
+        return;
+    }
+
+    ShaderDrawable& drawable = m_drawables.get(handle);
+    drawable.worldFromLocal = transform.worldMatrix();
+    drawable.worldFromTangent = mat4(transform.worldNormalMatrix());
+    drawable.previousFrameWorldFromLocal = transform.previousFrameWorldMatrix();
+
+    // If the transform changed this frame the previous frame matrix will catch up with it next frame, so we have to write it
+    // once more then, even if the transform doesn't change again. Otherwise we'd be left with a stale velocity for the drawable.
+    uploadState.transformChangeStamp = changeStamp;
+    uploadState.previousFrameMatrixPending = transformChanged;
+    uploadState.dirty = true;
+}
+
+void GpuScene::uploadDirtyDrawables(UploadBuffer& uploadBuffer, Buffer& objectDataBuffer)
+{
+    SCOPED_PROFILE_ZONE();
+
+    // Allow for some clean drawables between two dirty ones to be uploaded as part of the same range, to keep the number of copies down
+    constexpr size_t MaxDirtyRangeGap = 8;
+
+    std::span<ShaderDrawable const> drawables = m_drawables.resourceSpan();
+    ARKOSE_ASSERT(drawables.size() <= m_drawableUploadStates.size());
+
+    if (m_drawablesNeedFullUpload) {
+        uploadBuffer.upload(drawables, objectDataBuffer);
+        for (DrawableUploadState& uploadState : m_drawableUploadStates) {
+            uploadState.dirty = false;
+        }
+        m_drawablesNeedFullUpload = false;
+        return;
+    }
+
+    size_t drawableIdx = 0;
+    while (drawableIdx < drawables.size()) {
+        if (!m_drawableUploadStates[drawableIdx].dirty) {
+            drawableIdx += 1;
+            continue;
+        }
+
+        size_t firstDrawableIdx = drawableIdx;
+        size_t lastDrawableIdx = drawableIdx;
+
+        for (size_t idx = drawableIdx + 1; idx < drawables.size() && idx - lastDrawableIdx <= MaxDirtyRangeGap; ++idx) {
+            if (m_drawableUploadStates[idx].dirty) {
+                lastDrawableIdx = idx;
+            }
+        }
+
+        for (size_t idx = firstDrawableIdx; idx <= lastDrawableIdx; ++idx) {
+            m_drawableUploadStates[idx].dirty = false;
+        }
+
+        std::span<ShaderDrawable const> range = drawables.subspan(firstDrawableIdx, lastDrawableIdx - firstDrawableIdx + 1);
+        uploadBuffer.upload(range, objectDataBuffer, firstDrawableIdx * sizeof(ShaderDrawable));
+
+        drawableIdx = lastDrawableIdx + 1;
+    }
 }
 
 void GpuScene::updateEnvironmentMap(EnvironmentMap& environmentMap)
@@ -1200,12 +1387,19 @@ void GpuScene::initializeSkeletalMeshInstance(SkeletalMeshInstance& instance)
         // once the skinning vertex mapping has been allocated by VertexManager.
         drawable.relativeVelocityVertex = 0;
 
+        // Same as above, we can't draw the skinned target until it has been allocated
+        drawable.firstIndex = 0;
+        drawable.indexCount = 0;
+        drawable.vertexOffset = 0;
+
         if (instance.hasDrawableHandleForSegmentIndex(segmentIdx)) {
             DrawableObjectHandle handle = instance.drawableHandleForSegmentIndex(segmentIdx);
             m_drawables.set(handle, std::move(drawable));
+            markDrawableDirty(handle, instance.transform());
         } else {
             DrawableObjectHandle handle = m_drawables.add(std::move(drawable));
             instance.setDrawableHandle(segmentIdx, handle);
+            markDrawableDirty(handle, instance.transform());
         }
     }
 }
@@ -1259,12 +1453,19 @@ void GpuScene::initializeStaticMeshInstance(StaticMeshInstance& instance)
         // Not relevant for static meshes
         drawable.relativeVelocityVertex = 0;
 
+        // NOTE: Only valid once the mesh has been streamed in, but the instance is reinitialized when that happens
+        drawable.firstIndex = meshSegment.vertexAllocation.firstIndex;
+        drawable.indexCount = meshSegment.vertexAllocation.indexCount;
+        drawable.vertexOffset = meshSegment.vertexAllocation.firstVertex;
+
         if (instance.hasDrawableHandleForSegmentIndex(segmentIdx)) {
             DrawableObjectHandle handle = instance.drawableHandleForSegmentIndex(segmentIdx);
             m_drawables.set(handle, std::move(drawable));
+            markDrawableDirty(handle, instance.transform());
         } else {
             DrawableObjectHandle handle = m_drawables.add(std::move(drawable));
             instance.setDrawableHandle(segmentIdx, handle);
+            markDrawableDirty(handle, instance.transform());
         }
     }
 }
@@ -1299,8 +1500,14 @@ void GpuScene::initializeHairInstance(HairInstance& instance)
 
     drawable.relativeVelocityVertex = 0;
 
+    // Hair isn't drawn with indexed draws
+    drawable.firstIndex = 0;
+    drawable.indexCount = 0;
+    drawable.vertexOffset = 0;
+
     DrawableObjectHandle handle = m_drawables.add(std::move(drawable));
     instance.setDrawableHandle(handle);
+    markDrawableDirty(handle, instance.transform());
 }
 
 SkeletalMeshHandle GpuScene::registerSkeletalMesh(MeshAsset const* meshAsset, SkeletonAsset const* skeletonAsset)
@@ -1724,8 +1931,10 @@ void GpuScene::processDeferredDeletions()
             }
         }
 
-        // TODO!
-        //m_vertexManager->unregisterFromStreaming(*managedStaticMesh.staticMesh);
+        // NOTE: The mesh is not referenced by any frames in flight at this point, so its data can be freed right away
+        if (m_vertexManager != nullptr) {
+            m_vertexManager->unregisterFromStreaming(*managedStaticMesh.staticMesh);
+        }
 
         managedStaticMesh.meshAsset = nullptr;
         managedStaticMesh.staticMesh.reset();
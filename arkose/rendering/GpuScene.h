@@ -10,6 +10,7 @@
 #include "rendering/SkeletalMesh.h"
 #include "rendering/StaticMesh.h"
 #include "rendering/VertexManager.h"
+#include "rendering/forward/ForwardCulling.h"
 #include "scene/Scene.h"
 #include "scene/camera/Camera.h"
 #include <memory>
@@ -158,6 +159,9 @@ public:
     float globalMipBias() const { return m_globalMipBias; }
     void setGlobalMipBias(float globalMipBias) { m_globalMipBias = globalMipBias; }
 
+    // Shared by all passes drawing the same instances, as e.g. the prepass and forward pass must select the same LODs
+    ForwardCulling::Settings const& forwardCullingSettings() const { return m_forwardCullingSettings; }
+
     bool shouldIncludeMaterialColor() const { return m_includeMaterialColor; }
     bool& shouldIncludeMaterialColorMutable() { return m_includeMaterialColor; }
 
@@ -212,6 +216,12 @@ public:
     };
 
 private:
+    void updateRayTracingScene(CommandList&, UploadBuffer&, Buffer& rtTriangleMeshBuffer);
+
+    void markDrawableDirty(DrawableObjectHandle, Transform const&);
+    void updateDrawableTransform(DrawableObjectHandle, Transform const&);
+    void uploadDirtyDrawables(UploadBuffer&, Buffer& objectDataBuffer);
+
     Scene& m_scene;
     Backend& m_backend;
 
@@ -221,6 +231,7 @@ private:
     float m_lightPreExposure { 1.0f };
 
     float m_globalMipBias { 0.0f };
+    ForwardCulling::Settings m_forwardCullingSettings {};
 
     bool m_includeMaterialColor { true };
 
@@ -240,6 +251,18 @@ private:
     std::vector<std::unique_ptr<HairInstance>> m_hairInstances {};
     ResourceList<ShaderDrawable, DrawableObjectHandle> m_drawables { "Drawables", 65'536 };
 
+    // Upload tracking for the drawables (indexed by drawable handle index), so that only the drawables which have actually
+    // changed since the last frame have to be uploaded to the object data buffer.
+    struct DrawableUploadState {
+        // Change stamp of the world matrix that was last written to the drawable
+        u64 transformChangeStamp { 0 };
+        // The transform changed last frame, so the previous frame matrix must be written once more after it has stopped
+        bool previousFrameMatrixPending { false };
+        bool dirty { false };
+    };
+    std::vector<DrawableUploadState> m_drawableUploadStates {};
+    bool m_drawablesNeedFullUpload { true };
+
     std::unique_ptr<VertexManager> m_vertexManager {};
 
     struct ManagedDirectionalLight {
@@ -283,7 +306,29 @@ private:
 
     static constexpr uint32_t InitialMaxRayTracingGeometryInstanceCount { 32'768 };
     std::unique_ptr<TopLevelAS> m_sceneTopLevelAccelerationStructure {};
-    uint32_t m_framesUntilNextFullTlasBuild { 0u };
+
+    // Persistent copy of the scene TLAS instance table, so that only the instances which have changed since the last frame
+    // need to be uploaded and so that we can decide between a (cheap) refit and a (higher quality) full rebuild.
+    struct RayTracingInstance {
+        BottomLevelAS const* blas { nullptr };
+        u64 blasAddressStamp { 0 };
+
+        Transform const* transform { nullptr };
+        u64 transformChangeStamp { 0 };
+
+        RTTriangleMesh meshData {};
+        u32 shaderBindingTableOffset { 0 };
+        u8 hitMask { 0 };
+
+        float localBoundingRadius { 0.0f };
+        float worldBoundingRadiusAtLastFullBuild { 0.0f };
+        vec3 positionAtLastFullBuild {};
+        bool movedSinceLastFullBuild { false };
+    };
+    std::vector<RayTracingInstance> m_rayTracingInstances {};
+    std::vector<u32> m_dirtyRayTracingInstances {};
+    u32 m_rayTracingInstancesMovedSinceLastFullBuild { 0 };
+    bool m_sceneTlasNeedsFullBuild { true };
 
     std::unique_ptr<Texture> m_environmentMapTexture {};
     std::unique_ptr<Texture> m_colorGradingLutTexture {};
@@ -3,6 +3,9 @@
 #include "utility/FileIO.h"
 #include "core/Logging.h"
 #include "core/Assert.h"
+#include <ark/core.h>
+#include <algorithm>
+#include <numeric>
 #include <stb_image.h>
 
 Registry::Registry(Backend& backend, Texture* outputTexture, Registry* previousRegistry)
@@ -26,6 +29,13 @@ Texture* Registry::outputTexture()
 
 RenderTarget& Registry::createRenderTarget(std::vector<RenderTarget::Attachment> attachments)
 {
+    for (RenderTarget::Attachment const& attachment : attachments) {
+        markTransientTextureUse(*attachment.texture);
+        if (attachment.multisampleResolveTexture && attachment.multisampleResolveTexture->isTransient()) {
+            ARKOSE_LOG(Fatal, "Registry: transient textures can't be used as multisample resolve targets");
+        }
+    }
+
     auto renderTarget = backend().createRenderTarget(attachments);
     renderTarget->setOwningRegistry({}, this);
 
@@ -149,6 +159,162 @@ std::pair<Texture&, Registry::ReuseMode> Registry::createOrReuseTexture2D(const
     return { texture, ReuseMode::Created };
 }
 
+Texture& Registry::createTransientTexture2D(Extent2D extent, Texture::Format format, Texture::Filters filters, Texture::Mipmap mipmap, ImageWrapModes wrapMode)
+{
+    ARKOSE_ASSERT(m_currentNodeName.has_value());
+
+    Texture& texture = createTexture2D(extent, format, filters, mipmap, wrapMode);
+    texture.setTransient({}, true);
+
+    u32 nodeIdx = narrow_cast<u32>(m_allNodeNames.size() - 1);
+    m_transientTextures.push_back(TransientTexture { .texture = &texture,
+                                                     .firstNodeIdx = nodeIdx,
+                                                     .lastNodeIdx = nodeIdx });
+
+    return texture;
+}
+
+Registry::TransientTextureStats Registry::aliasTransientTextures(Badge<RenderPipeline>)
+{
+    SCOPED_PROFILE_ZONE();
+
+    TransientTextureStats stats {};
+    stats.textureCount = narrow_cast<u32>(m_transientTextures.size());
+
+    for (TransientTexture const& transientTexture : m_transientTextures) {
+        stats.peakSizeWithoutAliasing += transientTexture.texture->sizeInMemory();
+    }
+
+    stats.peakSizeWithAliasing = stats.peakSizeWithoutAliasing;
+
+    if (m_transientTextures.size() < 2) {
+        return stats;
+    }
+
+    // Place the largest textures first, each at the lowest offset where it doesn't overlap any of the already placed textures
+    // that are alive at the same time. This greedy approach is not optimal but it's simple and gets close enough in practice.
+    std::vector<size_t> placementOrder(m_transientTextures.size());
+    std::iota(placementOrder.begin(), placementOrder.end(), 0);
+    std::stable_sort(placementOrder.begin(), placementOrder.end(), [&](size_t lhs, size_t rhs) {
+        return m_transientTextures[lhs].texture->sizeInMemory() > m_transientTextures[rhs].texture->sizeInMemory();
+    });
+
+    std::vector<TransientTexture const*> placedTextures {};
+    std::vector<TransientTexture const*> overlappingTextures {};
+    size_t memorySize = 0;
+
+    for (size_t idx : placementOrder) {
+        TransientTexture& transientTexture = m_transientTextures[idx];
+        size_t size = transientTexture.texture->sizeInMemory();
+        size_t alignment = transientTexture.texture->memoryAlignment();
+
+        overlappingTextures.clear();
+        for (TransientTexture const* placedTexture : placedTextures) {
+            if (placedTexture->firstNodeIdx <= transientTexture.lastNodeIdx && transientTexture.firstNodeIdx <= placedTexture->lastNodeIdx) {
+                overlappingTextures.push_back(placedTexture);
+            }
+        }
+
+        std::sort(overlappingTextures.begin(), overlappingTextures.end(), [](TransientTexture const* lhs, TransientTexture const* rhs) {
+            return lhs->offset < rhs->offset;
+        });
+
+        size_t offset = 0;
+        for (TransientTexture const* overlappingTexture : overlappingTextures) {
+            if (offset + size <= overlappingTexture->offset) {
+                break;
+            }
+            size_t overlappingEnd = overlappingTexture->offset + overlappingTexture->texture->sizeInMemory();
+            offset = std::max(offset, ark::alignUp(overlappingEnd, alignment));
+        }
+
+        transientTexture.offset = offset;
+        memorySize = std::max(memorySize, offset + size);
+
+        placedTextures.push_back(&transientTexture);
+    }
+
+    std::vector<Backend::TextureMemoryPlacement> placements {};
+    for (TransientTexture const& transientTexture : m_transientTextures) {
+        placements.push_back(Backend::TextureMemoryPlacement { .texture = transientTexture.texture,
+                                                               .offset = transientTexture.offset });
+    }
+
+    if (!backend().placeTexturesInAliasedMemory(placements, memorySize)) {
+        ARKOSE_LOG(Info, "Registry: the backend can't alias texture memory, so all transient textures keep their own memory");
+        return stats;
+    }
+
+    // The textures now have new images & views, so refer to them in all bindings
+    for (BindingSet* bindingSet : m_bindingSetsWithTransientTextures) {
+        bindingSet->updateBindings();
+    }
+
+    for (TransientTexture const& transientTexture : m_transientTextures) {
+        std::string const& firstNodeName = m_allNodeNames[transientTexture.firstNodeIdx];
+        m_transientTexturesByFirstNode[firstNodeName].push_back(transientTexture.texture);
+    }
+
+    stats.peakSizeWithAliasing = memorySize;
+    return stats;
+}
+
+std::vector<Texture*> const& Registry::transientTexturesFirstUsedInNode(const std::string& nodeName) const
+{
+    static std::vector<Texture*> const noTextures {};
+
+    auto entry = m_transientTexturesByFirstNode.find(nodeName);
+    if (entry == m_transientTexturesByFirstNode.end()) {
+        return noTextures;
+    }
+
+    return entry->second;
+}
+
+bool Registry::markTransientTextureUse(Texture const& texture)
+{
+    if (!texture.isTransient()) {
+        return false;
+    }
+
+    auto entry = std::find_if(m_transientTextures.begin(), m_transientTextures.end(), [&](TransientTexture const& transientTexture) {
+        return transientTexture.texture == &texture;
+    });
+
+    // Transient textures from other registries (e.g. a previous one) can't be used
+    ARKOSE_ASSERT(entry != m_transientTextures.end());
+    ARKOSE_ASSERT(m_currentNodeName.has_value());
+
+    u32 nodeIdx = narrow_cast<u32>(m_allNodeNames.size() - 1);
+    entry->lastNodeIdx = std::max(entry->lastNodeIdx, nodeIdx);
+
+    return true;
+}
+
+bool Registry::markTransientTextureUses(BindingSet const& bindingSet)
+{
+    bool usesTransientTexture = false;
+
+    for (ShaderBinding const& shaderBinding : bindingSet.shaderBindings()) {
+        switch (shaderBinding.type()) {
+        case ShaderBindingType::SampledTexture:
+            for (Texture const* texture : shaderBinding.getSampledTextures()) {
+                usesTransientTexture |= texture && markTransientTextureUse(*texture);
+            }
+            break;
+        case ShaderBindingType::StorageTexture:
+            for (TextureMipView const& textureMipView : shaderBinding.getStorageTextures()) {
+                usesTransientTexture |= markTransientTextureUse(textureMipView.texture());
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return usesTransientTexture;
+}
+
 Texture& Registry::createOrReuseTextureArray(const std::string& name, uint32_t itemCount, Extent2D extent, Texture::Format format, Texture::Filters filters, Texture::Mipmap mipmap, ImageWrapModes wrapMode)
 {
     if (m_previousRegistry) {
@@ -206,6 +372,10 @@ BindingSet& Registry::createBindingSet(std::vector<ShaderBinding> shaderBindings
     auto bindingSet = backend().createBindingSet(shaderBindings);
     bindingSet->setOwningRegistry({}, this);
 
+    if (markTransientTextureUses(*bindingSet)) {
+        m_bindingSetsWithTransientTextures.push_back(bindingSet.get());
+    }
+
     m_bindingSets.push_back(std::move(bindingSet));
     return *m_bindingSets.back();
 }
@@ -293,6 +463,12 @@ ExternalFeature& Registry::createExternalFeature(ExternalFeatureType type, void*
     return *m_externalFeatures.back();
 }
 
+ReadbackRing& Registry::createReadbackRing(size_t sizePerFrame)
+{
+    m_readbackRings.push_back(std::make_unique<ReadbackRing>(backend(), sizePerFrame));
+    return *m_readbackRings.back();
+}
+
 bool Registry::hasPreviousNode(const std::string& name) const
 {
     auto entry = std::find(m_allNodeNames.begin(), m_allNodeNames.end(), name);
@@ -321,7 +497,11 @@ void Registry::publish(const std::string& name, TopLevelAS& tlas)
 
 Texture* Registry::getTexture(const std::string& name)
 {
-    return getResource(name, m_publishedTextures);
+    Texture* texture = getResource(name, m_publishedTextures);
+    if (texture) {
+        markTransientTextureUse(*texture);
+    }
+    return texture;
 }
 
 Buffer* Registry::getBuffer(const std::string& name)
@@ -331,7 +511,11 @@ Buffer* Registry::getBuffer(const std::string& name)
 
 BindingSet* Registry::getBindingSet(const std::string& name)
 {
-    return getResource(name, m_publishedBindingSets);
+    BindingSet* bindingSet = getResource(name, m_publishedBindingSets);
+    if (bindingSet) {
+        markTransientTextureUses(*bindingSet);
+    }
+    return bindingSet;
 }
 
 TopLevelAS* Registry::getTopLevelAccelerationStructure(const std::string& name)
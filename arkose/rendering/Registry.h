@@ -5,6 +5,7 @@
 #include "rendering/NodeDependency.h"
 #include "rendering/backend/base/Backend.h"
 #include "rendering/backend/Resources.h"
+#include "rendering/backend/util/ReadbackRing.h"
 #include "rendering/backend/util/UploadBuffer.h"
 #include "core/Assert.h"
 #include "core/Logging.h"
@@ -40,6 +41,25 @@ public:
     std::pair<Texture&, ReuseMode> createOrReuseTexture2D(const std::string& name, Extent2D, Texture::Format, Texture::Filters = Texture::Filters::linear(), Texture::Mipmap = Texture::Mipmap::None, ImageWrapModes = ImageWrapModes::repeatAll());
     Texture& createOrReuseTextureArray(const std::string& name, uint32_t itemCount, Extent2D, Texture::Format, Texture::Filters = Texture::Filters::linear(), Texture::Mipmap = Texture::Mipmap::None, ImageWrapModes = ImageWrapModes::repeatAll());
 
+    // Transient textures are only valid between their first and last use within a frame, i.e., they must be fully written before
+    // being read each frame, and nothing may be read back from them in a later frame. This lets transient textures which are used
+    // by non-overlapping ranges of nodes share the same memory, see aliasTransientTextures(..).
+    [[nodiscard]] Texture& createTransientTexture2D(Extent2D, Texture::Format, Texture::Filters = Texture::Filters::linear(), Texture::Mipmap = Texture::Mipmap::None, ImageWrapModes = ImageWrapModes::repeatAll());
+
+    struct TransientTextureStats {
+        u32 textureCount { 0 };
+        size_t peakSizeWithoutAliasing { 0 };
+        size_t peakSizeWithAliasing { 0 };
+    };
+
+    // Place all transient textures in shared memory, where textures that are alive at the same time never overlap. This is based
+    // on the nodes that use them, so it must be called after all nodes are constructed but before anything has been executed.
+    TransientTextureStats aliasTransientTextures(Badge<RenderPipeline>);
+
+    // The transient textures whose memory may have been used by other textures since the last frame, which therefore
+    // need an aliasing barrier before the node is executed (see CommandList::textureAliasingBarrier)
+    [[nodiscard]] std::vector<Texture*> const& transientTexturesFirstUsedInNode(const std::string& nodeName) const;
+
     [[nodiscard]] Buffer& createBuffer(size_t size, Buffer::Usage);
     [[nodiscard]] Buffer& createBuffer(const std::byte* data, size_t size, Buffer::Usage);
     template<typename T>
@@ -60,6 +80,9 @@ public:
 
     [[nodiscard]] ExternalFeature& createExternalFeature(ExternalFeatureType, void* externalFeatureParams);
 
+    // For reading back data from the GPU in the node's execute callback, see ReadbackRing
+    [[nodiscard]] ReadbackRing& createReadbackRing(size_t sizePerFrame);
+
     template<typename T, typename... Args>
     [[nodiscard]] T& allocate(Args&&...);
 
@@ -109,6 +132,21 @@ private:
     template<typename T>
     T* getResource(const std::string& name, const PublishedResourceMap<T>& map);
 
+    struct TransientTexture {
+        Texture* texture { nullptr };
+        u32 firstNodeIdx { 0 };
+        u32 lastNodeIdx { 0 };
+        size_t offset { 0 };
+    };
+
+    std::vector<TransientTexture> m_transientTextures {};
+    std::vector<BindingSet*> m_bindingSetsWithTransientTextures {};
+    std::unordered_map<std::string, std::vector<Texture*>> m_transientTexturesByFirstNode {};
+
+    // Extend the lifetime of transient textures to include the current node
+    bool markTransientTextureUse(Texture const&);
+    bool markTransientTextureUses(BindingSet const&);
+
     std::vector<std::unique_ptr<Buffer>> m_buffers;
     std::vector<std::unique_ptr<Texture>> m_textures;
     std::vector<std::unique_ptr<RenderTarget>> m_renderTargets;
@@ -119,6 +157,7 @@ private:
     std::vector<std::unique_ptr<RayTracingState>> m_rayTracingStates;
     std::vector<std::unique_ptr<ComputeState>> m_computeStates;
     std::vector<std::unique_ptr<ExternalFeature>> m_externalFeatures;
+    std::vector<std::unique_ptr<ReadbackRing>> m_readbackRings;
 
     static constexpr size_t PersistentBufferSize = 10 * ark::conversion::constants::BytesToKilobytes;
     BumpAllocator m_persistentBuffer { PersistentBufferSize };
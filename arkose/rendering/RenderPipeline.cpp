@@ -3,6 +3,7 @@
 #include "core/Logging.h"
 #include "utility/Profiling.h"
 #include "rendering/GpuScene.h"
+#include <ark/conversion.h>
 #include <fmt/format.h>
 #include <imgui.h>
 
@@ -53,6 +54,14 @@ void RenderPipeline::constructAll(Registry& registry)
     }
 
     registry.setCurrentNode({}, std::nullopt);
+
+    m_transientTextureStats = registry.aliasTransientTextures({});
+    if (m_transientTextureStats.textureCount > 0) {
+        ARKOSE_LOG(Info, "Transient textures: {} textures, peak footprint {:.1f} MB ({:.1f} MB without aliasing)",
+                   m_transientTextureStats.textureCount,
+                   ark::conversion::to::MB(m_transientTextureStats.peakSizeWithAliasing),
+                   ark::conversion::to::MB(m_transientTextureStats.peakSizeWithoutAliasing));
+    }
 }
 
 void RenderPipeline::forEachNodeInResolvedOrder(const Registry& frameManager, std::function<void(RenderPipelineNode&, const RenderPipelineNode::ExecuteCallback&)> callback) const
@@ -76,6 +85,11 @@ void RenderPipeline::drawGui(bool includeContainingWindow) const
     std::string frameTimePerfString = m_pipelineTimer.createFormattedString();
     ImGui::Text("Pipline frame time: %s", frameTimePerfString.c_str());
 
+    ImGui::Text("Transient textures: %u, peak footprint %.1f MB (%.1f MB without aliasing)",
+                m_transientTextureStats.textureCount,
+                ark::conversion::to::MB(m_transientTextureStats.peakSizeWithAliasing),
+                ark::conversion::to::MB(m_transientTextureStats.peakSizeWithoutAliasing));
+
     if (ImGui::TreeNode("Frame time plots")) {
 
         static float plotRangeMin = 0.0f;
@@ -71,6 +71,8 @@ private:
     std::vector<NodeContext> m_nodeContexts {};
     AvgElapsedTimer m_pipelineTimer {};
 
+    Registry::TransientTextureStats m_transientTextureStats {};
+
     Extent2D m_outputResolution {};
     Extent2D m_renderResolution {};
 
@@ -33,6 +33,10 @@ public:
     virtual bool isUpscalingNode() const { return false; }
     virtual Extent2D idealRenderResolution(Extent2D outputResolution) const { return outputResolution; }
 
+    // If true the execute callback may be recorded in parallel with other such nodes, in which case it must only modify
+    // state owned by this node and only upload through the upload buffer it's given. Backends are free to ignore this.
+    virtual bool supportsParallelRecording() const { return false; }
+
     virtual ExecuteCallback construct(GpuScene&, Registry&) = 0;
 
     // Draw GUI for this node
@@ -98,6 +98,10 @@ public:
     std::vector<StaticMeshLOD>& LODs(){ return m_lods; }
     const std::vector<StaticMeshLOD>& LODs() const { return m_lods; }
 
+    // Range of LODs that are allowed to be used for rendering (inclusive, the max LOD may be larger than the LOD count)
+    u32 minLod() const { return m_minLod; }
+    u32 maxLod() const { return m_maxLod; }
+
     ark::aabb3 boundingBox() const { return m_boundingBox; }
     geometry::Sphere boundingSphere() const { return m_boundingSphere; }
 
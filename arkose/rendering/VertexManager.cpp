@@ -13,19 +13,38 @@
 #include "asset/HairAsset.h"
 #include "scene/MeshInstance.h"
 #include <ark/conversion.h>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Frames to wait before freeing relocated allocations, to ensure no frames in flight are referencing them anymore
+constexpr u32 RetiredAllocationFrameDelay = 4;
+
+BufferCopyOperation createBufferToBufferCopy(Buffer& buffer, size_t srcOffset, size_t dstOffset, size_t size)
+{
+    BufferCopyOperation copyOperation {};
+    copyOperation.size = size;
+    copyOperation.srcBuffer = &buffer;
+    copyOperation.srcOffset = srcOffset;
+    copyOperation.destination = BufferCopyOperation::BufferDestination { .buffer = &buffer, .offset = dstOffset };
+    return copyOperation;
+}
+
+}
 
 VertexManager::VertexManager(Backend& backend, GpuScene& scene)
     : m_backend(&backend)
     , m_scene(&scene)
 {
-    const size_t indexBufferSize = MaxLoadedIndices * sizeofIndexType(indexType());
-    const size_t postionVertexBufferSize = MaxLoadedVertices * positionVertexLayout().packedVertexSize();
-    const size_t nonPostionVertexBufferSize = MaxLoadedVertices * nonPositionVertexLayout().packedVertexSize();
+    const size_t indexBufferSize = InitialLoadedIndices * sizeofIndexType(indexType());
+    const size_t postionVertexBufferSize = InitialLoadedVertices * positionVertexLayout().packedVertexSize();
+    const size_t nonPostionVertexBufferSize = InitialLoadedVertices * nonPositionVertexLayout().packedVertexSize();
     const size_t skinningDataVertexBufferSize = MaxLoadedSkinningVertices * skinningDataVertexLayout().packedVertexSize();
     const size_t velocityDataVertexBufferSize = MaxLoadedVelocityVertices * velocityDataVertexLayout().packedVertexSize();
     const size_t morphTargetVertexBufferSize = MaxLoadedMorphTargetVertices * morphTargetVertexLayout().packedVertexSize();
-    const size_t hairPositionVertexBufferSize = MaxLoadedHairVertices * hairPositionVertexLayout().packedVertexSize();
-    const size_t hairAttributeVertexBufferSize = MaxLoadedHairVertices * hairAttributeVertexLayout().packedVertexSize();
+    const size_t hairPositionVertexBufferSize = InitialLoadedHairVertices * hairPositionVertexLayout().packedVertexSize();
+    const size_t hairAttributeVertexBufferSize = InitialLoadedHairVertices * hairAttributeVertexLayout().packedVertexSize();
 
     float totalMemoryUseMb = ark::conversion::to::MB(indexBufferSize
                                                      + postionVertexBufferSize
@@ -35,7 +54,7 @@ VertexManager::VertexManager(Backend& backend, GpuScene& scene)
                                                      + morphTargetVertexBufferSize
                                                      + hairPositionVertexBufferSize
                                                      + hairAttributeVertexBufferSize);
-    ARKOSE_LOG(Info, "VertexManager: allocating a total of {:.1f} MB of VRAM for vertex data", totalMemoryUseMb);
+    ARKOSE_LOG(Info, "VertexManager: allocating an initial total of {:.1f} MB of VRAM for vertex data", totalMemoryUseMb);
 
     m_indexBuffer = backend.createBuffer(indexBufferSize, Buffer::Usage::Index);
     m_indexBuffer->setStride(sizeofIndexType(indexType()));
@@ -71,12 +90,12 @@ VertexManager::VertexManager(Backend& backend, GpuScene& scene)
 
     if (m_scene->maintainMeshShadingScene()) {
 
-        size_t vertexIndirectionBufferSize = sizeof(u32) * VertexManager::MaxLoadedVertices;
-        size_t meshletIndexBufferSize = sizeof(u32) * VertexManager::MaxLoadedIndices;
-        size_t meshletBufferSize = sizeof(ShaderMeshlet) * MaxLoadedMeshlets;
+        size_t vertexIndirectionBufferSize = sizeof(u32) * VertexManager::InitialLoadedVertices;
+        size_t meshletIndexBufferSize = sizeof(u32) * VertexManager::InitialLoadedIndices;
+        size_t meshletBufferSize = sizeof(ShaderMeshlet) * InitialLoadedMeshlets;
 
         float totalMeshletMemoryUseMb = ark::conversion::to::MB(vertexIndirectionBufferSize + meshletIndexBufferSize + meshletBufferSize);
-        ARKOSE_LOG(Info, "VertexManager: allocating a total of {:.1f} MB of VRAM for meshlet data", totalMeshletMemoryUseMb);
+        ARKOSE_LOG(Info, "VertexManager: allocating an initial total of {:.1f} MB of VRAM for meshlet data", totalMeshletMemoryUseMb);
 
         m_meshletVertexIndirectionBuffer = backend.createBuffer(vertexIndirectionBufferSize, Buffer::Usage::StorageBuffer);
         m_meshletVertexIndirectionBuffer->setStride(sizeof(u32));
@@ -109,6 +128,30 @@ void VertexManager::registerForStreaming(StaticMesh& mesh, bool includeIndices,
                                                 .includeVelocityData = includeVelocityData });
 }
 
+void VertexManager::unregisterFromStreaming(StaticMesh& mesh)
+{
+    auto entry = std::find_if(m_streamingMeshes.begin(), m_streamingMeshes.end(), [&](StreamingMesh const& streamingMesh) {
+        return streamingMesh.mesh == &mesh;
+    });
+
+    if (entry == m_streamingMeshes.end()) {
+        ARKOSE_LOG(Warning, "VertexManager: trying to unregister mesh '{}' which is not registered for streaming, ignoring", mesh.name());
+        return;
+    }
+
+    // Segments which are not yet allocated for have no valid internal allocations, so they're safe to free in any streaming state
+    for (StaticMeshLOD& lod : mesh.LODs()) {
+        for (StaticMeshSegment& meshSegment : lod.meshSegments) {
+            freeAllocations(meshSegment.vertexAllocation.internalAllocations);
+            meshSegment.vertexAllocation = {};
+            meshSegment.meshletView = std::nullopt;
+            meshSegment.blas.reset();
+        }
+    }
+
+    m_streamingMeshes.erase(entry);
+}
+
 void VertexManager::registerForStreaming(HairMesh& hairMesh)
 {
     m_streamingHairMeshes.push_back(StreamingHairMesh { .hairMesh = &hairMesh });
@@ -336,20 +379,16 @@ void VertexManager::processHairStreaming(CommandList&, UploadBuffer&)
                 break;
             }
 
-            OffsetAllocator::Allocation hairVertAlloc = m_hairVertexAllocator.allocate(pointCount);
-            OffsetAllocator::Allocation hairIndexAlloc = m_indexAllocator.allocate(indexCount);
+            OffsetAllocator::Allocation hairVertAlloc = allocateFromPool(GeometryPool::HairVertex, pointCount);
+            OffsetAllocator::Allocation hairIndexAlloc = allocateFromPool(GeometryPool::Index, indexCount);
 
             if (hairVertAlloc.isValid() && hairIndexAlloc.isValid()) {
                 hairMesh->hairVertexAlloc = hairVertAlloc;
                 hairMesh->indexAlloc = hairIndexAlloc;
                 streamingHairMesh.setNextState(HairStreamingState::StreamingPositionData);
             } else {
-                if (hairVertAlloc.isValid()) {
-                    m_hairVertexAllocator.free(hairVertAlloc);
-                }
-                if (hairIndexAlloc.isValid()) {
-                    m_indexAllocator.free(hairIndexAlloc);
-                }
+                freeToPool(GeometryPool::HairVertex, hairVertAlloc);
+                freeToPool(GeometryPool::Index, hairIndexAlloc);
             }
 
         } break;
@@ -643,9 +682,9 @@ void VertexManager::drawUI() const
                         totalUsedMeshletSizeMB += usedSizeMB;
                     };
 
-                    doTableRow("Meshlets", *m_meshletBuffer, m_nextFreeMeshletIndex);
-                    doTableRow("Meshlet vertex indirection", *m_meshletVertexIndirectionBuffer, m_nextFreeMeshletIndirIndex);
-                    doTableRow("Meshlet indices", *m_meshletIndexBuffer, m_nextFreeMeshletIndexBufferIndex);
+                    doTableRow("Meshlets", *m_meshletBuffer, numAllocatedMeshlets());
+                    doTableRow("Meshlet vertex indirection", *m_meshletVertexIndirectionBuffer, numAllocatedMeshletVertexIndirections());
+                    doTableRow("Meshlet indices", *m_meshletIndexBuffer, numAllocatedMeshletIndices());
 
                     ImGui::EndTable();
                 }
@@ -657,6 +696,61 @@ void VertexManager::drawUI() const
                 ImGui::Text("Total meshlet:        %.2f MB / %.2f MB", totalUsedMeshletSizeMB, totalAllocatedMeshletSizeMB);
             }
 
+            ImGui::Separator();
+
+            if (ImGui::BeginTable("GeometryPoolTable", 6)) {
+
+                ImGui::TableSetupColumn("Pool", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("Cap. #", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+                ImGui::TableSetupColumn("Max cap. #", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+                ImGui::TableSetupColumn("Utilization", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupColumn("Largest free #", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+                ImGui::TableSetupColumn("Fragmentation", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+
+                ImGui::TableHeadersRow();
+
+                for (size_t poolIdx = 0; poolIdx < GeometryPoolCount; ++poolIdx) {
+                    GeometryPool pool = static_cast<GeometryPool>(poolIdx);
+
+                    size_t capacity = poolCapacity(pool);
+                    if (capacity == 0) {
+                        continue;
+                    }
+
+                    size_t maxCapacity = geometryPoolMaxCapacity(pool);
+                    OffsetAllocator::StorageReport report = poolAllocator(pool).storageReport();
+                    size_t numUsed = maxCapacity - report.totalFreeSpace;
+
+                    ImGui::TableNextRow();
+
+                    ImGui::TableSetColumnIndex(0);
+                    if (m_requiredPoolCapacity[poolIdx] > capacity) {
+                        ImGui::Text("%s (pending growth)", geometryPoolName(pool));
+                    } else {
+                        ImGui::Text("%s", geometryPoolName(pool));
+                    }
+
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%zu", capacity);
+
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%zu", maxCapacity);
+
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%.1f%%", 100.0f * static_cast<f32>(numUsed) / static_cast<f32>(capacity));
+
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%u", report.largestFreeRegion);
+
+                    ImGui::TableSetColumnIndex(5);
+                    ImGui::Text("%.1f%%", 100.0f * poolFragmentation(pool));
+                }
+
+                ImGui::EndTable();
+            }
+
+            ImGui::Text("Defragmentation: relocated %u segments, %.2f MB in total", m_numRelocatedSegments, ark::conversion::to::MB(m_numRelocatedBytes));
+
             ImGui::EndChild();
             ImGui::EndTabItem();
         }
@@ -842,34 +936,31 @@ VertexAllocation VertexManager::allocateMeshDataForSegment(MeshSegmentAsset cons
 
     VertexAllocation::Internal allocs;
 
-    allocs.vertexAlloc = m_vertexAllocator.allocate(vertexCount);
+    allocs.vertexAlloc = allocateFromPool(GeometryPool::Vertex, vertexCount);
     if (!allocs.vertexAlloc.isValid()) {
         return {};
     }
 
     if (indexCount > 0 && includeIndices) {
-        allocs.indexAlloc = m_indexAllocator.allocate(indexCount);
+        allocs.indexAlloc = allocateFromPool(GeometryPool::Index, indexCount);
         if (!allocs.indexAlloc.isValid()) {
-            if (allocs.vertexAlloc.isValid()) m_vertexAllocator.free(allocs.vertexAlloc);
+            freeAllocations(allocs);
             return {};
         }
     }
 
     if (segmentAsset.hasSkinningData() && includeSkinningData) {
-        allocs.skinningVertAlloc = m_skinningVertexAllocator.allocate(vertexCount);
+        allocs.skinningVertAlloc = allocateFromPool(GeometryPool::SkinningVertex, vertexCount);
         if (!allocs.skinningVertAlloc.isValid()) {
-            if (allocs.vertexAlloc.isValid()) m_vertexAllocator.free(allocs.vertexAlloc);
-            if (allocs.indexAlloc.isValid()) m_indexAllocator.free(allocs.indexAlloc);
+            freeAllocations(allocs);
             return {};
         }
     }
 
     if (includeVelocityData) {
-        allocs.velocityVertAlloc = m_velocityVertexAllocator.allocate(vertexCount);
+        allocs.velocityVertAlloc = allocateFromPool(GeometryPool::VelocityVertex, vertexCount);
         if (!allocs.velocityVertAlloc.isValid()) {
-            if (allocs.vertexAlloc.isValid()) m_vertexAllocator.free(allocs.vertexAlloc);
-            if (allocs.indexAlloc.isValid()) m_indexAllocator.free(allocs.indexAlloc);
-            if (allocs.skinningVertAlloc.isValid()) m_skinningVertexAllocator.free(allocs.skinningVertAlloc);
+            freeAllocations(allocs);
             return {};
         }
     }
@@ -880,18 +971,11 @@ VertexAllocation VertexManager::allocateMeshDataForSegment(MeshSegmentAsset cons
             ARKOSE_ASSERT(morphTarget.normals.size() == 0 || morphTarget.normals.size() == vertexCount);
             ARKOSE_ASSERT(morphTarget.tangents.size() == 0 || morphTarget.tangents.size() == vertexCount);
 
-            OffsetAllocator::Allocation morphAlloc = m_morphTargetVertexAllocator.allocate(vertexCount);
+            OffsetAllocator::Allocation morphAlloc = allocateFromPool(GeometryPool::MorphTargetVertex, vertexCount);
             if (morphAlloc.isValid()) {
                 allocs.morphTargetVertAllocs.push_back(morphAlloc);
             } else {
-                if (allocs.vertexAlloc.isValid()) m_vertexAllocator.free(allocs.vertexAlloc);
-                if (allocs.indexAlloc.isValid()) m_indexAllocator.free(allocs.indexAlloc);
-                if (allocs.skinningVertAlloc.isValid()) m_skinningVertexAllocator.free(allocs.skinningVertAlloc);
-                if (allocs.velocityVertAlloc.isValid()) m_velocityVertexAllocator.free(allocs.velocityVertAlloc);
-                while (!allocs.morphTargetVertAllocs.empty()) {
-                    m_morphTargetVertexAllocator.free(allocs.morphTargetVertAllocs.back());
-                    allocs.morphTargetVertAllocs.pop_back();
-                }
+                freeAllocations(allocs);
                 return {};
             }
         }
@@ -928,6 +1012,398 @@ VertexAllocation VertexManager::allocateMeshDataForSegment(MeshSegmentAsset cons
     return allocation;
 }
 
+char const* VertexManager::geometryPoolName(GeometryPool pool)
+{
+    switch (pool) {
+    case GeometryPool::Index:
+        return "Index";
+    case GeometryPool::Vertex:
+        return "Vertex";
+    case GeometryPool::SkinningVertex:
+        return "Skinning vertex";
+    case GeometryPool::VelocityVertex:
+        return "Velocity vertex";
+    case GeometryPool::MorphTargetVertex:
+        return "Morph target vertex";
+    case GeometryPool::HairVertex:
+        return "Hair vertex";
+    case GeometryPool::Meshlet:
+        return "Meshlet";
+    case GeometryPool::MeshletVertexIndirection:
+        return "Meshlet vertex indirection";
+    case GeometryPool::MeshletIndex:
+        return "Meshlet index";
+    }
+
+    ASSERT_NOT_REACHED();
+}
+
+size_t VertexManager::geometryPoolMaxCapacity(GeometryPool pool)
+{
+    switch (pool) {
+    case GeometryPool::Index:
+        return MaxLoadedIndices;
+    case GeometryPool::Vertex:
+        return MaxLoadedVertices;
+    case GeometryPool::SkinningVertex:
+        return MaxLoadedSkinningVertices;
+    case GeometryPool::VelocityVertex:
+        return MaxLoadedVelocityVertices;
+    case GeometryPool::MorphTargetVertex:
+        return MaxLoadedMorphTargetVertices;
+    case GeometryPool::HairVertex:
+        return MaxLoadedHairVertices;
+    case GeometryPool::Meshlet:
+        return MaxLoadedMeshlets;
+    case GeometryPool::MeshletVertexIndirection:
+        return MaxLoadedVertices;
+    case GeometryPool::MeshletIndex:
+        return MaxLoadedIndices;
+    }
+
+    ASSERT_NOT_REACHED();
+}
+
+OffsetAllocator::Allocator& VertexManager::poolAllocator(GeometryPool pool)
+{
+    return const_cast<OffsetAllocator::Allocator&>(std::as_const(*this).poolAllocator(pool));
+}
+
+OffsetAllocator::Allocator const& VertexManager::poolAllocator(GeometryPool pool) const
+{
+    switch (pool) {
+    case GeometryPool::Index:
+        return m_indexAllocator;
+    case GeometryPool::Vertex:
+        return m_vertexAllocator;
+    case GeometryPool::SkinningVertex:
+        return m_skinningVertexAllocator;
+    case GeometryPool::VelocityVertex:
+        return m_velocityVertexAllocator;
+    case GeometryPool::MorphTargetVertex:
+        return m_morphTargetVertexAllocator;
+    case GeometryPool::HairVertex:
+        return m_hairVertexAllocator;
+    case GeometryPool::Meshlet:
+        return m_meshletAllocator;
+    case GeometryPool::MeshletVertexIndirection:
+        return m_meshletVertexIndirectionAllocator;
+    case GeometryPool::MeshletIndex:
+        return m_meshletIndexAllocator;
+    }
+
+    ASSERT_NOT_REACHED();
+}
+
+std::vector<Buffer*> VertexManager::poolBuffers(GeometryPool pool) const
+{
+    switch (pool) {
+    case GeometryPool::Index:
+        return { m_indexBuffer.get() };
+    case GeometryPool::Vertex:
+        return { m_positionOnlyVertexBuffer.get(), m_nonPositionVertexBuffer.get() };
+    case GeometryPool::SkinningVertex:
+        return { m_skinningDataVertexBuffer.get() };
+    case GeometryPool::VelocityVertex:
+        return { m_velocityDataVertexBuffer.get() };
+    case GeometryPool::MorphTargetVertex:
+        return { m_morphTargetVertexBuffer.get() };
+    case GeometryPool::HairVertex:
+        return { m_hairPositionVertexBuffer.get(), m_hairAttributeVertexBuffer.get() };
+    case GeometryPool::Meshlet:
+        return m_meshletBuffer ? std::vector<Buffer*> { m_meshletBuffer.get() } : std::vector<Buffer*> {};
+    case GeometryPool::MeshletVertexIndirection:
+        return m_meshletVertexIndirectionBuffer ? std::vector<Buffer*> { m_meshletVertexIndirectionBuffer.get() } : std::vector<Buffer*> {};
+    case GeometryPool::MeshletIndex:
+        return m_meshletIndexBuffer ? std::vector<Buffer*> { m_meshletIndexBuffer.get() } : std::vector<Buffer*> {};
+    }
+
+    ASSERT_NOT_REACHED();
+}
+
+size_t VertexManager::poolCapacity(GeometryPool pool) const
+{
+    // All buffers of a pool always have the same capacity, so just look at the first one
+    std::vector<Buffer*> buffers = poolBuffers(pool);
+    return buffers.empty() ? 0 : buffers.front()->size() / buffers.front()->stride();
+}
+
+float VertexManager::poolFragmentation(GeometryPool pool) const
+{
+    // The ratio of the free space which is not part of the largest free region, i.e., 0% if all free space is contiguous.
+    // NOTE: The allocator covers the max capacity, so free space which is not yet backed by the buffers is included.
+    OffsetAllocator::StorageReport report = poolAllocator(pool).storageReport();
+    if (report.totalFreeSpace == 0) {
+        return 0.0f;
+    }
+
+    return 1.0f - static_cast<float>(report.largestFreeRegion) / static_cast<float>(report.totalFreeSpace);
+}
+
+OffsetAllocator::Allocation VertexManager::allocateFromPool(GeometryPool pool, u32 count)
+{
+    OffsetAllocator::Allocator& allocator = poolAllocator(pool);
+
+    OffsetAllocator::Allocation allocation = allocator.allocate(count);
+    if (!allocation.isValid()) {
+        return {};
+    }
+
+    size_t requiredCapacity = static_cast<size_t>(allocation.offset) + count;
+    if (requiredCapacity > poolCapacity(pool)) {
+        // Not backed by the buffers yet; request growth so that it can be allocated next time around
+        allocator.free(allocation);
+        size_t& poolRequiredCapacity = m_requiredPoolCapacity[static_cast<size_t>(pool)];
+        poolRequiredCapacity = std::max(poolRequiredCapacity, requiredCapacity);
+        return {};
+    }
+
+    return allocation;
+}
+
+void VertexManager::freeToPool(GeometryPool pool, OffsetAllocator::Allocation allocation)
+{
+    if (allocation.isValid()) {
+        poolAllocator(pool).free(allocation);
+    }
+}
+
+void VertexManager::freeAllocations(VertexAllocation::Internal& allocs)
+{
+    freeToPool(GeometryPool::Vertex, allocs.vertexAlloc);
+    freeToPool(GeometryPool::Index, allocs.indexAlloc);
+    freeToPool(GeometryPool::SkinningVertex, allocs.skinningVertAlloc);
+    freeToPool(GeometryPool::VelocityVertex, allocs.velocityVertAlloc);
+    for (OffsetAllocator::Allocation morphAlloc : allocs.morphTargetVertAllocs) {
+        freeToPool(GeometryPool::MorphTargetVertex, morphAlloc);
+    }
+    freeToPool(GeometryPool::Meshlet, allocs.meshletAlloc);
+    freeToPool(GeometryPool::MeshletVertexIndirection, allocs.meshletVertexIndirectionAlloc);
+    freeToPool(GeometryPool::MeshletIndex, allocs.meshletIndexAlloc);
+
+    allocs = VertexAllocation::Internal();
+}
+
+bool VertexManager::growBuffersIfNeeded()
+{
+    SCOPED_PROFILE_ZONE();
+
+    bool anyBufferReplaced = false;
+
+    for (size_t poolIdx = 0; poolIdx < GeometryPoolCount; ++poolIdx) {
+        GeometryPool pool = static_cast<GeometryPool>(poolIdx);
+
+        size_t capacity = poolCapacity(pool);
+        size_t requiredCapacity = m_requiredPoolCapacity[poolIdx];
+        if (requiredCapacity <= capacity) {
+            continue;
+        }
+
+        // Grow by at least 50% so we don't have to reallocate for every new mesh which is streamed in
+        size_t newCapacity = std::min(std::max(requiredCapacity, capacity + capacity / 2), geometryPoolMaxCapacity(pool));
+        ARKOSE_ASSERT(newCapacity >= requiredCapacity);
+
+        if (!anyBufferReplaced) {
+            // Frames in flight may still be using the buffers that we're about to replace
+            m_backend->completePendingOperations();
+        }
+
+        for (Buffer* buffer : poolBuffers(pool)) {
+            buffer->reallocateWithSize(newCapacity * buffer->stride(), Buffer::ReallocateStrategy::CopyExistingData);
+        }
+
+        ARKOSE_LOG(Info, "VertexManager: grew {} pool from {} to {} elements", geometryPoolName(pool), capacity, newCapacity);
+        anyBufferReplaced = true;
+    }
+
+    return anyBufferReplaced;
+}
+
+void VertexManager::processDefragmentation(CommandList& cmdList, UploadBuffer& uploadBuffer, std::unordered_set<StaticMeshHandle>& updatedMeshes)
+{
+    SCOPED_PROFILE_ZONE();
+
+    // Free the allocations that were relocated away from once no frames in flight can reference them anymore
+    for (size_t idx = 0; idx < m_retiredAllocations.size();) {
+        RetiredAllocation& retiredAllocation = m_retiredAllocations[idx];
+        if (retiredAllocation.remainingFrames > 0) {
+            retiredAllocation.remainingFrames -= 1;
+            idx += 1;
+        } else {
+            freeToPool(retiredAllocation.pool, retiredAllocation.allocation);
+            retiredAllocation = m_retiredAllocations.back();
+            m_retiredAllocations.pop_back();
+        }
+    }
+
+    bool defragmentVertices = poolFragmentation(GeometryPool::Vertex) > DefragmentationThreshold;
+    bool defragmentIndices = poolFragmentation(GeometryPool::Index) > DefragmentationThreshold;
+    if (!defragmentVertices && !defragmentIndices) {
+        return;
+    }
+
+    // Only fully loaded static meshes are relocated. Skeletal meshes are not, as their allocations are also referenced by the
+    // skinning vertex mappings of their instances, and neither is hair, but they also make up a small part of the pools.
+    struct RelocationCandidate {
+        StaticMeshSegment* segment;
+        u32 offset;
+    };
+
+    std::vector<RelocationCandidate> vertexCandidates {};
+    std::vector<RelocationCandidate> indexCandidates {};
+
+    for (StreamingMesh& streamingMesh : m_streamingMeshes) {
+        if (streamingMesh.state != MeshStreamingState::Loaded || streamingMesh.includeSkinningData || streamingMesh.includeMorphTargetData) {
+            continue;
+        }
+
+        for (StaticMeshLOD& lod : streamingMesh.mesh->LODs()) {
+            for (StaticMeshSegment& meshSegment : lod.meshSegments) {
+                VertexAllocation::Internal const& allocs = meshSegment.vertexAllocation.internalAllocations;
+                if (defragmentVertices && allocs.vertexAlloc.isValid()) {
+                    vertexCandidates.push_back({ &meshSegment, allocs.vertexAlloc.offset });
+                }
+                if (defragmentIndices && allocs.indexAlloc.isValid()) {
+                    indexCandidates.push_back({ &meshSegment, allocs.indexAlloc.offset });
+                }
+            }
+        }
+    }
+
+    // Move the data at the highest offsets into free regions further down, which both compacts the used space and merges the free regions
+    auto sortByDescendingOffset = [](std::vector<RelocationCandidate>& candidates) {
+        std::sort(candidates.begin(), candidates.end(), [](RelocationCandidate const& lhs, RelocationCandidate const& rhs) {
+            return lhs.offset > rhs.offset;
+        });
+    };
+
+    sortByDescendingOffset(vertexCandidates);
+    sortByDescendingOffset(indexCandidates);
+
+    std::vector<BufferCopyOperation> copyOperations {};
+    size_t remainingBudget = DefragmentationBudgetPerFrame;
+
+    for (RelocationCandidate const& candidate : vertexCandidates) {
+        size_t relocatedSize = relocateVertexData(*candidate.segment, copyOperations, uploadBuffer);
+        if (relocatedSize == 0) {
+            // Nowhere further down to move it to (or no upload budget left), so there's no point in looking at lower offsets either
+            break;
+        }
+
+        updatedMeshes.insert(candidate.segment->staticMeshHandle);
+        remainingBudget -= std::min(remainingBudget, relocatedSize);
+        if (remainingBudget == 0) {
+            break;
+        }
+    }
+
+    for (RelocationCandidate const& candidate : indexCandidates) {
+        if (remainingBudget == 0) {
+            break;
+        }
+
+        size_t relocatedSize = relocateIndexData(*candidate.segment, copyOperations);
+        if (relocatedSize == 0) {
+            break;
+        }
+
+        updatedMeshes.insert(candidate.segment->staticMeshHandle);
+        remainingBudget -= std::min(remainingBudget, relocatedSize);
+    }
+
+    if (copyOperations.size() > 0) {
+        cmdList.executeBufferCopyOperations(std::move(copyOperations));
+    }
+}
+
+size_t VertexManager::relocateVertexData(StaticMeshSegment& meshSegment, std::vector<BufferCopyOperation>& copyOperations, UploadBuffer& uploadBuffer)
+{
+    VertexAllocation& allocation = meshSegment.vertexAllocation;
+    VertexAllocation::Internal& allocs = allocation.internalAllocations;
+
+    // The meshlet vertex indirection references the vertices by their index in the global vertex buffers, so it has to be updated too
+    std::vector<u32> adjustedVertexIndirection {};
+    if (allocs.meshletVertexIndirectionAlloc.isValid()) {
+        adjustedVertexIndirection = meshSegment.asset->meshletData.value().meshletVertexIndirection;
+        if (adjustedVertexIndirection.size() * sizeof(u32) > uploadBuffer.alignedRemainingSize(1)) {
+            return 0;
+        }
+    }
+
+    // NOTE: Don't use `allocateFromPool(..)` as we never want to grow the pool just to move data around
+    OffsetAllocator::Allocation newVertexAlloc = m_vertexAllocator.allocate(allocation.vertexCount);
+    if (!newVertexAlloc.isValid()) {
+        return 0;
+    }
+
+    if (newVertexAlloc.offset > allocs.vertexAlloc.offset) {
+        m_vertexAllocator.free(newVertexAlloc);
+        return 0;
+    }
+
+    size_t relocatedSize = 0;
+    for (Buffer* buffer : poolBuffers(GeometryPool::Vertex)) {
+        size_t stride = buffer->stride();
+        copyOperations.push_back(createBufferToBufferCopy(*buffer, allocs.vertexAlloc.offset * stride, newVertexAlloc.offset * stride, allocation.vertexCount * stride));
+        relocatedSize += allocation.vertexCount * stride;
+    }
+
+    if (allocs.meshletVertexIndirectionAlloc.isValid()) {
+        for (u32& vertexIndex : adjustedVertexIndirection) {
+            vertexIndex += newVertexAlloc.offset;
+        }
+
+        size_t vertexIndirectionOffset = allocs.meshletVertexIndirectionAlloc.offset * sizeof(u32);
+        uploadBuffer.upload(adjustedVertexIndirection, *m_meshletVertexIndirectionBuffer, vertexIndirectionOffset);
+    }
+
+    m_retiredAllocations.push_back(RetiredAllocation { .pool = GeometryPool::Vertex,
+                                                       .allocation = allocs.vertexAlloc,
+                                                       .remainingFrames = RetiredAllocationFrameDelay });
+
+    allocs.vertexAlloc = newVertexAlloc;
+    allocation.firstVertex = newVertexAlloc.offset;
+
+    m_numRelocatedSegments += 1;
+    m_numRelocatedBytes += relocatedSize;
+
+    return relocatedSize;
+}
+
+size_t VertexManager::relocateIndexData(StaticMeshSegment& meshSegment, std::vector<BufferCopyOperation>& copyOperations)
+{
+    VertexAllocation& allocation = meshSegment.vertexAllocation;
+    VertexAllocation::Internal& allocs = allocation.internalAllocations;
+
+    // NOTE: Don't use `allocateFromPool(..)` as we never want to grow the pool just to move data around
+    OffsetAllocator::Allocation newIndexAlloc = m_indexAllocator.allocate(allocation.indexCount);
+    if (!newIndexAlloc.isValid()) {
+        return 0;
+    }
+
+    if (newIndexAlloc.offset > allocs.indexAlloc.offset) {
+        m_indexAllocator.free(newIndexAlloc);
+        return 0;
+    }
+
+    // Indices are relative to the first vertex of the segment, so they can be moved as-is
+    size_t indexSize = sizeofIndexType(indexType());
+    size_t relocatedSize = allocation.indexCount * indexSize;
+    copyOperations.push_back(createBufferToBufferCopy(*m_indexBuffer, allocs.indexAlloc.offset * indexSize, newIndexAlloc.offset * indexSize, relocatedSize));
+
+    m_retiredAllocations.push_back(RetiredAllocation { .pool = GeometryPool::Index,
+                                                       .allocation = allocs.indexAlloc,
+                                                       .remainingFrames = RetiredAllocationFrameDelay });
+
+    allocs.indexAlloc = newIndexAlloc;
+    allocation.firstIndex = newIndexAlloc.offset;
+
+    m_numRelocatedSegments += 1;
+    m_numRelocatedBytes += relocatedSize;
+
+    return relocatedSize;
+}
+
 void VertexManager::uploadMeshDataForAllocation(MeshSegmentAsset const& segmentAsset, VertexAllocation const& allocation)
 {
     SCOPED_PROFILE_ZONE();
@@ -1199,24 +1675,15 @@ bool VertexManager::streamIndexData(StreamingMesh& streamingMesh, StaticMeshSegm
     return streamingMesh.nextIndex == allocation.indexCount;
 }
 
-std::optional<MeshletView> VertexManager::streamMeshletDataForSegment(StreamingMesh& streamingMesh, StaticMeshSegment const& meshSegment, UploadBuffer& uploadBuffer)
+std::optional<MeshletView> VertexManager::streamMeshletDataForSegment(StreamingMesh& streamingMesh, StaticMeshSegment& meshSegment, UploadBuffer& uploadBuffer)
 {
     MeshSegmentAsset const& meshSegmentAsset = *meshSegment.asset;
     MeshletDataAsset const& meshletDataAsset = meshSegmentAsset.meshletData.value();
 
-    //
-    // Test stuff (should not be needed, remove me)
-    //
-
     u32 vertexCount = narrow_cast<u32>(meshletDataAsset.meshletVertexIndirection.size());
     u32 indexCount = narrow_cast<u32>(meshletDataAsset.meshletIndices.size());
     u32 meshletCount = narrow_cast<u32>(meshletDataAsset.meshlets.size());
 
-    // TODO: Use allocations for this path as well! Not just a few incrementing u32s...
-    ARKOSE_ASSERT(m_nextFreeMeshletIndirIndex + vertexCount < VertexManager::MaxLoadedVertices);
-    ARKOSE_ASSERT(m_nextFreeMeshletIndexBufferIndex + indexCount < VertexManager::MaxLoadedIndices);
-    ARKOSE_ASSERT(m_nextFreeMeshletIndex + meshletCount < VertexManager::MaxLoadedMeshlets);
-
     size_t numUploads = 3;
     size_t totalUploadSize = vertexCount * sizeof(u32) // vertex indirection buffer
         + indexCount * sizeof(u32) // index buffer
@@ -1232,14 +1699,37 @@ std::optional<MeshletView> VertexManager::streamMeshletDataForSegment(StreamingM
         return std::nullopt;
     }
 
+    //
+    // Allocate space for the meshlet data
+    //
+
+    VertexAllocation::Internal& allocs = meshSegment.vertexAllocation.internalAllocations;
+    ARKOSE_ASSERT(!allocs.meshletAlloc.isValid());
+
+    OffsetAllocator::Allocation vertexIndirectionAlloc = allocateFromPool(GeometryPool::MeshletVertexIndirection, vertexCount);
+    OffsetAllocator::Allocation indexAlloc = allocateFromPool(GeometryPool::MeshletIndex, indexCount);
+    OffsetAllocator::Allocation meshletAlloc = allocateFromPool(GeometryPool::Meshlet, meshletCount);
+
+    if (!vertexIndirectionAlloc.isValid() || !indexAlloc.isValid() || !meshletAlloc.isValid()) {
+        // No room to allocate, hopefully temporarily, try again later
+        freeToPool(GeometryPool::MeshletVertexIndirection, vertexIndirectionAlloc);
+        freeToPool(GeometryPool::MeshletIndex, indexAlloc);
+        freeToPool(GeometryPool::Meshlet, meshletAlloc);
+        return std::nullopt;
+    }
+
+    allocs.meshletVertexIndirectionAlloc = vertexIndirectionAlloc;
+    allocs.meshletIndexAlloc = indexAlloc;
+    allocs.meshletAlloc = meshletAlloc;
+
     //
     // Initial data prep
     //
 
-    // Offset indices by current vertex count as we put all meshlets in a single buffer
+    // Offset indices by the first vertex indirection as we put all meshlets in a single buffer
     std::vector<u32> adjustedMeshletIndices = meshletDataAsset.meshletIndices;
     for (u32& index : adjustedMeshletIndices) {
-        index += m_nextFreeMeshletIndirIndex;
+        index += vertexIndirectionAlloc.offset;
     }
 
     // Offset vertex indirection by the segment's first vertex as we're referencing the global vertex buffers
@@ -1252,46 +1742,49 @@ std::optional<MeshletView> VertexManager::streamMeshletDataForSegment(StreamingM
     // Stream meshlet vertex indirection data
     //
 
-    size_t vertexIndirectionOffset = m_nextFreeMeshletIndirIndex * sizeof(u32);
+    size_t vertexIndirectionOffset = vertexIndirectionAlloc.offset * sizeof(u32);
     uploadBuffer.upload(adjustedVertexIndirection, *m_meshletVertexIndirectionBuffer, vertexIndirectionOffset);
 
     //
     // Stream meshlet index data
     //
 
-    size_t indexDataOffset = m_nextFreeMeshletIndexBufferIndex * sizeof(u32);
+    size_t indexDataOffset = indexAlloc.offset * sizeof(u32);
     uploadBuffer.upload(adjustedMeshletIndices, *m_meshletIndexBuffer, indexDataOffset);
 
     //
     // Stream meshlet data
     //
 
-    for (MeshletAsset const& meshletAsset : meshletDataAsset.meshlets) {
+    if (m_meshlets.size() < meshletAlloc.offset + meshletCount) {
+        m_meshlets.resize(meshletAlloc.offset + meshletCount);
+    }
+
+    u32 nextMeshletFirstVertex = vertexIndirectionAlloc.offset;
+    for (u32 meshletIdx = 0; meshletIdx < meshletCount; ++meshletIdx) {
+        MeshletAsset const& meshletAsset = meshletDataAsset.meshlets[meshletIdx];
 
-        ShaderMeshlet meshlet { .firstIndex = m_nextFreeMeshletIndexBufferIndex + meshletAsset.firstIndex,
+        ShaderMeshlet meshlet { .firstIndex = indexAlloc.offset + meshletAsset.firstIndex,
                                 .triangleCount = meshletAsset.triangleCount,
-                                .firstVertex = m_nextFreeMeshletIndirIndex,
+                                .firstVertex = nextMeshletFirstVertex,
                                 .vertexCount = meshletAsset.vertexCount,
                                 .center = meshletAsset.center,
                                 .radius = meshletAsset.radius };
 
-        m_meshlets.push_back(meshlet);
-        m_nextFreeMeshletIndirIndex += meshletAsset.vertexCount;
+        m_meshlets[meshletAlloc.offset + meshletIdx] = meshlet;
+        nextMeshletFirstVertex += meshletAsset.vertexCount;
     }
 
-    size_t meshletDataDstOffset = m_nextFreeMeshletIndex * sizeof(ShaderMeshlet);
-    uploadBuffer.upload(m_meshlets.data() + m_nextFreeMeshletIndex, meshletCount * sizeof(ShaderMeshlet), *m_meshletBuffer, meshletDataDstOffset);
+    size_t meshletDataDstOffset = meshletAlloc.offset * sizeof(ShaderMeshlet);
+    uploadBuffer.upload(m_meshlets.data() + meshletAlloc.offset, meshletCount * sizeof(ShaderMeshlet), *m_meshletBuffer, meshletDataDstOffset);
 
     //
     // Finalize
     //
 
-    MeshletView meshletView = { .firstMeshlet = m_nextFreeMeshletIndex,
+    MeshletView meshletView = { .firstMeshlet = meshletAlloc.offset,
                                 .meshletCount = meshletCount };
 
-    m_nextFreeMeshletIndexBufferIndex += indexCount;
-    m_nextFreeMeshletIndex += meshletCount;
-
     return meshletView;
 }
 
@@ -9,6 +9,7 @@
 #include "rendering/StaticMesh.h"
 #include "rendering/Vertex.h"
 #include <ark/copying.h>
+#include <array>
 #include <memory>
 #include <optional>
 #include <unordered_set>
@@ -21,6 +22,7 @@ class BottomLevelAS;
 class CommandList;
 class MeshSegmentAsset;
 class UploadBuffer;
+struct BufferCopyOperation;
 struct SkeletalMeshInstance;
 struct StaticMeshSegment;
 
@@ -32,7 +34,8 @@ public:
     ARK_NON_COPYABLE(VertexManager);
 
     void registerForStreaming(StaticMesh&, bool includeIndices, bool includeSkinningData, bool includeMorphData);
-    //void unregisterFromStreaming(StaticMesh&); TODO!
+    // NOTE: Frees the mesh data immediately, so the caller must ensure that no frames in flight are still referencing it
+    void unregisterFromStreaming(StaticMesh&);
 
     bool allocateSkeletalMeshInstance(SkeletalMeshInstance&, CommandList&);
     //void deallocateSkeletalMeshInstance(SkeletalMeshInstance&); // TODO!
@@ -42,6 +45,13 @@ public:
     void processMeshStreaming(CommandList&, UploadBuffer&, std::unordered_set<StaticMeshHandle>& updatedMeshes);
     void processHairStreaming(CommandList&, UploadBuffer&);
 
+    // Relocates mesh data to lower offsets (with GPU copies) when the pools are too fragmented. Relocated meshes are added to `updatedMeshes`.
+    void processDefragmentation(CommandList&, UploadBuffer&, std::unordered_set<StaticMeshHandle>& updatedMeshes);
+
+    // Grows the buffers which have run out of capacity. As the buffers are replaced this must not be called while recording a frame, and
+    // if it returns true the render pipeline must be reconstructed, as existing binding sets are referencing the old buffers.
+    bool growBuffersIfNeeded();
+
     void drawUI() const;
 
     IndexType indexType() const { return IndexType::UInt32; }
@@ -52,6 +62,7 @@ public:
     Buffer& positionVertexBuffer() { return *m_positionOnlyVertexBuffer; }
 
     VertexLayout const& nonPositionVertexLayout() const { return m_nonPositionVertexLayout; }
+    VertexComponent nonPositionTexCoordComponent() const { return m_nonPositionVertexLayout.components()[0]; }
     Buffer const& nonPositionVertexBuffer() const { return *m_nonPositionVertexBuffer; }
     Buffer& nonPositionVertexBuffer() { return *m_nonPositionVertexBuffer; }
 
@@ -98,6 +109,18 @@ public:
     // Here we add a factor of 2 to allow for a worst case where every meshlet is only half-full.
     static constexpr size_t MaxLoadedMeshlets         = MaxLoadedTriangles / 124 * 2;
 
+    // Initial capacity of the buffers, which then grow on demand up to the max capacity. The skinning, velocity, and morph target
+    // buffers are small enough that they are simply created at their max capacity.
+    static constexpr size_t InitialLoadedVertices     = 1'000'000;
+    static constexpr size_t InitialLoadedHairVertices = 250'000;
+    static constexpr size_t InitialLoadedTriangles    = 1'000'000;
+    static constexpr size_t InitialLoadedIndices      = 3 * InitialLoadedTriangles;
+    static constexpr size_t InitialLoadedMeshlets     = InitialLoadedTriangles / 124 * 2;
+
+    // Relocate mesh data when the ratio of free space outside of the largest free region goes above this threshold
+    static constexpr float DefragmentationThreshold = 0.25f;
+    static constexpr size_t DefragmentationBudgetPerFrame = 4 * 1024 * 1024;
+
     u32 numAllocatedIndices() const
     {
         OffsetAllocator::StorageReport report = m_indexAllocator.storageReport();
@@ -134,14 +157,38 @@ public:
         return MaxLoadedHairVertices - report.totalFreeSpace;
     }
 
+    u32 numAllocatedMeshlets() const
+    {
+        OffsetAllocator::StorageReport report = m_meshletAllocator.storageReport();
+        return MaxLoadedMeshlets - report.totalFreeSpace;
+    }
+
+    u32 numAllocatedMeshletVertexIndirections() const
+    {
+        OffsetAllocator::StorageReport report = m_meshletVertexIndirectionAllocator.storageReport();
+        return MaxLoadedVertices - report.totalFreeSpace;
+    }
+
+    u32 numAllocatedMeshletIndices() const
+    {
+        OffsetAllocator::StorageReport report = m_meshletIndexAllocator.storageReport();
+        return MaxLoadedIndices - report.totalFreeSpace;
+    }
+
 private:
     Backend* m_backend { nullptr };
     GpuScene* m_scene { nullptr };
 
     VertexLayout const m_positionOnlyVertexLayout { VertexComponent::Position3F };
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+    VertexLayout const m_nonPositionVertexLayout { VertexComponent::TexCoord2H,
+                                                   VertexComponent::NormalOct2S16,
+                                                   VertexComponent::TangentOct2S16 };
+#else
     VertexLayout const m_nonPositionVertexLayout { VertexComponent::TexCoord2F,
                                                    VertexComponent::Normal3F,
                                                    VertexComponent::Tangent4F };
+#endif
     VertexLayout const m_skinningDataVertexLayout { VertexComponent::JointIdx4U32,
                                                     VertexComponent::JointWeight4F };
     VertexLayout const m_velocityDataVertexLayout { VertexComponent::Velocity3F };
@@ -172,14 +219,58 @@ private:
     OffsetAllocator::Allocator m_hairVertexAllocator { MaxLoadedHairVertices };
 
     std::unique_ptr<Buffer> m_meshletVertexIndirectionBuffer {};
-    u32 m_nextFreeMeshletIndirIndex { 0 };
+    OffsetAllocator::Allocator m_meshletVertexIndirectionAllocator { MaxLoadedVertices };
 
     std::unique_ptr<Buffer> m_meshletIndexBuffer {};
-    u32 m_nextFreeMeshletIndexBufferIndex { 0 };
+    OffsetAllocator::Allocator m_meshletIndexAllocator { MaxLoadedIndices };
 
     std::vector<ShaderMeshlet> m_meshlets {};
     std::unique_ptr<Buffer> m_meshletBuffer {};
-    u32 m_nextFreeMeshletIndex { 0 };
+    OffsetAllocator::Allocator m_meshletAllocator { MaxLoadedMeshlets };
+
+    // All buffers which are sub-allocated by the same allocator make up a pool. The allocators always cover the max capacity
+    // of the pool, while the buffers only cover the capacity needed so far, see `growBuffersIfNeeded()`.
+    enum class GeometryPool {
+        Index = 0,
+        Vertex,
+        SkinningVertex,
+        VelocityVertex,
+        MorphTargetVertex,
+        HairVertex,
+        Meshlet,
+        MeshletVertexIndirection,
+        MeshletIndex,
+    };
+
+    static constexpr size_t GeometryPoolCount = static_cast<size_t>(GeometryPool::MeshletIndex) + 1;
+
+    static char const* geometryPoolName(GeometryPool);
+    static size_t geometryPoolMaxCapacity(GeometryPool);
+
+    OffsetAllocator::Allocator& poolAllocator(GeometryPool);
+    OffsetAllocator::Allocator const& poolAllocator(GeometryPool) const;
+    std::vector<Buffer*> poolBuffers(GeometryPool) const;
+    size_t poolCapacity(GeometryPool) const;
+    float poolFragmentation(GeometryPool) const;
+
+    // Allocations which end past the current capacity of the pool are not returned, but will make the pool grow before the next frame
+    OffsetAllocator::Allocation allocateFromPool(GeometryPool, u32 count);
+    void freeToPool(GeometryPool, OffsetAllocator::Allocation);
+    void freeAllocations(VertexAllocation::Internal&);
+
+    std::array<size_t, GeometryPoolCount> m_requiredPoolCapacity {};
+
+    // Allocations which have been relocated away from but which may still be referenced by frames in flight
+    struct RetiredAllocation {
+        GeometryPool pool;
+        OffsetAllocator::Allocation allocation;
+        u32 remainingFrames;
+    };
+
+    std::vector<RetiredAllocation> m_retiredAllocations {};
+
+    u32 m_numRelocatedSegments { 0 };
+    size_t m_numRelocatedBytes { 0 };
 
     // TODO: Remove me / rewrite for streaming
     void uploadMeshDataForAllocation(MeshSegmentAsset const&, VertexAllocation const&);
@@ -265,6 +356,8 @@ private:
     bool streamVertexData(StreamingMesh&, StaticMeshSegment const&, UploadBuffer&);
     bool streamMorphTargetData(StreamingMesh&, StaticMeshSegment const&, UploadBuffer&);
     bool streamIndexData(StreamingMesh&, StaticMeshSegment const&, UploadBuffer&);
-    std::optional<MeshletView> streamMeshletDataForSegment(StreamingMesh& streamingMesh, StaticMeshSegment const&, UploadBuffer&);
+    std::optional<MeshletView> streamMeshletDataForSegment(StreamingMesh& streamingMesh, StaticMeshSegment&, UploadBuffer&);
+    size_t relocateVertexData(StaticMeshSegment&, std::vector<BufferCopyOperation>&, UploadBuffer&);
+    size_t relocateIndexData(StaticMeshSegment&, std::vector<BufferCopyOperation>&);
     std::unique_ptr<BottomLevelAS> createBottomLevelAccelerationStructure(VertexAllocation const&);
 };
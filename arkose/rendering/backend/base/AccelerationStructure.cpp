@@ -1,6 +1,7 @@
 #include "AccelerationStructure.h"
 
 #include "rendering/backend/util/UploadBuffer.h"
+#include <atomic>
 
 RTGeometry::RTGeometry(RTTriangleGeometry triangles)
     : m_internal(triangles)
@@ -36,6 +37,13 @@ BottomLevelAS::BottomLevelAS(Backend& backend, std::vector<RTGeometry> geometrie
     : Resource(backend)
     , m_geometries(geometries)
 {
+    assignNewAddressStamp();
+}
+
+void BottomLevelAS::assignNewAddressStamp()
+{
+    static std::atomic<uint64_t> s_nextAddressStamp { 1 };
+    m_addressStamp = s_nextAddressStamp.fetch_add(1, std::memory_order_relaxed);
 }
 
 const std::vector<RTGeometry>& BottomLevelAS::geometries() const
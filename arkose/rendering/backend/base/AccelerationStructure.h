@@ -3,6 +3,7 @@
 #include "rendering/backend/base/Buffer.h"
 #include "rendering/backend/util/IndexType.h"
 #include <ark/matrix.h>
+#include <span>
 #include <variant>
 #include <vector>
 
@@ -66,11 +67,19 @@ public:
 
     size_t sizeInMemory() { return m_sizeInMemory; }
 
+    // Unique stamp for the memory this acceleration structure currently lives in. A new stamp is assigned whenever it's
+    // moved (e.g. when compacted), which means any top level acceleration structure instances referencing it must be
+    // updated and the TLAS rebuilt. No two acceleration structures ever share a stamp, even if one reuses the other's address.
+    uint64_t addressStamp() const { return m_addressStamp; }
+
 protected:
+    void assignNewAddressStamp();
+
     size_t m_sizeInMemory { SIZE_MAX };
 
 private:
     std::vector<RTGeometry> m_geometries {};
+    uint64_t m_addressStamp { 0 };
 };
 
 struct RTGeometryInstance {
@@ -90,6 +99,10 @@ public:
 
     virtual void updateInstanceDataWithUploadBuffer(const std::vector<RTGeometryInstance>&, UploadBuffer&) = 0;
 
+    // Update only the instances in the range [firstInstanceIdx, firstInstanceIdx + instances.size()), keeping all other instance data as-is
+    virtual void updateInstanceDataRangeWithUploadBuffer(uint32_t firstInstanceIdx, std::span<const RTGeometryInstance>, UploadBuffer&) = 0;
+    void setInstanceCount(uint32_t instanceCount) { updateCurrentInstanceCount(instanceCount); }
+
     [[nodiscard]] uint32_t instanceCount() const { return m_instanceCount; }
     [[nodiscard]] uint32_t maxInstanceCount() const { return m_maxInstanceCount; }
 
@@ -81,6 +81,10 @@ public:
     virtual void newFrame() = 0;
     virtual bool executeFrame(RenderPipeline&, float elapsedTime, float deltaTime) = 0;
 
+    // The number of frames that can be in flight on the GPU at once. When recording frame N, all frames
+    // up to and including frame N - inFlightFrameCount() are guaranteed to have completed on the GPU.
+    virtual u32 inFlightFrameCount() const = 0;
+
     virtual std::optional<SubmitStatus> submitRenderPipeline(RenderPipeline&, Registry&, UploadBuffer&, char const* debugName = nullptr) = 0;
     virtual bool pollSubmissionStatus(SubmitStatus&) const = 0;
     virtual bool waitForSubmissionCompletion(SubmitStatus&, u64 timeout) const = 0;
@@ -107,6 +111,15 @@ public:
     virtual std::unique_ptr<ComputeState> createComputeState(Shader const&, StateBindings const&) = 0;
     virtual std::unique_ptr<ExternalFeature> createExternalFeature(ExternalFeatureType, void* externalFeatureParameters) = 0;
 
+    struct TextureMemoryPlacement {
+        Texture* texture { nullptr };
+        size_t offset { 0 };
+    };
+
+    // Place the textures at the given offsets in a single block of memory of the given size, shared between all of them. Returns
+    // false if the backend can't alias the memory of these textures, in which case they are left unchanged with their own memory.
+    virtual bool placeTexturesInAliasedMemory(std::vector<TextureMemoryPlacement> const&, size_t memorySize) { return false; }
+
 protected:
     Badge<Backend> badge() const { return {}; }
 
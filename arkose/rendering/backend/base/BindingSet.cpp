@@ -41,6 +41,7 @@ ShaderBinding ShaderBinding::storageBufferReadonly(Buffer const& buffer, ShaderS
     ARKOSE_ASSERT(buffer.storageCapable());
 
     binding.m_buffers.push_back(const_cast<Buffer*>(&buffer));
+    binding.m_storageBufferReadonly = true;
 
     return binding;
 }
@@ -26,7 +26,7 @@ public:
 
     static ShaderBinding constantBuffer(Buffer const&, ShaderStage = ShaderStage::Any);
     static ShaderBinding storageBuffer(Buffer&, ShaderStage = ShaderStage::Any);
-    static ShaderBinding storageBufferReadonly(Buffer const&, ShaderStage = ShaderStage::Any); // NOTE: The readonly property is not guaranteed by this function!
+    static ShaderBinding storageBufferReadonly(Buffer const&, ShaderStage = ShaderStage::Any); // NOTE: The readonly property is not enforced by this function, but barriers are inferred assuming it holds!
     static ShaderBinding storageBufferBindlessArray(const std::vector<Buffer*>&, ShaderStage = ShaderStage::Any);
 
     static ShaderBinding sampledTexture(Texture const&, ShaderStage = ShaderStage::Any);
@@ -45,6 +45,9 @@ public:
 
     ShaderStage shaderStage() const { return m_shaderStage; }
 
+    // Only a hint, see storageBufferReadonly(..)
+    bool storageBufferIsReadonly() const { return m_storageBufferReadonly; }
+
     uint32_t bindingIndex() const { return m_bindingIndex; }
     void updateBindingIndex(Badge<class BindingSet>, uint32_t index) { m_bindingIndex = index; }
 
@@ -105,6 +108,7 @@ private:
     ShaderStage m_shaderStage;
 
     uint32_t m_arrayCount { 1 };
+    bool m_storageBufferReadonly { false };
 
     std::vector<Buffer*> m_buffers {};
     std::vector<Texture const*> m_sampledTextures {};
@@ -125,6 +129,9 @@ public:
 
     virtual void updateTextures(uint32_t index, const std::vector<TextureBindingUpdate>&) = 0;
 
+    // Rewrite all bindings, e.g. after the memory of some of the bound textures has been replaced
+    virtual void updateBindings() = 0;
+
     const std::vector<ShaderBinding>& shaderBindings() const { return m_shaderBindings; }
 
 private:
@@ -42,6 +42,13 @@ public:
 
     virtual void updateData(const std::byte* data, size_t size, size_t offset = 0) = 0;
 
+    // Pointer to the persistently mapped memory of the buffer, or nullptr if it's not mapped. Upload & readback buffers are always mappable.
+    // Any writes through this pointer must be flushed with `flushMappedData(..)` before they are read on the GPU, and any GPU writes
+    // must be invalidated with `invalidateMappedData(..)` before they are read through this pointer.
+    virtual std::byte* persistentlyMappedData() { return nullptr; }
+    virtual void flushMappedData(size_t size, size_t offset) { }
+    virtual void invalidateMappedData(size_t size, size_t offset) { }
+
     template<typename T>
     void updateData(const T* data, size_t size, size_t offset = 0)
     {
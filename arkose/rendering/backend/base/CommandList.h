@@ -39,6 +39,12 @@ public:
     template<typename T>
     void setNamedUniform(const std::string& name, T);
 
+    // Same as above, but for a constant resolved ahead of time, which avoids the lookup by name (see NamedConstantHandle)
+    virtual void setNamedUniform(NamedConstantHandle, void const*, size_t size) = 0;
+
+    template<typename T>
+    void setNamedUniform(NamedConstantHandle, T);
+
     virtual void draw(u32 vertexCount, u32 firstVertex = 0) = 0;
     virtual void drawIndexed(u32 indexCount, u32 instanceIndex = 0) = 0;
     virtual void drawIndirect(const Buffer& indirectBuffer, const Buffer& countBuffer) = 0;
@@ -74,6 +80,9 @@ public:
     virtual void textureMipWriteBarrier(const Texture&, uint32_t mip) = 0;
     virtual void bufferWriteBarrier(std::vector<Buffer const*>) = 0;
 
+    //! Before the first use of a transient texture in a frame, as other textures may have used its memory since. Discards its contents.
+    virtual void textureAliasingBarrier(const Texture&) = 0;
+
     virtual void slowBlockingReadFromBuffer(const Buffer&, size_t offset, size_t size, void* dst) = 0;
 };
 
@@ -95,6 +104,19 @@ inline void CommandList::setNamedUniform(const std::string& name, bool value)
     setNamedUniform(name, &intValue, sizeof(uint32_t));
 }
 
+template<typename T>
+inline void CommandList::setNamedUniform(NamedConstantHandle constantHandle, T value)
+{
+    setNamedUniform(constantHandle, &value, sizeof(T));
+}
+
+template<>
+inline void CommandList::setNamedUniform(NamedConstantHandle constantHandle, bool value)
+{
+    uint32_t intValue = (value) ? 1 : 0;
+    setNamedUniform(constantHandle, &intValue, sizeof(uint32_t));
+}
+
 inline void CommandList::dispatch(Extent3D globalSize, Extent3D localSize)
 {
     u32 x = (globalSize.width() + localSize.width() - 1) / localSize.width();
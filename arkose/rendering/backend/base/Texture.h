@@ -208,6 +208,12 @@ public:
     }
 
     size_t sizeInMemory() { return m_sizeInMemory; }
+    size_t memoryAlignment() const { return m_memoryAlignment; }
+
+    // Transient textures only hold data while used within a frame, so they can share memory with other transient
+    // textures that are not in use at the same time (see Registry::createTransientTexture2D)
+    void setTransient(Badge<Registry>, bool transient) { m_transient = transient; }
+    bool isTransient() const { return m_transient; }
 
     // For passing this texture to "Dear ImGui" for rendering
     virtual ImTextureID asImTextureID() = 0;
@@ -215,9 +221,11 @@ public:
 protected:
     Description& mutableDescription() { return m_description; }
     size_t m_sizeInMemory { SIZE_MAX };
+    size_t m_memoryAlignment { 1 };
 
 private:
     Description m_description;
+    bool m_transient { false };
 };
 
 // Used for storage textures when referencing a specific MIP of the texture 
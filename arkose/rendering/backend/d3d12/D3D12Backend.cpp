@@ -384,6 +384,10 @@ bool D3D12Backend::executeFrame(RenderPipeline& renderPipeline, float elapsedTim
                 cmdList.beginDebugLabel(nodeName);
                 //vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frameContext.timestampQueryPool, nodeStartTimestampIdx);
 
+                for (Texture* transientTexture : registry.transientTexturesFirstUsedInNode(nodeName)) {
+                    cmdList.textureAliasingBarrier(*transientTexture);
+                }
+
                 nodeExecuteCallback(appState, cmdList, uploadBuffer);
                 //cmdList.endNode({}); // ??
 
@@ -38,6 +38,7 @@ public:
     void waitForFrameReady() override;
     void newFrame() override;
     bool executeFrame(RenderPipeline&, float elapsedTime, float deltaTime) override;
+    u32 inFlightFrameCount() const override { return QueueSlotCount; }
 
     std::optional<SubmitStatus> submitRenderPipeline(RenderPipeline&, Registry&, UploadBuffer&, char const* debugName) override;
     bool pollSubmissionStatus(SubmitStatus&) const override;
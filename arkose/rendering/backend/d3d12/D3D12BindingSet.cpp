@@ -221,6 +221,15 @@ void D3D12BindingSet::updateTextures(uint32_t bindingIndex, const std::vector<Te
     // TODO
 }
 
+void D3D12BindingSet::updateBindings()
+{
+    SCOPED_PROFILE_ZONE_GPURESOURCE();
+
+    // Bindings only have to be updated after transient textures are placed in aliased memory, which the D3D12 backend doesn't
+    // support yet (see Backend::placeTexturesInAliasedMemory), so this should never be called. Implement it along with that.
+    NOT_YET_IMPLEMENTED();
+}
+
 D3D12_SHADER_VISIBILITY D3D12BindingSet::shaderVisibilityFromShaderStage(ShaderStage shaderStage) const
 {
     switch (shaderStage) {
@@ -12,6 +12,7 @@ public:
 
     virtual void setName(const std::string& name) override;
     virtual void updateTextures(uint32_t index, const std::vector<TextureBindingUpdate>&) override;
+    virtual void updateBindings() override;
 
     D3D12_SHADER_VISIBILITY shaderVisibilityFromShaderStage(ShaderStage) const;
 
@@ -3,6 +3,7 @@
 #include "rendering/backend/d3d12/D3D12Backend.h"
 #include "core/Logging.h"
 #include "utility/Profiling.h"
+#include <cstring>
 #include <d3dx12/d3dx12.h>
 
 D3D12Buffer::D3D12Buffer(Backend& backend, size_t size, Usage usage)
@@ -10,13 +11,18 @@ D3D12Buffer::D3D12Buffer(Backend& backend, size_t size, Usage usage)
 {
     SCOPED_PROFILE_ZONE_GPURESOURCE();
 
-    auto& d3d12Backend = static_cast<D3D12Backend&>(backend);
+    createInternal();
+}
+
+void D3D12Buffer::createInternal()
+{
+    auto& d3d12Backend = static_cast<D3D12Backend&>(backend());
     
     D3D12_RESOURCE_STATES initialResourceState = D3D12_RESOURCE_STATE_COMMON;
     
     D3D12MA::ALLOCATION_DESC allocDescription = {};
 
-    switch (usage) {
+    switch (usage()) {
     case Buffer::Usage::Vertex:
     case Buffer::Usage::Index:
     case Buffer::Usage::RTInstanceBuffer:
@@ -51,7 +57,7 @@ D3D12Buffer::D3D12Buffer(Backend& backend, size_t size, Usage usage)
         resourceFlags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
     }
 
-    if (usage == Buffer::Usage::ConstantBuffer) {
+    if (usage() == Buffer::Usage::ConstantBuffer) {
         // D3D12 ERROR: ID3D12Device::CreateConstantBufferView: Size of <...> is invalid. Device requires SizeInBytes be a multiple of 256. [ STATE_CREATION ERROR #650: CREATE_CONSTANT_BUFFER_VIEW_INVALID_DESC]
         constexpr size_t BufferMinimumAlignment = 256;
         m_sizeInMemory = ark::divideAndRoundUp<size_t>(m_size, BufferMinimumAlignment) * BufferMinimumAlignment;
@@ -175,9 +181,92 @@ void D3D12Buffer::updateData(const std::byte* data, size_t updateSize, size_t of
     }
 }
 
+std::byte* D3D12Buffer::persistentlyMappedData()
+{
+    if (usage() != Buffer::Usage::Upload && usage() != Buffer::Usage::Readback) {
+        return nullptr;
+    }
+
+    // Upload & readback heap resources may stay mapped for their entire lifetime, and the memory is always coherent so there's no
+    // need to flush or invalidate. Upload memory is never read on the CPU, while any part of readback memory may be.
+    if (m_persistentlyMappedData == nullptr) {
+        D3D12_RANGE emptyReadRange { .Begin = 0, .End = 0 };
+        D3D12_RANGE const* readRange = usage() == Buffer::Usage::Readback ? nullptr : &emptyReadRange;
+
+        void* mappedMemory;
+        if (HRESULT hr = bufferResource->Map(0, readRange, &mappedMemory); FAILED(hr)) {
+            ARKOSE_LOG(Error, "Failed to persistently map buffer resource.");
+            return nullptr;
+        }
+
+        m_persistentlyMappedData = reinterpret_cast<std::byte*>(mappedMemory);
+    }
+
+    return m_persistentlyMappedData;
+}
+
 void D3D12Buffer::reallocateWithSize(size_t newSize, ReallocateStrategy strategy)
 {
     SCOPED_PROFILE_ZONE_GPURESOURCE();
-    
-    ASSERT_NOT_REACHED();
+
+    if (strategy == ReallocateStrategy::CopyExistingData && newSize < size()) {
+        ARKOSE_LOG(Fatal, "Can't reallocate buffer ReallocateStrategy::CopyExistingData if the new size is smaller than the current size!");
+    }
+
+    // The persistent mapping points into the old resource, so drop it and let it be mapped again on demand
+    if (m_persistentlyMappedData != nullptr) {
+        bufferResource->Unmap(0, nullptr);
+        m_persistentlyMappedData = nullptr;
+    }
+
+    // NOTE: The old resource is kept alive until the end of this function, so we can copy from it
+    ComPtr<D3D12MA::Allocation> oldAllocation = std::move(bufferAllocation);
+    ComPtr<ID3D12Resource> oldResource = std::move(bufferResource);
+    D3D12_RESOURCE_STATES oldResourceState = resourceState;
+    size_t oldSize = m_size;
+
+    m_size = newSize;
+    createInternal();
+
+    if (strategy == ReallocateStrategy::CopyExistingData && oldSize > 0) {
+        switch (usage()) {
+        case Buffer::Usage::Upload:
+        case Buffer::Usage::Readback: {
+            // Upload & readback heap resources can't change resource state, but they are CPU visible so copy through mappings
+            D3D12_RANGE emptyRange { .Begin = 0, .End = 0 };
+            D3D12_RANGE writtenRange { .Begin = 0, .End = oldSize };
+
+            void* oldData;
+            void* newData;
+            if (FAILED(oldResource->Map(0, nullptr, &oldData)) || FAILED(bufferResource->Map(0, &emptyRange, &newData))) {
+                ARKOSE_LOG(Fatal, "D3D12Buffer: could not map buffer resources to copy over existing data, exiting.");
+            }
+
+            std::memcpy(newData, oldData, oldSize);
+
+            bufferResource->Unmap(0, &writtenRange);
+            oldResource->Unmap(0, &emptyRange);
+        } break;
+        default: {
+            // NOTE: The one-off command waits for the queue to finish the copy and all work submitted before it, so after this
+            // returns there is no pending work left referring to the old resource, and it can be released.
+            auto& d3d12Backend = static_cast<D3D12Backend&>(backend());
+            d3d12Backend.issueOneOffCommand([&](ID3D12GraphicsCommandList& cmdList) {
+                if (oldResourceState != D3D12_RESOURCE_STATE_COPY_SOURCE) {
+                    auto transitionBeforeCopy = CD3DX12_RESOURCE_BARRIER::Transition(oldResource.Get(), oldResourceState, D3D12_RESOURCE_STATE_COPY_SOURCE);
+                    cmdList.ResourceBarrier(1, &transitionBeforeCopy);
+                }
+
+                // The new resource is in the common state, from which buffers are implicitly promoted to copy destination (and
+                // decay back to common once the command list has executed)
+                cmdList.CopyBufferRegion(bufferResource.Get(), 0, oldResource.Get(), 0, oldSize);
+            });
+        } break;
+        }
+    }
+
+    // Re-set GPU buffer name for the new resource
+    if (!name().empty()) {
+        setName(name());
+    }
 }
@@ -15,9 +15,17 @@ public:
     bool mapData(MapMode, size_t size, size_t offset, std::function<void(std::byte*)>&& mapCallback) override;
 
     void updateData(const std::byte* data, size_t size, size_t offset) override;
+
+    std::byte* persistentlyMappedData() override;
     void reallocateWithSize(size_t newSize, ReallocateStrategy) override;
 
     ComPtr<D3D12MA::Allocation> bufferAllocation;
     ComPtr<ID3D12Resource> bufferResource;
     mutable D3D12_RESOURCE_STATES resourceState;
+
+private:
+    // (Re)create the resource for the current size of the buffer
+    void createInternal();
+
+    std::byte* m_persistentlyMappedData { nullptr };
 };
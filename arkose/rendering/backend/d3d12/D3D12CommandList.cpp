@@ -372,6 +372,30 @@ void D3D12CommandList::setNamedUniform(const std::string& name, void const* data
     }
 }
 
+void D3D12CommandList::setNamedUniform(NamedConstantHandle constantHandle, void const* data, size_t size)
+{
+    SCOPED_PROFILE_ZONE_GPUCOMMAND();
+
+    // We always use CBV 0 for named constants
+    constexpr UINT rootParameterIndex = 0;
+
+    ARKOSE_ASSERT(constantHandle.valid());
+    ARKOSE_ASSERT(constantHandle.size == size);
+
+    ARKOSE_ASSERT(size % sizeof(u32) == 0);
+    UINT num32bitConstants = narrow_cast<UINT>(size / sizeof(UINT));
+
+    UINT offset = static_cast<UINT>(constantHandle.offset);
+
+    if (m_activeRenderState) {
+        m_commandList->SetGraphicsRoot32BitConstants(rootParameterIndex, num32bitConstants, data, offset);
+    } else if (m_activeComputeState) {
+        m_commandList->SetComputeRoot32BitConstants(rootParameterIndex, num32bitConstants, data, offset);
+    } else {
+        NOT_YET_IMPLEMENTED();
+    }
+}
+
 void D3D12CommandList::draw(u32 vertexCount, u32 firstVertex)
 {
     SCOPED_PROFILE_ZONE_GPUCOMMAND();
@@ -670,6 +694,20 @@ void D3D12CommandList::bufferWriteBarrier(std::vector<Buffer const*> buffers)
     }
 }
 
+void D3D12CommandList::textureAliasingBarrier(Texture const& texture)
+{
+    SCOPED_PROFILE_ZONE_GPUCOMMAND();
+
+    auto const& d3d12Texture = static_cast<D3D12Texture const&>(texture);
+
+    D3D12_RESOURCE_BARRIER resourceBarrier {};
+    resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    resourceBarrier.Aliasing.pResourceBefore = nullptr;
+    resourceBarrier.Aliasing.pResourceAfter = d3d12Texture.textureResource.Get();
+    m_commandList->ResourceBarrier(1, &resourceBarrier);
+}
+
 D3D12_RESOURCE_BARRIER D3D12CommandList::createResourceTransitionBarrier(D3D12Buffer const& d3d12Buffer, D3D12_RESOURCE_STATES targetResourceState) const
 {
     ARKOSE_ASSERT(d3d12Buffer.resourceState != targetResourceState);
@@ -38,6 +38,7 @@ public:
     void bindTextureSet(BindingSet&, u32 index) override;
 
     void setNamedUniform(const std::string& name, void const* data, size_t size) override;
+    void setNamedUniform(NamedConstantHandle, void const* data, size_t size) override;
 
     void draw(u32 vertexCount, u32 firstVertex) override;
     void drawIndexed(u32 indexCount, u32 instanceIndex) override;
@@ -69,6 +70,7 @@ public:
     void textureWriteBarrier(Texture const&) override;
     void textureMipWriteBarrier(Texture const&, u32 mip) override;
     void bufferWriteBarrier(std::vector<Buffer const*>) override;
+    void textureAliasingBarrier(Texture const&) override;
 
     void slowBlockingReadFromBuffer(const Buffer&, size_t offset, size_t size, void* dst) override;
 
@@ -77,6 +77,18 @@ D3D12RenderState::D3D12RenderState(Backend& backend, RenderTarget const& renderT
                 inputElementDesc.SemanticName = "COLOR";
                 inputElementDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
                 break;
+            case VertexComponent::TexCoord2H:
+                inputElementDesc.SemanticName = "TEXCOORD";
+                inputElementDesc.Format = DXGI_FORMAT_R16G16_FLOAT;
+                break;
+            case VertexComponent::NormalOct2S16:
+                inputElementDesc.SemanticName = "NORMAL";
+                inputElementDesc.Format = DXGI_FORMAT_R16G16_SNORM;
+                break;
+            case VertexComponent::TangentOct2S16:
+                inputElementDesc.SemanticName = "TANGENT";
+                inputElementDesc.Format = DXGI_FORMAT_R16G16_SNORM;
+                break;
             }
 
             // NOTE: If we're getting HLSL source transpiled from GLSL all input attributes will have
@@ -11,3 +11,13 @@ struct NamedConstant {
     u32 offset { 0 };
     ShaderStage stages {};
 };
+
+// A named constant resolved ahead of time (see NamedConstantLookup::resolveConstant), so that it can be set without looking
+// it up by name. Only valid for states with the same named constants as the state it was resolved from.
+struct NamedConstantHandle {
+    u32 offset { 0 };
+    u32 size { 0 };
+    ShaderStage stages {};
+
+    bool valid() const { return size > 0; }
+};
@@ -32,6 +32,24 @@ std::optional<u32> NamedConstantLookup::lookupConstantOffset(std::string const&
     return constant->offset;
 }
 
+NamedConstantHandle NamedConstantLookup::resolveConstant(std::string const& constantName, size_t expectedSize) const
+{
+    NamedConstant const* constant = lookupConstant(constantName);
+    if (constant == nullptr) {
+        ARKOSE_LOG(Fatal, "NamedConstantLookup: failed to resolve constant with name '{}', exiting.", constantName);
+        return {};
+    }
+
+    if (!validateConstant(*constant, expectedSize)) {
+        ARKOSE_LOG(Fatal, "NamedConstantLookup: failed to resolve constant with name '{}' and size {}, exiting.", constantName, expectedSize);
+        return {};
+    }
+
+    return NamedConstantHandle { .offset = constant->offset,
+                                 .size = constant->size,
+                                 .stages = constant->stages };
+}
+
 bool NamedConstantLookup::validateConstant(NamedConstant const& constant, size_t expectedSize) const
 {
     if (constant.size != expectedSize) {
@@ -16,6 +16,13 @@ public:
 
     bool validateConstant(NamedConstant const&, size_t expectedSize) const;
 
+    // Resolve a constant once, e.g. when creating a state, so it can be set by handle when recording. Unlike the lookups
+    // above this is a fatal error if no constant with the name & expected size exists.
+    NamedConstantHandle resolveConstant(std::string const& constantName, size_t expectedSize) const;
+
+    template<typename T>
+    NamedConstantHandle resolveConstant(std::string const& constantName) const;
+
     bool empty() const { return m_lookupMap.empty(); }
     u32 totalOccupiedSize() const;
 
@@ -23,3 +30,16 @@ private:
     std::unordered_map<std::string, NamedConstant> m_lookupMap {};
     u32 m_totalOccupiedSize { 0 };
 };
+
+template<typename T>
+inline NamedConstantHandle NamedConstantLookup::resolveConstant(std::string const& constantName) const
+{
+    return resolveConstant(constantName, sizeof(T));
+}
+
+template<>
+inline NamedConstantHandle NamedConstantLookup::resolveConstant<bool>(std::string const& constantName) const
+{
+    // Bools are set as u32, see CommandList::setNamedUniform
+    return resolveConstant(constantName, sizeof(u32));
+}
@@ -0,0 +1,91 @@
+#include "ReadbackRing.h"
+
+#include "core/Logging.h"
+#include "rendering/backend/base/CommandList.h"
+#include "utility/Profiling.h"
+#include <ark/core.h>
+
+ReadbackRing::ReadbackRing(Backend& backend, size_t sizePerFrame)
+    : m_frameLatency(backend.inFlightFrameCount())
+{
+    // While the readbacks of one frame are being resolved on the CPU, the following frames may still be writing to theirs
+    m_frames.resize(m_frameLatency + 1);
+
+    for (Frame& frame : m_frames) {
+        frame.buffer = backend.createBuffer(sizePerFrame, Buffer::Usage::Readback);
+        frame.buffer->setName("ReadbackRing");
+
+        frame.mappedData = frame.buffer->persistentlyMappedData();
+        if (frame.mappedData == nullptr) {
+            ARKOSE_LOG(Fatal, "ReadbackRing: failed to persistently map the readback buffer, exiting.");
+        }
+    }
+}
+
+void ReadbackRing::newFrame(u32 frameIndex)
+{
+    SCOPED_PROFILE_ZONE();
+
+    if (m_currentFrame != nullptr && m_currentFrame->frameIndex == frameIndex) {
+        return;
+    }
+
+    for (Frame& frame : m_frames) {
+        if (frame.pendingReadbacks.size() > 0 && frameIndex >= frame.frameIndex + m_frameLatency) {
+            resolveFrame(frame);
+        }
+    }
+
+    m_currentFrame = &m_frames[frameIndex % m_frames.size()];
+
+    // The frame which last used this buffer is at least `m_frameLatency` frames old, so it must have been resolved above
+    ARKOSE_ASSERT(m_currentFrame->pendingReadbacks.empty());
+    m_currentFrame->frameIndex = frameIndex;
+    m_currentFrame->cursor = 0;
+}
+
+bool ReadbackRing::readback(CommandList& cmdList, Buffer& srcBuffer, size_t srcOffset, size_t size, Callback&& callback)
+{
+    SCOPED_PROFILE_ZONE();
+
+    ARKOSE_ASSERT(size > 0);
+    ARKOSE_ASSERT(srcOffset + size <= srcBuffer.size());
+
+    if (m_currentFrame == nullptr) {
+        ARKOSE_LOG(Fatal, "ReadbackRing: requesting a readback before the first call to newFrame(..), exiting.");
+    }
+
+    Frame& frame = *m_currentFrame;
+
+    size_t offset = ark::alignUp(frame.cursor, readbackAlignment());
+    if (offset + size > frame.buffer->size()) {
+        ARKOSE_LOG(Warning, "ReadbackRing: out of space for readbacks this frame ({} bytes requested), ignoring.", size);
+        return false;
+    }
+
+    BufferCopyOperation copyOperation {};
+    copyOperation.size = size;
+    copyOperation.srcBuffer = &srcBuffer;
+    copyOperation.srcOffset = srcOffset;
+    copyOperation.destination = BufferCopyOperation::BufferDestination { .buffer = frame.buffer.get(), .offset = offset };
+    cmdList.executeBufferCopyOperations({ copyOperation });
+
+    frame.pendingReadbacks.push_back(PendingReadback { .offset = offset,
+                                                       .size = size,
+                                                       .callback = std::move(callback) });
+    frame.cursor = offset + size;
+
+    return true;
+}
+
+void ReadbackRing::resolveFrame(Frame& frame)
+{
+    // Make the GPU writes of the whole frame visible to the CPU with a single invalidate
+    frame.buffer->invalidateMappedData(frame.cursor, 0);
+
+    for (PendingReadback& pendingReadback : frame.pendingReadbacks) {
+        pendingReadback.callback(frame.mappedData + pendingReadback.offset, pendingReadback.size);
+    }
+
+    frame.pendingReadbacks.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "rendering/backend/base/Backend.h"
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+class CommandList;
+
+// Ring of persistently mapped readback buffers, for reading back data from the GPU without stalling on it. There is one buffer
+// per frame of latency, and a readback requested while recording a frame has its callback called once that frame has completed
+// on the GPU, i.e., `Backend::inFlightFrameCount()` frames later. The size of each buffer is the readback budget for a frame.
+class ReadbackRing final {
+public:
+    ReadbackRing(Backend&, size_t sizePerFrame);
+
+    ReadbackRing(ReadbackRing&) = delete;
+    ReadbackRing& operator=(ReadbackRing&) = delete;
+
+    // The read back data is only valid for the duration of the callback
+    using Callback = std::function<void(std::byte const* data, size_t size)>;
+
+    // Call the callbacks of all readbacks of frames that have completed on the GPU. Must be called every frame that requests
+    // readbacks, before requesting any, and is also safe to call on other frames to not hold on to completed readbacks.
+    void newFrame(u32 frameIndex);
+
+    // Copy `size` bytes from the source buffer into readback memory, and call the callback once the data is available on the CPU.
+    // Returns false if there is no space left for this frame, in which case the callback will never be called.
+    bool readback(CommandList&, Buffer& srcBuffer, size_t srcOffset, size_t size, Callback&&);
+
+    template<typename T>
+    bool readback(CommandList& cmdList, Buffer& srcBuffer, size_t srcOffset, std::function<void(T const&)>&& callback)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read back from GPU memory");
+        return readback(cmdList, srcBuffer, srcOffset, sizeof(T), [callback = std::move(callback)](std::byte const* data, size_t size) {
+            T object;
+            std::memcpy(&object, data, sizeof(T));
+            callback(object);
+        });
+    }
+
+    // Alignment of each readback within the frame's buffer, which makes it safe to read back any type
+    size_t readbackAlignment() const { return 16; }
+
+private:
+
+    struct PendingReadback {
+        size_t offset { 0 };
+        size_t size { 0 };
+        Callback callback {};
+    };
+
+    struct Frame {
+        std::unique_ptr<Buffer> buffer {};
+        std::byte* mappedData { nullptr };
+        size_t cursor { 0 };
+
+        u32 frameIndex { 0 };
+        std::vector<PendingReadback> pendingReadbacks {};
+    };
+
+    void resolveFrame(Frame&);
+
+    std::vector<Frame> m_frames {};
+    Frame* m_currentFrame { nullptr };
+
+    u32 m_frameLatency { 0 };
+};
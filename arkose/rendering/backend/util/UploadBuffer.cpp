@@ -1,15 +1,26 @@
 #include "UploadBuffer.h"
 
 #include "core/Logging.h"
+#include <ark/conversion.h>
+#include <cstring>
 
 UploadBuffer::UploadBuffer(Backend& backend, size_t size)
+    : m_backend(backend)
 {
-    // TODO: Maybe create a persistent mapping for this buffer? Makes sense considering its use.
-    m_buffer = backend.createBuffer(size, Buffer::Usage::Upload);
+    m_mainPage = createPage(size);
+    if (m_mainPage.mappedData == nullptr) {
+        ARKOSE_LOG(Fatal, "UploadBuffer: failed to persistently map the upload buffer, exiting.");
+    }
 }
 
 std::vector<BufferCopyOperation> UploadBuffer::popPendingOperations()
 {
+    // Make sure all written data is visible to the GPU before the copies are executed
+    flushPage(m_mainPage);
+    for (size_t pageIdx = 0; pageIdx < m_numUsedSpillPages; ++pageIdx) {
+        flushPage(m_spillPages[pageIdx]);
+    }
+
     auto pending = std::move(m_pendingOperations);
     m_pendingOperations.clear();
     return pending;
@@ -27,22 +38,65 @@ size_t UploadBuffer::alignedRemainingSize(size_t numUploads) const
 
 void UploadBuffer::reset()
 {
-    m_cursor = 0;
+    m_mainPage.cursor = 0;
+    m_mainPage.flushedCursor = 0;
+
+    // Keep the spill pages which were used since the last reset, as it's likely they will be needed again, but release the rest
+    m_spillPages.resize(m_numUsedSpillPages);
+    for (Page& spillPage : m_spillPages) {
+        spillPage.cursor = 0;
+        spillPage.flushedCursor = 0;
+    }
+    m_numUsedSpillPages = 0;
+
     if (m_pendingOperations.size() > 0)
         ARKOSE_LOG(Fatal, "UploadBuffer: resetting although not all pending operations have been executed, exiting.");
 }
 
 bool UploadBuffer::upload(const void* data, size_t size, Buffer& dstBuffer, size_t dstOffset)
 {
-    return upload(data, size, BufferCopyOperation::BufferDestination { .buffer = &dstBuffer, .offset = dstOffset });
+    std::byte* memory = allocate(size, 1, BufferCopyOperation::BufferDestination { .buffer = &dstBuffer, .offset = dstOffset });
+    if (memory == nullptr) {
+        return false;
+    }
+
+    std::memcpy(memory, data, size);
+    return true;
 }
 
 bool UploadBuffer::upload(const void* data, size_t size, Texture& dstTexture, size_t dstTextureMip, size_t dstTextureArrayLayer)
 {
-    return upload(data, size, BufferCopyOperation::TextureDestination { .texture = &dstTexture, .textureMip = dstTextureMip, .textureArrayLayer = dstTextureArrayLayer });
+    std::byte* memory = allocate(size, 1, BufferCopyOperation::TextureDestination { .texture = &dstTexture, .textureMip = dstTextureMip, .textureArrayLayer = dstTextureArrayLayer });
+    if (memory == nullptr) {
+        return false;
+    }
+
+    std::memcpy(memory, data, size);
+    return true;
 }
 
-bool UploadBuffer::upload(const void* data, size_t size, std::variant<BufferCopyOperation::BufferDestination, BufferCopyOperation::TextureDestination>&& destination)
+std::byte* UploadBuffer::allocateUpload(size_t size, size_t alignment, Buffer& dstBuffer, size_t dstOffset)
+{
+    return allocate(size, alignment, BufferCopyOperation::BufferDestination { .buffer = &dstBuffer, .offset = dstOffset });
+}
+
+UploadBuffer::Page UploadBuffer::createPage(size_t size)
+{
+    Page page {};
+    page.buffer = m_backend.createBuffer(size, Buffer::Usage::Upload);
+    page.mappedData = page.buffer->persistentlyMappedData();
+    return page;
+}
+
+void UploadBuffer::flushPage(Page& page)
+{
+    if (page.cursor > page.flushedCursor) {
+        page.buffer->flushMappedData(page.cursor - page.flushedCursor, page.flushedCursor);
+        page.flushedCursor = page.cursor;
+    }
+}
+
+std::byte* UploadBuffer::allocate(size_t size, size_t alignment, CopyDestination&& destination)
 {
     if (std::holds_alternative<BufferCopyOperation::BufferDestination>(destination)) {
         auto const& bufferCopyDestination = std::get<BufferCopyOperation::BufferDestination>(destination);
@@ -56,27 +110,101 @@ bool UploadBuffer::upload(const void* data, size_t size, std::variant<BufferCopy
         }
     }
 
-    size_t alignedCursor = ark::alignUp(m_cursor, uploadAlignment());
-    size_t requiredSize = alignedCursor + size;
-    if (requiredSize > m_buffer->size()) {
-        size_t missingBytes = requiredSize - m_buffer->size();
-        ARKOSE_LOG(Error, "UploadBuffer: not enough space for all requested uploads. Missing {} bytes.", missingBytes);
-        return false;
+    if (std::byte* memory = tryAppendToLastOperation(size, alignment, destination)) {
+        return memory;
     }
 
-    m_cursor = alignedCursor;
+    if (std::byte* memory = allocateInPage(m_mainPage, size, alignment, destination)) {
+        return memory;
+    }
+
+    // Out of space in the main page, so spill into the current spill page, or one kept from earlier frames, or a new one
+    if (m_numUsedSpillPages > 0) {
+        if (std::byte* memory = allocateInPage(m_spillPages[m_numUsedSpillPages - 1], size, alignment, destination)) {
+            return memory;
+        }
+    }
+
+    while (m_numUsedSpillPages < m_spillPages.size()) {
+        Page& spillPage = m_spillPages[m_numUsedSpillPages++];
+        if (std::byte* memory = allocateInPage(spillPage, size, alignment, destination)) {
+            return memory;
+        }
+    }
+
+    size_t spillPageSize = std::max(MinSpillPageSize, size);
+    ARKOSE_LOG(Warning, "UploadBuffer: not enough space for all requested uploads, spilling into an additional {:.1f} MB page.",
+               ark::conversion::to::MB(spillPageSize));
+
+    Page spillPage = createPage(spillPageSize);
+    if (spillPage.mappedData == nullptr) {
+        ARKOSE_LOG(Error, "UploadBuffer: failed to create spill page, dropping upload of {} bytes.", size);
+        return nullptr;
+    }
+
+    m_spillPages.push_back(std::move(spillPage));
+    m_numUsedSpillPages = m_spillPages.size();
+
+    return allocateInPage(m_spillPages.back(), size, alignment, destination);
+}
+
+std::byte* UploadBuffer::allocateInPage(Page& page, size_t size, size_t alignment, CopyDestination& destination)
+{
+    size_t alignedCursor = ark::alignUp(page.cursor, std::max(alignment, uploadAlignment()));
+    if (alignedCursor + size > page.buffer->size()) {
+        return nullptr;
+    }
 
     BufferCopyOperation copyOperation;
     copyOperation.size = size;
 
-    copyOperation.srcBuffer = m_buffer.get();
-    copyOperation.srcOffset = m_cursor;
+    copyOperation.srcBuffer = page.buffer.get();
+    copyOperation.srcOffset = alignedCursor;
 
     copyOperation.destination = std::move(destination);
 
-    m_buffer->updateData(data, size, m_cursor);
-    m_cursor += size;
-
     m_pendingOperations.push_back(copyOperation);
-    return true;
+
+    page.cursor = alignedCursor + size;
+    return page.mappedData + alignedCursor;
+}
+
+std::byte* UploadBuffer::tryAppendToLastOperation(size_t size, size_t alignment, CopyDestination const& destination)
+{
+    if (m_pendingOperations.empty()) {
+        return nullptr;
+    }
+
+    BufferCopyOperation& lastOperation = m_pendingOperations.back();
+
+    // Only merge copies to directly adjacent ranges of the same buffer
+    auto const* lastBufferDestination = std::get_if<BufferCopyOperation::BufferDestination>(&lastOperation.destination);
+    auto const* bufferDestination = std::get_if<BufferCopyOperation::BufferDestination>(&destination);
+    if (lastBufferDestination == nullptr || bufferDestination == nullptr
+        || lastBufferDestination->buffer != bufferDestination->buffer
+        || lastBufferDestination->offset + lastOperation.size != bufferDestination->offset) {
+        return nullptr;
+    }
+
+    // The source data must also be directly adjacent, i.e., the last operation must be the most recent allocation of its page
+    Page* page = nullptr;
+    if (lastOperation.srcBuffer == m_mainPage.buffer.get()) {
+        page = &m_mainPage;
+    } else if (m_numUsedSpillPages > 0 && lastOperation.srcBuffer == m_spillPages[m_numUsedSpillPages - 1].buffer.get()) {
+        page = &m_spillPages[m_numUsedSpillPages - 1];
+    }
+
+    if (page == nullptr
+        || lastOperation.srcOffset + lastOperation.size != page->cursor
+        || page->cursor % alignment != 0
+        || page->cursor + size > page->buffer->size()) {
+        return nullptr;
+    }
+
+    std::byte* memory = page->mappedData + page->cursor;
+
+    page->cursor += size;
+    lastOperation.size += size;
+
+    return memory;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "rendering/backend/base/Backend.h"
+#include <new>
+#include <span>
+#include <type_traits>
 #include <variant>
 
 struct BufferCopyOperation {
@@ -28,6 +31,11 @@ struct BufferCopyOperation {
     std::variant<BufferDestination, TextureDestination> destination;
 };
 
+// Linear allocator in persistently mapped upload memory, for staging data which is then copied to GPU buffers & textures. There is one
+// upload buffer per frame context, so it's reset when the GPU is done with the frame. Uploads to directly adjacent ranges of the same
+// destination buffer are merged into a single copy operation. If an upload doesn't fit in the main page it spills into additional
+// pages which are kept around for as long as they are needed. The size of the main page is the upload budget for a frame, so any
+// uploads which can be deferred to the next frame should check `alignedRemainingSize(..)` first instead of spilling.
 class UploadBuffer final {
 public:
     UploadBuffer(Backend&, size_t size);
@@ -42,8 +50,8 @@ public:
     // but we should probably query the real value per platform to avoid wasting memory.
     size_t uploadAlignment() const { return 256; }
 
-    size_t size() const { return m_buffer->size(); }
-    size_t unalignedRemainingSize() const { return size() - m_cursor; }
+    size_t size() const { return m_mainPage.buffer->size(); }
+    size_t unalignedRemainingSize() const { return size() - m_mainPage.cursor; }
     size_t alignedRemainingSize(size_t numUploads) const;
 
     void reset();
@@ -70,11 +78,44 @@ public:
         return upload(span.data(), sizeof(T) * span.size(), dstBuffer, dstOffset);
     }
 
+    // Allocate space for uploading `size` bytes to the destination buffer and return a pointer for writing the data in place. The data
+    // must be written before the pending operations are popped. Returns nullptr if the space couldn't be allocated.
+    std::byte* allocateUpload(size_t size, size_t alignment, Buffer& dstBuffer, size_t dstOffset = 0);
+
+    // Construct an object in place in upload memory, to be copied to the destination buffer. Returns nullptr if there is no space.
+    template<typename T, typename... Args>
+    T* emplaceUpload(Buffer& dstBuffer, size_t dstOffset, Args&&... args)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be copied to GPU memory");
+        std::byte* memory = allocateUpload(sizeof(T), alignof(T), dstBuffer, dstOffset);
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
 private:
 
-    bool upload(const void* data, size_t size, std::variant<BufferCopyOperation::BufferDestination, BufferCopyOperation::TextureDestination>&& destination);
+    using CopyDestination = std::variant<BufferCopyOperation::BufferDestination, BufferCopyOperation::TextureDestination>;
+
+    struct Page {
+        std::unique_ptr<Buffer> buffer {};
+        std::byte* mappedData { nullptr };
+        size_t cursor { 0 };
+        size_t flushedCursor { 0 };
+    };
+
+    Page createPage(size_t size);
+    void flushPage(Page&);
+
+    std::byte* allocate(size_t size, size_t alignment, CopyDestination&&);
+    std::byte* allocateInPage(Page&, size_t size, size_t alignment, CopyDestination&);
+    std::byte* tryAppendToLastOperation(size_t size, size_t alignment, CopyDestination const&);
+
+    Backend& m_backend;
 
-    size_t m_cursor { 0 };
     std::vector<BufferCopyOperation> m_pendingOperations;
-    std::unique_ptr<Buffer> m_buffer;
+
+    Page m_mainPage {};
+
+    static constexpr size_t MinSpillPageSize = 16 * 1024 * 1024;
+    std::vector<Page> m_spillPages {};
+    size_t m_numUsedSpillPages { 0 };
 };
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "core/Types.h"
+#include <vulkan/vulkan.h>
+
+// The accesses made to a buffer or texture by the commands recorded so far, which the command list uses to infer what barriers
+// are needed before the next access. The state is only valid for the tracking epoch it was recorded in; whenever a new epoch
+// begins (e.g. for a new command list) everything before it has been synchronized by a full barrier.
+struct VulkanAccessState {
+    u64 epoch { 0 };
+
+    // Stages & accesses of the last write (a layout transition also counts as a write)
+    VkPipelineStageFlags writeStages { 0 };
+    VkAccessFlags writeAccess { 0 };
+
+    // Stages & accesses that the last write has been made visible to
+    VkPipelineStageFlags visibleStages { 0 };
+    VkAccessFlags visibleAccess { 0 };
+
+    // Stages that have read since the last write, which must finish before the next write
+    VkPipelineStageFlags readStages { 0 };
+};
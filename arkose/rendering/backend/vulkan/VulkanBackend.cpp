@@ -6,6 +6,7 @@
 #include "VulkanBackend.h"
 
 #include "core/CommandLine.h"
+#include "core/parallel/ParallelFor.h"
 #include "rendering/backend/vulkan/VulkanBindingSet.h"
 #include "rendering/backend/vulkan/VulkanBuffer.h"
 #include "rendering/backend/vulkan/VulkanCommandList.h"
@@ -684,6 +685,52 @@ std::unique_ptr<ExternalFeature> VulkanBackend::createExternalFeature(ExternalFe
     }
 }
 
+bool VulkanBackend::placeTexturesInAliasedMemory(std::vector<TextureMemoryPlacement> const& placements, size_t memorySize)
+{
+    SCOPED_PROFILE_ZONE_BACKEND();
+
+    VkMemoryRequirements memoryRequirements {};
+    memoryRequirements.size = memorySize;
+    memoryRequirements.alignment = 1;
+    memoryRequirements.memoryTypeBits = UINT32_MAX;
+
+    for (TextureMemoryPlacement const& placement : placements) {
+        auto const& texture = static_cast<VulkanTexture const&>(*placement.texture);
+
+        VkMemoryRequirements textureMemoryRequirements;
+        vkGetImageMemoryRequirements(device(), texture.image, &textureMemoryRequirements);
+
+        ARKOSE_ASSERT(placement.offset % textureMemoryRequirements.alignment == 0);
+        ARKOSE_ASSERT(placement.offset + textureMemoryRequirements.size <= memorySize);
+
+        memoryRequirements.alignment = std::max(memoryRequirements.alignment, textureMemoryRequirements.alignment);
+        memoryRequirements.memoryTypeBits &= textureMemoryRequirements.memoryTypeBits;
+    }
+
+    if (memoryRequirements.memoryTypeBits == 0) {
+        ARKOSE_LOG(Warning, "VulkanBackend: no memory type is compatible with all of the textures, so their memory can't be aliased.");
+        return false;
+    }
+
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VmaAllocation allocation;
+    if (vmaAllocateMemory(globalAllocator(), &memoryRequirements, &allocCreateInfo, &allocation, nullptr) != VK_SUCCESS) {
+        ARKOSE_LOG(Error, "VulkanBackend: could not allocate {} bytes of aliased texture memory.", memorySize);
+        return false;
+    }
+
+    auto aliasedMemory = std::make_shared<VulkanAliasedMemory>(globalAllocator(), allocation);
+
+    for (TextureMemoryPlacement const& placement : placements) {
+        auto& texture = static_cast<VulkanTexture&>(*placement.texture);
+        texture.placeInAliasedMemory(aliasedMemory, placement.offset);
+    }
+
+    return true;
+}
+
 VkSurfaceFormatKHR VulkanBackend::pickBestSurfaceFormat() const
 {
     uint32_t formatCount;
@@ -1570,6 +1617,13 @@ void VulkanBackend::destroyFrameContexts()
     for (std::unique_ptr<FrameContext>& frameContext : m_frameContexts) {
         vkDestroyQueryPool(device(), frameContext->timestampQueryPool, nullptr);
         vkFreeCommandBuffers(device(), m_defaultCommandPool, 1, &frameContext->commandBuffer);
+        if (frameContext->additionalCommandBuffers.size() > 0) {
+            vkFreeCommandBuffers(device(), m_defaultCommandPool, static_cast<uint32_t>(frameContext->additionalCommandBuffers.size()), frameContext->additionalCommandBuffers.data());
+        }
+        for (auto& nodeRecordingContext : frameContext->nodeRecordingContexts) {
+            // (also frees the command buffers allocated from it)
+            vkDestroyCommandPool(device(), nodeRecordingContext->commandPool, nullptr);
+        }
         vkDestroySemaphore(device(), frameContext->imageAvailableSemaphore, nullptr);
         vkDestroyFence(device(), frameContext->frameFence, nullptr);
         frameContext.reset();
@@ -1849,6 +1903,10 @@ bool VulkanBackend::executeFrame(RenderPipeline& renderPipeline, float elapsedTi
         return double(nanosecondDiff) / (1000.0 * 1000.0 * 1000.0);
     };
 
+    // The command buffers of this frame, in submission order. Nodes recorded in parallel each have their own command buffer,
+    // so the frame is split up into multiple command buffers around them.
+    std::vector<VkCommandBuffer> submitCommandBuffers {};
+
     // Draw frame
     {
         uint32_t nextTimestampQueryIdx = 0;
@@ -1901,41 +1959,203 @@ bool VulkanBackend::executeFrame(RenderPipeline& renderPipeline, float elapsedTi
         UploadBuffer& uploadBuffer = *frameContext.uploadBuffer;
         uploadBuffer.reset();
 
+        // Each node recording context is used by at most one node per frame (across all parallel batches), so reset them all up front
+        for (auto& nodeRecordingContext : frameContext.nodeRecordingContexts) {
+            vkResetCommandPool(device(), nodeRecordingContext->commandPool, 0);
+            nodeRecordingContext->uploadBuffer->reset();
+        }
+        size_t nextNodeRecordingContextIdx = 0;
+
         Registry& registry = *m_pipelineRegistry;
-        VulkanCommandList cmdList { *this, commandBuffer };
+        auto cmdList = std::make_unique<VulkanCommandList>(*this, commandBuffer);
 
         vkCmdResetQueryPool(commandBuffer, frameContext.timestampQueryPool, 0, FrameContext::TimestampQueryPoolCount);
         vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frameContext.timestampQueryPool, frameStartTimestampIdx);
 
-        {
-            SCOPED_PROFILE_ZONE_GPU(commandBuffer, "Frame Render Pipeline");
-            renderPipeline.forEachNodeInResolvedOrder(registry, [&](RenderPipelineNode& node, const RenderPipelineNode::ExecuteCallback& nodeExecuteCallback) {
+        size_t nextAdditionalCommandBufferIdx = 0;
+        auto beginNextMainCommandBuffer = [&]() -> VkCommandBuffer {
+            if (nextAdditionalCommandBufferIdx == frameContext.additionalCommandBuffers.size()) {
+                VkCommandBufferAllocateInfo commandBufferAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+                commandBufferAllocateInfo.commandPool = m_defaultCommandPool;
+                commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                commandBufferAllocateInfo.commandBufferCount = 1;
+
+                VkCommandBuffer additionalCommandBuffer;
+                if (vkAllocateCommandBuffers(device(), &commandBufferAllocateInfo, &additionalCommandBuffer) != VK_SUCCESS) {
+                    ARKOSE_LOG(Fatal, "VulkanBackend: could not create additional command buffer, exiting.");
+                }
+
+                frameContext.additionalCommandBuffers.push_back(additionalCommandBuffer);
+            }
+
+            VkCommandBuffer nextCommandBuffer = frameContext.additionalCommandBuffers[nextAdditionalCommandBufferIdx++];
+            if (vkBeginCommandBuffer(nextCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+                ARKOSE_LOG(Error, "VulkanBackend: error beginning command buffer command!");
+            }
+
+            return nextCommandBuffer;
+        };
+
+        struct NodeRecording {
+            RenderPipelineNode* node { nullptr };
+            RenderPipelineNode::ExecuteCallback const* executeCallback { nullptr };
+            std::string nodeName {};
+            uint32_t startTimestampIdx { 0 };
+            uint32_t endTimestampIdx { 0 };
+            std::vector<Texture*> const* transientTextures { nullptr };
+
+            // Only for nodes recorded in parallel
+            std::unique_ptr<VulkanCommandList> cmdList {};
+        };
+
+        auto recordNode = [&](NodeRecording& recording, VulkanCommandList& nodeCmdList, VkCommandBuffer nodeCommandBuffer, UploadBuffer& nodeUploadBuffer) {
+            SCOPED_PROFILE_ZONE_DYNAMIC(recording.nodeName, 0x00ffff);
+            double cpuStartTime = System::get().timeSinceStartup();
+
+            nodeCmdList.beginDebugLabel(recording.nodeName);
+            vkCmdWriteTimestamp(nodeCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frameContext.timestampQueryPool, recording.startTimestampIdx);
+
+            for (Texture* transientTexture : *recording.transientTextures) {
+                nodeCmdList.textureAliasingBarrier(*transientTexture);
+            }
+
+            (*recording.executeCallback)(appState, nodeCmdList, nodeUploadBuffer);
+            nodeCmdList.endNode({});
+
+            vkCmdWriteTimestamp(nodeCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frameContext.timestampQueryPool, recording.endTimestampIdx);
+            nodeCmdList.endDebugLabel();
+
+            double cpuElapsed = System::get().timeSinceStartup() - cpuStartTime;
+            recording.node->timer().reportCpuTime(cpuElapsed);
+        };
+
+        // Consecutive nodes which support parallel recording are collected here and then recorded all at once
+        std::vector<NodeRecording> parallelNodeBatch {};
+
+        auto recordParallelNodeBatch = [&]() {
+            if (parallelNodeBatch.empty()) {
+                return;
+            }
+
+            // Not worth the overhead of separate command buffers for a single node
+            if (parallelNodeBatch.size() == 1) {
+                recordNode(parallelNodeBatch.front(), *cmdList, commandBuffer, uploadBuffer);
+                parallelNodeBatch.clear();
+                return;
+            }
+
+            SCOPED_PROFILE_ZONE_BACKEND_NAMED("Record nodes in parallel");
+
+            // Everything recorded so far is submitted before the nodes of the batch
+            cmdList->endAllNodes({});
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                ARKOSE_LOG(Error, "VulkanBackend: error ending command buffer command!");
+            }
+            submitCommandBuffers.push_back(commandBuffer);
 
-                std::string nodeName = node.name();
+            // Earlier batches of this frame have recorded into the contexts before this offset, which are yet to be submitted
+            size_t contextOffset = nextNodeRecordingContextIdx;
+            nextNodeRecordingContextIdx += parallelNodeBatch.size();
 
-                SCOPED_PROFILE_ZONE_DYNAMIC(nodeName, 0x00ffff);
-                double cpuStartTime = System::get().timeSinceStartup();
+            while (frameContext.nodeRecordingContexts.size() < nextNodeRecordingContextIdx) {
+                auto nodeRecordingContext = std::make_unique<FrameContext::NodeRecordingContext>();
 
-                // NOTE: This works assuming we never modify the list of nodes (add/remove/reorder)
-                uint32_t nodeStartTimestampIdx = nextTimestampQueryIdx++;
-                uint32_t nodeEndTimestampIdx = nextTimestampQueryIdx++;
-                node.timer().reportGpuTime(elapsedSecondsBetweenTimestamps(nodeStartTimestampIdx, nodeEndTimestampIdx));
+                VkCommandPoolCreateInfo poolCreateInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+                poolCreateInfo.queueFamilyIndex = m_graphicsQueue.familyIndex;
+                if (vkCreateCommandPool(device(), &poolCreateInfo, nullptr, &nodeRecordingContext->commandPool) != VK_SUCCESS) {
+                    ARKOSE_LOG(Fatal, "VulkanBackend: could not create command pool for node recording, exiting.");
+                }
 
-                cmdList.beginDebugLabel(nodeName);
-                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frameContext.timestampQueryPool, nodeStartTimestampIdx);
+                VkCommandBufferAllocateInfo commandBufferAllocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+                commandBufferAllocateInfo.commandPool = nodeRecordingContext->commandPool;
+                commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                commandBufferAllocateInfo.commandBufferCount = 2;
 
-                nodeExecuteCallback(appState, cmdList, uploadBuffer);
-                cmdList.endNode({});
+                VkCommandBuffer commandBuffers[2];
+                if (vkAllocateCommandBuffers(device(), &commandBufferAllocateInfo, commandBuffers) != VK_SUCCESS) {
+                    ARKOSE_LOG(Fatal, "VulkanBackend: could not create command buffers for node recording, exiting.");
+                }
 
-                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frameContext.timestampQueryPool, nodeEndTimestampIdx);
-                cmdList.endDebugLabel();
+                nodeRecordingContext->commandBuffer = commandBuffers[0];
+                nodeRecordingContext->resolveCommandBuffer = commandBuffers[1];
+                nodeRecordingContext->uploadBuffer = std::make_unique<UploadBuffer>(*this, FrameContext::NodeRecordingUploadBufferSize);
 
-                double cpuElapsed = System::get().timeSinceStartup() - cpuStartTime;
-                node.timer().reportCpuTime(cpuElapsed);
+                frameContext.nodeRecordingContexts.push_back(std::move(nodeRecordingContext));
+            }
+
+            ParallelFor(parallelNodeBatch.size(), [&](size_t idx) {
+                NodeRecording& recording = parallelNodeBatch[idx];
+                FrameContext::NodeRecordingContext& nodeRecordingContext = *frameContext.nodeRecordingContexts[contextOffset + idx];
+
+                VkCommandBuffer nodeCommandBuffer = nodeRecordingContext.commandBuffer;
+                if (vkBeginCommandBuffer(nodeCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+                    ARKOSE_LOG(Error, "VulkanBackend: error beginning command buffer command!");
+                }
+
+                recording.cmdList = std::make_unique<VulkanCommandList>(*this, nodeCommandBuffer, VulkanCommandList::ResourceStateTracking::Deferred);
+                recordNode(recording, *recording.cmdList, nodeCommandBuffer, *nodeRecordingContext.uploadBuffer);
+                recording.cmdList->endAllNodes({});
+
+                if (vkEndCommandBuffer(nodeCommandBuffer) != VK_SUCCESS) {
+                    ARKOSE_LOG(Error, "VulkanBackend: error ending command buffer command!");
+                }
             });
-        }
 
-        cmdList.beginDebugLabel("GUI");
+            // Resolve the resource states of the nodes against each other, in the order they will execute
+            for (size_t idx = 0; idx < parallelNodeBatch.size(); ++idx) {
+                FrameContext::NodeRecordingContext& nodeRecordingContext = *frameContext.nodeRecordingContexts[contextOffset + idx];
+
+                VkCommandBuffer resolveCommandBuffer = nodeRecordingContext.resolveCommandBuffer;
+                if (vkBeginCommandBuffer(resolveCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+                    ARKOSE_LOG(Error, "VulkanBackend: error beginning command buffer command!");
+                }
+
+                if (idx > 0) {
+                    parallelNodeBatch[idx - 1].cmdList->resolveDeferredExitStates({}, resolveCommandBuffer);
+                }
+                parallelNodeBatch[idx].cmdList->resolveDeferredEntryStates({}, resolveCommandBuffer);
+
+                if (vkEndCommandBuffer(resolveCommandBuffer) != VK_SUCCESS) {
+                    ARKOSE_LOG(Error, "VulkanBackend: error ending command buffer command!");
+                }
+
+                submitCommandBuffers.push_back(resolveCommandBuffer);
+                submitCommandBuffers.push_back(nodeRecordingContext.commandBuffer);
+            }
+
+            // Continue recording on the main thread in a new command buffer
+            commandBuffer = beginNextMainCommandBuffer();
+            parallelNodeBatch.back().cmdList->resolveDeferredExitStates({}, commandBuffer);
+            cmdList = std::make_unique<VulkanCommandList>(*this, commandBuffer);
+
+            parallelNodeBatch.clear();
+        };
+
+        renderPipeline.forEachNodeInResolvedOrder(registry, [&](RenderPipelineNode& node, const RenderPipelineNode::ExecuteCallback& nodeExecuteCallback) {
+
+            NodeRecording recording { .node = &node,
+                                      .executeCallback = &nodeExecuteCallback,
+                                      .nodeName = node.name() };
+
+            // NOTE: This works assuming we never modify the list of nodes (add/remove/reorder)
+            recording.startTimestampIdx = nextTimestampQueryIdx++;
+            recording.endTimestampIdx = nextTimestampQueryIdx++;
+            node.timer().reportGpuTime(elapsedSecondsBetweenTimestamps(recording.startTimestampIdx, recording.endTimestampIdx));
+
+            recording.transientTextures = &registry.transientTexturesFirstUsedInNode(recording.nodeName);
+
+            if (vulkanParallelNodeRecording && node.supportsParallelRecording()) {
+                parallelNodeBatch.push_back(std::move(recording));
+            } else {
+                recordParallelNodeBatch();
+                recordNode(recording, *cmdList, commandBuffer, uploadBuffer);
+            }
+        });
+
+        recordParallelNodeBatch();
+        cmdList->endAllNodes({});
+
+        cmdList->beginDebugLabel("GUI");
         {
             SCOPED_PROFILE_ZONE_GPU(commandBuffer, "GUI");
             SCOPED_PROFILE_ZONE_BACKEND_NAMED("GUI Rendering");
@@ -1948,7 +2168,7 @@ bool VulkanBackend::executeFrame(RenderPipeline& renderPipeline, float elapsedTi
                 ImGui::RenderPlatformWindowsDefault();
             }
         }
-        cmdList.endDebugLabel();
+        cmdList->endDebugLabel();
 
         {
             // Transition swapchain image to present layout
@@ -1987,6 +2207,7 @@ bool VulkanBackend::executeFrame(RenderPipeline& renderPipeline, float elapsedTi
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             ARKOSE_LOG(Error, "VulkanBackend: error ending command buffer command!");
         }
+        submitCommandBuffers.push_back(commandBuffer);
 
         m_currentlyExecutingMainCommandBuffer = false;
     }
@@ -2081,8 +2302,8 @@ bool VulkanBackend::executeFrame(RenderPipeline& renderPipeline, float elapsedTi
 
         VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
 
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &frameContext.commandBuffer;
+        submitInfo.commandBufferCount = static_cast<uint32_t>(submitCommandBuffers.size());
+        submitInfo.pCommandBuffers = submitCommandBuffers.data();
 
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = &frameContext.imageAvailableSemaphore;
@@ -2177,6 +2398,10 @@ std::optional<Backend::SubmitStatus> VulkanBackend::submitRenderPipeline(RenderP
 
             cmdList.beginDebugLabel(nodeName);
 
+            for (Texture* transientTexture : registry.transientTexturesFirstUsedInNode(nodeName)) {
+                cmdList.textureAliasingBarrier(*transientTexture);
+            }
+
             nodeExecuteCallback(hackAppState, cmdList, uploadBuffer);
             cmdList.endNode({});
 
@@ -2187,6 +2412,8 @@ std::optional<Backend::SubmitStatus> VulkanBackend::submitRenderPipeline(RenderP
         });
     }
 
+    cmdList.endAllNodes({});
+
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         ARKOSE_LOG(Error, "VulkanBackend: error ending command buffer command!");
         return {};
@@ -43,6 +43,12 @@ static constexpr bool vulkanDebugMode = false;
 static constexpr bool vulkanVerboseDebugMessages = false;
 #endif
 
+// Validate the barriers inferred by the command list against the conservative behaviour of a full barrier after every node
+static constexpr bool vulkanBarrierValidation = false;
+
+// Record consecutive render pipeline nodes which support it (see RenderPipelineNode::supportsParallelRecording) in parallel
+static constexpr bool vulkanParallelNodeRecording = true;
+
 class VulkanBackend final : public Backend {
 public:
     VulkanBackend(Badge<Backend>, const AppSpecification& appSpecification);
@@ -65,6 +71,7 @@ public:
     void waitForFrameReady() override;
     void newFrame() override;
     bool executeFrame(RenderPipeline&, float elapsedTime, float deltaTime) override;
+    u32 inFlightFrameCount() const override { return NumInFlightFrames; }
 
     std::optional<SubmitStatus> submitRenderPipeline(RenderPipeline&, Registry&, UploadBuffer&, char const* debugName) override;
     bool pollSubmissionStatus(SubmitStatus&) const override;
@@ -94,6 +101,8 @@ public:
     std::unique_ptr<ComputeState> createComputeState(Shader const&, StateBindings const&) override;
     std::unique_ptr<ExternalFeature> createExternalFeature(ExternalFeatureType, void* externalFeatureParameters) override;
 
+    bool placeTexturesInAliasedMemory(std::vector<TextureMemoryPlacement> const&, size_t memorySize) override;
+
     ///////////////////////////////////////////////////////////////////////////
     /// Utilities
 
@@ -324,6 +333,21 @@ private:
         VkCommandBuffer commandBuffer {};
         std::unique_ptr<UploadBuffer> uploadBuffer {};
 
+        // For nodes recorded in parallel. Command pools (and upload buffers) can't be used from multiple threads at once, so
+        // each node being recorded gets its own for the frame, and a command buffer for resolving its resource states on the main thread.
+        struct NodeRecordingContext {
+            VkCommandPool commandPool {};
+            VkCommandBuffer commandBuffer {};
+            VkCommandBuffer resolveCommandBuffer {};
+            std::unique_ptr<UploadBuffer> uploadBuffer {};
+        };
+
+        static constexpr size_t NodeRecordingUploadBufferSize = 4 * 1024 * 1024;
+        std::vector<std::unique_ptr<NodeRecordingContext>> nodeRecordingContexts {};
+
+        // For continuing on the main thread after nodes recorded in parallel
+        std::vector<VkCommandBuffer> additionalCommandBuffers {};
+
         static constexpr uint32_t TimestampQueryPoolCount = 100;
         TimestampResult64 timestampResults[TimestampQueryPoolCount] = {};
         uint32_t numTimestampsWrittenLastTime { 0 };
@@ -218,6 +218,12 @@ void VulkanBindingSet::updateBindings()
 {
     auto& vulkanBackend = static_cast<const VulkanBackend&>(backend());
 
+    // The views are recreated below, as they might be referencing images that no longer exist
+    for (VkImageView imageView : m_additionalImageViews) {
+        vkDestroyImageView(vulkanBackend.device(), imageView, nullptr);
+    }
+    m_additionalImageViews.clear();
+
     std::vector<VkWriteDescriptorSet> descriptorSetWrites {};
     CapList<VkDescriptorBufferInfo> descBufferInfos { 4096 };
     CapList<VkDescriptorImageInfo> descImageInfos { 4096 };
@@ -12,9 +12,8 @@ public:
 
     virtual void setName(const std::string& name) override;
 
-    void updateBindings();
-
     virtual void updateTextures(uint32_t index, const std::vector<TextureBindingUpdate>&) override;
+    virtual void updateBindings() override;
 
     VkDescriptorPool descriptorPool;
     VkDescriptorSetLayout descriptorSetLayout;
@@ -136,6 +136,36 @@ void VulkanBuffer::updateData(const std::byte* data, size_t updateSize, size_t o
     }
 }
 
+std::byte* VulkanBuffer::persistentlyMappedData()
+{
+    // NOTE: Upload & readback buffers are always created with VMA_ALLOCATION_CREATE_MAPPED_BIT, other buffers only with ReBAR support
+    return reinterpret_cast<std::byte*>(allocationInfo.pMappedData);
+}
+
+void VulkanBuffer::flushMappedData(size_t size, size_t offset)
+{
+    SCOPED_PROFILE_ZONE_GPURESOURCE();
+
+    ARKOSE_ASSERT(allocationInfo.pMappedData != nullptr);
+    ARKOSE_ASSERT(offset + size <= m_size);
+
+    // NOTE: VMA ignores the flush if the memory is host coherent
+    auto& vulkanBackend = static_cast<VulkanBackend&>(backend());
+    vmaFlushAllocation(vulkanBackend.globalAllocator(), allocation, offset, size);
+}
+
+void VulkanBuffer::invalidateMappedData(size_t size, size_t offset)
+{
+    SCOPED_PROFILE_ZONE_GPURESOURCE();
+
+    ARKOSE_ASSERT(allocationInfo.pMappedData != nullptr);
+    ARKOSE_ASSERT(offset + size <= m_size);
+
+    // NOTE: VMA ignores the invalidate if the memory is host coherent
+    auto& vulkanBackend = static_cast<VulkanBackend&>(backend());
+    vmaInvalidateAllocation(vulkanBackend.globalAllocator(), allocation, offset, size);
+}
+
 void VulkanBuffer::reallocateWithSize(size_t newSize, ReallocateStrategy strategy)
 {
     SCOPED_PROFILE_ZONE_GPURESOURCE();
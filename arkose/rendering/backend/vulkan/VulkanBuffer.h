@@ -1,6 +1,7 @@
 #pragma once
 
 #include "rendering/backend/base/Buffer.h"
+#include "rendering/backend/vulkan/VulkanAccessState.h"
 
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
@@ -15,12 +16,18 @@ public:
     bool mapData(MapMode, size_t size, size_t offset, std::function<void(std::byte*)>&& mapCallback) override;
 
     void updateData(const std::byte* data, size_t size, size_t offset) override;
+
+    std::byte* persistentlyMappedData() override;
+    void flushMappedData(size_t size, size_t offset) override;
+    void invalidateMappedData(size_t size, size_t offset) override;
     void reallocateWithSize(size_t newSize, ReallocateStrategy) override;
 
     VkBuffer buffer;
     VmaAllocation allocation;
     VmaAllocationInfo allocationInfo;
 
+    mutable VulkanAccessState accessState {};
+
 private:
     void createInternal(size_t size, VkBuffer& buffer, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo);
     void destroyInternal(VkBuffer buffer, VmaAllocation allocation, VmaAllocationInfo& allocationInfo);
@@ -13,16 +13,62 @@
 #include "rendering/backend/vulkan/extensions/ray-tracing-khr/VulkanRayTracingStateKHR.h"
 #include "rendering/backend/vulkan/features/dlss/VulkanDLSS.h"
 #include "utility/Profiling.h"
+#include <algorithm>
 #include <fmt/format.h>
 #include <stb_image_write.h>
 
 // Shared shader headers
 #include "shaders/shared/IndirectData.h"
 
-VulkanCommandList::VulkanCommandList(VulkanBackend& backend, VkCommandBuffer commandBuffer)
+// All accesses which write to memory, i.e., which must be made available before any later access
+static constexpr VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT
+                                               | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                                               | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                               | VK_ACCESS_TRANSFER_WRITE_BIT
+                                               | VK_ACCESS_HOST_WRITE_BIT
+                                               | VK_ACCESS_MEMORY_WRITE_BIT
+                                               | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+// All reads which can be made within a render pass without being declared when beginning rendering
+static constexpr VkAccessFlags GraphicsReadAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                                      | VK_ACCESS_INDEX_READ_BIT
+                                                      | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                                      | VK_ACCESS_UNIFORM_READ_BIT
+                                                      | VK_ACCESS_SHADER_READ_BIT;
+
+static VkImageMemoryBarrier wholeTextureLayoutTransition(VulkanTexture const& texture, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier imageBarrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    imageBarrier.oldLayout = oldLayout;
+    imageBarrier.newLayout = newLayout;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    // NOTE: We always transition all mips so we can ensure our invariant of same layout accross mips holds.
+    imageBarrier.image = texture.image;
+    imageBarrier.subresourceRange.aspectMask = texture.aspectMask();
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = texture.mipLevels();
+    imageBarrier.subresourceRange.baseArrayLayer = 0;
+    imageBarrier.subresourceRange.layerCount = texture.layerCount();
+
+    return imageBarrier;
+}
+
+std::atomic<u64> VulkanCommandList::s_nextTrackingEpoch { 1 };
+
+VulkanCommandList::VulkanCommandList(VulkanBackend& backend, VkCommandBuffer commandBuffer, ResourceStateTracking resourceStateTracking)
     : m_backend(backend)
     , m_commandBuffer(commandBuffer)
+    , m_resourceStateTracking(resourceStateTracking)
+    , m_trackingEpoch(s_nextTrackingEpoch++)
 {
+    // The access states know nothing about what's recorded in other command buffers, so synchronize with all of it. For deferred
+    // resource states this is instead part of the barriers recorded by resolveDeferredEntryStates(..).
+    if (m_resourceStateTracking == ResourceStateTracking::Immediate) {
+        debugBarrier();
+        m_barrierStats.fullBarrierCount += 1;
+    }
 }
 
 void VulkanCommandList::fillBuffer(Buffer& genBuffer, u32 fillValue)
@@ -30,6 +76,10 @@ void VulkanCommandList::fillBuffer(Buffer& genBuffer, u32 fillValue)
     SCOPED_PROFILE_ZONE_GPUCOMMAND();
 
     auto& buffer = static_cast<VulkanBuffer&>(genBuffer);
+
+    requireBufferAccess(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    flushBarriers();
+
     vkCmdFillBuffer(m_commandBuffer, buffer.buffer, 0, VK_WHOLE_SIZE, fillValue);
 }
 
@@ -49,38 +99,15 @@ void VulkanCommandList::clearTexture(Texture& genTexture, ClearValue clearValue)
         aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     }
 
-    std::optional<VkImageLayout> originalLayout;
-    if (texture.currentLayout != VK_IMAGE_LAYOUT_GENERAL && texture.currentLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        originalLayout = texture.currentLayout;
-
-        VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        imageBarrier.oldLayout = originalLayout.value();
-        imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-        imageBarrier.image = texture.image;
-        imageBarrier.subresourceRange.aspectMask = aspectMask;
-        imageBarrier.subresourceRange.baseMipLevel = 0;
-        imageBarrier.subresourceRange.levelCount = texture.mipLevels();
-        imageBarrier.subresourceRange.baseArrayLayer = 0;
-        imageBarrier.subresourceRange.layerCount = texture.layerCount();
-
-        // FIXME: Probably overly aggressive barriers!
-
-        VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-        VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-        imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             sourceStage, destinationStage, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &imageBarrier);
+    VkImageLayout originalLayout = layoutFor(texture);
+    VkImageLayout clearLayout = VK_IMAGE_LAYOUT_GENERAL;
+    if (originalLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        clearLayout = originalLayout;
     }
 
+    requireTextureAccess(texture, clearLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    flushBarriers();
+
     VkImageSubresourceRange range {};
     range.aspectMask = aspectMask;
     range.baseMipLevel = 0;
@@ -93,7 +120,7 @@ void VulkanCommandList::clearTexture(Texture& genTexture, ClearValue clearValue)
         clearDepthStencil.depth = clearValue.depth;
         clearDepthStencil.stencil = clearValue.stencil;
 
-        vkCmdClearDepthStencilImage(m_commandBuffer, texture.image, VK_IMAGE_LAYOUT_GENERAL, &clearDepthStencil, 1, &range);
+        vkCmdClearDepthStencilImage(m_commandBuffer, texture.image, clearLayout, &clearDepthStencil, 1, &range);
 
     } else {
         VkClearColorValue clearColor {};
@@ -102,42 +129,13 @@ void VulkanCommandList::clearTexture(Texture& genTexture, ClearValue clearValue)
         clearColor.float32[2] = clearValue.color.b;
         clearColor.float32[3] = clearValue.color.a;
 
-        vkCmdClearColorImage(m_commandBuffer, texture.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+        vkCmdClearColorImage(m_commandBuffer, texture.image, clearLayout, &clearColor, 1, &range);
     }
 
-    // Return the image to its original layout, if needed
-    if (originalLayout.has_value()) {
-        if (originalLayout.value() == VK_IMAGE_LAYOUT_UNDEFINED || originalLayout.value() == VK_IMAGE_LAYOUT_PREINITIALIZED) {
-            // Can't return it to undefined, let's keep it in general now
-            texture.currentLayout = VK_IMAGE_LAYOUT_GENERAL;
-        } else {
-            VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-            imageBarrier.newLayout = originalLayout.value();
-            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-            imageBarrier.image = texture.image;
-            imageBarrier.subresourceRange.aspectMask = aspectMask;
-            imageBarrier.subresourceRange.baseMipLevel = 0;
-            imageBarrier.subresourceRange.levelCount = texture.mipLevels();
-            imageBarrier.subresourceRange.baseArrayLayer = 0;
-            imageBarrier.subresourceRange.layerCount = texture.layerCount();
-
-            // FIXME: Probably overly aggressive barriers!
-
-            VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-            VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-            imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-            vkCmdPipelineBarrier(m_commandBuffer,
-                                 sourceStage, destinationStage, 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &imageBarrier);
-        }
+    // Return the image to its original layout, if needed (the transition is batched with the barriers of the next command).
+    // We can't return it to undefined though, so then let's keep it in general.
+    if (originalLayout != VK_IMAGE_LAYOUT_UNDEFINED && originalLayout != VK_IMAGE_LAYOUT_PREINITIALIZED) {
+        requireTextureAccess(texture, originalLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
     }
 }
 
@@ -148,6 +146,7 @@ void VulkanCommandList::copyTexture(Texture& genSrc, Texture& genDst, ImageFilte
     auto& src = static_cast<VulkanTexture&>(genSrc);
     auto& dst = static_cast<VulkanTexture&>(genDst);
 
+    ARKOSE_ASSERT(&src != &dst);
     ARKOSE_ASSERT(srcMip < src.mipLevels());
     ARKOSE_ASSERT(dstMip < dst.mipLevels());
     ARKOSE_ASSERT(src.hasDepthFormat() == dst.hasDepthFormat());
@@ -155,59 +154,19 @@ void VulkanCommandList::copyTexture(Texture& genSrc, Texture& genDst, ImageFilte
     ARKOSE_ASSERT(src.aspectMask() == dst.aspectMask());
     VkImageAspectFlags aspectMask = src.aspectMask();
 
-    ARKOSE_ASSERT(src.currentLayout != VK_IMAGE_LAYOUT_UNDEFINED && src.currentLayout != VK_IMAGE_LAYOUT_PREINITIALIZED);
-    VkImageLayout initialSrcLayout = src.currentLayout;
+    VkImageLayout initialSrcLayout = layoutFor(src);
+    ARKOSE_ASSERT(initialSrcLayout != VK_IMAGE_LAYOUT_UNDEFINED && initialSrcLayout != VK_IMAGE_LAYOUT_PREINITIALIZED);
 
-    bool dstWasUndefined = false;
-    VkImageLayout finalDstLayout = dst.currentLayout;
+    // We never want to transition anything back to undefined, so if the destination is undefined it remains in the general layout
+    VkImageLayout finalDstLayout = layoutFor(dst);
     if (finalDstLayout == VK_IMAGE_LAYOUT_UNDEFINED || finalDstLayout == VK_IMAGE_LAYOUT_PREINITIALIZED) {
         finalDstLayout = VK_IMAGE_LAYOUT_GENERAL;
-        dstWasUndefined = true;
     }
 
-    {
-        VkImageMemoryBarrier genBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        genBarrier.subresourceRange.aspectMask = aspectMask;
-        genBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        genBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        genBarrier.subresourceRange.baseMipLevel = 0;
-        genBarrier.subresourceRange.levelCount = 1;
-        genBarrier.subresourceRange.baseArrayLayer = 0;
-        genBarrier.subresourceRange.layerCount = 1;
-        genBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-
-        std::array<VkImageMemoryBarrier, 2> barriers { genBarrier, genBarrier };
-
-        barriers[0].image = src.image;
-        barriers[0].oldLayout = src.currentLayout;
-        barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        barriers[0].subresourceRange.baseMipLevel = srcMip;
-
-        barriers[1].image = dst.image;
-        barriers[1].oldLayout = dst.currentLayout;
-        barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        // If the initial is undefined we first transition *all* layers and mips to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        // so that we can then at the end copy all of them back to `finalDstLayout` and have no inconsistensies in that
-        // final transition (i.e., all are the same).
-        // TODO: Maybe also ensure we copy black/magenta/? pixels into the undefined layers & mips?
-        if (dstWasUndefined) {
-            barriers[1].subresourceRange.baseMipLevel = 0;
-            barriers[1].subresourceRange.levelCount = dst.mipLevels();
-            barriers[1].subresourceRange.baseArrayLayer = 0;
-            barriers[1].subresourceRange.layerCount = dst.layerCount();
-        } else {
-            barriers[1].subresourceRange.baseMipLevel = dstMip;
-        }
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             (uint32_t)barriers.size(), barriers.data());
-    }
+    // NOTE: We always transition all layers & mips so we can ensure our invariant of same layout accross mips holds.
+    requireTextureAccess(src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    requireTextureAccess(dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    flushBarriers();
 
     {
         auto extentToOffset = [](Extent3D extent) -> VkOffset3D {
@@ -254,49 +213,9 @@ void VulkanCommandList::copyTexture(Texture& genSrc, Texture& genDst, ImageFilte
                        blitFilter);
     }
 
-    {
-        VkImageMemoryBarrier genBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        genBarrier.subresourceRange.aspectMask = aspectMask;
-        genBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        genBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        genBarrier.subresourceRange.baseMipLevel = 0;
-        genBarrier.subresourceRange.levelCount = 1;
-        genBarrier.subresourceRange.baseArrayLayer = 0;
-        genBarrier.subresourceRange.layerCount = 1;
-        genBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
-        genBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-        std::array<VkImageMemoryBarrier, 2> barriers { genBarrier, genBarrier };
-
-        barriers[0].image = src.image;
-        barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barriers[0].newLayout = initialSrcLayout;
-        barriers[0].subresourceRange.baseMipLevel = srcMip;
-
-        barriers[1].image = dst.image;
-        barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barriers[1].newLayout = finalDstLayout;
-
-        // Usually we just transition the specified layer and mip to what we need and then back, but we never want to
-        // transition anything back to undefined. If the initial is undefined we transition *all* layers and mips to
-        // the new layout so that we maintain our invariant that all of them should have the same layout always.
-        if (dstWasUndefined) {
-            barriers[1].subresourceRange.baseMipLevel = 0;
-            barriers[1].subresourceRange.levelCount = dst.mipLevels();
-            barriers[1].subresourceRange.baseArrayLayer = 0;
-            barriers[1].subresourceRange.layerCount = dst.layerCount();
-        } else {
-            barriers[1].subresourceRange.baseMipLevel = dstMip;
-        }
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             (uint32_t)barriers.size(), barriers.data());
-
-        dst.currentLayout = finalDstLayout;
-    }
+    // Return both to their layouts from before (these transitions are batched with the barriers of the next command)
+    requireTextureAccess(src, initialSrcLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+    requireTextureAccess(dst, finalDstLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
 }
 
 void VulkanCommandList::generateMipmaps(Texture& genTexture)
@@ -310,18 +229,21 @@ void VulkanCommandList::generateMipmaps(Texture& genTexture)
         return;
     }
 
-    if (texture.currentLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+    if (layoutFor(texture) == VK_IMAGE_LAYOUT_UNDEFINED) {
         ARKOSE_LOG(Error, "generateMipmaps called on command list for texture which currently has the layout VK_IMAGE_LAYOUT_UNDEFINED. Ignoring request.");
         return;
     }
 
     beginDebugLabel(fmt::format("Generate Mipmaps ({}x{})", genTexture.extent().width(), genTexture.extent().height()));
 
-    // Make sure that all mips have whatever layout the texture has before this function was called!
-    VkImageLayout finalLayout = texture.currentLayout;
+    VkImageLayout finalLayout = layoutFor(texture);
 
     VkImageAspectFlags aspectMask = texture.aspectMask();
 
+    // Start out with all mips as transfer destinations, and make each mip a transfer source once it has been written to
+    requireTextureAccess(texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    flushBarriers();
+
     VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
     barrier.subresourceRange.aspectMask = aspectMask;
     barrier.image = texture.image;
@@ -330,80 +252,26 @@ void VulkanCommandList::generateMipmaps(Texture& genTexture)
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = texture.layerCount();
     barrier.subresourceRange.levelCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
     uint32_t levels = texture.mipLevels();
     int32_t mipWidth = texture.extent().width();
     int32_t mipHeight = texture.extent().height();
 
-    // We have to be very general in this function..
-    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-    VkAccessFlags finalAccess = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-    // Transition mip 0 to transfer src optimal (and wait for all its read & writes to finish first)
-    {
-        VkImageMemoryBarrier initialBarrierMip0 = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        initialBarrierMip0.image = texture.image;
-        initialBarrierMip0.subresourceRange.aspectMask = aspectMask;
-        initialBarrierMip0.oldLayout = texture.currentLayout;
-        initialBarrierMip0.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        initialBarrierMip0.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-        initialBarrierMip0.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        initialBarrierMip0.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        initialBarrierMip0.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        initialBarrierMip0.subresourceRange.baseArrayLayer = 0;
-        initialBarrierMip0.subresourceRange.layerCount = texture.layerCount();
-        initialBarrierMip0.subresourceRange.baseMipLevel = 0;
-        initialBarrierMip0.subresourceRange.levelCount = 1;
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &initialBarrierMip0);
-    }
-
-    // Transition mips 1-n to transfer dst optimal
-    {
-        VkImageMemoryBarrier initialBarrierMip1plus = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        initialBarrierMip1plus.image = texture.image;
-        initialBarrierMip1plus.subresourceRange.aspectMask = aspectMask;
-        initialBarrierMip1plus.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        initialBarrierMip1plus.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        initialBarrierMip1plus.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-        initialBarrierMip1plus.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        initialBarrierMip1plus.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        initialBarrierMip1plus.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        initialBarrierMip1plus.subresourceRange.baseArrayLayer = 0;
-        initialBarrierMip1plus.subresourceRange.layerCount = texture.layerCount();
-        initialBarrierMip1plus.subresourceRange.baseMipLevel = 1;
-        initialBarrierMip1plus.subresourceRange.levelCount = levels - 1;
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &initialBarrierMip1plus);
-    }
-
     for (uint32_t i = 1; i < levels; ++i) {
 
         int32_t nextWidth = mipWidth > 1 ? mipWidth / 2 : 1;
         int32_t nextHeight = mipHeight > 1 ? mipHeight / 2 : 1;
 
-        // (mip0 is already in src optimal)
-        if (i > 1) {
-            barrier.subresourceRange.baseMipLevel = i - 1;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-            vkCmdPipelineBarrier(m_commandBuffer,
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &barrier);
-        }
+        barrier.subresourceRange.baseMipLevel = i - 1;
+        vkCmdPipelineBarrier(m_commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &barrier);
 
         VkImageBlit blit = {};
 
@@ -427,33 +295,27 @@ void VulkanCommandList::generateMipmaps(Texture& genTexture)
                        1, &blit,
                        VK_FILTER_LINEAR);
 
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        barrier.newLayout = finalLayout;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        barrier.dstAccessMask = finalAccess;
-
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
-
         mipWidth = nextWidth;
         mipHeight = nextHeight;
     }
 
+    // Make the last mip a transfer source too, so that all mips have the same layout again
     barrier.subresourceRange.baseMipLevel = levels - 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = finalLayout;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = finalAccess;
-
     vkCmdPipelineBarrier(m_commandBuffer,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
                          0, nullptr,
                          0, nullptr,
                          1, &barrier);
 
+    m_barrierStats.pipelineBarrierCount += levels;
+    m_barrierStats.imageBarrierCount += levels;
+    layoutFor(texture) = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    // Make sure that all mips have whatever layout the texture had before this function was called. This is flushed right away
+    // as this function is also used on its own for single time commands.
+    requireTextureAccess(texture, finalLayout, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+    flushBarriers();
+
     endDebugLabel();
 }
 
@@ -466,7 +328,28 @@ void VulkanCommandList::executeBufferCopyOperations(std::vector<BufferCopyOperat
 
     beginDebugLabel(fmt::format("Execute buffer copy operations (x{})", copyOperations.size()));
 
-    std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers {};
+    // Declare all accesses up front so that a single barrier covers all of the copies. As the copy operations are
+    // independent of each other there is no need for barriers between them.
+    for (const BufferCopyOperation& copyOperation : copyOperations) {
+
+        if (copyOperation.size == 0)
+            continue;
+
+        requireBufferAccess(*static_cast<VulkanBuffer*>(copyOperation.srcBuffer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+        if (std::holds_alternative<BufferCopyOperation::BufferDestination>(copyOperation.destination)) {
+            auto const& copyDestination = std::get<BufferCopyOperation::BufferDestination>(copyOperation.destination);
+            requireBufferAccess(*static_cast<VulkanBuffer*>(copyDestination.buffer), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        } else if (std::holds_alternative<BufferCopyOperation::TextureDestination>(copyOperation.destination)) {
+            auto const& copyDestination = std::get<BufferCopyOperation::TextureDestination>(copyOperation.destination);
+            // NOTE: The *entire* texture is transitioned, so that all mips & layers have the same layout
+            requireTextureAccess(*static_cast<VulkanTexture*>(copyDestination.texture), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        }
+    }
+
+    flushBarriers();
+
     for (const BufferCopyOperation& copyOperation : copyOperations) {
 
         if (copyOperation.size == 0)
@@ -485,50 +368,10 @@ void VulkanCommandList::executeBufferCopyOperations(std::vector<BufferCopyOperat
 
             vkCmdCopyBuffer(m_commandBuffer, srcVkBuffer, dstVkBuffer, 1, &bufferCopyRegion);
 
-            VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
-            barrier.buffer = dstVkBuffer;
-            barrier.size = copyOperation.size;
-            barrier.offset = copyDestination.offset;
-
-            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-            bufferMemoryBarriers.push_back(barrier);
-
         } else if (std::holds_alternative<BufferCopyOperation::TextureDestination>(copyOperation.destination)) {
             auto const& copyDestination = std::get<BufferCopyOperation::TextureDestination>(copyOperation.destination);
             VulkanTexture& dstTexture = *static_cast<VulkanTexture*>(copyDestination.texture);
-
-            // Ensure that the *entire* texture is in the correct layout
-            if (dstTexture.currentLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-                VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                imageBarrier.image = dstTexture.image;
-                imageBarrier.subresourceRange.aspectMask = dstTexture.aspectMask();
-                imageBarrier.subresourceRange.baseMipLevel = 0;
-                imageBarrier.subresourceRange.levelCount = dstTexture.mipLevels();
-                imageBarrier.subresourceRange.baseArrayLayer = 0;
-                imageBarrier.subresourceRange.layerCount = dstTexture.layerCount();
-
-                VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-                imageBarrier.srcAccessMask = 0;
-
-                VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-                imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-                vkCmdPipelineBarrier(m_commandBuffer, sourceStage, destinationStage, 0,
-                                     0, nullptr,
-                                     0, nullptr,
-                                     1, &imageBarrier);
-
-                dstTexture.currentLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            }
+            ARKOSE_ASSERT(layoutFor(dstTexture) == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
             VkBufferImageCopy copyRegion = {};
 
@@ -560,12 +403,19 @@ void VulkanCommandList::executeBufferCopyOperations(std::vector<BufferCopyOperat
         }
     }
 
-    if (bufferMemoryBarriers.size() > 0) {
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
-                             0, nullptr,
-                             (uint32_t)bufferMemoryBarriers.size(), bufferMemoryBarriers.data(),
-                             0, nullptr);
+    // Copies into readback memory are read on the CPU once the frame has completed, so make them visible to the host
+    bool copiedToReadbackBuffer = false;
+    for (const BufferCopyOperation& copyOperation : copyOperations) {
+        if (auto const* copyDestination = std::get_if<BufferCopyOperation::BufferDestination>(&copyOperation.destination)) {
+            if (copyOperation.size > 0 && copyDestination->buffer->usage() == Buffer::Usage::Readback) {
+                requireBufferAccess(*static_cast<VulkanBuffer*>(copyDestination->buffer), VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+                copiedToReadbackBuffer = true;
+            }
+        }
+    }
+
+    if (copiedToReadbackBuffer) {
+        flushBarriers();
     }
 
     endDebugLabel();
@@ -619,112 +469,30 @@ void VulkanCommandList::beginRendering(const RenderState& genRenderState, ClearV
             clearValues.push_back(value);
     });
 
-    // TODO: What about imageless framebuffer? Then I guess we would want to transition those images instead? Or just assume they are already of the correct layout?
+    // Vertex, index & indirect buffers, as well as binding sets bound while rendering, aren't known up front, and we can't add
+    // any barriers within the render pass, so make all outstanding writes visible to the graphics stages before it begins.
+    requireOutstandingWritesVisible(VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, GraphicsReadAccessMask);
+
+    // We require textures that we render to to always have the optimal layout both as initial and final, so that we can
+    // do things like LoadOp::Load and then just always assume that we have e.g. color target optimal.
     for (auto& [genAttachedTexture, requiredLayout] : renderTarget.attachedTextures) {
         auto& attachedTexture = static_cast<VulkanTexture&>(*genAttachedTexture);
-
-        // We require textures that we render to to always have the optimal layout both as initial and final, so that we can
-        // do things like LoadOp::Load and then just always assume that we have e.g. color target optimal.
-        if (attachedTexture.currentLayout != requiredLayout) {
-
-            VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-            imageBarrier.oldLayout = attachedTexture.currentLayout;
-            imageBarrier.newLayout = requiredLayout;
-            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-            imageBarrier.image = attachedTexture.image;
-            imageBarrier.subresourceRange.aspectMask = attachedTexture.aspectMask();
-            imageBarrier.subresourceRange.baseMipLevel = 0;
-            imageBarrier.subresourceRange.levelCount = attachedTexture.mipLevels();
-            imageBarrier.subresourceRange.baseArrayLayer = 0;
-            imageBarrier.subresourceRange.layerCount = attachedTexture.layerCount();
-
-            VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-            imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
-
-            VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
-            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-
-            vkCmdPipelineBarrier(m_commandBuffer,
-                                 sourceStage, destinationStage, 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &imageBarrier);
-            attachedTexture.currentLayout = requiredLayout;
+        if (requiredLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+            requireTextureAccess(attachedTexture, requiredLayout,
+                                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+        } else {
+            requireTextureAccess(attachedTexture, requiredLayout,
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                 VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
         }
     }
 
-    // Explicitly transition the layouts of the referenced textures to an optimal layout (if it isn't already)
-    std::vector<VkImageMemoryBarrier> imageMemoryBarriers {};
-    renderState.stateBindings().forEachBinding([&](const ShaderBinding& bindingInfo) {
-        if (bindingInfo.type() == ShaderBindingType::SampledTexture) {
-            for (Texture const* texture : bindingInfo.getSampledTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture const&>(*texture);
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        } else if (bindingInfo.type() == ShaderBindingType::StorageTexture) {
-            for (TextureMipView textureMip : bindingInfo.getStorageTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture&>(textureMip.texture());
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_GENERAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    // NOTE: We always transition all mips so we can ensure our invariant of same layout accross mips holds.
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        }
+    renderState.stateBindings().forEachBindingSet([this](u32 setIndex, BindingSet& bindingSet) {
+        requireBindingSetAccess(bindingSet, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT);
     });
 
-    VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
-    vkCmdPipelineBarrier(m_commandBuffer,
-                         sourceStage, destinationStage, 0,
-                         0, nullptr,
-                         0, nullptr,
-                         (uint32_t)imageMemoryBarriers.size(), imageMemoryBarriers.data());
+    flushBarriers();
 
     VkRenderPassBeginInfo renderPassBeginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
 
@@ -850,82 +618,10 @@ void VulkanCommandList::setRayTracingState(const RayTracingState& rtState)
     activeRayTracingState = &rtState;
     activeComputeState = nullptr;
 
-    // Explicitly transition the layouts of the referenced textures to an optimal layout (if it isn't already)
-    std::vector<VkImageMemoryBarrier> imageMemoryBarriers {};
-    rtState.stateBindings().forEachBinding([&](const ShaderBinding& bindingInfo) {
-        if (bindingInfo.type() == ShaderBindingType::SampledTexture) {
-            for (Texture const* texture : bindingInfo.getSampledTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture const&>(*texture);
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        } else if (bindingInfo.type() == ShaderBindingType::StorageTexture) {
-            for (TextureMipView textureMip : bindingInfo.getStorageTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture&>(textureMip.texture());
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_GENERAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    // NOTE: We always transition all mips so we can ensure our invariant of same layout accross mips holds.
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        }
-    });
-
-    auto issuePipelineBarrierForRayTracingStateResources = [&](VkPipelineStageFlags destinationStage) {
-        VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             sourceStage, destinationStage, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             (uint32_t)imageMemoryBarriers.size(), imageMemoryBarriers.data());
-    };
-
     auto& khrRtState = static_cast<const VulkanRayTracingStateKHR&>(rtState);
-    issuePipelineBarrierForRayTracingStateResources(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
     vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, khrRtState.pipeline);
 
+    // NOTE: Binding the sets also declares their accesses, which are then synchronized before tracing rays
     rtState.stateBindings().forEachBindingSet([this](u32 setIndex, BindingSet& bindingSet) {
         bindSet(bindingSet, setIndex);
     });
@@ -944,77 +640,9 @@ void VulkanCommandList::setComputeState(const ComputeState& genComputeState)
     activeComputeState = &computeState;
     activeRayTracingState = nullptr;
 
-    // Explicitly transition the layouts of the referenced textures to an optimal layout (if it isn't already)
-    std::vector<VkImageMemoryBarrier> imageMemoryBarriers {};
-    computeState.stateBindings().forEachBinding([&](ShaderBinding const& bindingInfo) {
-        if (bindingInfo.type() == ShaderBindingType::SampledTexture) {
-            for (Texture const* texture : bindingInfo.getSampledTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture const&>(*texture);
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        } else if (bindingInfo.type() == ShaderBindingType::StorageTexture) {
-            for (TextureMipView textureMip : bindingInfo.getStorageTextures()) {
-                auto& vulkanTexture = static_cast<VulkanTexture&>(textureMip.texture());
-
-                constexpr VkImageLayout targetLayout = VK_IMAGE_LAYOUT_GENERAL;
-                if (vulkanTexture.currentLayout != targetLayout) {
-
-                    VkImageMemoryBarrier imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-                    imageBarrier.oldLayout = vulkanTexture.currentLayout;
-                    imageBarrier.newLayout = targetLayout;
-                    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-                    // NOTE: We always transition all mips so we can ensure our invariant of same layout accross mips holds.
-                    imageBarrier.image = vulkanTexture.image;
-                    imageBarrier.subresourceRange.aspectMask = vulkanTexture.aspectMask();
-                    imageBarrier.subresourceRange.baseMipLevel = 0;
-                    imageBarrier.subresourceRange.levelCount = vulkanTexture.mipLevels();
-                    imageBarrier.subresourceRange.baseArrayLayer = 0;
-                    imageBarrier.subresourceRange.layerCount = vulkanTexture.layerCount();
-
-                    imageBarrier.srcAccessMask = 0;
-                    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT; // FIXME: Maybe memory read & write?
-
-                    imageMemoryBarriers.push_back(imageBarrier);
-                    vulkanTexture.currentLayout = targetLayout;
-                }
-            }
-        }
-    });
-
-    if (imageMemoryBarriers.size() > 0) {
-        vkCmdPipelineBarrier(m_commandBuffer,
-                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             narrow_cast<u32>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
-    }
-
     vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeState.pipeline);
 
+    // NOTE: Binding the sets also declares their accesses, which are then synchronized before dispatching
     computeState.stateBindings().forEachBindingSet([this](u32 setIndex, BindingSet& bindingSet) {
         bindSet(bindingSet, setIndex);
     });
@@ -1024,6 +652,11 @@ void VulkanCommandList::evaluateExternalFeature(ExternalFeature const& externalF
 {
     SCOPED_PROFILE_ZONE_GPUCOMMAND();
 
+    // External features record their own commands for resources we pass to them, so they are fully synchronized. They also
+    // transition the layouts of those resources themselves, so they can't be used with deferred resource states.
+    ARKOSE_ASSERT(m_resourceStateTracking == ResourceStateTracking::Immediate);
+    synchronizeAllAccesses();
+
     switch (externalFeature.type()) {
     case ExternalFeatureType::None:
         ARKOSE_LOG(Fatal, "Trying to evaluate an external feature of type None, which shouldn't be created in the first place.");
@@ -1049,6 +682,9 @@ void VulkanCommandList::evaluateExternalFeature(ExternalFeature const& externalF
         #endif
     } break;
     }
+
+    m_recordedSinceFullBarrier = true;
+    synchronizeAllAccesses();
 }
 
 void VulkanCommandList::bindSet(BindingSet& bindingSet, u32 index)
@@ -1065,6 +701,11 @@ void VulkanCommandList::bindSet(BindingSet& bindingSet, u32 index)
     VkPipelineLayout pipelineLayout = pipelinePair.first;
     VkPipelineBindPoint bindPoint = pipelinePair.second;
 
+    // The accesses of render state binding sets are declared when beginning rendering, see also bindTextureSet(..)
+    if (!activeRenderState) {
+        requireBindingSetAccess(bindingSet, currentlyBoundShaderStages());
+    }
+
     auto& vulkanBindingSet = static_cast<VulkanBindingSet&>(bindingSet);
     vkCmdBindDescriptorSets(m_commandBuffer, bindPoint, pipelineLayout, index, 1, &vulkanBindingSet.descriptorSet, 0, nullptr);
 }
@@ -1085,6 +726,13 @@ void VulkanCommandList::bindTextureSet(BindingSet& bindingSet, u32 index)
         //              || vulkanTexture->currentLayout == VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL
         //              || vulkanTexture->currentLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
         //              || vulkanTexture->currentLayout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL);
+
+        // Within a render pass these reads can't be synchronized, but it's already taken care of when beginning rendering
+        if (activeRenderState) {
+            for (Texture const* texture : shaderBinding.getSampledTextures()) {
+                noteRenderPassRead(accessStateFor(*static_cast<VulkanTexture const*>(texture)), VK_ACCESS_SHADER_READ_BIT, texture->name());
+            }
+        }
     }
 
     bindSet(bindingSet, index);
@@ -1125,6 +773,23 @@ void VulkanCommandList::setNamedUniform(const std::string& name, void const* dat
     }
 }
 
+void VulkanCommandList::setNamedUniform(NamedConstantHandle constantHandle, void const* data, size_t size)
+{
+    SCOPED_PROFILE_ZONE_GPUCOMMAND();
+
+    if (!activeRenderState && !activeRayTracingState && !activeComputeState) {
+        ARKOSE_LOG(Fatal, "VulkanCommandList: no active render or compute or ray tracing state for setting named uniform");
+    }
+
+    // Already validated when resolved
+    ARKOSE_ASSERT(constantHandle.valid());
+    ARKOSE_ASSERT(constantHandle.size == size);
+
+    VkPipelineLayout pipelineLayout = currentlyBoundPipelineLayout().first;
+    VkShaderStageFlags stageFlags = backend().shaderStageToVulkanShaderStageFlags(constantHandle.stages);
+    vkCmdPushConstants(m_commandBuffer, pipelineLayout, stageFlags, constantHandle.offset, constantHandle.size, data);
+}
+
 void VulkanCommandList::draw(u32 vertexCount, u32 firstVertex)
 {
     SCOPED_PROFILE_ZONE_GPUCOMMAND();
@@ -1177,14 +842,16 @@ void VulkanCommandList::drawIndirect(const Buffer& indirectBuffer, const Buffer&
         ARKOSE_LOG(Fatal, "drawIndirect: supplied count buffer is not an indirect buffer!");
     }
 
-    VkBuffer vulkanIndirectBuffer = static_cast<const VulkanBuffer&>(indirectBuffer).buffer;
-    VkBuffer vulkanCountBuffer = static_cast<const VulkanBuffer&>(countBuffer).buffer;
+    auto const& vulkanIndirectBuffer = static_cast<const VulkanBuffer&>(indirectBuffer);
+    auto const& vulkanCountBuffer = static_cast<const VulkanBuffer&>(countBuffer);
+    noteRenderPassRead(accessStateFor(vulkanIndirectBuffer), VK_ACCESS_INDIRECT_COMMAND_READ_BIT, indirectBuffer.name());
+    noteRenderPassRead(accessStateFor(vulkanCountBuffer), VK_ACCESS_INDIRECT_COMMAND_READ_BIT, countBuffer.name());
 
     // TODO: Parameterize these maybe? Now we assume that they are packed etc.
     uint32_t indirectDataStride = sizeof(IndexedDrawCmd);
     uint32_t maxDrawCount = (uint32_t)indirectBuffer.size() / indirectDataStride;
 
-    vkCmdDrawIndexedIndirectCount(m_commandBuffer, vulkanIndirectBuffer, 0u, vulkanCountBuffer, 0u, maxDrawCount, indirectDataStride);
+    vkCmdDrawIndexedIndirectCount(m_commandBuffer, vulkanIndirectBuffer.buffer, 0u, vulkanCountBuffer.buffer, 0u, maxDrawCount, indirectDataStride);
 }
 
 void VulkanCommandList::drawMeshTasks(u32 groupCountX, u32 groupCountY, u32 groupCountZ)
@@ -1222,15 +889,17 @@ void VulkanCommandList::drawMeshTasksIndirect(Buffer const& indirectBuffer, u32
         ARKOSE_LOG(Fatal, "drawMeshTasksIndirect: supplied count buffer is not an indirect buffer!");
     }
 
-    VkBuffer vulkanIndirectBuffer = static_cast<const VulkanBuffer&>(indirectBuffer).buffer;
-    VkBuffer vulkanCountBuffer = static_cast<const VulkanBuffer&>(countBuffer).buffer;
+    auto const& vulkanIndirectBuffer = static_cast<const VulkanBuffer&>(indirectBuffer);
+    auto const& vulkanCountBuffer = static_cast<const VulkanBuffer&>(countBuffer);
+    noteRenderPassRead(accessStateFor(vulkanIndirectBuffer), VK_ACCESS_INDIRECT_COMMAND_READ_BIT, indirectBuffer.name());
+    noteRenderPassRead(accessStateFor(vulkanCountBuffer), VK_ACCESS_INDIRECT_COMMAND_READ_BIT, countBuffer.name());
 
     ARKOSE_ASSERT(indirectDataStride >= 3 * sizeof(u32));
     u32 maxDrawCount = narrow_cast<u32>(indirectBuffer.size() - indirectDataOffset) / indirectDataStride;
 
     backend().meshShaderEXT().vkCmdDrawMeshTasksIndirectCountEXT(m_commandBuffer,
-                                                                 vulkanIndirectBuffer, indirectDataOffset,
-                                                                 vulkanCountBuffer, countDataOffset,
+                                                                 vulkanIndirectBuffer.buffer, indirectDataOffset,
+                                                                 vulkanCountBuffer.buffer, countDataOffset,
                                                                  maxDrawCount, indirectDataStride);
 }
 
@@ -1279,7 +948,10 @@ void VulkanCommandList::bindVertexBuffer(Buffer const& vertexBuffer, size_t stri
     if (vertexBuffer.usage() != Buffer::Usage::Vertex)
         ARKOSE_LOG(Fatal, "bindVertexBuffer: not a vertex buffer!");
 
-    VkBuffer vulkanBuffer = static_cast<const VulkanBuffer&>(vertexBuffer).buffer;
+    auto const& vulkanVertexBuffer = static_cast<const VulkanBuffer&>(vertexBuffer);
+    noteRenderPassRead(accessStateFor(vulkanVertexBuffer), VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, vertexBuffer.name());
+
+    VkBuffer vulkanBuffer = vulkanVertexBuffer.buffer;
     if (m_boundVertexBuffer == vulkanBuffer)
         return;
 
@@ -1297,7 +969,10 @@ void VulkanCommandList::bindIndexBuffer(Buffer const& indexBuffer, IndexType ind
     if (indexBuffer.usage() != Buffer::Usage::Index)
         ARKOSE_LOG(Fatal, "bindIndexBuffer: not an index buffer!");
 
-    VkBuffer vulkanBuffer = static_cast<const VulkanBuffer&>(indexBuffer).buffer;
+    auto const& vulkanIndexBuffer = static_cast<const VulkanBuffer&>(indexBuffer);
+    noteRenderPassRead(accessStateFor(vulkanIndexBuffer), VK_ACCESS_INDEX_READ_BIT, indexBuffer.name());
+
+    VkBuffer vulkanBuffer = vulkanIndexBuffer.buffer;
     if (m_boundIndexBuffer == vulkanBuffer) {
         return;
     }
@@ -1349,9 +1024,15 @@ void VulkanCommandList::buildTopLevelAcceratationStructure(TopLevelAS& tlas, Acc
 
     beginDebugLabel("Rebuild TLAS");
 
+    // Acceleration structure builds access buffers we don't track, so they are fully synchronized
+    synchronizeAllAccesses();
+
     auto& khrTlas = static_cast<VulkanTopLevelASKHR&>(tlas);
     khrTlas.build(m_commandBuffer, buildType);
 
+    m_recordedSinceFullBarrier = true;
+    synchronizeAllAccesses();
+
     endDebugLabel();
 }
 
@@ -1364,9 +1045,14 @@ void VulkanCommandList::buildBottomLevelAcceratationStructure(BottomLevelAS& bla
 
     beginDebugLabel("Rebuild BLAS");
 
+    synchronizeAllAccesses();
+
     auto& khrBlas = static_cast<VulkanBottomLevelASKHR&>(blas);
     khrBlas.build(m_commandBuffer, buildType);
 
+    m_recordedSinceFullBarrier = true;
+    synchronizeAllAccesses();
+
     endDebugLabel();
 }
 
@@ -1382,8 +1068,13 @@ void VulkanCommandList::copyBottomLevelAcceratationStructure(BottomLevelAS& dst,
     auto& khrDstBlas = static_cast<VulkanBottomLevelASKHR&>(dst);
     auto const& khrSrcBlas = static_cast<VulkanBottomLevelASKHR const&>(src);
 
+    synchronizeAllAccesses();
+
     khrDstBlas.copyFrom(m_commandBuffer, khrSrcBlas);
 
+    m_recordedSinceFullBarrier = true;
+    synchronizeAllAccesses();
+
     endDebugLabel();
 }
 
@@ -1395,8 +1086,13 @@ bool VulkanCommandList::compactBottomLevelAcceratationStructure(BottomLevelAS& b
         ARKOSE_LOG(Fatal, "Trying to compact a bottom level acceleration structure but there is no ray tracing support!");
 
     beginDebugLabel("Compact BLAS");
+    synchronizeAllAccesses();
+
     auto& khrBlas = static_cast<VulkanBottomLevelASKHR&>(blas);
     bool completed = khrBlas.compact(m_commandBuffer);
+
+    m_recordedSinceFullBarrier = true;
+    synchronizeAllAccesses();
     endDebugLabel();
 
     return completed;
@@ -1411,6 +1107,8 @@ void VulkanCommandList::traceRays(Extent2D extent)
     if (!backend().hasRayTracingSupport())
         ARKOSE_LOG(Fatal, "Trying to trace rays but there is no ray tracing support!");
 
+    flushBarriers();
+
     auto& khrRtState = static_cast<const VulkanRayTracingStateKHR&>(*activeRayTracingState);
     khrRtState.traceRaysWithShaderOnlySBT(m_commandBuffer, extent);
 }
@@ -1422,6 +1120,8 @@ void VulkanCommandList::dispatch(uint32_t x, uint32_t y, uint32_t z)
     if (!activeComputeState) {
         ARKOSE_LOG(Fatal, "Trying to dispatch compute but there is no active compute state!");
     }
+
+    flushBarriers();
     vkCmdDispatch(m_commandBuffer, x, y, z);
 }
 
@@ -1557,119 +1257,468 @@ void VulkanCommandList::endDebugLabel()
 void VulkanCommandList::textureWriteBarrier(const Texture& genTexture)
 {
     auto& texture = static_cast<const VulkanTexture&>(genTexture);
+    VulkanAccessState& accessState = accessStateFor(texture);
 
-    if (texture.currentLayout == VK_IMAGE_LAYOUT_PREINITIALIZED || texture.currentLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        // Texture has no valid data written to it, so this barrier can be a no-op
+    if (accessState.writeStages == 0) {
+        // Texture has no data written to it since the last full barrier, so this barrier can be a no-op
         return;
     }
 
-    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-    barrier.image = texture.image;
+    // The writes must finish before any later memory access by the following commands, which reuse the current state and therefore
+    // don't declare their accesses again. The write is still considered outstanding, as those commands might write to it again.
+    VkPipelineStageFlags stages = accessState.writeStages | accessState.readStages;
+    addPendingDependency(stages, accessState.writeAccess, stages, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+}
 
-    // no layout transitions
-    barrier.oldLayout = texture.currentLayout;
-    barrier.newLayout = texture.currentLayout;
+void VulkanCommandList::textureMipWriteBarrier(const Texture& genTexture, uint32_t mip)
+{
+    // NOTE: Accesses are tracked per texture, not per mip, so this is the same as a barrier for the whole texture
+    textureWriteBarrier(genTexture);
+}
 
-    // all texture writes must finish before any later memory access (r/w)
-    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+void VulkanCommandList::bufferWriteBarrier(std::vector<Buffer const*> buffers)
+{
+    for (Buffer const* buffer : buffers) {
+        VulkanAccessState& accessState = accessStateFor(*static_cast<VulkanBuffer const*>(buffer));
 
-    barrier.subresourceRange.aspectMask = texture.aspectMask();
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = texture.layerCount();
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = texture.mipLevels();
+        // Just like for textures, see textureWriteBarrier(..)
+        if (accessState.writeStages != 0) {
+            VkPipelineStageFlags stages = accessState.writeStages | accessState.readStages;
+            addPendingDependency(stages, accessState.writeAccess, stages, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+        }
+    }
+}
 
-    vkCmdPipelineBarrier(m_commandBuffer,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         0,
+void VulkanCommandList::textureAliasingBarrier(const Texture& genTexture)
+{
+    auto& texture = static_cast<const VulkanTexture&>(genTexture);
+
+    // We don't know which textures have used the shared memory before, so all earlier accesses must finish before this texture
+    // is used. This is batched with the barriers of the first command using the texture.
+    addPendingDependency(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+
+    // The contents are no longer valid, so transition from the undefined layout on next use
+    layoutFor(texture) = VK_IMAGE_LAYOUT_UNDEFINED;
+    accessStateFor(texture) = VulkanAccessState { .epoch = m_trackingEpoch };
+
+    if (m_resourceStateTracking == ResourceStateTracking::Deferred) {
+        // The earlier contents (and layout) are discarded, so there's nothing to return to
+        m_deferredTextureStates[&texture].restoreEntryLayout = false;
+    }
+}
+
+void VulkanCommandList::endNode(Badge<class VulkanBackend>)
+{
+    endCurrentRenderPassIfAny();
+
+    // NOTE: Any pending barriers are left to be batched with the barriers of the next node
+
+    m_barrierStats.nodeCount += 1;
+
+    if constexpr (vulkanBarrierValidation) {
+        // The old conservative behaviour, so that any rendering issue can be narrowed down to the inferred barriers by toggling validation
+        debugBarrier();
+    }
+}
+
+void VulkanCommandList::endAllNodes(Badge<class VulkanBackend>)
+{
+    endCurrentRenderPassIfAny();
+
+    // For deferred resource states any pending barriers are instead recorded by resolveDeferredExitStates(..)
+    if (m_resourceStateTracking == ResourceStateTracking::Immediate) {
+        synchronizeAllAccesses();
+    }
+
+    if constexpr (vulkanBarrierValidation) {
+        ARKOSE_LOG(Info, "Barrier validation: inferred {} pipeline barriers (with {} image barriers) and {} full barriers for {} nodes, "
+                         "where the conservative behaviour would add a full barrier after every node on top of its own barriers",
+                   m_barrierStats.pipelineBarrierCount, m_barrierStats.imageBarrierCount, m_barrierStats.fullBarrierCount, m_barrierStats.nodeCount);
+    }
+}
+
+void VulkanCommandList::resolveDeferredEntryStates(Badge<class VulkanBackend>, VkCommandBuffer commandBuffer)
+{
+    ARKOSE_ASSERT(m_resourceStateTracking == ResourceStateTracking::Deferred);
+
+    std::vector<VkImageMemoryBarrier> imageBarriers {};
+    for (auto& [texture, deferredState] : m_deferredTextureStates) {
+        deferredState.resolvedEntryLayout = texture->currentLayout;
+
+        if (deferredState.entryLayout != DeferredEntryLayout && deferredState.entryLayout != texture->currentLayout) {
+            VkImageMemoryBarrier imageBarrier = wholeTextureLayoutTransition(*texture, texture->currentLayout, deferredState.entryLayout);
+            imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            imageBarriers.push_back(imageBarrier);
+
+            texture->currentLayout = deferredState.entryLayout;
+        }
+    }
+
+    // We know nothing about the accesses before this command list, so synchronize with all of them
+    VkMemoryBarrier memoryBarrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1, &memoryBarrier,
                          0, nullptr,
+                         static_cast<u32>(imageBarriers.size()), imageBarriers.data());
+}
+
+void VulkanCommandList::resolveDeferredExitStates(Badge<class VulkanBackend>, VkCommandBuffer commandBuffer)
+{
+    ARKOSE_ASSERT(m_resourceStateTracking == ResourceStateTracking::Deferred);
+    ARKOSE_ASSERT(activeRenderState == nullptr);
+
+    // Any barriers still pending at the end of the command list are recorded here, as the layouts are already applied to the states
+    std::vector<VkImageMemoryBarrier> imageBarriers = std::move(m_pendingImageBarriers);
+    m_pendingImageBarriers.clear();
+
+    for (auto& [texture, deferredState] : m_deferredTextureStates) {
+
+        // If it was never transitioned it's still in the layout it had before the command list
+        if (deferredState.layout == DeferredEntryLayout) {
+            continue;
+        }
+
+        VkImageLayout finalLayout = deferredState.layout;
+
+        // We never want to transition anything back to undefined, so then it's left in whatever layout it has now
+        VkImageLayout entryLayout = deferredState.resolvedEntryLayout;
+        bool canRestoreEntryLayout = entryLayout != VK_IMAGE_LAYOUT_UNDEFINED && entryLayout != VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+        if (deferredState.restoreEntryLayout && canRestoreEntryLayout && entryLayout != finalLayout) {
+            auto pendingBarrier = std::find_if(imageBarriers.begin(), imageBarriers.end(), [&](VkImageMemoryBarrier const& barrier) {
+                return barrier.image == texture->image;
+            });
+
+            if (pendingBarrier != imageBarriers.end()) {
+                pendingBarrier->newLayout = entryLayout;
+            } else {
+                VkImageMemoryBarrier imageBarrier = wholeTextureLayoutTransition(*texture, finalLayout, entryLayout);
+                imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+                imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                imageBarriers.push_back(imageBarrier);
+            }
+
+            finalLayout = entryLayout;
+        }
+
+        texture->currentLayout = finalLayout;
+    }
+
+    // We know nothing about the accesses after this command list, so synchronize with all of them
+    VkMemoryBarrier memoryBarrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1, &memoryBarrier,
                          0, nullptr,
-                         1, &barrier);
+                         static_cast<u32>(imageBarriers.size()), imageBarriers.data());
+
+    m_pendingSrcStages = 0;
+    m_pendingDstStages = 0;
+    m_pendingSrcAccess = 0;
+    m_pendingDstAccess = 0;
 }
 
-void VulkanCommandList::textureMipWriteBarrier(const Texture& genTexture, uint32_t mip)
+void VulkanCommandList::endCurrentRenderPassIfAny()
 {
-    auto& texture = static_cast<const VulkanTexture&>(genTexture);
+    if (activeRenderState) {
+        vkCmdEndRenderPass(m_commandBuffer);
+        activeRenderState = nullptr;
+    }
+}
+
+VulkanAccessState& VulkanCommandList::currentAccessState(VulkanAccessState& accessState)
+{
+    // Anything recorded in an earlier epoch has been synchronized by a full barrier, so it's as if it was never accessed
+    if (accessState.epoch != m_trackingEpoch) {
+        accessState = VulkanAccessState { .epoch = m_trackingEpoch };
+    }
+    return accessState;
+}
+
+VulkanAccessState& VulkanCommandList::accessStateFor(VulkanBuffer const& buffer)
+{
+    if (m_resourceStateTracking == ResourceStateTracking::Deferred) {
+        return currentAccessState(m_deferredBufferStates[&buffer]);
+    }
+    return currentAccessState(buffer.accessState);
+}
 
-    if (texture.currentLayout == VK_IMAGE_LAYOUT_PREINITIALIZED || texture.currentLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        // Texture has no valid data written to it, so this barrier can be a no-op
+VulkanAccessState& VulkanCommandList::accessStateFor(VulkanTexture const& texture)
+{
+    if (m_resourceStateTracking == ResourceStateTracking::Deferred) {
+        return currentAccessState(m_deferredTextureStates[&texture].accessState);
+    }
+    return currentAccessState(texture.accessState);
+}
+
+VkImageLayout& VulkanCommandList::layoutFor(VulkanTexture const& texture)
+{
+    if (m_resourceStateTracking == ResourceStateTracking::Deferred) {
+        return m_deferredTextureStates[&texture].layout;
+    }
+    return texture.currentLayout;
+}
+
+void VulkanCommandList::addPendingDependency(VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+{
+    m_pendingSrcStages |= srcStages;
+    m_pendingSrcAccess |= srcAccess;
+    m_pendingDstStages |= dstStages;
+    m_pendingDstAccess |= dstAccess;
+}
+
+void VulkanCommandList::recordWrite(VulkanAccessState& accessState, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    accessState.writeStages = stages;
+    accessState.writeAccess = access & WriteAccessMask;
+    accessState.visibleStages = 0;
+    accessState.visibleAccess = 0;
+    accessState.readStages = 0;
+
+    m_outstandingWrites.push_back(&accessState);
+}
+
+void VulkanCommandList::requireMemoryAccess(VulkanAccessState& accessState, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    if (access & WriteAccessMask) {
+        // Wait for the last write (WAW) and all reads since (WAR) to finish, and make the last write available
+        VkPipelineStageFlags waitStages = accessState.writeStages | accessState.readStages;
+        if (waitStages != 0) {
+            addPendingDependency(waitStages, accessState.writeAccess, stages, access);
+        }
+        recordWrite(accessState, stages, access);
+    } else {
+        // Only wait for the last write (RAW), and only if it's not already visible to these stages & accesses
+        bool lastWriteVisible = (stages & ~accessState.visibleStages) == 0 && (access & ~accessState.visibleAccess) == 0;
+        if (accessState.writeStages != 0 && !lastWriteVisible) {
+            addPendingDependency(accessState.writeStages, accessState.writeAccess, stages, access);
+            accessState.visibleStages |= stages;
+            accessState.visibleAccess |= access;
+        }
+        accessState.readStages |= stages;
+    }
+}
+
+void VulkanCommandList::requireBufferAccess(VulkanBuffer const& buffer, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    requireMemoryAccess(accessStateFor(buffer), stages, access);
+}
+
+void VulkanCommandList::requireTextureAccess(VulkanTexture const& texture, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    VulkanAccessState& accessState = accessStateFor(texture);
+    VkImageLayout& currentLayout = layoutFor(texture);
+
+    DeferredTextureState* deferredState = nullptr;
+    if (m_resourceStateTracking == ResourceStateTracking::Deferred) {
+        deferredState = &m_deferredTextureStates[&texture];
+
+        if (layout == DeferredEntryLayout) {
+            // Returning to the layout from before this command list, which is only known once resolved (see resolveDeferredExitStates)
+            if (currentLayout != DeferredEntryLayout) {
+                deferredState->restoreEntryLayout = true;
+            }
+            return;
+        }
+
+        if (currentLayout == DeferredEntryLayout) {
+            // First access in this command list, so the transition into this layout is made before it (see resolveDeferredEntryStates)
+            deferredState->entryLayout = layout;
+            currentLayout = layout;
+        }
+    }
+
+    if (currentLayout == layout) {
+        requireMemoryAccess(accessState, stages, access);
         return;
     }
 
-    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-    barrier.image = texture.image;
+    // Barriers within one pipeline barrier command are unordered, so if this image is already transitioned by a pending
+    // barrier we have to extend that barrier instead of adding a second one for the same image.
+    auto pendingBarrier = std::find_if(m_pendingImageBarriers.begin(), m_pendingImageBarriers.end(), [&](VkImageMemoryBarrier const& barrier) {
+        return barrier.image == texture.image;
+    });
 
-    // no layout transitions
-    barrier.oldLayout = texture.currentLayout;
-    barrier.newLayout = texture.currentLayout;
+    if (pendingBarrier != m_pendingImageBarriers.end()) {
+        pendingBarrier->newLayout = layout;
+        pendingBarrier->dstAccessMask |= access;
+    } else {
+        VkImageMemoryBarrier imageBarrier = wholeTextureLayoutTransition(texture, currentLayout, layout);
+        imageBarrier.srcAccessMask = accessState.writeAccess;
+        imageBarrier.dstAccessMask = access;
+        m_pendingImageBarriers.push_back(imageBarrier);
+    }
 
-    // all texture writes must finish before any later memory access (r/w)
-    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    // A layout transition is a write, so it must wait for all earlier accesses, and all later accesses must wait for it
+    addPendingDependency(accessState.writeStages | accessState.readStages, 0, stages, 0);
+    currentLayout = layout;
 
-    barrier.subresourceRange.aspectMask = texture.aspectMask();
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = texture.layerCount();
-    barrier.subresourceRange.baseMipLevel = mip;
-    barrier.subresourceRange.levelCount = 1;
+    if (deferredState) {
+        // Explicitly transitioned after returning to the entry layout, so this is now the layout it's left in
+        deferredState->restoreEntryLayout = false;
+    }
 
-    vkCmdPipelineBarrier(m_commandBuffer,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
+    recordWrite(accessState, stages, access);
+    if ((access & WriteAccessMask) == 0) {
+        accessState.visibleStages = stages;
+        accessState.visibleAccess = access;
+        accessState.readStages = stages;
+    }
 }
 
-void VulkanCommandList::bufferWriteBarrier(std::vector<Buffer const*> buffers)
+void VulkanCommandList::requireBindingSetAccess(BindingSet const& bindingSet, VkPipelineStageFlags stages)
+{
+    for (ShaderBinding const& bindingInfo : bindingSet.shaderBindings()) {
+        switch (bindingInfo.type()) {
+        case ShaderBindingType::ConstantBuffer:
+            for (Buffer const* buffer : bindingInfo.getBuffers()) {
+                requireBufferAccess(static_cast<VulkanBuffer const&>(*buffer), stages, VK_ACCESS_UNIFORM_READ_BIT);
+            }
+            break;
+        case ShaderBindingType::StorageBuffer: {
+            VkAccessFlags access = bindingInfo.storageBufferIsReadonly()
+                ? VK_ACCESS_SHADER_READ_BIT
+                : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            for (Buffer const* buffer : bindingInfo.getBuffers()) {
+                if (buffer != nullptr) {
+                    requireBufferAccess(static_cast<VulkanBuffer const&>(*buffer), stages, access);
+                }
+            }
+        } break;
+        case ShaderBindingType::SampledTexture:
+            for (Texture const* texture : bindingInfo.getSampledTextures()) {
+                if (texture != nullptr) {
+                    requireTextureAccess(static_cast<VulkanTexture const&>(*texture), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, stages, VK_ACCESS_SHADER_READ_BIT);
+                }
+            }
+            break;
+        case ShaderBindingType::StorageTexture:
+            for (TextureMipView const& textureMip : bindingInfo.getStorageTextures()) {
+                requireTextureAccess(static_cast<VulkanTexture const&>(textureMip.texture()), VK_IMAGE_LAYOUT_GENERAL, stages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+            }
+            break;
+        case ShaderBindingType::RTAccelerationStructure:
+            // Acceleration structures are only written by builds, which are fully synchronized (see buildTopLevelAcceratationStructure)
+            break;
+        }
+    }
+}
+
+void VulkanCommandList::requireOutstandingWritesVisible(VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    for (VulkanAccessState* accessState : m_outstandingWrites) {
+        if (accessState->epoch != m_trackingEpoch || accessState->writeStages == 0) {
+            continue;
+        }
+
+        bool alreadyVisible = (stages & ~accessState->visibleStages) == 0 && (access & ~accessState->visibleAccess) == 0;
+        if (!alreadyVisible) {
+            addPendingDependency(accessState->writeStages, accessState->writeAccess, stages, access);
+            accessState->visibleStages |= stages;
+            accessState->visibleAccess |= access;
+        }
+
+        // We can't know if the resource is actually read (e.g. bindless), so assume it is, so that the next write waits for it
+        accessState->readStages |= stages;
+    }
+
+    m_outstandingWrites.clear();
+}
+
+void VulkanCommandList::flushBarriers()
 {
-    if (buffers.size() == 0)
+    m_recordedSinceFullBarrier = true;
+
+    if (m_pendingDstStages == 0) {
+        ARKOSE_ASSERT(m_pendingImageBarriers.empty());
         return;
+    }
 
-    std::vector<VkBufferMemoryBarrier> barriers {};
-    barriers.resize(buffers.size());
+    // With no earlier accesses to wait for (e.g. the first transition of a texture) we still need a valid source stage
+    VkPipelineStageFlags srcStages = m_pendingSrcStages != 0 ? m_pendingSrcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
 
-    for (int i = 0; i < buffers.size(); ++i) {
-        Buffer const& buffer = *buffers[i];
+    VkMemoryBarrier memoryBarrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    memoryBarrier.srcAccessMask = m_pendingSrcAccess;
+    memoryBarrier.dstAccessMask = m_pendingDstAccess;
+    bool needsMemoryBarrier = m_pendingSrcAccess != 0 || m_pendingDstAccess != 0;
 
-        VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
-        barrier.buffer = static_cast<VulkanBuffer const&>(buffer).buffer;
+    vkCmdPipelineBarrier(m_commandBuffer, srcStages, m_pendingDstStages, 0,
+                         needsMemoryBarrier ? 1 : 0, needsMemoryBarrier ? &memoryBarrier : nullptr,
+                         0, nullptr,
+                         static_cast<u32>(m_pendingImageBarriers.size()), m_pendingImageBarriers.data());
 
-        // the whole range
-        barrier.offset = 0;
-        barrier.size = buffer.size();
+    m_barrierStats.pipelineBarrierCount += 1;
+    m_barrierStats.imageBarrierCount += static_cast<u32>(m_pendingImageBarriers.size());
 
-        // all writes must finish before any later memory access (r/w)
-        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    m_pendingSrcStages = 0;
+    m_pendingDstStages = 0;
+    m_pendingSrcAccess = 0;
+    m_pendingDstAccess = 0;
+    m_pendingImageBarriers.clear();
+}
 
-        barriers[i] = barrier;
+void VulkanCommandList::synchronizeAllAccesses()
+{
+    if (!m_recordedSinceFullBarrier && m_pendingDstStages == 0) {
+        return;
     }
 
-    vkCmdPipelineBarrier(m_commandBuffer,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         0,
+    VkMemoryBarrier memoryBarrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1, &memoryBarrier,
                          0, nullptr,
-                         (uint32_t)barriers.size(), barriers.data(),
-                         0, nullptr);
+                         static_cast<u32>(m_pendingImageBarriers.size()), m_pendingImageBarriers.data());
+
+    m_barrierStats.fullBarrierCount += 1;
+    m_barrierStats.imageBarrierCount += static_cast<u32>(m_pendingImageBarriers.size());
+
+    m_pendingSrcStages = 0;
+    m_pendingDstStages = 0;
+    m_pendingSrcAccess = 0;
+    m_pendingDstAccess = 0;
+    m_pendingImageBarriers.clear();
+
+    // Everything is now synchronized, so start over with a new epoch, which implicitly resets all access states
+    m_trackingEpoch = s_nextTrackingEpoch++;
+    m_outstandingWrites.clear();
+    m_recordedSinceFullBarrier = false;
 }
 
-void VulkanCommandList::endNode(Badge<class VulkanBackend>)
+void VulkanCommandList::noteRenderPassRead(VulkanAccessState& currentState, VkAccessFlags access, std::string_view resourceName)
 {
-    endCurrentRenderPassIfAny();
-    debugBarrier(); // TODO: We probably don't need to do this..?
+    if constexpr (vulkanBarrierValidation) {
+        bool lastWriteVisible = (VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT & ~currentState.visibleStages) == 0 && (access & ~currentState.visibleAccess) == 0;
+        if (currentState.writeStages != 0 && !lastWriteVisible) {
+            ARKOSE_LOG(Warning, "Barrier validation: '{}' is read within a render pass but its last write is not visible to it", resourceName);
+        }
+    }
+
+    currentState.readStages |= VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
 }
 
-void VulkanCommandList::endCurrentRenderPassIfAny()
+VkPipelineStageFlags VulkanCommandList::currentlyBoundShaderStages() const
 {
     if (activeRenderState) {
-        vkCmdEndRenderPass(m_commandBuffer);
-        activeRenderState = nullptr;
+        return VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
     }
+    if (activeComputeState) {
+        return VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    if (activeRayTracingState) {
+        return VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+    }
+
+    ASSERT_NOT_REACHED();
 }
 
 void VulkanCommandList::transitionImageLayoutDEBUG(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags imageAspectMask, VkCommandBuffer commandBuffer) const
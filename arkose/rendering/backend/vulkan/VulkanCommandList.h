@@ -1,17 +1,31 @@
 #include "rendering/backend/base/CommandList.h"
 
+#include "VulkanAccessState.h"
 #include "VulkanBackend.h"
 
 #if defined(TRACY_ENABLE)
 #include <tracy/TracyVulkan.hpp>
 #endif
 
+#include <atomic>
+#include <unordered_map>
+
+struct VulkanBuffer;
 struct VulkanComputeState;
 struct VulkanRenderState;
+struct VulkanTexture;
 
 class VulkanCommandList final : public CommandList {
 public:
-    explicit VulkanCommandList(VulkanBackend&, VkCommandBuffer);
+    // Command lists recorded in parallel with other command lists can't know the layouts & access states that the resources will
+    // have when they execute, so they track them locally instead (deferred). Before submitting, such a command list must be resolved
+    // against the real states, in submission order, see resolveDeferredEntryStates(..) & resolveDeferredExitStates(..).
+    enum class ResourceStateTracking {
+        Immediate,
+        Deferred,
+    };
+
+    explicit VulkanCommandList(VulkanBackend&, VkCommandBuffer, ResourceStateTracking = ResourceStateTracking::Immediate);
 
     void fillBuffer(Buffer&, u32 fillValue) override;
     void clearTexture(Texture&, ClearValue) override;
@@ -34,6 +48,7 @@ public:
     void bindTextureSet(BindingSet&, u32 index) override;
 
     void setNamedUniform(const std::string& name, void const* data, size_t size) override;
+    void setNamedUniform(NamedConstantHandle, void const* data, size_t size) override;
 
     void draw(u32 vertexCount, u32 firstVertex) override;
     void drawIndexed(u32 indexCount, u32 instanceIndex) override;
@@ -65,15 +80,49 @@ public:
     void textureWriteBarrier(const Texture&) override;
     void textureMipWriteBarrier(const Texture&, uint32_t mip) override;
     void bufferWriteBarrier(std::vector<Buffer const*>) override;
+    void textureAliasingBarrier(const Texture&) override;
 
     void slowBlockingReadFromBuffer(const Buffer&, size_t offset, size_t size, void* dst) override;
 
     void endNode(Badge<VulkanBackend>);
 
+    // Synchronize everything recorded so far, as the backend records its own (untracked) commands after the nodes
+    void endAllNodes(Badge<VulkanBackend>);
+
+    // Record the barriers which must execute right before this (deferred) command list, i.e., synchronization with everything before
+    // it and the transitions into the layouts it expects the textures to be in.
+    void resolveDeferredEntryStates(Badge<VulkanBackend>, VkCommandBuffer);
+
+    // Record the barriers which must execute right after this (deferred) command list, and apply the layouts it leaves the textures in.
+    void resolveDeferredExitStates(Badge<VulkanBackend>, VkCommandBuffer);
+
 private:
     void endCurrentRenderPassIfAny();
     void bindSet(BindingSet&, u32 index);
 
+    // Barrier inference: each access is declared before the command that makes it is recorded, and any barriers needed
+    // for it are batched up until flushBarriers() is called, right before recording that command.
+    void requireTextureAccess(VulkanTexture const&, VkImageLayout, VkPipelineStageFlags, VkAccessFlags);
+    void requireBufferAccess(VulkanBuffer const&, VkPipelineStageFlags, VkAccessFlags);
+    void requireBindingSetAccess(BindingSet const&, VkPipelineStageFlags);
+    void requireOutstandingWritesVisible(VkPipelineStageFlags, VkAccessFlags);
+    void flushBarriers();
+
+    // For commands whose accesses we can't see, e.g. external features, surround them with full barriers
+    void synchronizeAllAccesses();
+
+    VulkanAccessState& currentAccessState(VulkanAccessState&);
+    VulkanAccessState& accessStateFor(VulkanBuffer const&);
+    VulkanAccessState& accessStateFor(VulkanTexture const&);
+    VkImageLayout& layoutFor(VulkanTexture const&);
+    void requireMemoryAccess(VulkanAccessState&, VkPipelineStageFlags, VkAccessFlags);
+    void addPendingDependency(VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+    void recordWrite(VulkanAccessState&, VkPipelineStageFlags, VkAccessFlags);
+
+    // Accesses made within a render pass can't be synchronized there, but the reads must be known for later writes
+    void noteRenderPassRead(VulkanAccessState&, VkAccessFlags, std::string_view resourceName);
+    VkPipelineStageFlags currentlyBoundShaderStages() const;
+
     VulkanBackend& backend() { return m_backend; }
 
     VkDevice device() { return backend().device(); }
@@ -87,6 +136,7 @@ private:
 private:
     VulkanBackend& m_backend;
     VkCommandBuffer m_commandBuffer;
+    ResourceStateTracking m_resourceStateTracking;
 
     VkBuffer m_boundVertexBuffer { VK_NULL_HANDLE };
     VkBuffer m_boundIndexBuffer { VK_NULL_HANDLE };
@@ -95,6 +145,46 @@ private:
     const VulkanComputeState* activeComputeState = nullptr;
     const RayTracingState* activeRayTracingState = nullptr;
 
+    static std::atomic<u64> s_nextTrackingEpoch;
+    u64 m_trackingEpoch { 0 };
+
+    VkPipelineStageFlags m_pendingSrcStages { 0 };
+    VkPipelineStageFlags m_pendingDstStages { 0 };
+    VkAccessFlags m_pendingSrcAccess { 0 };
+    VkAccessFlags m_pendingDstAccess { 0 };
+    std::vector<VkImageMemoryBarrier> m_pendingImageBarriers {};
+
+    // Access states with writes which might not yet be visible to all later accesses
+    std::vector<VulkanAccessState*> m_outstandingWrites {};
+
+    bool m_recordedSinceFullBarrier { false };
+
+    // Stand-in for the layout a texture has before a deferred command list, which is only known once it's resolved
+    static constexpr VkImageLayout DeferredEntryLayout = VK_IMAGE_LAYOUT_MAX_ENUM;
+
+    struct DeferredTextureState {
+        VkImageLayout layout { DeferredEntryLayout };
+        VulkanAccessState accessState {};
+
+        // The layout required by the first access, which the texture is transitioned into before the command list
+        VkImageLayout entryLayout { DeferredEntryLayout };
+        // Return the texture to the layout it had before the command list, once it's done
+        bool restoreEntryLayout { false };
+        // The real layout before the command list, known once resolved
+        VkImageLayout resolvedEntryLayout { VK_IMAGE_LAYOUT_UNDEFINED };
+    };
+
+    std::unordered_map<VulkanTexture const*, DeferredTextureState> m_deferredTextureStates {};
+    std::unordered_map<VulkanBuffer const*, VulkanAccessState> m_deferredBufferStates {};
+
+    struct BarrierStats {
+        u32 nodeCount { 0 };
+        u32 pipelineBarrierCount { 0 };
+        u32 imageBarrierCount { 0 };
+        u32 fullBarrierCount { 0 };
+    };
+    BarrierStats m_barrierStats {};
+
 #if defined(TRACY_ENABLE)
     std::vector<std::unique_ptr<tracy::VkCtxScope>> m_tracyDebugLabelStack;
 #endif
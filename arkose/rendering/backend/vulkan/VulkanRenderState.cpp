@@ -66,6 +66,13 @@ VulkanRenderState::VulkanRenderState(Backend& backend, RenderTarget const& rende
                 case VertexComponent::Color4U8:
                     description.format = VK_FORMAT_R8G8B8A8_UNORM;
                     break;
+                case VertexComponent::TexCoord2H:
+                    description.format = VK_FORMAT_R16G16_SFLOAT;
+                    break;
+                case VertexComponent::NormalOct2S16:
+                case VertexComponent::TangentOct2S16:
+                    description.format = VK_FORMAT_R16G16_SNORM;
+                    break;
                 default:
                     ASSERT_NOT_REACHED();
                 }
@@ -135,13 +135,13 @@ VulkanRenderTarget::VulkanRenderTarget(Backend& backend, std::vector<Attachment>
     framebufferCreateInfo.height = extent().height();
     framebufferCreateInfo.layers = 1;
 
+    // Transient textures may later be placed in aliased memory, which means their image views change after this
     bool makeImagelessFramebuffer = false;
-    for (const Attachment& attachment : colorAttachments()) {
-        if (attachment.texture == vulkanBackend.placeholderSwapchainTexture()) {
+    forEachAttachmentInOrder([&](const Attachment& attachment) {
+        if (attachment.texture == vulkanBackend.placeholderSwapchainTexture() || attachment.texture->isTransient()) {
             makeImagelessFramebuffer = true;
-            break;
         }
-    }
+    });
 
     VkFramebufferAttachmentsCreateInfo attachmentCreateInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENTS_CREATE_INFO };
     std::vector<VkFramebufferAttachmentImageInfo> attachmentImageInfos {};
@@ -112,7 +112,6 @@ VulkanTexture::VulkanTexture(Backend& backend, Description desc)
     VmaAllocationCreateInfo allocCreateInfo = {};
     allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-    VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
     imageCreateInfo.extent = { .width = extent3D().width(), .height = extent3D().height(), .depth = extent3D().depth() };
     imageCreateInfo.mipLevels = mipLevels();
     imageCreateInfo.usage = usageFlags;
@@ -152,6 +151,10 @@ VulkanTexture::VulkanTexture(Backend& backend, Description desc)
             ARKOSE_LOG(Error, "VulkanBackend::newTexture(): could not create image.");
         }
         m_sizeInMemory = allocationInfo.size;
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(vulkanBackend.device(), image, &memoryRequirements);
+        m_memoryAlignment = memoryRequirements.alignment;
     }
 
     imageView = createImageView(0, mipLevels(), {});
@@ -250,6 +253,34 @@ VulkanTexture::~VulkanTexture()
     vmaDestroyImage(vulkanBackend.globalAllocator(), image, allocation);
 }
 
+void VulkanTexture::placeInAliasedMemory(std::shared_ptr<VulkanAliasedMemory> memory, size_t offset)
+{
+    SCOPED_PROFILE_ZONE_GPURESOURCE();
+
+    auto& vulkanBackend = static_cast<VulkanBackend&>(backend());
+
+    // The ImGui descriptor set can't be updated, and there's no reason to display a texture before the pipeline is constructed
+    ARKOSE_ASSERT(descriptorSetForImGui == VK_NULL_HANDLE);
+
+    vkDestroyImageView(vulkanBackend.device(), imageView, nullptr);
+    vmaDestroyImage(vulkanBackend.globalAllocator(), image, allocation);
+    allocation = VK_NULL_HANDLE;
+
+    if (vmaCreateAliasingImage2(vulkanBackend.globalAllocator(), memory->allocation, offset, &imageCreateInfo, &image) != VK_SUCCESS) {
+        ARKOSE_LOG(Fatal, "VulkanTexture: could not create image in aliased memory.");
+    }
+
+    aliasedMemory = std::move(memory);
+
+    imageView = createImageView(0, mipLevels(), {});
+    currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // Apply the debug names to the new image & view
+    if (!name().empty()) {
+        setName(name());
+    }
+}
+
 std::unique_ptr<VulkanTexture> VulkanTexture::createSwapchainPlaceholderTexture(Extent2D swapchainExtent, VkImageUsageFlags imageUsage, VkFormat swapchainFormat)
 {
     auto texture = std::make_unique<VulkanTexture>();
@@ -1,10 +1,25 @@
 #pragma once
 
 #include "rendering/backend/base/Texture.h"
+#include "rendering/backend/vulkan/VulkanAccessState.h"
 
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.h>
 
+// A block of memory shared between multiple textures, which is freed when the last of them is destroyed
+struct VulkanAliasedMemory {
+    VulkanAliasedMemory(VmaAllocator allocator, VmaAllocation allocation)
+        : allocator(allocator)
+        , allocation(allocation)
+    {
+    }
+
+    ~VulkanAliasedMemory() { vmaFreeMemory(allocator, allocation); }
+
+    VmaAllocator allocator;
+    VmaAllocation allocation;
+};
+
 struct VulkanTexture final : public Texture {
 public:
     VulkanTexture() = default;
@@ -31,8 +46,15 @@ public:
 
     VkImageView createImageView(uint32_t baseMip, uint32_t numMips, std::optional<VkComponentMapping>) const;
 
+    // Replace the texture's own memory with the memory at `offset` in the aliased memory. This recreates the image
+    // and its views, so it must be done before anything else references them.
+    void placeInAliasedMemory(std::shared_ptr<VulkanAliasedMemory>, size_t offset);
+
     VkImage image { VK_NULL_HANDLE };
     VmaAllocation allocation { VK_NULL_HANDLE };
+    std::shared_ptr<VulkanAliasedMemory> aliasedMemory {};
+
+    VkImageCreateInfo imageCreateInfo { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 
     VkImageUsageFlags vkUsage { 0 };
     VkFormat vkFormat { VK_FORMAT_R8G8B8A8_UINT };
@@ -40,6 +62,7 @@ public:
     VkSampler sampler { VK_NULL_HANDLE };
 
     mutable VkImageLayout currentLayout { VK_IMAGE_LAYOUT_UNDEFINED };
+    mutable VulkanAccessState accessState {};
 
     // For Dear ImGui display
     static constexpr VkImageLayout ImGuiRenderingTargetLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
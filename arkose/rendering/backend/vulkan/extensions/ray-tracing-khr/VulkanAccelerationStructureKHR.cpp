@@ -171,7 +171,16 @@ void VulkanTopLevelASKHR::updateInstanceDataWithUploadBuffer(const std::vector<R
     uploadBuffer.upload(updatedInstanceData, *instanceBuffer);
 }
 
-std::vector<VkAccelerationStructureInstanceKHR> VulkanTopLevelASKHR::createInstanceData(const std::vector<RTGeometryInstance>& instances) const
+void VulkanTopLevelASKHR::updateInstanceDataRangeWithUploadBuffer(uint32_t firstInstanceIdx, std::span<const RTGeometryInstance> instances, UploadBuffer& uploadBuffer)
+{
+    ARKOSE_ASSERT(firstInstanceIdx + instances.size() <= maxInstanceCount());
+
+    auto updatedInstanceData = createInstanceData(instances);
+    size_t dstOffset = firstInstanceIdx * sizeof(VkAccelerationStructureInstanceKHR);
+    uploadBuffer.upload(updatedInstanceData.data(), updatedInstanceData.size() * sizeof(VkAccelerationStructureInstanceKHR), *instanceBuffer, dstOffset);
+}
+
+std::vector<VkAccelerationStructureInstanceKHR> VulkanTopLevelASKHR::createInstanceData(std::span<const RTGeometryInstance> instances) const
 {
     SCOPED_PROFILE_ZONE_GPURESOURCE();
 
@@ -596,6 +605,7 @@ bool VulkanBottomLevelASKHR::compact(VkCommandBuffer commandBuffer)
     VkAccelerationStructureDeviceAddressInfoKHR blasDeviceAddressInfo { VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR };
     blasDeviceAddressInfo.accelerationStructure = accelerationStructure;
     accelerationStructureDeviceAddress = vulkanBackend.rayTracingKHR().vkGetAccelerationStructureDeviceAddressKHR(vulkanBackend.device(), &blasDeviceAddressInfo);
+    assignNewAddressStamp();
 
     compactionState = CompactionState::Compacted;
 
@@ -16,8 +16,9 @@ public:
     void build(VkCommandBuffer, AccelerationStructureBuildType);
 
     void updateInstanceDataWithUploadBuffer(const std::vector<RTGeometryInstance>&, UploadBuffer&) override;
+    void updateInstanceDataRangeWithUploadBuffer(uint32_t firstInstanceIdx, std::span<const RTGeometryInstance>, UploadBuffer&) override;
 
-    std::vector<VkAccelerationStructureInstanceKHR> createInstanceData(const std::vector<RTGeometryInstance>&) const;
+    std::vector<VkAccelerationStructureInstanceKHR> createInstanceData(std::span<const RTGeometryInstance>) const;
 
     VkAccelerationStructureKHR accelerationStructure;
     VkDeviceAddress accelerationStructureDeviceAddress;
@@ -54,7 +54,7 @@ RenderPipelineNode::ExecuteCallback BakeAmbientOcclusionNode::construct(GpuScene
 
     // Ensure we don't try to load the unused components from the vertex buffer
     VertexLayout& bakeParamsVertexLayout = reg.allocate<VertexLayout>();
-    bakeParamsVertexLayout = scene.vertexManager().nonPositionVertexLayout().replaceAllWithPaddingBut(VertexComponent::TexCoord2F);
+    bakeParamsVertexLayout = scene.vertexManager().nonPositionVertexLayout().replaceAllWithPaddingBut(scene.vertexManager().nonPositionTexCoordComponent());
 
     RenderStateBuilder bakeParamsStateBuilder { renderTarget, bakeParamsParamsShader, bakeParamsVertexLayout };
     bakeParamsStateBuilder.primitiveType = PrimitiveType::Triangles;
@@ -0,0 +1,188 @@
+#include "ForwardCulling.h"
+
+#include "core/parallel/ParallelFor.h"
+#include "rendering/GpuScene.h"
+#include "scene/MeshInstance.h"
+#include "utility/Profiling.h"
+#include <algorithm>
+#include <cmath>
+#include <imgui.h>
+
+namespace ForwardCulling {
+
+namespace {
+
+// Skeletal meshes are culled against the bounds of their bind pose, so give them some margin for the animated pose
+constexpr float SkeletalMeshBoundsMargin = 1.5f;
+
+constexpr size_t InstancesPerBatch = 64;
+
+struct CullResult {
+    bool visible { false };
+    u32 lodIdx { 0 };
+    vec3 worldPosition {};
+};
+
+bool lodIsDrawable(StaticMesh const& mesh, u32 lodIdx)
+{
+    // Drawables are only created for the segments of LOD0 (see GpuScene::initializeStaticMeshInstance), so other LODs
+    // can only be drawn if their segments match up with the LOD0 segments. They also have to be streamed in already.
+    StaticMeshLOD const& lod = mesh.lodAtIndex(lodIdx);
+    if (lod.meshSegments.size() != mesh.lodAtIndex(0).meshSegments.size()) {
+        return false;
+    }
+
+    return std::all_of(lod.meshSegments.begin(), lod.meshSegments.end(), [](StaticMeshSegment const& segment) {
+        return segment.vertexAllocation.isValid();
+    });
+}
+
+u32 selectLod(StaticMesh const& mesh, float screenSize, Settings const& settings)
+{
+    // The indirect draws only cover LOD0, and all passes must render the same geometry
+    if (settings.indirectDraws) {
+        return 0;
+    }
+
+    u32 lodIdx = 0;
+    if (settings.lodSelection && screenSize < settings.lod1ScreenSize) {
+        lodIdx = 1 + static_cast<u32>(std::log2(settings.lod1ScreenSize / std::max(screenSize, 1e-6f)));
+    }
+
+    u32 maxLodIdx = std::min(mesh.maxLod(), mesh.numLODs() - 1);
+    u32 minLodIdx = std::min(mesh.minLod(), maxLodIdx);
+    lodIdx = std::clamp(lodIdx, minLodIdx, maxLodIdx);
+
+    while (lodIdx > 0 && !lodIsDrawable(mesh, lodIdx)) {
+        lodIdx -= 1;
+    }
+
+    return lodIdx;
+}
+
+CullResult cullInstance(StaticMesh const& mesh, mat4 const& worldFromLocal, float boundsMargin,
+                        geometry::Frustum const& frustum, vec3 cameraPosition, float projectionScaleY, Settings const& settings)
+{
+    geometry::Sphere const& localSphere = mesh.boundingSphere();
+    vec3 worldCenter = vec3(worldFromLocal * vec4(localSphere.center(), 1.0f));
+    float maxScale = std::max({ length(worldFromLocal.x.xyz()), length(worldFromLocal.y.xyz()), length(worldFromLocal.z.xyz()) });
+    float worldRadius = localSphere.radius() * maxScale * boundsMargin;
+
+    if (settings.frustumCulling && !frustum.includesSphere(geometry::Sphere(worldCenter, worldRadius))) {
+        return CullResult { .visible = false };
+    }
+
+    // Approximate fraction of the screen height covered by the bounding sphere
+    float distanceToCenter = distance(cameraPosition, worldCenter);
+    float screenSize = distanceToCenter > worldRadius ? (worldRadius * projectionScaleY) / distanceToCenter : 1.0f;
+
+    if (settings.screenSizeCulling && screenSize < settings.minScreenSize) {
+        return CullResult { .visible = false };
+    }
+
+    return CullResult { .visible = true,
+                        .lodIdx = selectLod(mesh, screenSize, settings),
+                        .worldPosition = worldFromLocal.w.xyz() };
+}
+
+template<typename InstanceType, typename MeshResolver>
+std::vector<VisibleInstance<InstanceType>> cullInstances(GpuScene const& scene, std::vector<std::unique_ptr<InstanceType>> const& instances,
+                                                         Settings const& settings, Stats& stats, MeshResolver&& meshResolver)
+{
+    SCOPED_PROFILE_ZONE();
+
+    Camera const& camera = scene.camera();
+    geometry::Frustum const& frustum = camera.frustum();
+    vec3 cameraPosition = camera.position();
+    float projectionScaleY = std::abs(camera.projectionMatrix().y.y);
+
+    constexpr bool isSkeletal = std::is_same_v<InstanceType, SkeletalMeshInstance>;
+    constexpr float boundsMargin = isSkeletal ? SkeletalMeshBoundsMargin : 1.0f;
+
+    std::vector<CullResult> cullResults {};
+    cullResults.resize(instances.size());
+
+    ParallelForBatched(instances.size(), InstancesPerBatch, [&](size_t idx) {
+        InstanceType const& instance = *instances[idx];
+
+        // Without drawables the instance isn't initialized yet, so there is nothing to draw
+        if (instance.drawableHandles().empty()) {
+            return;
+        }
+
+        // NOTE: Use the world matrix which GpuScene has already written to the drawables this frame, as Transform::worldMatrix()
+        // lazily caches matrices and so can't be called from multiple threads (and other nodes may be culling at the same time).
+        ShaderDrawable const* drawable = scene.drawableForHandle(instance.drawableHandles().front());
+        if (drawable == nullptr) {
+            return;
+        }
+
+        if (StaticMesh const* mesh = meshResolver(instance)) {
+            cullResults[idx] = cullInstance(*mesh, drawable->worldFromLocal, boundsMargin, frustum, cameraPosition, projectionScaleY, settings);
+            if constexpr (isSkeletal) {
+                // Skinning targets only exist for LOD0
+                cullResults[idx].lodIdx = 0;
+            }
+        }
+    });
+
+    std::vector<VisibleInstance<InstanceType>> visibleInstances {};
+    visibleInstances.reserve(instances.size());
+
+    for (size_t idx = 0; idx < instances.size(); ++idx) {
+        if (cullResults[idx].visible) {
+            InstanceType const& instance = *instances[idx];
+            visibleInstances.push_back(VisibleInstance<InstanceType> { .instance = &instance,
+                                                                       .mesh = meshResolver(instance),
+                                                                       .lodIdx = cullResults[idx].lodIdx,
+                                                                       .worldPosition = cullResults[idx].worldPosition });
+        }
+    }
+
+    stats.drawnInstanceCount += static_cast<u32>(visibleInstances.size());
+    stats.culledInstanceCount += static_cast<u32>(instances.size() - visibleInstances.size());
+
+    return visibleInstances;
+}
+
+}
+
+std::vector<VisibleInstance<StaticMeshInstance>> cullStaticMeshInstances(GpuScene const& scene, Settings const& settings, Stats& stats)
+{
+    return cullInstances(scene, scene.staticMeshInstances(), settings, stats, [&](StaticMeshInstance const& instance) -> StaticMesh const* {
+        return scene.staticMeshForInstance(instance);
+    });
+}
+
+std::vector<VisibleInstance<SkeletalMeshInstance>> cullSkeletalMeshInstances(GpuScene const& scene, Settings const& settings, Stats& stats)
+{
+    return cullInstances(scene, scene.skeletalMeshInstances(), settings, stats, [&](SkeletalMeshInstance const& instance) -> StaticMesh const* {
+        SkeletalMesh const* skeletalMesh = scene.skeletalMeshForInstance(instance);
+        return skeletalMesh ? &skeletalMesh->underlyingMesh() : nullptr;
+    });
+}
+
+void Settings::drawGui()
+{
+    ImGui::Checkbox("Frustum culling", &frustumCulling);
+
+    ImGui::Checkbox("Screen size culling", &screenSizeCulling);
+    if (screenSizeCulling) {
+        ImGui::SliderFloat("Min. screen size", &minScreenSize, 0.0f, 0.05f, "%.4f");
+    }
+
+    ImGui::Checkbox("LOD selection", &lodSelection);
+    if (lodSelection) {
+        ImGui::SliderFloat("LOD1 screen size", &lod1ScreenSize, 0.01f, 1.0f);
+    }
+
+    ImGui::Checkbox("GPU-driven indirect draws (opaque forward)", &indirectDraws);
+}
+
+void Stats::drawGui() const
+{
+    ImGui::Text("Instances: %u drawn, %u culled", drawnInstanceCount, culledInstanceCount);
+    ImGui::Text("Mesh segments drawn: %u", drawnSegmentCount);
+}
+
+}
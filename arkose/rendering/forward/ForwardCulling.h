@@ -0,0 +1,55 @@
+#pragma once
+
+#include "core/Types.h"
+#include <vector>
+
+class GpuScene;
+class StaticMesh;
+struct SkeletalMeshInstance;
+struct StaticMeshInstance;
+
+// CPU culling & LOD selection of mesh instances, for the raster passes which generate their draw lists on the CPU.
+namespace ForwardCulling {
+
+    struct Settings {
+        bool frustumCulling { true };
+
+        // Cull instances which cover less than `minScreenSize` of the screen height, i.e., tiny and/or far away instances
+        bool screenSizeCulling { true };
+        float minScreenSize { 0.002f };
+
+        // Pick LODs based on the screen size of the instance. LOD1 is used below `lod1ScreenSize` of the screen height,
+        // and each following LOD is used below half the screen size of the previous one.
+        bool lodSelection { true };
+        float lod1ScreenSize { 0.25f };
+
+        // Draw opaque meshes in the forward pass with GPU-driven indirect draws, culled on the GPU. The drawables only
+        // cover LOD0, so then all passes use LOD0 to ensure that they still render the exact same geometry.
+        bool indirectDraws { false };
+
+        void drawGui();
+    };
+
+    struct Stats {
+        u32 drawnInstanceCount { 0 };
+        u32 culledInstanceCount { 0 };
+        u32 drawnSegmentCount { 0 };
+
+        void drawGui() const;
+    };
+
+    template<typename InstanceType>
+    struct VisibleInstance {
+        InstanceType const* instance { nullptr };
+        StaticMesh const* mesh { nullptr };
+        u32 lodIdx { 0 };
+
+        // Position of the instance in the world this frame, which (unlike its transform) is safe to use from any thread
+        vec3 worldPosition {};
+    };
+
+    // Returns the visible instances in the same order as they are in the scene, and adds the results to the stats
+    std::vector<VisibleInstance<StaticMeshInstance>> cullStaticMeshInstances(GpuScene const&, Settings const&, Stats&);
+    std::vector<VisibleInstance<SkeletalMeshInstance>> cullSkeletalMeshInstances(GpuScene const&, Settings const&, Stats&);
+
+}
@@ -3,12 +3,17 @@
 #include "core/Types.h"
 #include "rendering/GpuScene.h"
 #include "rendering/VertexManager.h"
+#include "rendering/backend/util/UploadBuffer.h"
 #include "rendering/util/BlendModeUtil.h"
 #include "rendering/util/ScopedDebugZone.h"
 #include "scene/MeshInstance.h"
 #include "utility/Profiling.h"
+#include <algorithm>
 #include <imgui.h>
 
+// Shared shader headers
+#include "shaders/shared/IndirectData.h"
+
 ForwardRenderNode::ForwardRenderNode(Mode mode, ForwardMeshFilter meshFilter, ForwardClearMode clearMode)
     : m_mode(mode)
     , m_meshFilter(meshFilter)
@@ -32,6 +37,15 @@ std::string ForwardRenderNode::name() const
     ASSERT_NOT_REACHED();
 }
 
+void ForwardRenderNode::drawGui()
+{
+    if (m_usingIndirectDraws) {
+        ImGui::Text("Culling & draw setup is done on the GPU");
+    } else {
+        m_cullingStats.drawGui();
+    }
+}
+
 RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene, Registry& reg)
 {
     m_hasPreviousPrepass = reg.hasPreviousNode("Prepass");
@@ -39,8 +53,15 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
     // Create render target
     RenderTarget& renderTarget = makeRenderTarget(reg, m_mode);
 
+    // The GPU draw setup only matches drawables by draw key and has no notion of mesh types, so only use indirect draws when
+    // drawing all meshes. The draw key of a render state doesn't tell if it's for skeletal meshes, it only tends to correlate.
+    bool supportsIndirectDraws = m_mode == Mode::Opaque && m_meshFilter == ForwardMeshFilter::AllMeshes;
+
+    m_indirectDrawStates.clear();
+    Shader drawSetupShader = Shader::createCompute("forward/forwardDrawSetup.comp", { ShaderDefine::makeInt("GROUP_SIZE", IndirectDrawSetupGroupSize) });
+
     // Create all render states (PSOs) needed for rendering
-    auto& renderStateLookup = reg.allocate<std::unordered_map<u32, RenderState*>>();
+    auto& renderStateLookup = reg.allocate<std::unordered_map<u32, ForwardRenderState>>();
     for (DrawKey const& drawKey : DrawKey::createCompletePermutationSet()) {
 
         // filter out some potential draw states which we don't need
@@ -58,10 +79,17 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
             continue;
         }
 
-        renderStateLookup[drawKey.asUint32()] = &makeForwardRenderState(reg, scene, renderTarget, drawKey);
+        RenderState& renderState = makeForwardRenderState(reg, scene, renderTarget, drawKey);
+        ForwardRenderState& forwardRenderState = renderStateLookup[drawKey.asUint32()];
+        forwardRenderState.renderState = &renderState;
+        forwardRenderState.constants = ForwardStateConstants::resolve(renderState);
+
+        if (supportsIndirectDraws) {
+            createIndirectDrawState(reg, drawKey, forwardRenderState, drawSetupShader);
+        }
     }
 
-    return [&](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
+    return [&, supportsIndirectDraws](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
 
         if (m_clearMode == ForwardClearMode::ClearBeforeFirstDraw) {
             for (RenderTarget::Attachment const& attachment : renderTarget.colorAttachments()) {
@@ -72,8 +100,14 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
             }
         }
 
-        std::vector<MeshSegmentInstance> instances = generateSortedDrawList(scene, m_mode, m_meshFilter);
-        if (instances.empty()) {
+        m_usingIndirectDraws = supportsIndirectDraws && scene.forwardCullingSettings().indirectDraws;
+        if (m_usingIndirectDraws) {
+            executeIndirectDraws(scene, cmdList, uploadBuffer, renderTarget);
+            return;
+        }
+
+        generateSortedDrawList(scene, m_mode, m_meshFilter);
+        if (m_drawOrder.empty()) {
             return;
         }
 
@@ -81,10 +115,12 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
 
         DrawKey const* currentStateDrawKey = nullptr;
         BufferStates const* currentBufferStates = nullptr;
-        for (MeshSegmentInstance const& instance : instances) {
+        for (RadixSortItem const& drawOrderItem : m_drawOrder) {
+            MeshSegmentInstance const& instance = m_drawList[drawOrderItem.index];
 
             if (currentStateDrawKey == nullptr || instance.drawKey != *currentStateDrawKey) {
-                RenderState* renderState = renderStateLookup[instance.drawKey.asUint32()];
+                ForwardRenderState const& forwardRenderState = renderStateLookup[instance.drawKey.asUint32()];
+                RenderState* renderState = forwardRenderState.renderState;
                 ARKOSE_ASSERT(renderState != nullptr);
 
                 if (!firstDraw) {
@@ -95,22 +131,19 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
                 cmdList.beginDebugLabel(renderState->name());
                 cmdList.beginRendering(*renderState);
 
-                cmdList.setNamedUniform("ambientAmount", scene.preExposedAmbient());
-                cmdList.setNamedUniform("frustumJitterCorrection", scene.camera().frustumJitterUVCorrection());
-                cmdList.setNamedUniform("invTargetSize", renderTarget.extent().inverse());
-                cmdList.setNamedUniform("mipBias", scene.globalMipBias());
-                cmdList.setNamedUniform("withMaterialColor", scene.shouldIncludeMaterialColor());
+                setPerStateUniforms(scene, cmdList, renderTarget, forwardRenderState.constants);
 
                 currentStateDrawKey = &instance.drawKey;
             }
 
-            if (currentBufferStates == nullptr || instance.bufferStates != *currentBufferStates) {
-                for (u32 idx = 0; idx < instance.bufferStates.vertexBuffers.size(); ++idx) {
-                    auto const& [vertexBuffer, layout] = instance.bufferStates.vertexBuffers[idx];
+            BufferStates const& bufferStates = m_bufferStates[instance.bufferStatesIdx];
+            if (currentBufferStates != &bufferStates) {
+                for (u32 idx = 0; idx < bufferStates.vertexBuffers.size(); ++idx) {
+                    auto const& [vertexBuffer, layout] = bufferStates.vertexBuffers[idx];
                     cmdList.bindVertexBuffer(*vertexBuffer, layout.packedVertexSize(), idx);
                 }
-                cmdList.bindIndexBuffer(*instance.bufferStates.indexBuffer.first, instance.bufferStates.indexBuffer.second);
-                currentBufferStates = &instance.bufferStates;
+                cmdList.bindIndexBuffer(*bufferStates.indexBuffer.first, bufferStates.indexBuffer.second);
+                currentBufferStates = &bufferStates;
             }
 
             cmdList.issueDrawCall(instance.drawCall);
@@ -123,15 +156,134 @@ RenderPipelineNode::ExecuteCallback ForwardRenderNode::construct(GpuScene& scene
     };
 }
 
-ForwardRenderNode::MeshSegmentInstance::MeshSegmentInstance(DrawCallDescription inDrawCall, DrawKey inDrawKey,
-    BufferStates inBufferStates, Transform const& inTransform)
+void ForwardRenderNode::createIndirectDrawState(Registry& reg, DrawKey const& drawKey, ForwardRenderState const& forwardRenderState, Shader const& drawSetupShader)
+{
+    RenderState& renderState = *forwardRenderState.renderState;
+
+    IndirectDrawState& state = m_indirectDrawStates.emplace_back();
+    state.drawKey = drawKey;
+    state.forwardRenderState = forwardRenderState;
+
+    state.indirectBuffer = &reg.createBuffer(MaxIndirectDrawsPerRenderState * sizeof(IndexedDrawCmd), Buffer::Usage::IndirectBuffer);
+    state.indirectBuffer->setStride(sizeof(IndexedDrawCmd));
+    state.indirectBuffer->setName(fmt::format("{}IndirectDraws", renderState.name()));
+
+    state.countBuffer = &reg.createBuffer(sizeof(u32), Buffer::Usage::IndirectBuffer);
+    state.countBuffer->setName(fmt::format("{}IndirectDrawCount", renderState.name()));
+
+    BindingSet& drawSetupBindingSet = reg.createBindingSet({ ShaderBinding::storageBufferReadonly(*reg.getBuffer("SceneObjectData")),
+                                                             ShaderBinding::storageBuffer(*state.indirectBuffer),
+                                                             ShaderBinding::storageBuffer(*state.countBuffer) });
+
+    StateBindings stateBindings;
+    stateBindings.at(0, drawSetupBindingSet);
+
+    state.drawSetupComputeState = &reg.createComputeState(drawSetupShader, stateBindings);
+
+    NamedConstantLookup const& constantLookup = state.drawSetupComputeState->namedConstantLookup();
+    state.frustumPlanesConstant = constantLookup.resolveConstant<geometry::Plane[6]>("frustumPlanes");
+    state.drawableCountConstant = constantLookup.resolveConstant<u32>("drawableCount");
+    state.drawKeyConstant = constantLookup.resolveConstant<u32>("drawKey");
+    state.maxDrawCountConstant = constantLookup.resolveConstant<u32>("maxDrawCount");
+    state.frustumCullConstant = constantLookup.resolveConstant<bool>("frustumCull");
+}
+
+void ForwardRenderNode::executeIndirectDraws(GpuScene const& scene, CommandList& cmdList, UploadBuffer& uploadBuffer, RenderTarget const& renderTarget) const
+{
+    u32 drawableCount = narrow_cast<u32>(scene.drawableCountForFrame());
+    if (drawableCount == 0) {
+        return;
+    }
+
+    {
+        ScopedDebugZone zone { cmdList, "Forward draw setup" };
+
+        // Reset the draw counts before accumulating into them in the shader
+        for (IndirectDrawState const& state : m_indirectDrawStates) {
+            uploadBuffer.upload(0u, *state.countBuffer, 0);
+        }
+        cmdList.executeBufferCopyOperations(uploadBuffer);
+
+        size_t frustumPlaneDataSize;
+        void const* frustumPlaneData = reinterpret_cast<void const*>(scene.camera().frustum().rawPlaneData(&frustumPlaneDataSize));
+        bool frustumCull = scene.forwardCullingSettings().frustumCulling;
+
+        std::vector<Buffer const*> writtenBuffers {};
+        for (IndirectDrawState const& state : m_indirectDrawStates) {
+            cmdList.setComputeState(*state.drawSetupComputeState);
+
+            cmdList.setNamedUniform(state.frustumPlanesConstant, frustumPlaneData, frustumPlaneDataSize);
+            cmdList.setNamedUniform(state.drawableCountConstant, drawableCount);
+            cmdList.setNamedUniform(state.drawKeyConstant, state.drawKey.asUint32());
+            cmdList.setNamedUniform(state.maxDrawCountConstant, MaxIndirectDrawsPerRenderState);
+            cmdList.setNamedUniform(state.frustumCullConstant, frustumCull);
+
+            cmdList.dispatch({ drawableCount, 1, 1 }, { IndirectDrawSetupGroupSize, 1, 1 });
+
+            writtenBuffers.push_back(state.indirectBuffer);
+            writtenBuffers.push_back(state.countBuffer);
+        }
+
+        cmdList.bufferWriteBarrier(writtenBuffers);
+    }
+
+    VertexManager const& vm = scene.vertexManager();
+
+    for (IndirectDrawState const& state : m_indirectDrawStates) {
+        RenderState const& renderState = *state.forwardRenderState.renderState;
+        cmdList.beginDebugLabel(renderState.name());
+        cmdList.beginRendering(renderState);
+
+        setPerStateUniforms(scene, cmdList, renderTarget, state.forwardRenderState.constants);
+
+        cmdList.bindVertexBuffer(vm.positionVertexBuffer(), vm.positionVertexLayout().packedVertexSize(), 0);
+        cmdList.bindVertexBuffer(vm.nonPositionVertexBuffer(), vm.nonPositionVertexLayout().packedVertexSize(), 1);
+        cmdList.bindIndexBuffer(vm.indexBuffer(), IndexType::UInt32);
+
+        cmdList.drawIndirect(*state.indirectBuffer, *state.countBuffer);
+
+        cmdList.endRendering();
+        cmdList.endDebugLabel();
+    }
+}
+
+void ForwardRenderNode::setPerStateUniforms(GpuScene const& scene, CommandList& cmdList, RenderTarget const& renderTarget, ForwardStateConstants const& constants) const
+{
+    cmdList.setNamedUniform(constants.ambientAmount, scene.preExposedAmbient());
+    cmdList.setNamedUniform(constants.frustumJitterCorrection, scene.camera().frustumJitterUVCorrection());
+    cmdList.setNamedUniform(constants.invTargetSize, renderTarget.extent().inverse());
+    cmdList.setNamedUniform(constants.mipBias, scene.globalMipBias());
+    cmdList.setNamedUniform(constants.withMaterialColor, scene.shouldIncludeMaterialColor());
+}
+
+ForwardRenderNode::ForwardStateConstants ForwardRenderNode::ForwardStateConstants::resolve(RenderState const& renderState)
+{
+    NamedConstantLookup const& constantLookup = renderState.namedConstantLookup();
+    return ForwardStateConstants { .ambientAmount = constantLookup.resolveConstant<float>("ambientAmount"),
+                                   .frustumJitterCorrection = constantLookup.resolveConstant<vec2>("frustumJitterCorrection"),
+                                   .invTargetSize = constantLookup.resolveConstant<vec2>("invTargetSize"),
+                                   .mipBias = constantLookup.resolveConstant<float>("mipBias"),
+                                   .withMaterialColor = constantLookup.resolveConstant<bool>("withMaterialColor") };
+}
+
+ForwardRenderNode::MeshSegmentInstance::MeshSegmentInstance(DrawCallDescription inDrawCall, DrawKey inDrawKey, u32 inBufferStatesIdx)
     : drawCall(inDrawCall)
     , drawKey(inDrawKey)
-    , bufferStates(inBufferStates)
-    , transform(&inTransform)
+    , bufferStatesIdx(inBufferStatesIdx)
 {
 }
 
+u32 ForwardRenderNode::bufferStatesIndex(BufferStates const& bufferStates)
+{
+    auto entry = std::find(m_bufferStates.begin(), m_bufferStates.end(), bufferStates);
+    if (entry != m_bufferStates.end()) {
+        return static_cast<u32>(std::distance(m_bufferStates.begin(), entry));
+    }
+
+    m_bufferStates.push_back(bufferStates);
+    return static_cast<u32>(m_bufferStates.size() - 1);
+}
+
 RenderTarget& ForwardRenderNode::makeRenderTarget(Registry& reg, Mode mode) const
 {
     constexpr LoadOp loadOp = LoadOp::Load;
@@ -243,19 +395,40 @@ RenderState& ForwardRenderNode::makeForwardRenderState(Registry& reg, GpuScene c
     return renderState;
 }
 
-std::vector<ForwardRenderNode::MeshSegmentInstance> ForwardRenderNode::generateSortedDrawList(GpuScene const& scene, Mode mode, ForwardMeshFilter meshFilter) const
+void ForwardRenderNode::generateSortedDrawList(GpuScene const& scene, Mode mode, ForwardMeshFilter meshFilter)
 {
     SCOPED_PROFILE_ZONE();
 
-    std::vector<MeshSegmentInstance> meshSegmentInstances {};
-
-    vec3 cameraPosition = scene.camera().position();
-    //geometry::Frustum const& cameraFrustum = scene.camera().frustum();
-    
-    auto conditionallyAppendInstance = [&]<typename InstanceType>(InstanceType const& instance, StaticMesh const& mesh) -> void {
-
-        constexpr u32 lodIdx = 0;
-        StaticMeshLOD const& lod = mesh.lodAtIndex(lodIdx);
+    // The draw order is defined by a 64-bit sort key per draw, which is built once per instance and then radix sorted:
+    //  - opaque: [ draw key : 32 ][ buffer states : 8 ][ depth : 24 ], i.e., minimize state changes, then front to back
+    //  - translucent: [ inverted depth : 24 ][ draw key : 32 ][ buffer states : 8 ], i.e., back to front
+    constexpr u32 DepthBits = 24;
+    constexpr u32 BufferStatesBits = 8;
+    constexpr u64 MaxQuantizedDepth = (1ull << DepthBits) - 1;
+
+    // The buffer states are only referred to by this frame's draw list, so start over every frame. Otherwise old states,
+    // e.g. from before vertex buffers were reallocated, would accumulate until they no longer fit in the sort key.
+    m_bufferStates.clear();
+    m_drawList.clear();
+    m_drawOrder.clear();
+    m_cullingStats = {};
+
+    Camera const& camera = scene.camera();
+    vec3 cameraPosition = camera.position();
+    float depthQuantizationScale = static_cast<float>(MaxQuantizedDepth) / camera.farClipPlane();
+
+    VertexManager const& vm = scene.vertexManager();
+
+    BufferStates bufferStates;
+    bufferStates.indexBuffer = { &vm.indexBuffer(), IndexType::UInt32 };
+    bufferStates.vertexBuffers = { { &vm.positionVertexBuffer(), vm.positionVertexLayout() },
+                                   { &vm.nonPositionVertexBuffer(), vm.nonPositionVertexLayout() } };
+    u32 bufferStatesIdx = bufferStatesIndex(bufferStates);
+    ARKOSE_ASSERT(bufferStatesIdx < (1u << BufferStatesBits));
+
+    auto appendInstance = [&]<typename InstanceType>(ForwardCulling::VisibleInstance<InstanceType> const& visibleInstance) -> void {
+        InstanceType const& instance = *visibleInstance.instance;
+        StaticMesh const& mesh = *visibleInstance.mesh;
 
         // Early-out if we know there are no relevant segments
         if (mode == Mode::Translucent && !mesh.hasTranslucentSegments()) {
@@ -264,17 +437,24 @@ std::vector<ForwardRenderNode::MeshSegmentInstance> ForwardRenderNode::generateS
             return;
         }
 
-        // TODO: Add me back! But probably AABB testing ...
-        //if (not cameraFrustum.includesSphere(mesh.boundingSphere())) {
-        //    return;
-        //}
+        StaticMeshLOD const& lod = mesh.lodAtIndex(visibleInstance.lodIdx);
 
-        VertexManager const& vm = scene.vertexManager();
+        float instanceDistance = distance(cameraPosition, visibleInstance.worldPosition);
+        u64 quantizedDepth = static_cast<u64>(std::clamp(instanceDistance * depthQuantizationScale, 0.0f, static_cast<float>(MaxQuantizedDepth)));
 
-        BufferStates bufferStates;
-        bufferStates.indexBuffer = { &vm.indexBuffer(), IndexType::UInt32 };
-        bufferStates.vertexBuffers = { { &vm.positionVertexBuffer(), vm.positionVertexLayout() },
-                                       { &vm.nonPositionVertexBuffer(), vm.nonPositionVertexLayout() } };
+        auto appendDraw = [&](DrawCallDescription const& drawCall, DrawKey const& drawKey) {
+            u64 drawKeyBits = drawKey.asUint32();
+
+            u64 sortKey;
+            if (mode == Mode::Translucent) {
+                sortKey = ((MaxQuantizedDepth - quantizedDepth) << (32 + BufferStatesBits)) | (drawKeyBits << BufferStatesBits) | bufferStatesIdx;
+            } else {
+                sortKey = (drawKeyBits << (BufferStatesBits + DepthBits)) | (u64(bufferStatesIdx) << DepthBits) | quantizedDepth;
+            }
+
+            m_drawOrder.push_back(RadixSortItem { .key = sortKey, .index = static_cast<u32>(m_drawList.size()) });
+            m_drawList.emplace_back(drawCall, drawKey, bufferStatesIdx);
+        };
 
         for (u32 segmentIdx = 0; segmentIdx < lod.meshSegments.size(); ++segmentIdx) {
             StaticMeshSegment const& meshSegment = lod.meshSegments[segmentIdx];
@@ -284,6 +464,7 @@ std::vector<ForwardRenderNode::MeshSegmentInstance> ForwardRenderNode::generateS
 
                 DrawKey drawKey = meshSegment.drawKey;
 
+                // NOTE: Drawables are created for the LOD0 segments, which the segments of the selected LOD correspond to
                 u32 drawableIdx = instance.drawableHandleForSegmentIndex(segmentIdx).template indexOfType<u32>();
                 if constexpr (std::is_same_v<InstanceType, SkeletalMeshInstance>) {
                     if (instance.hasSkinningVertexMappingForSegmentIndex(segmentIdx)) {
@@ -294,12 +475,12 @@ std::vector<ForwardRenderNode::MeshSegmentInstance> ForwardRenderNode::generateS
                         SkinningVertexMapping const& skinningVertexMapping = instance.skinningVertexMappingForSegmentIndex(segmentIdx);
                         DrawCallDescription drawCall = DrawCallDescription::fromVertexAllocation(skinningVertexMapping.skinnedTarget);
                         drawCall.firstInstance = drawableIdx;
-                        meshSegmentInstances.emplace_back(drawCall, drawKey, bufferStates, instance.transform());
+                        appendDraw(drawCall, drawKey);
                     }
                 } else {
                     DrawCallDescription drawCall = DrawCallDescription::fromVertexAllocation(meshSegment.vertexAllocation);
                     drawCall.firstInstance = drawableIdx;
-                    meshSegmentInstances.emplace_back(drawCall, drawKey, bufferStates, instance.transform());
+                    appendDraw(drawCall, drawKey);
                 }
             }
         }
@@ -309,35 +490,18 @@ std::vector<ForwardRenderNode::MeshSegmentInstance> ForwardRenderNode::generateS
     bool includeSkeletalMeshes = meshFilter != ForwardMeshFilter::OnlyStaticMeshes;
 
     if (includeStaticMeshes) {
-        for (auto const& instance : scene.staticMeshInstances()) {
-            if (StaticMesh const* staticMesh = scene.staticMeshForInstance(*instance)) {
-                conditionallyAppendInstance(*instance, *staticMesh);
-            }
+        for (auto const& visibleInstance : ForwardCulling::cullStaticMeshInstances(scene, scene.forwardCullingSettings(), m_cullingStats)) {
+            appendInstance(visibleInstance);
         }
     }
 
     if (includeSkeletalMeshes) {
-        for (auto const& instance : scene.skeletalMeshInstances()) {
-            if (SkeletalMesh const* skeletalMesh = scene.skeletalMeshForInstance(*instance)) {
-                StaticMesh const& underlyingMesh = skeletalMesh->underlyingMesh();
-                conditionallyAppendInstance(*instance, underlyingMesh);
-            }
+        for (auto const& visibleInstance : ForwardCulling::cullSkeletalMeshInstances(scene, scene.forwardCullingSettings(), m_cullingStats)) {
+            appendInstance(visibleInstance);
         }
     }
 
-    if (mode == Mode::Translucent) {
-        // Sort back to front
-        std::sort(meshSegmentInstances.begin(), meshSegmentInstances.end(), [&](MeshSegmentInstance const& lhs, MeshSegmentInstance const& rhs) {
-            float lhsDistance = distance(cameraPosition, lhs.transform->positionInWorld());
-            float rhsDistance = distance(cameraPosition, rhs.transform->positionInWorld());
-            return lhsDistance > rhsDistance;
-        });
-    } else {
-        // Sort to minimize render state changes
-        std::sort(meshSegmentInstances.begin(), meshSegmentInstances.end(), [&](MeshSegmentInstance const& lhs, MeshSegmentInstance const& rhs) {
-            return lhs.drawKey.asUint32() < rhs.drawKey.asUint32();
-        });
-    }
+    m_cullingStats.drawnSegmentCount = static_cast<u32>(m_drawList.size());
 
-    return meshSegmentInstances;
+    radixSort(m_drawOrder, m_drawOrderScratch);
 }
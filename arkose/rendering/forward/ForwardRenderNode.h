@@ -3,7 +3,9 @@
 #include "rendering/DrawKey.h"
 #include "rendering/RenderPipelineNode.h"
 #include "rendering/VertexManager.h"
+#include "rendering/forward/ForwardCulling.h"
 #include "rendering/forward/ForwardModes.h"
+#include "utility/RadixSort.h"
 
 class CommandList;
 struct StaticMeshSegment;
@@ -20,6 +22,10 @@ public:
                       ForwardClearMode = ForwardClearMode ::ClearBeforeFirstDraw);
 
     std::string name() const override;
+    void drawGui() override;
+
+    bool supportsParallelRecording() const override { return true; }
+
     ExecuteCallback construct(GpuScene&, Registry&) override;
 
 private:
@@ -28,22 +34,76 @@ private:
     ForwardClearMode m_clearMode;
     bool m_hasPreviousPrepass { false };
 
+    ForwardCulling::Stats m_cullingStats {};
+
+    // Named constants of a forward render state which are set whenever the state is begun
+    struct ForwardStateConstants {
+        NamedConstantHandle ambientAmount {};
+        NamedConstantHandle frustumJitterCorrection {};
+        NamedConstantHandle invTargetSize {};
+        NamedConstantHandle mipBias {};
+        NamedConstantHandle withMaterialColor {};
+
+        static ForwardStateConstants resolve(RenderState const&);
+    };
+
+    struct ForwardRenderState {
+        RenderState* renderState { nullptr };
+        ForwardStateConstants constants {};
+    };
+
     struct BufferStates {
         std::vector<std::pair<Buffer const*, VertexLayout>> vertexBuffers {};
         std::pair<Buffer const*, IndexType> indexBuffer {};
-        bool operator<=>(BufferStates const& other) const = default;
+        bool operator==(BufferStates const& other) const = default;
     };
 
     struct MeshSegmentInstance {
-        MeshSegmentInstance(DrawCallDescription, DrawKey, BufferStates, Transform const&);
+        MeshSegmentInstance(DrawCallDescription, DrawKey, u32 bufferStatesIdx);
         DrawCallDescription drawCall {};
         DrawKey drawKey {};
-        BufferStates bufferStates {};
-        Transform const* transform {};
+        u32 bufferStatesIdx { 0 };
     };
 
+    // All distinct buffer states of the current frame, referred to by index from the draw list (and its sort keys)
+    std::vector<BufferStates> m_bufferStates {};
+    u32 bufferStatesIndex(BufferStates const&);
+
+    // Draw list, and the order to draw it in, which are reused across frames to avoid reallocating them every frame
+    std::vector<MeshSegmentInstance> m_drawList {};
+    std::vector<RadixSortItem> m_drawOrder {};
+    std::vector<RadixSortItem> m_drawOrderScratch {};
+
+    // GPU-driven indirect draws (opaque only, and only when drawing all meshes), with one indirect buffer per render state which is filled in by a compute
+    // pass that culls all drawables of the scene which match the draw key of the render state.
+    static constexpr u32 MaxIndirectDrawsPerRenderState = 16'384;
+    static constexpr u32 IndirectDrawSetupGroupSize = 32;
+
+    struct IndirectDrawState {
+        DrawKey drawKey {};
+        ForwardRenderState forwardRenderState {};
+        Buffer* indirectBuffer { nullptr };
+        Buffer* countBuffer { nullptr };
+        ComputeState* drawSetupComputeState { nullptr };
+
+        // Named constants of the draw setup compute state
+        NamedConstantHandle frustumPlanesConstant {};
+        NamedConstantHandle drawableCountConstant {};
+        NamedConstantHandle drawKeyConstant {};
+        NamedConstantHandle maxDrawCountConstant {};
+        NamedConstantHandle frustumCullConstant {};
+    };
+
+    std::vector<IndirectDrawState> m_indirectDrawStates {};
+    bool m_usingIndirectDraws { false };
+
+    void createIndirectDrawState(Registry&, DrawKey const&, ForwardRenderState const&, Shader const& drawSetupShader);
+    void executeIndirectDraws(GpuScene const&, CommandList&, UploadBuffer&, RenderTarget const&) const;
+    void setPerStateUniforms(GpuScene const&, CommandList&, RenderTarget const&, ForwardStateConstants const&) const;
+
     RenderTarget& makeRenderTarget(Registry&, Mode) const;
     RenderState& makeForwardRenderState(Registry&, GpuScene const&, RenderTarget const&, DrawKey const&) const;
 
-    std::vector<MeshSegmentInstance> generateSortedDrawList(GpuScene const&, Mode, ForwardMeshFilter) const;
+    // Generates `m_drawList` and `m_drawOrder` for the current frame
+    void generateSortedDrawList(GpuScene const&, Mode, ForwardMeshFilter);
 };
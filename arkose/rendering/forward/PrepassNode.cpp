@@ -1,6 +1,7 @@
 #include "PrepassNode.h"
 
 #include "rendering/util/ScopedDebugZone.h"
+#include "scene/MeshInstance.h"
 #include <imgui.h>
 
 PrepassNode::PrepassNode(ForwardMeshFilter meshFilter, ForwardClearMode clearMode)
@@ -9,6 +10,11 @@ PrepassNode::PrepassNode(ForwardMeshFilter meshFilter, ForwardClearMode clearMod
 {
 }
 
+void PrepassNode::drawGui()
+{
+    m_cullingStats.drawGui();
+}
+
 RenderPipelineNode::ExecuteCallback PrepassNode::construct(GpuScene& scene, Registry& reg)
 {
     // Create render target
@@ -18,7 +24,7 @@ RenderPipelineNode::ExecuteCallback PrepassNode::construct(GpuScene& scene, Regi
 
     // Create all render states (PSOs) needed for rendering
 
-    auto& renderStateLookup = reg.allocate<std::unordered_map<u32, RenderState*>>();
+    auto& renderStateLookup = reg.allocate<std::unordered_map<u32, PrepassRenderState>>();
 
     auto stateDrawKeys = { DrawKey({}, BlendMode::Opaque, false, {}),
                            DrawKey({}, BlendMode::Opaque, true, {}),
@@ -26,7 +32,11 @@ RenderPipelineNode::ExecuteCallback PrepassNode::construct(GpuScene& scene, Regi
                            DrawKey({}, BlendMode::Masked, true, {}) };
 
     for (DrawKey const& drawKey : stateDrawKeys) {
-        renderStateLookup[drawKey.asUint32()] = &makeRenderState(reg, scene, renderTarget, drawKey);
+        RenderState& renderState = makeRenderState(reg, scene, renderTarget, drawKey);
+        NamedConstantLookup const& constantLookup = renderState.namedConstantLookup();
+        renderStateLookup[drawKey.asUint32()] = PrepassRenderState { .renderState = &renderState,
+                                                                     .depthOffset = constantLookup.resolveConstant<float>("depthOffset"),
+                                                                     .projectionFromWorld = constantLookup.resolveConstant<mat4>("projectionFromWorld") };
     }
 
     return [&](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
@@ -50,7 +60,8 @@ RenderPipelineNode::ExecuteCallback PrepassNode::construct(GpuScene& scene, Regi
         for (MeshSegmentInstance const& instance : instances) {
 
             if (currentStateDrawKey == nullptr || instance.drawKey != *currentStateDrawKey) {
-                RenderState* renderState = renderStateLookup[instance.drawKey.asUint32()];
+                PrepassRenderState const& prepassRenderState = renderStateLookup[instance.drawKey.asUint32()];
+                RenderState* renderState = prepassRenderState.renderState;
                 ARKOSE_ASSERT(renderState != nullptr);
 
                 if (!firstDraw) {
@@ -61,8 +72,8 @@ RenderPipelineNode::ExecuteCallback PrepassNode::construct(GpuScene& scene, Regi
                 cmdList.beginDebugLabel(renderState->name());
                 cmdList.beginRendering(*renderState);
 
-                cmdList.setNamedUniform("depthOffset", 0.00005f);
-                cmdList.setNamedUniform("projectionFromWorld", scene.camera().viewProjectionMatrix());
+                cmdList.setNamedUniform(prepassRenderState.depthOffset, 0.00005f);
+                cmdList.setNamedUniform(prepassRenderState.projectionFromWorld, scene.camera().viewProjectionMatrix());
 
                 currentStateDrawKey = &instance.drawKey;
             }
@@ -125,27 +136,24 @@ RenderState& PrepassNode::makeRenderState(Registry& reg, GpuScene const& scene,
     return renderState;
 }
 
-std::vector<PrepassNode::MeshSegmentInstance> PrepassNode::generateSortedDrawList(GpuScene const& scene, ForwardMeshFilter meshFilter) const
+std::vector<PrepassNode::MeshSegmentInstance> PrepassNode::generateSortedDrawList(GpuScene const& scene, ForwardMeshFilter meshFilter)
 {
     SCOPED_PROFILE_ZONE();
 
     std::vector<MeshSegmentInstance> meshSegmentInstances {};
 
-    //geometry::Frustum const& cameraFrustum = scene.camera().frustum();
+    m_cullingStats = {};
 
-    auto conditionallyAppendInstance = [&]<typename InstanceType>(InstanceType const& instance, StaticMesh const& mesh) -> void {
-        constexpr u32 lodIdx = 0;
-        StaticMeshLOD const& lod = mesh.lodAtIndex(lodIdx);
+    auto appendInstance = [&]<typename InstanceType>(ForwardCulling::VisibleInstance<InstanceType> const& visibleInstance) -> void {
+        InstanceType const& instance = *visibleInstance.instance;
+        StaticMesh const& mesh = *visibleInstance.mesh;
 
         // Early-out if we know there are no relevant segments
         if (!mesh.hasNonTranslucentSegments()) {
             return;
         }
 
-        // TODO: Add me back! But probably AABB testing ...
-        // if (not cameraFrustum.includesSphere(mesh.boundingSphere())) {
-        //    return;
-        //}
+        StaticMeshLOD const& lod = mesh.lodAtIndex(visibleInstance.lodIdx);
 
         for (u32 segmentIdx = 0; segmentIdx < lod.meshSegments.size(); ++segmentIdx) {
             StaticMeshSegment const& meshSegment = lod.meshSegments[segmentIdx];
@@ -158,6 +166,7 @@ std::vector<PrepassNode::MeshSegmentInstance> PrepassNode::generateSortedDrawLis
                 bool doubleSided = meshSegment.drawKey.doubleSided().value();
                 DrawKey prepassDrawKey = DrawKey({}, blendMode, doubleSided, {});
 
+                // NOTE: Drawables are created for the LOD0 segments, which the segments of the selected LOD correspond to
                 u32 drawableIdx = instance.drawableHandleForSegmentIndex(segmentIdx).template indexOfType<u32>();
                 if constexpr (std::is_same_v<InstanceType, SkeletalMeshInstance>) {
                     if (instance.hasSkinningVertexMappingForSegmentIndex(segmentIdx)) {
@@ -175,22 +184,19 @@ std::vector<PrepassNode::MeshSegmentInstance> PrepassNode::generateSortedDrawLis
     bool includeSkeletalMeshes = meshFilter != ForwardMeshFilter::OnlyStaticMeshes;
 
     if (includeStaticMeshes) {
-        for (auto const& instance : scene.staticMeshInstances()) {
-            if (StaticMesh const* staticMesh = scene.staticMeshForInstance(*instance)) {
-                conditionallyAppendInstance(*instance, *staticMesh);
-            }
+        for (auto const& visibleInstance : ForwardCulling::cullStaticMeshInstances(scene, scene.forwardCullingSettings(), m_cullingStats)) {
+            appendInstance(visibleInstance);
         }
     }
 
     if (includeSkeletalMeshes) {
-        for (auto const& instance : scene.skeletalMeshInstances()) {
-            if (SkeletalMesh const* skeletalMesh = scene.skeletalMeshForInstance(*instance)) {
-                StaticMesh const& underlyingMesh = skeletalMesh->underlyingMesh();
-                conditionallyAppendInstance(*instance, underlyingMesh);
-            }
+        for (auto const& visibleInstance : ForwardCulling::cullSkeletalMeshInstances(scene, scene.forwardCullingSettings(), m_cullingStats)) {
+            appendInstance(visibleInstance);
         }
     }
 
+    m_cullingStats.drawnSegmentCount = static_cast<u32>(meshSegmentInstances.size());
+
     // Sort to minimize render state changes
     std::sort(meshSegmentInstances.begin(), meshSegmentInstances.end(), [&](MeshSegmentInstance const& lhs, MeshSegmentInstance const& rhs) {
         return lhs.drawKey.asUint32() < rhs.drawKey.asUint32();
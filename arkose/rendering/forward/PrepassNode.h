@@ -2,6 +2,7 @@
 
 #include "rendering/RenderPipelineNode.h"
 #include "rendering/GpuScene.h"
+#include "rendering/forward/ForwardCulling.h"
 #include "rendering/forward/ForwardModes.h"
 
 class PrepassNode final : public RenderPipelineNode {
@@ -11,12 +12,25 @@ public:
                 ForwardClearMode = ForwardClearMode ::ClearBeforeFirstDraw);
 
     std::string name() const override { return "Prepass"; }
+    void drawGui() override;
+
+    bool supportsParallelRecording() const override { return true; }
+
     ExecuteCallback construct(GpuScene&, Registry&) override;
 
 private:
     ForwardMeshFilter m_meshFilter;
     ForwardClearMode m_clearMode;
 
+    ForwardCulling::Stats m_cullingStats {};
+
+    // A prepass render state along with its named constants, which are set whenever the state is begun
+    struct PrepassRenderState {
+        RenderState* renderState { nullptr };
+        NamedConstantHandle depthOffset {};
+        NamedConstantHandle projectionFromWorld {};
+    };
+
     struct MeshSegmentInstance {
         MeshSegmentInstance(VertexAllocation, DrawKey, u32 drawableIdx);
         VertexAllocation vertexAllocation {};
@@ -26,5 +40,5 @@ private:
 
     RenderState& makeRenderState(Registry&, GpuScene const&, RenderTarget const&, DrawKey const&) const;
 
-    std::vector<MeshSegmentInstance> generateSortedDrawList(GpuScene const&, ForwardMeshFilter) const;
+    std::vector<MeshSegmentInstance> generateSortedDrawList(GpuScene const&, ForwardMeshFilter);
 };
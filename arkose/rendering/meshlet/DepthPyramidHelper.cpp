@@ -0,0 +1,54 @@
+#include "DepthPyramidHelper.h"
+
+#include "rendering/Registry.h"
+#include "rendering/backend/base/CommandList.h"
+#include "rendering/backend/base/Texture.h"
+#include "rendering/util/ScopedDebugZone.h"
+
+DepthPyramid& DepthPyramidHelper::createDepthPyramid(Registry& reg, Texture& depthTexture, std::string const& name) const
+{
+    Extent2D pyramidExtent = { std::max(depthTexture.extent().width() / 2, 1u),
+                               std::max(depthTexture.extent().height() / 2, 1u) };
+
+    Texture& pyramidTexture = reg.createTexture2D(pyramidExtent, Texture::Format::R32F, Texture::Filters::nearest(), Texture::Mipmap::Nearest, ImageWrapModes::clampAllToEdge());
+    pyramidTexture.setName(name);
+
+    Shader firstMipShader = Shader::createCompute("meshlet/depthPyramidReduce.comp", { ShaderDefine::makeBool("DEPTH_PYRAMID_FIRST_MIP", true) });
+    Shader reduceMipShader = Shader::createCompute("meshlet/depthPyramidReduce.comp", { ShaderDefine::makeBool("DEPTH_PYRAMID_FIRST_MIP", false) });
+
+    DepthPyramid& depthPyramid = reg.allocate<DepthPyramid>();
+    depthPyramid.texture = &pyramidTexture;
+
+    for (u32 mipLevel = 0; mipLevel < pyramidTexture.mipLevels(); ++mipLevel) {
+
+        BindingSet* reduceBindingSet = nullptr;
+        if (mipLevel == 0) {
+            reduceBindingSet = &reg.createBindingSet({ ShaderBinding::sampledTexture(depthTexture, ShaderStage::Compute),
+                                                       ShaderBinding::storageTextureAtMip(pyramidTexture, 0, ShaderStage::Compute) });
+        } else {
+            reduceBindingSet = &reg.createBindingSet({ ShaderBinding::storageTextureAtMip(pyramidTexture, mipLevel - 1, ShaderStage::Compute),
+                                                       ShaderBinding::storageTextureAtMip(pyramidTexture, mipLevel, ShaderStage::Compute) });
+        }
+
+        StateBindings stateBindings;
+        stateBindings.at(0, *reduceBindingSet);
+
+        Shader const& shader = mipLevel == 0 ? firstMipShader : reduceMipShader;
+        depthPyramid.mipReduceStates.push_back(&reg.createComputeState(shader, stateBindings));
+    }
+
+    return depthPyramid;
+}
+
+void DepthPyramidHelper::buildDepthPyramid(CommandList& cmdList, DepthPyramid const& depthPyramid) const
+{
+    ScopedDebugZone zone { cmdList, "Depth pyramid" };
+
+    constexpr Extent3D localSizeForComp { 16, 16, 1 };
+
+    for (u32 mipLevel = 0; mipLevel < depthPyramid.mipReduceStates.size(); ++mipLevel) {
+        cmdList.setComputeState(*depthPyramid.mipReduceStates[mipLevel]);
+        cmdList.dispatch(depthPyramid.texture->extentAtMip(mipLevel), localSizeForComp);
+        cmdList.textureMipWriteBarrier(*depthPyramid.texture, mipLevel);
+    }
+}
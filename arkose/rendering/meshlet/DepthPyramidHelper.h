@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ark/copying.h>
+#include "core/Types.h"
+#include <string>
+#include <vector>
+
+class CommandList;
+class ComputeState;
+class Registry;
+class Texture;
+
+struct DepthPyramid {
+    Texture* texture { nullptr };
+
+    // One state per mip level, each reducing the previous level (or the depth texture, for the first level) into it
+    std::vector<ComputeState*> mipReduceStates {};
+};
+
+class DepthPyramidHelper {
+public:
+    DepthPyramidHelper() = default;
+    ~DepthPyramidHelper() = default;
+    ARK_NON_COPYABLE(DepthPyramidHelper)
+
+    // Create a depth pyramid (hierarchical-Z) for the depth texture, at half its resolution and with a full mip chain. Every
+    // texel contains the max (i.e. farthest) depth of its footprint in the depth texture, for conservative occlusion tests.
+    DepthPyramid& createDepthPyramid(Registry&, Texture& depthTexture, std::string const& name) const;
+
+    // Build all mip levels of the depth pyramid from the current contents of its depth texture
+    void buildDepthPyramid(CommandList&, DepthPyramid const&) const;
+};
@@ -7,6 +7,8 @@ public:
     std::string name() const override { return "Meshlet depth-only"; }
 
 protected:
+    bool supportsOcclusionCulling() const override { return false; }
+
     RenderTarget& makeRenderTarget(Registry&, LoadOp loadOp) const override;
     Shader makeShader(BlendMode, std::vector<ShaderDefine> const& shaderDefines) const override;
 };
@@ -5,6 +5,7 @@
 #include "rendering/backend/util/UploadBuffer.h"
 #include "rendering/backend/base/Buffer.h"
 #include "rendering/backend/base/CommandList.h"
+#include "rendering/backend/base/ComputeState.h"
 #include "rendering/util/ScopedDebugZone.h"
 
 MeshletIndirectBuffer& MeshletIndirectHelper::createIndirectBuffer(Registry& reg, DrawKey drawKeyMask, u32 maxMeshletCount) const
@@ -21,12 +22,17 @@ MeshletIndirectBuffer& MeshletIndirectHelper::createIndirectBuffer(Registry& reg
     return indirectBuffer;
 }
 
-MeshletIndirectSetupState const& MeshletIndirectHelper::createMeshletIndirectSetupState(Registry& reg, std::vector<MeshletIndirectBuffer*> const& indirectBuffers) const
+MeshletIndirectSetupState const& MeshletIndirectHelper::createMeshletIndirectSetupState(Registry& reg, std::vector<MeshletIndirectBuffer*> const& indirectBuffers,
+                                                                                        MeshletOcclusionCullingResources const* occlusionCullingResources) const
 {
-    auto meshletTaskSetupDefines = { ShaderDefine::makeInt("GROUP_SIZE", GroupSize) };
+    std::vector<ShaderDefine> meshletTaskSetupDefines = { ShaderDefine::makeInt("GROUP_SIZE", GroupSize) };
+    if (occlusionCullingResources) {
+        meshletTaskSetupDefines.push_back(ShaderDefine::makeSymbol("MESHLET_OCCLUSION_CULLING"));
+    }
     Shader meshletTaskSetupShader = Shader::createCompute("meshlet/meshletTaskSetup.comp", meshletTaskSetupDefines);
 
     MeshletIndirectSetupState& state = reg.allocate<MeshletIndirectSetupState>();
+    state.supportsOcclusionCulling = occlusionCullingResources != nullptr;
 
     for (MeshletIndirectBuffer* indirectBuffer : indirectBuffers) {
 
@@ -36,13 +42,32 @@ MeshletIndirectSetupState const& MeshletIndirectHelper::createMeshletIndirectSet
 
         MeshletIndirectSetupDispatch& dispatch = state.dispatches.emplace_back();
         dispatch.drawKeyMask = indirectBuffer->drawKeyMask;
-        dispatch.indirectDataBindingSet = &reg.createBindingSet({ ShaderBinding::storageBuffer(*reg.getBuffer("SceneObjectData")),
-                                                                  ShaderBinding::storageBuffer(*indirectBuffer->buffer) });
+        if (occlusionCullingResources) {
+            dispatch.indirectDataBindingSet = &reg.createBindingSet({ ShaderBinding::storageBuffer(*reg.getBuffer("SceneObjectData")),
+                                                                      ShaderBinding::storageBuffer(*indirectBuffer->buffer),
+                                                                      ShaderBinding::storageBuffer(*occlusionCullingResources->cullingStatsBuffer),
+                                                                      ShaderBinding::sampledTexture(*occlusionCullingResources->previousDepthPyramid),
+                                                                      ShaderBinding::sampledTexture(*occlusionCullingResources->depthPyramid) });
+        } else {
+            dispatch.indirectDataBindingSet = &reg.createBindingSet({ ShaderBinding::storageBuffer(*reg.getBuffer("SceneObjectData")),
+                                                                      ShaderBinding::storageBuffer(*indirectBuffer->buffer) });
+        }
 
         StateBindings stateBindings;
         stateBindings.at(0, *dispatch.indirectDataBindingSet);
 
         dispatch.taskSetupComputeState = &reg.createComputeState(meshletTaskSetupShader, stateBindings);
+
+        NamedConstantLookup const& constantLookup = dispatch.taskSetupComputeState->namedConstantLookup();
+        dispatch.drawableCountConstant = constantLookup.resolveConstant<u32>("drawableCount");
+        dispatch.drawKeyMaskConstant = constantLookup.resolveConstant<u32>("drawKeyMask");
+        if (occlusionCullingResources) {
+            dispatch.occlusionCullingPhaseConstant = constantLookup.resolveConstant<u32>("occlusionCullingPhase");
+            dispatch.frustumCullConstant = constantLookup.resolveConstant<bool>("frustumCull");
+            dispatch.frustumPlanesConstant = constantLookup.resolveConstant<geometry::Plane[6]>("frustumPlanes");
+            dispatch.projectionFromWorldConstant = constantLookup.resolveConstant<mat4>("projectionFromWorld");
+            dispatch.previousProjectionFromWorldConstant = constantLookup.resolveConstant<mat4>("previousProjectionFromWorld");
+        }
     }
 
     return state;
@@ -61,11 +86,29 @@ void MeshletIndirectHelper::executeMeshletIndirectSetup(GpuScene& scene, Command
 
     const u32 drawableCount = narrow_cast<u32>(scene.drawableCountForFrame());
 
+    ARKOSE_ASSERT(state.supportsOcclusionCulling || (!options.cullingFrustum.has_value() && options.occlusionCullingPhase == MeshletOcclusionCullingPhase::None));
+
+    size_t frustumPlaneDataSize = 0;
+    void const* frustumPlaneData = nullptr;
+    if (options.cullingFrustum.has_value()) {
+        frustumPlaneData = reinterpret_cast<void const*>(options.cullingFrustum->rawPlaneData(&frustumPlaneDataSize));
+    }
+
     for (MeshletIndirectSetupDispatch const& dispatch : state.dispatches) {
         cmdList.setComputeState(*dispatch.taskSetupComputeState);
 
-        cmdList.setNamedUniform("drawableCount", drawableCount);
-        cmdList.setNamedUniform("drawKeyMask", dispatch.drawKeyMask.asUint32());
+        cmdList.setNamedUniform(dispatch.drawableCountConstant, drawableCount);
+        cmdList.setNamedUniform(dispatch.drawKeyMaskConstant, dispatch.drawKeyMask.asUint32());
+
+        if (state.supportsOcclusionCulling) {
+            cmdList.setNamedUniform(dispatch.occlusionCullingPhaseConstant, static_cast<u32>(options.occlusionCullingPhase));
+            cmdList.setNamedUniform(dispatch.frustumCullConstant, options.cullingFrustum.has_value());
+            if (frustumPlaneData != nullptr) {
+                cmdList.setNamedUniform(dispatch.frustumPlanesConstant, frustumPlaneData, frustumPlaneDataSize);
+            }
+            cmdList.setNamedUniform(dispatch.projectionFromWorldConstant, options.projectionFromWorld);
+            cmdList.setNamedUniform(dispatch.previousProjectionFromWorldConstant, options.previousProjectionFromWorld);
+        }
 
         cmdList.dispatch({ drawableCount, 1, 1 }, { GroupSize, 1, 1 });
     }
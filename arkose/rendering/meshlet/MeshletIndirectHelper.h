@@ -2,17 +2,40 @@
 
 #include <ark/copying.h>
 #include "core/Types.h"
+#include "core/math/Frustum.h"
 #include "rendering/DrawKey.h"
+#include "rendering/backend/shader/NamedConstant.h"
+#include <optional>
 #include <vector>
 
+// Shared shader headers
+#include "shaders/shared/SceneData.h"
+
 class BindingSet;
 class Buffer;
 class CommandList;
 class ComputeState;
 class GpuScene;
 class Registry;
+class Texture;
 class UploadBuffer;
 
+enum class MeshletOcclusionCullingPhase : u32 {
+    None = MESHLET_OCCLUSION_CULLING_PHASE_NONE,
+    Early = MESHLET_OCCLUSION_CULLING_PHASE_EARLY,
+    Late = MESHLET_OCCLUSION_CULLING_PHASE_LATE,
+};
+
+// Resources needed for (two-phase) occlusion culling, in both the task setup and in the task shaders
+struct MeshletOcclusionCullingResources {
+    // Depth pyramid of last frame's depth, used in the early phase
+    Texture* previousDepthPyramid { nullptr };
+    // Depth pyramid of the depth drawn in the early phase, used in the late phase
+    Texture* depthPyramid { nullptr };
+    // Buffer containing a single `ShaderMeshletCullingStats`
+    Buffer* cullingStatsBuffer { nullptr };
+};
+
 struct MeshletIndirectBuffer {
     Buffer* buffer { nullptr };
     DrawKey drawKeyMask {};
@@ -22,6 +45,15 @@ struct MeshletIndirectSetupDispatch {
     DrawKey drawKeyMask {};
     ComputeState* taskSetupComputeState { nullptr };
     BindingSet* indirectDataBindingSet { nullptr };
+
+    // Named constants of the task setup compute state, where all but the first two require occlusion culling support
+    NamedConstantHandle drawableCountConstant {};
+    NamedConstantHandle drawKeyMaskConstant {};
+    NamedConstantHandle occlusionCullingPhaseConstant {};
+    NamedConstantHandle frustumCullConstant {};
+    NamedConstantHandle frustumPlanesConstant {};
+    NamedConstantHandle projectionFromWorldConstant {};
+    NamedConstantHandle previousProjectionFromWorldConstant {};
 };
 
 struct MeshletIndirectSetupState {
@@ -29,10 +61,20 @@ struct MeshletIndirectSetupState {
     std::vector<Buffer*> rawIndirectBuffers {};
 
     std::vector<MeshletIndirectSetupDispatch> dispatches {};
+
+    // Only if the state was created with occlusion culling resources
+    bool supportsOcclusionCulling { false };
 };
 
 struct MeshletIndirectSetupOptions {
-    // ..
+    // NOTE: All options below require that the setup state was created with occlusion culling resources
+
+    // Cull drawables against the frustum, if specified
+    std::optional<geometry::Frustum> cullingFrustum {};
+
+    MeshletOcclusionCullingPhase occlusionCullingPhase { MeshletOcclusionCullingPhase::None };
+    mat4 projectionFromWorld {};
+    mat4 previousProjectionFromWorld {};
 };
 
 class MeshletIndirectHelper {
@@ -45,7 +87,8 @@ public:
     MeshletIndirectBuffer& createIndirectBuffer(Registry&, DrawKey drawKeyMask, u32 maxMeshletCount) const;
 
     // Create the state needed for meshlet task setup execution
-    MeshletIndirectSetupState const& createMeshletIndirectSetupState(Registry&, std::vector<MeshletIndirectBuffer*> const& indirectBuffers) const;
+    MeshletIndirectSetupState const& createMeshletIndirectSetupState(Registry&, std::vector<MeshletIndirectBuffer*> const& indirectBuffers,
+                                                                     MeshletOcclusionCullingResources const* = nullptr) const;
 
     // Execute the meshlet task setup, from the given state
     void executeMeshletIndirectSetup(GpuScene&, CommandList&, UploadBuffer&, MeshletIndirectSetupState const&, MeshletIndirectSetupOptions const&) const;
@@ -8,22 +8,60 @@
 void MeshletVisibilityBufferRenderNode::drawGui()
 {
     ImGui::Checkbox("Frustum cull meshlets", &m_frustumCullMeshlets);
+
+    if (supportsOcclusionCulling()) {
+        ImGui::Checkbox("Occlusion cull meshlets", &m_occlusionCulling);
+        ImGui::Text("Meshlets drawn: %u (early phase), %u (late phase)", m_cullingStats.drawnEarlyCount, m_cullingStats.drawnLateCount);
+        ImGui::Text("Meshlets culled: %u (frustum), %u (occlusion)", m_cullingStats.frustumCulledCount, m_cullingStats.occlusionCulledCount);
+    }
 }
 
 RenderPipelineNode::ExecuteCallback MeshletVisibilityBufferRenderNode::construct(GpuScene& scene, Registry& reg)
 {
-    std::vector<RenderStateWithIndirectData*> const& renderStates = createRenderStates(reg, scene);
+    MeshletOcclusionCullingResources* occlusionCullingResources = nullptr;
+    DepthPyramid* previousDepthPyramid = nullptr;
+    DepthPyramid* depthPyramid = nullptr;
+    ReadbackRing* cullingStatsReadback = nullptr;
+
+    if (supportsOcclusionCulling()) {
+        Texture& sceneDepth = *reg.getTexture("SceneDepth");
+        previousDepthPyramid = &m_depthPyramidHelper.createDepthPyramid(reg, sceneDepth, "MeshletPreviousDepthPyramid");
+        depthPyramid = &m_depthPyramidHelper.createDepthPyramid(reg, sceneDepth, "MeshletDepthPyramid");
+
+        Buffer& cullingStatsBuffer = reg.createBuffer(sizeof(ShaderMeshletCullingStats), Buffer::Usage::StorageBuffer);
+        cullingStatsBuffer.setName("MeshletCullingStats");
+        cullingStatsReadback = &reg.createReadbackRing(sizeof(ShaderMeshletCullingStats));
+
+        occlusionCullingResources = &reg.allocate<MeshletOcclusionCullingResources>();
+        occlusionCullingResources->previousDepthPyramid = previousDepthPyramid->texture;
+        occlusionCullingResources->depthPyramid = depthPyramid->texture;
+        occlusionCullingResources->cullingStatsBuffer = &cullingStatsBuffer;
+    }
 
-    // TODO: If we collect render states and indirect buffers into separate arrays we won't have to do this...
-    // However, it potentially make other code more messy, so perhaps not worth doing.
-    std::vector<MeshletIndirectBuffer*> indirectBuffers {};
-    for (auto const& renderState : renderStates) {
-        indirectBuffers.push_back(renderState->indirectBuffer);
+    // With occlusion culling these are the render states of the early phase, and the late phase gets its own set
+    MeshletOcclusionCullingPhase firstPhase = occlusionCullingResources ? MeshletOcclusionCullingPhase::Early : MeshletOcclusionCullingPhase::None;
+    std::vector<RenderStateWithIndirectData*> const& renderStates = createRenderStates(reg, scene, firstPhase, occlusionCullingResources);
+
+    auto createIndirectSetupState = [&](std::vector<RenderStateWithIndirectData*> const& passRenderStates) -> MeshletIndirectSetupState const& {
+        // TODO: If we collect render states and indirect buffers into separate arrays we won't have to do this...
+        // However, it potentially make other code more messy, so perhaps not worth doing.
+        std::vector<MeshletIndirectBuffer*> indirectBuffers {};
+        for (auto const& renderState : passRenderStates) {
+            indirectBuffers.push_back(renderState->indirectBuffer);
+        }
+        return m_meshletIndirectHelper.createMeshletIndirectSetupState(reg, indirectBuffers, occlusionCullingResources);
+    };
+
+    MeshletIndirectSetupState const& indirectSetupState = createIndirectSetupState(renderStates);
+
+    std::vector<RenderStateWithIndirectData*> const* lateRenderStates = nullptr;
+    MeshletIndirectSetupState const* lateIndirectSetupState = nullptr;
+    if (occlusionCullingResources) {
+        lateRenderStates = &createRenderStates(reg, scene, MeshletOcclusionCullingPhase::Late, occlusionCullingResources);
+        lateIndirectSetupState = &createIndirectSetupState(*lateRenderStates);
     }
-    MeshletIndirectSetupState const& indirectSetupState = m_meshletIndirectHelper.createMeshletIndirectSetupState(reg, indirectBuffers);
 
-    return [&](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
-        m_meshletIndirectHelper.executeMeshletIndirectSetup(scene, cmdList, uploadBuffer, indirectSetupState, {});
+    return [&, occlusionCullingResources, previousDepthPyramid, depthPyramid, cullingStatsReadback, lateRenderStates, lateIndirectSetupState](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
 
         mat4 projectionFromWorld = calculateViewProjectionMatrix(scene);
 
@@ -31,24 +69,76 @@ RenderPipelineNode::ExecuteCallback MeshletVisibilityBufferRenderNode::construct
         size_t frustumPlaneDataSize;
         void const* frustumPlaneData = reinterpret_cast<void const*>(cullingFrustum.rawPlaneData(&frustumPlaneDataSize));
 
-        for (RenderStateWithIndirectData* renderState : renderStates) {
+        bool occlusionCulling = occlusionCullingResources != nullptr && m_occlusionCulling;
+        MeshletOcclusionCullingPhase phase = occlusionCulling ? MeshletOcclusionCullingPhase::Early : MeshletOcclusionCullingPhase::None;
+
+        MeshletIndirectSetupOptions setupOptions {};
 
-            // NOTE: If render target is not set up to clear then the clear value specified here is arbitrary
-            cmdList.beginRendering(*renderState->renderState, ClearValue::blackAtMaxDepth());
+        if (occlusionCullingResources) {
+            // Pick up the stats of the latest frame which has completed on the GPU
+            cullingStatsReadback->newFrame(appState.frameIndex());
 
-            if (usingDepthBias()) {
-                vec2 depthBiasParams = depthBiasParameters(scene);
-                cmdList.setDepthBias(depthBiasParams.x, depthBiasParams.y);
+            cmdList.fillBuffer(*occlusionCullingResources->cullingStatsBuffer, 0);
+            cmdList.bufferWriteBarrier({ occlusionCullingResources->cullingStatsBuffer });
+
+            // Cull whole drawables against the frustum already in the setup, so they don't even get to the task shader
+            if (m_frustumCullMeshlets) {
+                setupOptions.cullingFrustum = cullingFrustum;
+            }
+
+            setupOptions.occlusionCullingPhase = phase;
+            setupOptions.projectionFromWorld = projectionFromWorld;
+            setupOptions.previousProjectionFromWorld = scene.camera().previousFrameViewProjectionMatrix();
+
+            // The scene depth still contains the depth of last frame at this point, before the first pass clears it
+            if (occlusionCulling) {
+                m_depthPyramidHelper.buildDepthPyramid(cmdList, *previousDepthPyramid);
             }
+        }
+
+        auto drawPasses = [&](MeshletIndirectSetupState const& setupState, std::vector<RenderStateWithIndirectData*> const& passRenderStates) {
+            m_meshletIndirectHelper.executeMeshletIndirectSetup(scene, cmdList, uploadBuffer, setupState, setupOptions);
+
+            for (RenderStateWithIndirectData* renderState : passRenderStates) {
+
+                // NOTE: If render target is not set up to clear then the clear value specified here is arbitrary
+                cmdList.beginRendering(*renderState->renderState, ClearValue::blackAtMaxDepth());
 
-            cmdList.setNamedUniform("projectionFromWorld", projectionFromWorld);
-            cmdList.setNamedUniform("frustumPlanes", frustumPlaneData, frustumPlaneDataSize);
-            cmdList.setNamedUniform("frustumCullMeshlets", m_frustumCullMeshlets);
+                if (usingDepthBias()) {
+                    vec2 depthBiasParams = depthBiasParameters(scene);
+                    cmdList.setDepthBias(depthBiasParams.x, depthBiasParams.y);
+                }
 
-            MeshletIndirectBuffer& indirectBuffer = *renderState->indirectBuffer;
-            m_meshletIndirectHelper.drawMeshletsWithIndirectBuffer(cmdList, indirectBuffer);
+                cmdList.setNamedUniform(renderState->projectionFromWorldConstant, projectionFromWorld);
+                cmdList.setNamedUniform(renderState->frustumPlanesConstant, frustumPlaneData, frustumPlaneDataSize);
+                cmdList.setNamedUniform(renderState->frustumCullMeshletsConstant, m_frustumCullMeshlets);
 
-            cmdList.endRendering();
+                if (occlusionCullingResources) {
+                    cmdList.setNamedUniform(renderState->occlusionCullingPhaseConstant, static_cast<u32>(setupOptions.occlusionCullingPhase));
+                    cmdList.setNamedUniform(renderState->previousProjectionFromWorldConstant, setupOptions.previousProjectionFromWorld);
+                }
+
+                MeshletIndirectBuffer& indirectBuffer = *renderState->indirectBuffer;
+                m_meshletIndirectHelper.drawMeshletsWithIndirectBuffer(cmdList, indirectBuffer);
+
+                cmdList.endRendering();
+            }
+        };
+
+        drawPasses(indirectSetupState, renderStates);
+
+        if (occlusionCulling) {
+            // Re-test everything that was culled in the early phase against the depth of what we've drawn so far
+            m_depthPyramidHelper.buildDepthPyramid(cmdList, *depthPyramid);
+
+            setupOptions.occlusionCullingPhase = MeshletOcclusionCullingPhase::Late;
+            drawPasses(*lateIndirectSetupState, *lateRenderStates);
+        }
+
+        if (occlusionCullingResources) {
+            cullingStatsReadback->readback<ShaderMeshletCullingStats>(cmdList, *occlusionCullingResources->cullingStatsBuffer, 0, [this](ShaderMeshletCullingStats const& cullingStats) {
+                m_cullingStats = cullingStats;
+            });
         }
     };
 }
@@ -89,10 +179,14 @@ MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData& MeshletVisibilit
     i32 maxVertexCount = 64;
     i32 maxPrimitiveCount = 126;
 
-    auto shaderDefines = { ShaderDefine::makeInt("VISBUF_BLEND_MODE", blendModeToShaderBlendMode(blendMode)),
-                           ShaderDefine::makeInt("GROUP_SIZE", groupSize),
-                           ShaderDefine::makeInt("MAX_VERTEX_COUNT", maxVertexCount),
-                           ShaderDefine::makeInt("MAX_PRIMITIVE_COUNT", maxPrimitiveCount) };
+    std::vector<ShaderDefine> shaderDefines = { ShaderDefine::makeInt("VISBUF_BLEND_MODE", blendModeToShaderBlendMode(blendMode)),
+                                                ShaderDefine::makeInt("GROUP_SIZE", groupSize),
+                                                ShaderDefine::makeInt("MAX_VERTEX_COUNT", maxVertexCount),
+                                                ShaderDefine::makeInt("MAX_PRIMITIVE_COUNT", maxPrimitiveCount) };
+
+    if (passSettings.occlusionCullingResources) {
+        shaderDefines.push_back(ShaderDefine::makeSymbol("MESHLET_OCCLUSION_CULLING"));
+    }
 
     Shader shader = makeShader(blendMode, shaderDefines);
 
@@ -113,9 +207,17 @@ MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData& MeshletVisibilit
 
     VertexManager const& vertexManager = scene.vertexManager();
 
-    BindingSet& taskShaderBindingSet = reg.createBindingSet({ ShaderBinding::storageBufferReadonly(*indirectBuffer.buffer),
-                                                              ShaderBinding::storageBufferReadonly(*reg.getBuffer("SceneObjectData")),
-                                                              ShaderBinding::storageBufferReadonly(vertexManager.meshletBuffer()) });
+    std::vector<ShaderBinding> taskShaderBindings = { ShaderBinding::storageBufferReadonly(*indirectBuffer.buffer),
+                                                      ShaderBinding::storageBufferReadonly(*reg.getBuffer("SceneObjectData")),
+                                                      ShaderBinding::storageBufferReadonly(vertexManager.meshletBuffer()) };
+
+    if (MeshletOcclusionCullingResources const* occlusionCullingResources = passSettings.occlusionCullingResources) {
+        taskShaderBindings.push_back(ShaderBinding::storageBuffer(*occlusionCullingResources->cullingStatsBuffer));
+        taskShaderBindings.push_back(ShaderBinding::sampledTexture(*occlusionCullingResources->previousDepthPyramid));
+        taskShaderBindings.push_back(ShaderBinding::sampledTexture(*occlusionCullingResources->depthPyramid));
+    }
+
+    BindingSet& taskShaderBindingSet = reg.createBindingSet(taskShaderBindings);
 
     BindingSet& meshShaderBindingSet = reg.createBindingSet({ ShaderBinding::storageBufferReadonly(vertexManager.meshletIndexBuffer()),
                                                               ShaderBinding::storageBufferReadonly(vertexManager.meshletVertexIndirectionBuffer()),
@@ -138,13 +240,25 @@ MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData& MeshletVisibilit
     auto& renderStateWithIndirectData = reg.allocate<RenderStateWithIndirectData>();
     renderStateWithIndirectData.renderState = &renderState;
     renderStateWithIndirectData.indirectBuffer = &indirectBuffer;
+
+    NamedConstantLookup const& constantLookup = renderState.namedConstantLookup();
+    renderStateWithIndirectData.projectionFromWorldConstant = constantLookup.resolveConstant<mat4>("projectionFromWorld");
+    renderStateWithIndirectData.frustumPlanesConstant = constantLookup.resolveConstant<geometry::Plane[6]>("frustumPlanes");
+    renderStateWithIndirectData.frustumCullMeshletsConstant = constantLookup.resolveConstant<bool>("frustumCullMeshlets");
+    if (passSettings.occlusionCullingResources) {
+        renderStateWithIndirectData.occlusionCullingPhaseConstant = constantLookup.resolveConstant<u32>("occlusionCullingPhase");
+        renderStateWithIndirectData.previousProjectionFromWorldConstant = constantLookup.resolveConstant<mat4>("previousProjectionFromWorld");
+    }
+
     return renderStateWithIndirectData;
 }
 
-std::vector<MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData*>& MeshletVisibilityBufferRenderNode::createRenderStates(Registry& reg, GpuScene const& scene) const
+std::vector<MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData*>& MeshletVisibilityBufferRenderNode::createRenderStates(Registry& reg, GpuScene const& scene,
+                                                                                                                                   MeshletOcclusionCullingPhase occlusionCullingPhase,
+                                                                                                                                   MeshletOcclusionCullingResources const* occlusionCullingResources) const
 {
     std::vector<PassSettings> passes {};
-    std::string debugName = "MeshletVisibility";
+    std::string debugName = occlusionCullingPhase == MeshletOcclusionCullingPhase::Late ? "MeshletVisibilityLate" : "MeshletVisibility";
 
     // NOTE: We don't discriminate between BRDFs, include all in the same draw call
     auto brdfMask = std::optional<Brdf>();
@@ -170,13 +284,15 @@ std::vector<MeshletVisibilityBufferRenderNode::RenderStateWithIndirectData*>& Me
                        .maxMeshlets = 50'000,
                        .debugName = debugName + "MaskedDoubleSided" });
 
-    // Ensure that the first pass is marked as such, so we know to clear the render targets before starting the pass
-    if (passes.size() > 0) {
+    // Ensure that the first pass is marked as such, so we know to clear the render targets before starting the pass.
+    // The late phase of occlusion culling draws on top of what the early phase drew, so then nothing should be cleared.
+    if (passes.size() > 0 && occlusionCullingPhase != MeshletOcclusionCullingPhase::Late) {
         passes.front().firstPass = true;
     }
 
     auto& renderStates = reg.allocate<std::vector<RenderStateWithIndirectData*>>();
-    for (PassSettings const& pass : passes) {
+    for (PassSettings& pass : passes) {
+        pass.occlusionCullingResources = occlusionCullingResources;
         renderStates.push_back(&makeRenderState(reg, scene, pass));
     }
 
@@ -2,6 +2,7 @@
 
 #include "core/math/Frustum.h"
 #include "rendering/RenderPipelineNode.h"
+#include "rendering/meshlet/DepthPyramidHelper.h"
 #include "rendering/meshlet/MeshletIndirectHelper.h"
 
 class MeshletVisibilityBufferRenderNode : public RenderPipelineNode {
@@ -9,25 +10,44 @@ public:
     std::string name() const override { return "Meshlet visibility buffer"; }
     void drawGui() override;
 
+    bool supportsParallelRecording() const override { return true; }
+
     ExecuteCallback construct(GpuScene&, Registry&) override;
 
 protected:
     MeshletIndirectHelper m_meshletIndirectHelper {};
     bool m_frustumCullMeshlets { true };
 
+    DepthPyramidHelper m_depthPyramidHelper {};
+    bool m_occlusionCulling { true };
+
+    // Read back from the GPU with some frames of latency, so only for display
+    ShaderMeshletCullingStats m_cullingStats {};
+
     struct PassSettings {
         DrawKey drawKeyMask {};
         u32 maxMeshlets { 10'000 };
         std::string debugName {};
         bool firstPass { false };
+        MeshletOcclusionCullingResources const* occlusionCullingResources { nullptr };
     };
 
     struct RenderStateWithIndirectData {
         RenderState* renderState { nullptr };
         MeshletIndirectBuffer* indirectBuffer { nullptr };
+
+        // Named constants of the render state, where the last two require occlusion culling support
+        NamedConstantHandle projectionFromWorldConstant {};
+        NamedConstantHandle frustumPlanesConstant {};
+        NamedConstantHandle frustumCullMeshletsConstant {};
+        NamedConstantHandle occlusionCullingPhaseConstant {};
+        NamedConstantHandle previousProjectionFromWorldConstant {};
     };
 
     virtual bool usingDepthBias() const { return false; }
+
+    // Occlusion culling requires that the view renders to the scene depth, which is not the case for e.g. shadow views
+    virtual bool supportsOcclusionCulling() const { return true; }
     virtual vec2 depthBiasParameters(GpuScene&) const { return vec2(0.0f, 0.0f); }
 
     virtual mat4 calculateViewProjectionMatrix(GpuScene&) const;
@@ -37,5 +57,6 @@ protected:
     virtual Shader makeShader(BlendMode, std::vector<ShaderDefine> const& shaderDefines) const;
 
     RenderStateWithIndirectData& makeRenderState(Registry&, GpuScene const&, PassSettings) const;
-    std::vector<RenderStateWithIndirectData*>& createRenderStates(Registry&, GpuScene const&) const;
+    std::vector<RenderStateWithIndirectData*>& createRenderStates(Registry&, GpuScene const&, MeshletOcclusionCullingPhase = MeshletOcclusionCullingPhase::None,
+                                                                  MeshletOcclusionCullingResources const* = nullptr) const;
 };
@@ -18,10 +18,10 @@ RenderPipelineNode::ExecuteCallback BloomNode::construct(GpuScene& scene, Regist
 
     Texture& mainTexture = *reg.getTexture("SceneColor");
 
-    Texture& downsampleTex = reg.createTexture2D(mainTexture.extent(), Texture::Format::RGBA16F, Texture::Filters::linear(), Texture::Mipmap::Linear, ImageWrapModes::clampAllToEdge());
+    Texture& downsampleTex = reg.createTransientTexture2D(mainTexture.extent(), Texture::Format::RGBA16F, Texture::Filters::linear(), Texture::Mipmap::Linear, ImageWrapModes::clampAllToEdge());
     downsampleTex.setName("BloomDownsampleTexture");
 
-    Texture& upsampleTex = reg.createTexture2D(mainTexture.extent(), Texture::Format::RGBA16F, Texture::Filters::linear(), Texture::Mipmap::Linear, ImageWrapModes::clampAllToEdge());
+    Texture& upsampleTex = reg.createTransientTexture2D(mainTexture.extent(), Texture::Format::RGBA16F, Texture::Filters::linear(), Texture::Mipmap::Linear, ImageWrapModes::clampAllToEdge());
     upsampleTex.setName("BloomUpsampleTexture");
 
     Shader downsampleShader = Shader::createCompute("bloom/downsample.comp");
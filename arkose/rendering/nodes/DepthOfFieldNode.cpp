@@ -24,8 +24,8 @@ RenderPipelineNode::ExecuteCallback DepthOfFieldNode::construct(GpuScene& scene,
     Texture& sceneColor = *reg.getTexture("SceneColor");
     Texture& sceneDepth= *reg.getTexture("SceneDepth");
 
-    Texture& circleOfConfusionTex = reg.createTexture2D(pipeline().renderResolution(), Texture::Format::R16F);
-    Texture& depthOfFieldTex = reg.createTexture2D(pipeline().renderResolution(), Texture::Format::RGBA16F);
+    Texture& circleOfConfusionTex = reg.createTransientTexture2D(pipeline().renderResolution(), Texture::Format::R16F);
+    Texture& depthOfFieldTex = reg.createTransientTexture2D(pipeline().renderResolution(), Texture::Format::RGBA16F);
 
     // CoC calculation step
     BindingSet& calculateCocBindingSet = reg.createBindingSet({ ShaderBinding::storageTexture(circleOfConfusionTex, ShaderStage::Compute),
@@ -16,9 +16,12 @@
 
 RenderPipelineNode::ExecuteCallback PickingNode::construct(GpuScene& scene, Registry& reg)
 {
-    Buffer& resultBuffer = reg.createBuffer(sizeof(PickingData), Buffer::Usage::Readback);
+    Buffer& resultBuffer = reg.createBuffer(sizeof(PickingData), Buffer::Usage::StorageBuffer);
     resultBuffer.setStride(sizeof(PickingData));
 
+    // The result is read back asynchronously, so it's processed some frames after the click
+    ReadbackRing& resultReadback = reg.createReadbackRing(sizeof(PickingData));
+
     Texture& indexTexture = reg.createTexture2D(pipeline().outputResolution(), Texture::Format::R32Uint);
     Texture& depthTexture = reg.createTexture2D(pipeline().outputResolution(), Texture::Format::Depth32F);
 
@@ -50,14 +53,8 @@ RenderPipelineNode::ExecuteCallback PickingNode::construct(GpuScene& scene, Regi
 
     return [&](const AppState& appState, CommandList& cmdList, UploadBuffer& uploadBuffer) {
 
-        // TODO: Implement some proper CPU readback context so we know for sure that the previous result
-        // is ready at this point. Just because it's from the previous frame doesn't mean it must be done.
-        // What if we submit the queue and immediately start work on the next frame before the first is
-        // even started? And many more similar scenarios.
-        if (m_pendingDeferredResult.has_value()) {
-            processDeferredResult(cmdList, scene, m_pendingDeferredResult.value());
-            m_pendingDeferredResult.reset();
-        }
+        // Process the results of earlier picks which are now available on the CPU
+        resultReadback.newFrame(appState.frameIndex());
 
         auto& input = Input::instance();
         vec2 pickLocation = input.mousePosition();
@@ -157,21 +154,20 @@ RenderPipelineNode::ExecuteCallback PickingNode::construct(GpuScene& scene, Regi
         cmdList.setNamedUniform("mousePosition", pickLocation);
         cmdList.dispatch(indexTexture.extent(), { 16, 16, 1 });
 
-        m_pendingDeferredResult = DeferredResult { .resultBuffer = &resultBuffer,
-                                                   .selectMesh = meshSelectPick,
-                                                   .specifyFocusDepth = focusDepthPick };
+        PickRequest pickRequest { .selectMesh = meshSelectPick,
+                                  .specifyFocusDepth = focusDepthPick };
+        resultReadback.readback<PickingData>(cmdList, resultBuffer, 0, [this, &scene, pickRequest](PickingData const& pickingData) {
+            processPickingResult(scene, pickRequest, pickingData);
+        });
     };
 }
 
-void PickingNode::processDeferredResult(CommandList& cmdList, GpuScene& scene, const DeferredResult& deferredResult)
+void PickingNode::processPickingResult(GpuScene& scene, PickRequest pickRequest, PickingData const& pickingData)
 {
     // At least one must be specified
-    ARKOSE_ASSERT(deferredResult.selectMesh || deferredResult.specifyFocusDepth);
-
-    PickingData pickingData;
-    cmdList.slowBlockingReadFromBuffer(*deferredResult.resultBuffer, 0, sizeof(pickingData), &pickingData);
+    ARKOSE_ASSERT(pickRequest.selectMesh || pickRequest.specifyFocusDepth);
 
-    if (deferredResult.selectMesh) {
+    if (pickRequest.selectMesh) {
         EditorScene& editorScene = scene.scene().editorScene();
 
         DrawableObjectHandle pickedHandle = DrawableObjectHandle(pickingData.drawableIdx);
@@ -183,7 +179,7 @@ void PickingNode::processDeferredResult(CommandList& cmdList, GpuScene& scene, c
         }
     }
 
-    if (deferredResult.specifyFocusDepth) {
+    if (pickRequest.specifyFocusDepth) {
         setFocusDepth(scene, pickingData.depth);
     }
 }
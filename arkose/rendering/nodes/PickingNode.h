@@ -2,6 +2,8 @@
 
 #include "rendering/RenderPipelineNode.h"
 
+struct PickingData;
+
 class PickingNode final : public RenderPipelineNode {
 public:
 
@@ -9,16 +11,12 @@ public:
     ExecuteCallback construct(GpuScene&, Registry&) override;
 
 private:
-    struct DeferredResult {
-        Buffer* resultBuffer {};
-
+    struct PickRequest {
         // What should we use the result for?
         bool selectMesh { false };
         bool specifyFocusDepth { false };
     };
 
-    std::optional<DeferredResult> m_pendingDeferredResult {};
-
-    void processDeferredResult(CommandList& cmdList, GpuScene&, const DeferredResult&);
+    void processPickingResult(GpuScene&, PickRequest, PickingData const&);
     void setFocusDepth(GpuScene&, float focusDepth);
 };
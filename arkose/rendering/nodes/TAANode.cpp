@@ -29,8 +29,8 @@ RenderPipelineNode::ExecuteCallback TAANode::construct(GpuScene& scene, Registry
     Texture& currentFrameVelocity = *reg.getTexture("SceneNormalVelocity");
 
     Texture& accumulationTexture = reg.createTexture2D(currentFrameTexture.extent(), Texture::Format::RGBA16F);
-    Texture& historyTexture = reg.createTexture2D(currentFrameTexture.extent(), currentFrameTexture.format(),
-                                                  Texture::Filters::linear(), Texture::Mipmap::None, ImageWrapModes::clampAllToEdge());
+    Texture& historyTexture = reg.createTransientTexture2D(currentFrameTexture.extent(), currentFrameTexture.format(),
+                                                           Texture::Filters::linear(), Texture::Mipmap::None, ImageWrapModes::clampAllToEdge());
 
     BindingSet& taaBindingSet = reg.createBindingSet({ ShaderBinding::storageTexture(accumulationTexture, ShaderStage::Compute),
                                                        ShaderBinding::sampledTexture(currentFrameTexture, ShaderStage::Compute),
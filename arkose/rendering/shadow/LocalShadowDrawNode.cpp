@@ -98,9 +98,9 @@ RenderPipelineNode::ExecuteCallback LocalShadowDrawNode::construct(GpuScene& sce
                 cmdList.beginRendering(*renderState->renderState, false);
                 cmdList.setDepthBias(light.constantBias(), light.slopeBias());
 
-                cmdList.setNamedUniform("projectionFromWorld", projectionFromWorld);
-                cmdList.setNamedUniform("frustumPlanes", frustumPlaneData, frustumPlaneDataSize);
-                cmdList.setNamedUniform("frustumCullMeshlets", m_frustumCullMeshlets);
+                cmdList.setNamedUniform(renderState->projectionFromWorldConstant, projectionFromWorld);
+                cmdList.setNamedUniform(renderState->frustumPlanesConstant, frustumPlaneData, frustumPlaneDataSize);
+                cmdList.setNamedUniform(renderState->frustumCullMeshletsConstant, m_frustumCullMeshlets);
 
                 MeshletIndirectBuffer& indirectBuffer = *renderState->indirectBuffer;
                 m_meshletIndirectHelper.drawMeshletsWithIndirectBuffer(cmdList, indirectBuffer);
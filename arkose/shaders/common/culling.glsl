@@ -15,4 +15,58 @@ bool isSphereInFrustum(vec4 sphere, vec4 frustumPlanes[CULLING_FRUSTUM_PLANES])
     return !fullyOutside;
 }
 
+// Test a (world space) sphere against a depth pyramid, where each texel of each mip level contains the max (i.e. farthest)
+// depth of its footprint in the depth buffer. Assumes a [0, 1] depth range where 1 is the far plane. The results are marked
+// as precise, as the two-phase occlusion culling relies on getting the exact same result in different shaders.
+bool isSphereOccluded(vec4 sphere, mat4 projectionFromWorld, sampler2D depthPyramid)
+{
+    precise vec2 uvMin = vec2(1.0);
+    precise vec2 uvMax = vec2(0.0);
+    precise float nearestDepth = 1.0;
+
+    // Project the corners of the bounding box of the sphere to find a conservative screen space rect and depth for it
+    for (int i = 0; i < 8; ++i) {
+        vec3 cornerOffset = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        precise vec4 projectedCorner = projectionFromWorld * vec4(sphere.xyz + sphere.w * cornerOffset, 1.0);
+
+        // If any part of the box is behind the camera we can't project it, but then it's also very close, so consider it visible
+        if (projectedCorner.w <= 0.0) {
+            return false;
+        }
+
+        precise vec3 ndc = projectedCorner.xyz / projectedCorner.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+
+    if (nearestDepth <= 0.0) {
+        return false;
+    }
+
+    uvMin = clamp(uvMin, vec2(0.0), vec2(1.0));
+    uvMax = clamp(uvMax, vec2(0.0), vec2(1.0));
+
+    // Pick the mip level where the rect covers at most 2x2 texels
+    vec2 rectSizeInTexels = (uvMax - uvMin) * vec2(textureSize(depthPyramid, 0));
+    int mipLevel = int(ceil(log2(max(max(rectSizeInTexels.x, rectSizeInTexels.y), 1.0))));
+    mipLevel = clamp(mipLevel, 0, textureQueryLevels(depthPyramid) - 1);
+
+    ivec2 mipSize = textureSize(depthPyramid, mipLevel);
+    ivec2 texelMin = clamp(ivec2(uvMin * vec2(mipSize)), ivec2(0), mipSize - 1);
+    ivec2 texelMax = clamp(ivec2(uvMax * vec2(mipSize)), ivec2(0), mipSize - 1);
+
+    // Should never happen with the mip level picked above, but if it does we can't be sure it's occluded
+    if (any(greaterThan(texelMax - texelMin, ivec2(1)))) {
+        return false;
+    }
+
+    float maxDepth = max(max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMin.y), mipLevel).x,
+                             texelFetch(depthPyramid, ivec2(texelMax.x, texelMin.y), mipLevel).x),
+                         max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMax.y), mipLevel).x,
+                             texelFetch(depthPyramid, ivec2(texelMax.x, texelMax.y), mipLevel).x));
+
+    return nearestDepth > maxDepth;
+}
+
 #endif // CULLING_GLSL
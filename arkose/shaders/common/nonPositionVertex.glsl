@@ -0,0 +1,55 @@
+#ifndef NON_POSITION_VERTEX_GLSL
+#define NON_POSITION_VERTEX_GLSL
+
+#include <common/octahedral.glsl>
+#include <shared/SceneData.h>
+
+// The tangent is octahedral encoded just like the normal, but it also needs the bitangent sign. It's folded into the y-component,
+// which is first remapped to [1/32767, 1] so that the sign of it survives the snorm16 quantization (i.e. it's never zero).
+// NOTE: Must match the encoding of VertexComponent::TangentOct2S16 in MeshSegmentAsset::assembleVertexData!
+
+vec2 encodeCompactTangent(vec4 tangent)
+{
+    vec2 octahedral = octahedralEncode(tangent.xyz);
+    float y = max(octahedral.y * 0.5 + 0.5, 1.0 / 32767.0);
+    return vec2(octahedral.x, tangent.w < 0.0 ? -y : y);
+}
+
+vec4 decodeCompactTangent(vec2 encodedTangent)
+{
+    float bitangentSign = encodedTangent.y < 0.0 ? -1.0 : 1.0;
+    vec2 octahedral = vec2(encodedTangent.x, abs(encodedTangent.y) * 2.0 - 1.0);
+    return vec4(octahedralDecode(octahedral), bitangentSign);
+}
+
+NonPositionVertex unpackNonPositionVertex(PackedNonPositionVertex packedVertex)
+{
+    NonPositionVertex vertex;
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+    vertex.texcoord0 = unpackHalf2x16(packedVertex.texcoord0);
+    vertex.normal = octahedralDecode(unpackSnorm2x16(packedVertex.normal));
+    vertex.tangent = decodeCompactTangent(unpackSnorm2x16(packedVertex.tangent));
+#else
+    vertex.texcoord0 = packedVertex.texcoord0;
+    vertex.normal = packedVertex.normal;
+    vertex.tangent = packedVertex.tangent;
+#endif
+    return vertex;
+}
+
+PackedNonPositionVertex packNonPositionVertex(NonPositionVertex vertex)
+{
+    PackedNonPositionVertex packedVertex;
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+    packedVertex.texcoord0 = packHalf2x16(vertex.texcoord0);
+    packedVertex.normal = packSnorm2x16(octahedralEncode(vertex.normal));
+    packedVertex.tangent = packSnorm2x16(encodeCompactTangent(vertex.tangent));
+#else
+    packedVertex.texcoord0 = vertex.texcoord0;
+    packedVertex.normal = vertex.normal;
+    packedVertex.tangent = vertex.tangent;
+#endif
+    return packedVertex;
+}
+
+#endif // NON_POSITION_VERTEX_GLSL
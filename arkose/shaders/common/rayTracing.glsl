@@ -3,18 +3,25 @@
 
 #include <rayTracing/khrRayTracing.glsl>
 
+#include <common/nonPositionVertex.glsl>
 #include <shared/RTData.h>
 
 // Corresponding to published binding set "SceneRTMeshDataSet"
 #define DeclareCommonBindingSet_RTMesh(index) \
-    layout(set = index, binding = 0, scalar) buffer readonly RTTriangleMeshesBlock { RTTriangleMesh _rtMeshes[]; };  \
-    layout(set = index, binding = 1, scalar) buffer readonly RTIndicesBlock        { uint           _rtIndices[]; }; \
-    layout(set = index, binding = 2, scalar) buffer readonly RTPositionsBlock      { vec3           _rtPositions[]; }; \
-    layout(set = index, binding = 3, scalar) buffer readonly RTVerticesBlock       { RTVertex       _rtVertices[]; };
+    layout(set = index, binding = 0, scalar) buffer readonly RTTriangleMeshesBlock { RTTriangleMesh          _rtMeshes[]; };  \
+    layout(set = index, binding = 1, scalar) buffer readonly RTIndicesBlock        { uint                    _rtIndices[]; }; \
+    layout(set = index, binding = 2, scalar) buffer readonly RTPositionsBlock      { vec3                    _rtPositions[]; }; \
+    layout(set = index, binding = 3, scalar) buffer readonly RTVerticesBlock       { PackedNonPositionVertex _rtVertices[]; };
+
+RTVertex rtmesh_unpackVertex(PackedNonPositionVertex packedVertex)
+{
+    NonPositionVertex vertex = unpackNonPositionVertex(packedVertex);
+    return RTVertex(vertex.texcoord0, vertex.normal, vertex.tangent);
+}
 
 #define rtmesh_getMesh(index) _rtMeshes[index]
 #define rtmesh_getIndex(index) _rtIndices[index]
 #define rtmesh_getPosition(index) _rtPositions[index]
-#define rtmesh_getVertex(index) _rtVertices[index]
+#define rtmesh_getVertex(index) rtmesh_unpackVertex(_rtVertices[index])
 
 #endif // RAY_TRACING_GLSL
@@ -3,16 +3,18 @@
 
 #extension GL_EXT_scalar_block_layout : require
 
+#include <common/nonPositionVertex.glsl>
+
 // Corresponding to published binding set "VisibilityBufferData"
-#define DeclareCommonBindingSet_VisibilityBuffer(index)                                                                                         \
-    layout(set = index, binding = 0)         uniform usampler2D _visbufDrawableVisibilityTex;                                                   \
-    layout(set = index, binding = 1)         uniform usampler2D _visbufTriangleVisibilityTex;                                                   \
-    layout(set = index, binding = 2)         buffer restrict readonly VisbufInstanceBlock     { ShaderDrawable    _visbufInstances[]; };        \
-    layout(set = index, binding = 3)         buffer restrict readonly VisbufMeshletBlock      { ShaderMeshlet     _visbufMeshlets[]; };         \
-    layout(set = index, binding = 4, scalar) buffer restrict readonly VisbufIndicesBlock      { uint              _visbufMeshletIndices[]; };   \
-    layout(set = index, binding = 5, scalar) buffer restrict readonly VisbufVertIndBlock      { uint              _visbufMeshletVertIndir[]; }; \
-    layout(set = index, binding = 6, scalar) buffer restrict readonly VisbufPositionsBlock    { vec3              _visbufPositionVertices[]; }; \
-    layout(set = index, binding = 7, scalar) buffer restrict readonly VisbufNonPositionsBlock { NonPositionVertex _visbufNonPositionVertices[]; };
+#define DeclareCommonBindingSet_VisibilityBuffer(index)                                                                                               \
+    layout(set = index, binding = 0)         uniform usampler2D _visbufDrawableVisibilityTex;                                                         \
+    layout(set = index, binding = 1)         uniform usampler2D _visbufTriangleVisibilityTex;                                                         \
+    layout(set = index, binding = 2)         buffer restrict readonly VisbufInstanceBlock     { ShaderDrawable          _visbufInstances[]; };        \
+    layout(set = index, binding = 3)         buffer restrict readonly VisbufMeshletBlock      { ShaderMeshlet           _visbufMeshlets[]; };         \
+    layout(set = index, binding = 4, scalar) buffer restrict readonly VisbufIndicesBlock      { uint                    _visbufMeshletIndices[]; };   \
+    layout(set = index, binding = 5, scalar) buffer restrict readonly VisbufVertIndBlock      { uint                    _visbufMeshletVertIndir[]; }; \
+    layout(set = index, binding = 6, scalar) buffer restrict readonly VisbufPositionsBlock    { vec3                    _visbufPositionVertices[]; }; \
+    layout(set = index, binding = 7, scalar) buffer restrict readonly VisbufNonPositionsBlock { PackedNonPositionVertex _visbufNonPositionVertices[]; };
 
 #define visbuf_fetchDrawableIdx(pixelCoord) uint(texelFetch(_visbufDrawableVisibilityTex, pixelCoord, 0).x)
 #define visbuf_fetchTriangleId(pixelCoord) uint(texelFetch(_visbufTriangleVisibilityTex, pixelCoord, 0).x)
@@ -51,9 +53,9 @@
                                                                  out NonPositionVertex v1,        \
                                                                  out NonPositionVertex v2)        \
     {                                                                                             \
-        v0 = _visbufNonPositionVertices[triangle[0]];                                                 \
-        v1 = _visbufNonPositionVertices[triangle[1]];                                                 \
-        v2 = _visbufNonPositionVertices[triangle[2]];                                                 \
+        v0 = unpackNonPositionVertex(_visbufNonPositionVertices[triangle[0]]);                    \
+        v1 = unpackNonPositionVertex(_visbufNonPositionVertices[triangle[1]]);                    \
+        v2 = unpackNonPositionVertex(_visbufNonPositionVertices[triangle[2]]);                    \
     }
 
 #endif // VISIBILITY_BUFFER_GLSL
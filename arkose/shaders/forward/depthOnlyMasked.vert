@@ -5,8 +5,13 @@
 
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec2 aTexCoord;
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+layout(location = 2) in vec2 aNormal;
+layout(location = 3) in vec2 aTangent;
+#else
 layout(location = 2) in vec3 aNormal;
 layout(location = 3) in vec4 aTangent;
+#endif
 
 layout(set = 0, binding = 0) buffer readonly PerObjectBlock { ShaderDrawable drawables[]; };
 
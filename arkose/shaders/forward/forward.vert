@@ -2,14 +2,20 @@
 
 #extension GL_EXT_scalar_block_layout : require
 
+#include <common/nonPositionVertex.glsl>
 #include <forward/forwardCommon.glsl>
 #include <shared/CameraState.h>
 #include <shared/SceneData.h>
 
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec2 aTexCoord;
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+layout(location = 2) in vec2 aNormal;
+layout(location = 3) in vec2 aTangent;
+#else
 layout(location = 2) in vec3 aNormal;
 layout(location = 3) in vec4 aTangent;
+#endif
 
 layout(set = 0, binding = 0) uniform CameraStateBlock { CameraState camera; };
 
@@ -52,10 +58,18 @@ void main()
     vCurrFrameProjectedPos = camera.projectionFromView * viewSpacePos;
     vPrevFrameProjectedPos = camera.previousFrameProjectionFromView * camera.previousFrameViewFromWorld * object.previousFrameWorldFromLocal * vec4(prevLocalPos, 1.0);
 
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+    vec3 normal = octahedralDecode(aNormal);
+    vec4 tangent = decodeCompactTangent(aTangent);
+#else
+    vec3 normal = aNormal;
+    vec4 tangent = aTangent;
+#endif
+
     mat3 viewFromTangent = mat3(camera.viewFromWorld) * mat3(object.worldFromTangent);
-    vNormal = normalize(viewFromTangent * aNormal);
-    vTangent = normalize(viewFromTangent * aTangent.xyz);
-    vBitangentSign = aTangent.w;
+    vNormal = normalize(viewFromTangent * normal);
+    vTangent = normalize(viewFromTangent * tangent.xyz);
+    vBitangentSign = tangent.w;
 
     gl_Position = vCurrFrameProjectedPos;
 }
@@ -17,6 +17,10 @@ struct MeshletConstants {
     mat4 projectionFromWorld;
     vec4 frustumPlanes[6];
     bool frustumCullMeshlets;
+#ifdef MESHLET_OCCLUSION_CULLING
+    uint occlusionCullingPhase;
+    mat4 previousProjectionFromWorld;
+#endif
 };
 
 #endif // MESHLET_COMMON_GLSL
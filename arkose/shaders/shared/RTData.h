@@ -5,7 +5,7 @@
 #define RT_HIT_MASK_MASKED 0x02
 #define RT_HIT_MASK_BLEND  0x04
 
-// NOTE: Must match whatever vertex data layout we pass to the ray tracing shaders!
+// Vertex data as unpacked from the scene's non-position vertex buffer, see rtmesh_getVertex
 struct RTVertex {
     vec2 texCoord;
     vec3 normal;
@@ -11,7 +11,11 @@ struct ShaderDrawable {
     uint firstMeshlet;
     uint meshletCount;
     int relativeVelocityVertex;
-    int _pad0, _pad1, _pad2;
+
+    // Index data for drawing this drawable with (indirect) indexed draws. The index count is 0 if it can't be drawn this way.
+    uint firstIndex;
+    uint indexCount;
+    int vertexOffset;
 };
 
 struct ShaderMeshlet {
@@ -24,12 +28,47 @@ struct ShaderMeshlet {
     float radius;
 };
 
+// Two-phase occlusion culling of meshlets. In the early phase everything which was visible according to the depth of last
+// frame is drawn, and then in the late phase everything that was culled in the early phase is re-tested against the new depth.
+#define MESHLET_OCCLUSION_CULLING_PHASE_NONE  0
+#define MESHLET_OCCLUSION_CULLING_PHASE_EARLY 1
+#define MESHLET_OCCLUSION_CULLING_PHASE_LATE  2
+
+// Set in the drawable lookup of the late phase indirect data for drawables which were also drawn in the early phase
+#define MESHLET_DRAWABLE_VISIBLE_EARLY_BIT 0x80000000u
+
+struct ShaderMeshletCullingStats {
+    uint drawnEarlyCount;
+    uint drawnLateCount;
+    uint frustumCulledCount;
+    uint occlusionCulledCount;
+};
+
+// Store the non-position vertex data in the compact format: half-float texture coordinates and 16-bit octahedral encoded
+// normals & tangents, i.e. 12 instead of 36 bytes per vertex. See common/nonPositionVertex.glsl for how it's decoded.
+#define SCENE_COMPACT_NON_POSITION_VERTICES 1
+
 struct NonPositionVertex {
     vec2 texcoord0;
     vec3 normal;
     vec4 tangent;
 };
 
+// Non-position vertex as stored in the vertex buffer. Use (un)packNonPositionVertex to convert to & from NonPositionVertex.
+#if SCENE_COMPACT_NON_POSITION_VERTICES
+struct PackedNonPositionVertex {
+    uint texcoord0; // 2x float16
+    uint normal; // 2x snorm16, octahedral encoded
+    uint tangent; // 2x snorm16, octahedral encoded with the bitangent sign folded into y
+};
+#else
+struct PackedNonPositionVertex {
+    vec2 texcoord0;
+    vec3 normal;
+    vec4 tangent;
+};
+#endif
+
 struct SkinningVertex {
     uvec4 jointIndices;
     vec4 jointWeights;
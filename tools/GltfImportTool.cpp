@@ -5,9 +5,9 @@
 
 int main(int argc, char* argv[])
 {
-    if (argc < 3) {
+    if (argc < 4) {
         // TODO: Add support for named command line arguments!
-        ARKOSE_LOG(Error, "GltfImportTool: must be called as\n> GltfImportTool <SourceGltfFile> <TargetDirectory> <TempDirectory>");
+        ARKOSE_LOG(Error, "GltfImportTool: must be called as\n> GltfImportTool <SourceGltfFile> <TargetDirectory> <TempDirectory> [MeshLODCount]");
         return 1;
     }
 
@@ -20,9 +20,23 @@ int main(int argc, char* argv[])
     std::filesystem::path tempDirectory = argv[3];
     ARKOSE_LOG(Info, "GltfImportTool: will write temp files to '{}'", tempDirectory);
 
+    // Shared with ImgAssetBakeTool, which bakes the image specs written to the temp directory
+    BakeCache bakeCache { tempDirectory / "BakeCache" };
+
+    // Including LOD0, so by default only LOD0 is imported and LOD generation is opt-in
+    u32 meshLODCount = 1;
+    if (argc > 4) {
+        meshLODCount = static_cast<u32>(std::max(std::atoi(argv[4]), 1));
+        ARKOSE_LOG(Info, "GltfImportTool: will generate up to {} LODs per mesh", meshLODCount);
+    }
+
     AssetImporterOptions options { .generateMipmaps = true,
                                    .blockCompressImages = true,
-                                   .generateImageSpecs = true };
+                                   .generateImageSpecs = true,
+                                   .meshLODCount = meshLODCount,
+                                   .bakeCache = &bakeCache };
+
+    TaskGraph::initialize();
 
     ImportResult result;
 
@@ -34,6 +48,8 @@ int main(int argc, char* argv[])
         result = std::move(*importTask->result());
     }
 
+    bakeCache.logStatistics("GltfImportTool");
+
     // Create dependency file
     {
         std::string originalExt = inputAsset.extension().string();
@@ -61,6 +77,11 @@ int main(int argc, char* argv[])
             auto& imageSpec = result.imageSpecs[imgIdx];
             auto& imageAsset = result.images[imgIdx];
 
+            // Images which failed to load are not written, so there is nothing to depend on
+            if (imageAsset == nullptr) {
+                continue;
+            }
+
             if (imageSpec != nullptr) {
                 addImageSpecOutputDependency(*imageSpec);
             } else {
@@ -91,5 +112,7 @@ int main(int argc, char* argv[])
         FileIO::writeTextDataToFile(dependencyFilePath, dependencyData);
     }
 
+    TaskGraph::shutdown();
+
     return toolReturnCode();
 }
@@ -1,9 +1,88 @@
 #include <asset/ImageAsset.h>
 #include <asset/TextureCompressor.h>
+#include <asset/misc/BakeCache.h>
 #include <asset/misc/ImageBakeSpec.h>
 #include <core/Logging.h>
+#include <core/parallel/TaskGraph.h>
 #include <utility/FileIO.h>
 #include <utility/ToolUtilities.h>
+#include <ark/defer.h>
+
+// Bump this whenever a change to the tool (or the code it calls into) changes the baked output, to invalidate the bake cache
+constexpr u32 ImgAssetBakeToolVersion = 1;
+
+static bool bakeImage(ImageBakeSpec const& imgSpec)
+{
+    ARKOSE_LOG(Info, "ImgAssetBakeTool: loading image image '{}'...", imgSpec.inputImage);
+
+    std::unique_ptr<ImageAsset> imageAsset = ImageAsset::createFromSourceAsset(imgSpec.inputImage);
+
+    if (!imageAsset) {
+        ARKOSE_LOG(Error, "ImgAssetBakeTool: failed to load image");
+        return false;
+    }
+    switch (imgSpec.type) {
+    case ImageType::sRGBColor:
+        imageAsset->setType(ImageType::sRGBColor);
+        break;
+    case ImageType::GenericData:
+        imageAsset->setType(ImageType::GenericData);
+        break;
+    case ImageType::NormalMap:
+        imageAsset->setType(ImageType::NormalMap);
+        break;
+    default:
+        imageAsset->setType(ImageType::Unknown);
+        break;
+    }
+
+    if (imageAsset->numMips() == 1) {
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: generating mipmaps...");
+        if (!imageAsset->generateMipmaps(imgSpec.mipmapFilter)) {
+            ARKOSE_LOG(Warning, "ImgAssetBakeTool: failed to generate mipmaps");
+        }
+    } else {
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: image already has mipmaps, skipping generation");
+    }
+
+    bool isAlreadyCompressed = imageFormatIsBlockCompressed(imageAsset->format());
+    if (isAlreadyCompressed) {
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: image is already block compressed, skipping compression");
+    } else if (imgSpec.compress) {
+
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: compressing image...");
+
+        TextureCompressor textureCompressor;
+        switch (imgSpec.type) {
+        case ImageType::sRGBColor:
+        case ImageType::GenericData:
+            imageAsset = textureCompressor.compressBC7(*imageAsset, imgSpec.compressionQuality);
+            break;
+        case ImageType::NormalMap:
+            imageAsset = textureCompressor.compressBC5(*imageAsset, imgSpec.compressionQuality);
+            break;
+        case ImageType::Unknown:
+            ARKOSE_LOG(Warning, "ImgAssetBakeTool: compressing image '{}' of unknown type as BC7 (ideally we have a type!)", imgSpec.inputImage);
+            imageAsset = textureCompressor.compressBC7(*imageAsset, imgSpec.compressionQuality);
+            break;
+        default:
+            ARKOSE_LOG(Error, "ImgAssetBakeTool: failed to compress image of type '{}'", imgSpec.type);
+            return false;
+        }
+    }
+
+    ARKOSE_LOG(Info, "ImgAssetBakeTool: writing image...");
+
+    bool writeSuccess = imageAsset->writeToFile(imgSpec.targetImage, AssetStorage::Binary);
+    if (writeSuccess) {
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: wrote baked image to '{}'", imgSpec.targetImage);
+    } else {
+        ARKOSE_LOG(Info, "ImgAssetBakeTool: failed to write baked image to '{}'", imgSpec.targetImage);
+        return false;
+    }
+
+    return true;
+}
 
 int main(int argc, char* argv[])
 {
@@ -14,6 +93,13 @@ int main(int argc, char* argv[])
     }
 
     std::filesystem::path inputFile = argv[1];
+
+    // Mipmap generation and compression are split up over the task graph, so even a single large image uses all cores
+    TaskGraph::initialize();
+    ark::AtScopeExit shutdownTaskGraph([]() {
+        TaskGraph::shutdown();
+    });
+
     if (inputFile.has_extension() && inputFile.extension() == ".imgspec") {
 
         ARKOSE_LOG(Info, "ImgAssetBakeTool: parsing image bake spec");
@@ -24,74 +110,30 @@ int main(int argc, char* argv[])
             return 1;
         }
 
-        ARKOSE_LOG(Info, "ImgAssetBakeTool: loading image image '{}'...", imgSpec.inputImage);
+        // Serve the baked image from the bake cache (next to the spec file) if nothing that affects the output has changed
+        BakeCache bakeCache { inputFile.parent_path() / "BakeCache" };
 
-        std::unique_ptr<ImageAsset> imageAsset = ImageAsset::createFromSourceAsset(imgSpec.inputImage);
+        ContentHasher hasher {};
+        hasher.append("ImgAssetBakeTool");
+        hasher.appendValue(ImgAssetBakeToolVersion);
+        imgSpec.hashBakeOptions(hasher);
+        bool canUseBakeCache = hasher.appendFileContents(imgSpec.inputImage);
+        BakeCacheKey bakeCacheKey = hasher.finalize();
 
-        if (!imageAsset) {
-            ARKOSE_LOG(Error, "ImgAssetBakeTool: failed to load image");
-            return 1;
-        }
-        switch (imgSpec.type) {
-        case ImageType::sRGBColor:
-            imageAsset->setType(ImageType::sRGBColor);
-            break;
-        case ImageType::GenericData:
-            imageAsset->setType(ImageType::GenericData);
-            break;
-        case ImageType::NormalMap:
-            imageAsset->setType(ImageType::NormalMap);
-            break;
-        default:
-            imageAsset->setType(ImageType::Unknown);
-            break;
-        }
-
-        if (imageAsset->numMips() == 1) {
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: generating mipmaps...");
-            if (!imageAsset->generateMipmaps()) {
-                ARKOSE_LOG(Warning, "ImgAssetBakeTool: failed to generate mipmaps");
-            }
+        if (canUseBakeCache && bakeCache.retrieve(bakeCacheKey, imgSpec.targetImage)) {
+            ARKOSE_LOG(Info, "ImgAssetBakeTool: copied baked image from the bake cache to '{}'", imgSpec.targetImage);
         } else {
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: image already has mipmaps, skipping generation");
-        }
-
-        bool isAlreadyCompressed = imageFormatIsBlockCompressed(imageAsset->format());
-        if (isAlreadyCompressed) {
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: image is already block compressed, skipping compression");
-        } else if (imgSpec.compress) {
-
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: compressing image...");
-
-            TextureCompressor textureCompressor;
-            switch (imgSpec.type) {
-            case ImageType::sRGBColor:
-            case ImageType::GenericData:
-                imageAsset = textureCompressor.compressBC7(*imageAsset);
-                break;
-            case ImageType::NormalMap:
-                imageAsset = textureCompressor.compressBC5(*imageAsset);
-                break;
-            case ImageType::Unknown:
-                ARKOSE_LOG(Warning, "ImgAssetBakeTool: compressing image '{}' of unknown type as BC7 (ideally we have a type!)", imgSpec.inputImage);
-                imageAsset = textureCompressor.compressBC7(*imageAsset);
-                break;
-            default:
-                ARKOSE_LOG(Error, "ImgAssetBakeTool: failed to compress image of type '{}'", imgSpec.type);
+            if (!bakeImage(imgSpec)) {
                 return 1;
             }
-        }
-
-        ARKOSE_LOG(Info, "ImgAssetBakeTool: writing image...");
 
-        bool writeSuccess = imageAsset->writeToFile(imgSpec.targetImage, AssetStorage::Binary);
-        if (writeSuccess) {
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: wrote baked image to '{}'", imgSpec.targetImage);
-        } else {
-            ARKOSE_LOG(Info, "ImgAssetBakeTool: failed to write baked image to '{}'", imgSpec.targetImage);
-            return 1;
+            if (canUseBakeCache) {
+                bakeCache.store(bakeCacheKey, imgSpec.targetImage);
+            }
         }
 
+        bakeCache.logStatistics("ImgAssetBakeTool");
+
         ARKOSE_LOG(Info, "ImgAssetBakeTool: writing dependency file...");
 
         std::string dependencyData = fmt::format("INPUT: {}\nOUTPUT: {}\n", imgSpec.inputImage, imgSpec.targetImage);
@@ -0,0 +1,160 @@
+#include <core/Logging.h>
+#include <core/parallel/ParallelFor.h>
+#include <core/parallel/Task.h>
+#include <core/parallel/TaskGraph.h>
+#include <utility/ToolUtilities.h>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+#if PLATFORM_WINDOWS
+#include <Windows.h>
+#endif
+
+// Micro-benchmark for the task system. Measures the cost of creating, executing and releasing single tasks, the overall
+// ParallelFor throughput, the throughput of short bursts of work (where workers go idle in between), and how much CPU time
+// idle workers burn. Everything is measured once with workers idling like they used to (WorkerIdleMode::YieldOnly) as the
+// baseline, and once with the current idle mode, and then the two are compared.
+
+namespace {
+
+template<typename Function>
+double measureTasksPerSecond(size_t taskCount, Function&& function)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    function();
+    auto endTime = std::chrono::steady_clock::now();
+
+    double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    return static_cast<double>(taskCount) / elapsedSeconds;
+}
+
+// CPU time (user & kernel) consumed by all threads of this process so far
+double processCpuSeconds()
+{
+#if PLATFORM_WINDOWS
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+
+    auto toSeconds = [](FILETIME fileTime) -> double {
+        ULARGE_INTEGER value;
+        value.LowPart = fileTime.dwLowDateTime;
+        value.HighPart = fileTime.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) * 100e-9; // in units of 100 ns
+    };
+
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+    // NOTE: On POSIX systems clock() measures the CPU time of the process
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+struct BenchmarkResults {
+    double singleTasksPerSecond { 0.0 };
+    double parallelForItemsPerSecond { 0.0 };
+    double burstItemsPerSecond { 0.0 };
+    double idleBusyCores { 0.0 };
+    TaskGraph::IdleStatistics idleStatistics {};
+};
+
+BenchmarkResults runBenchmarks(TaskGraphSettings const& taskGraphSettings, size_t taskCount)
+{
+    // Small enough that the workers go idle in between every burst
+    constexpr size_t BurstSize = 256;
+    constexpr std::chrono::milliseconds IdleDuration { 250 };
+
+    TaskGraph::initialize(taskGraphSettings);
+
+    BenchmarkResults results {};
+
+    std::atomic_uint64_t counter { 0 };
+
+    // NOTE: Capture a few values so the lambda is representative of a typical task, i.e., not trivially small
+    u64 valueA = 1, valueB = 2, valueC = 3;
+    auto taskBody = [&counter, valueA, valueB, valueC]() {
+        counter.fetch_add(valueA + valueB + valueC, std::memory_order_relaxed);
+    };
+
+    results.singleTasksPerSecond = measureTasksPerSecond(taskCount, [&]() {
+        for (size_t idx = 0; idx < taskCount; ++idx) {
+            Task& task = Task::create(taskBody);
+            task.executeSynchronous();
+            task.release();
+        }
+    });
+
+    results.parallelForItemsPerSecond = measureTasksPerSecond(taskCount, [&]() {
+        ParallelFor(taskCount, [&](size_t idx) {
+            taskBody();
+        });
+    });
+
+    size_t burstCount = std::max(taskCount / BurstSize, size_t(1));
+    results.burstItemsPerSecond = measureTasksPerSecond(burstCount * BurstSize, [&]() {
+        for (size_t burstIdx = 0; burstIdx < burstCount; ++burstIdx) {
+            ParallelFor(BurstSize, [&](size_t idx) {
+                taskBody();
+            });
+        }
+    });
+
+    // With nothing to do all the workers are idle, so any CPU time spent now is spent by the idle mode itself
+    double cpuSecondsBeforeIdle = processCpuSeconds();
+    std::this_thread::sleep_for(IdleDuration);
+    double idleCpuSeconds = processCpuSeconds() - cpuSecondsBeforeIdle;
+    results.idleBusyCores = idleCpuSeconds / std::chrono::duration<double>(IdleDuration).count();
+
+    results.idleStatistics = TaskGraph::get().idleStatistics();
+
+    TaskGraph::shutdown();
+
+    return results;
+}
+
+void logResults(char const* label, BenchmarkResults const& results)
+{
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: [{}] single tasks (create, execute, release): {:.2f} M tasks/s", label, results.singleTasksPerSecond / 1e6);
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: [{}] ParallelFor: {:.2f} M items/s", label, results.parallelForItemsPerSecond / 1e6);
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: [{}] ParallelFor bursts: {:.2f} M items/s", label, results.burstItemsPerSecond / 1e6);
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: [{}] CPU usage while idle: {:.2f} cores", label, results.idleBusyCores);
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: [{}] worker idle statistics: {} spins, {} parks, {} wakeups",
+               label, results.idleStatistics.spins, results.idleStatistics.parks, results.idleStatistics.wakeups);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    size_t taskCount = 1'000'000;
+    if (argc >= 2) {
+        taskCount = std::stoull(argv[1]);
+    }
+
+    TaskGraphSettings taskGraphSettings {};
+    if (argc >= 3) {
+        taskGraphSettings.numDefaultWorkerThreads = static_cast<u32>(std::stoul(argv[2]));
+    }
+
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: running benchmarks with {} tasks", taskCount);
+
+    TaskGraphSettings baselineSettings = taskGraphSettings;
+    baselineSettings.workerIdleMode = WorkerIdleMode::YieldOnly;
+    BenchmarkResults baselineResults = runBenchmarks(baselineSettings, taskCount);
+    logResults("yield only (baseline)", baselineResults);
+
+    taskGraphSettings.workerIdleMode = WorkerIdleMode::SpinThenPark;
+    BenchmarkResults results = runBenchmarks(taskGraphSettings, taskCount);
+    logResults("spin then park", results);
+
+    ARKOSE_LOG(Info, "TaskGraphBenchmarkTool: spin then park relative to the baseline: single tasks {:.2f}x, ParallelFor {:.2f}x, "
+                     "ParallelFor bursts {:.2f}x, CPU usage while idle {:.2f} vs. {:.2f} cores",
+               results.singleTasksPerSecond / baselineResults.singleTasksPerSecond,
+               results.parallelForItemsPerSecond / baselineResults.parallelForItemsPerSecond,
+               results.burstItemsPerSecond / baselineResults.burstItemsPerSecond,
+               results.idleBusyCores, baselineResults.idleBusyCores);
+
+    return toolReturnCode();
+}